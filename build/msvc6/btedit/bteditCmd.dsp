@@ -107,6 +107,22 @@ SOURCE=..\..\..\src\btree\btrec.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\bulk.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\compress.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\cursor.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\fdpool.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\stdlib\dirs.c
 # End Source File
 # Begin Source File
@@ -135,6 +151,14 @@ SOURCE=..\..\..\src\btree\index.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\journal.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\lock.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\arch\mswin\intlshim.c
 # End Source File
 # Begin Source File
@@ -163,6 +187,10 @@ SOURCE=..\..\..\src\btree\opnbtree.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\snapshot.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\stdlib\path.c
 # End Source File
 # Begin Source File
@@ -112,6 +112,22 @@ SOURCE=..\..\..\src\btree\btrec.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\bulk.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\compress.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\cursor.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\fdpool.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\charmaps.c
 # End Source File
 # Begin Source File
@@ -208,6 +224,14 @@ SOURCE=..\..\..\src\btree\index.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\journal.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\lock.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\indiseq.c
 # End Source File
 # Begin Source File
@@ -228,6 +252,10 @@ SOURCE=..\..\..\src\gedlib\keytonod.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\gedlib\kinship.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\stdlib\list.c
 # End Source File
 # Begin Source File
@@ -292,6 +320,10 @@ SOURCE=..\..\..\src\stdlib\mystring.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\gedlib\namegram.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\names.c
 # End Source File
 # Begin Source File
@@ -324,6 +356,10 @@ SOURCE=..\..\..\src\btree\opnbtree.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\snapshot.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\stdlib\path.c
 # End Source File
 # Begin Source File
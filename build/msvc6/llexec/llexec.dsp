@@ -124,6 +124,22 @@ SOURCE=..\..\..\src\btree\btrec.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\bulk.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\compress.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\cursor.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\fdpool.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\interp\builtin.c
 # End Source File
 # Begin Source File
@@ -148,6 +164,10 @@ SOURCE=..\..\..\src\gedlib\codesets.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\interp\compile.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\datei.c
 # End Source File
 # Begin Source File
@@ -252,6 +272,14 @@ SOURCE=..\..\..\src\btree\index.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\journal.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\lock.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\indiseq.c
 # End Source File
 # Begin Source File
@@ -280,6 +308,10 @@ SOURCE=..\..\..\src\gedlib\keytonod.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\gedlib\kinship.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\interp\lex.c
 # End Source File
 # Begin Source File
@@ -364,6 +396,10 @@ SOURCE=..\..\..\src\stdlib\mystring.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\gedlib\namegram.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\names.c
 # End Source File
 # Begin Source File
@@ -396,6 +432,10 @@ SOURCE=..\..\..\src\btree\opnbtree.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\snapshot.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\stdlib\path.c
 # End Source File
 # Begin Source File
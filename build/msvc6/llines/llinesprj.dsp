@@ -149,6 +149,22 @@ SOURCE=..\..\..\src\btree\btrec.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\bulk.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\compress.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\cursor.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\fdpool.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\interp\builtin.c
 # End Source File
 # Begin Source File
@@ -173,6 +189,10 @@ SOURCE=..\..\..\src\gedlib\codesets.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\interp\compile.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\liflines\cscurses.c
 # End Source File
 # Begin Source File
@@ -309,6 +329,14 @@ SOURCE=..\..\..\src\btree\index.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\journal.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\src\btree\lock.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\indiseq.c
 # End Source File
 # Begin Source File
@@ -341,6 +369,10 @@ SOURCE=..\..\..\src\gedlib\keytonod.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\gedlib\kinship.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\liflines\lbrowse.c
 # End Source File
 # Begin Source File
@@ -453,6 +485,10 @@ SOURCE=..\..\..\src\stdlib\mystring.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\gedlib\namegram.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\gedlib\names.c
 # End Source File
 # Begin Source File
@@ -493,6 +529,10 @@ SOURCE=..\..\..\src\btree\opnbtree.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\src\btree\snapshot.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\src\stdlib\path.c
 # End Source File
 # Begin Source File
@@ -46,7 +46,7 @@ syn keyword	lifelinesIndi			difference parentset childset spouseset siblingset
 syn keyword	lifelinesIndi			ancestorset descendentset descendantset uniqueset
 syn keyword	lifelinesIndi			namesort keysort valuesort genindiset getindiset
 syn keyword	lifelinesIndi			forindiset lastindi writeindi
-syn keyword	lifelinesIndi			inset
+syn keyword	lifelinesIndi			inset searchindiset
 syn keyword	lifelinesFam			marriage husband wife nchildren firstchild
 syn keyword	lifelinesFam			lastchild fnode fam firstfam nextfam lastfam
 syn keyword	lifelinesFam			prevfam children forfam writefam
@@ -52,10 +52,6 @@ crtblock (BTREE btree)  /*btree handle*/
 	BLOCK block;
 	ASSERT(bwrite(btree) == 1);
 	block = allocblock();
-	ixself(block) = btree->b_kfile.k_fkey;
-	nextfkey(btree);
-	rewind(bkfp(btree));
-	if (fwrite(&bkfile(btree), sizeof(bkfile(btree)), 1, bkfp(btree)) != 1)
-		FATAL();
+	ixself(block) = snap_newfkey(btree);
 	return block;
 }
@@ -42,7 +42,24 @@
  *********************************************/
 
 /* alphabetical */
+static void addrecord(BTREE btree, RKEY rkey, RAWRECORD rec, INT len);
+static BOOLEAN append_record(BTREE btree, BLOCK old, INT lo, BOOLEAN found
+	, RKEY rkey, RAWRECORD rec, INT len);
 static void check_offset(BLOCK block, RKEY rkey, INT i);
+static BOOLEAN compact_block_cb(BTREE btree, BLOCK block, void * param);
+static INT convert_record(FILE * fo, INT slen, BOOLEAN fromzip, BOOLEAN tozip, FILE * fn);
+static RAWRECORD expand_record(BTFDSLOT * slot, BLOCK block, INT i, INT *plen);
+static INT32 live_length(BLOCK block);
+static BLOCK lookup_record(BTREE btree, const RKEY * rkey, INT *pi);
+
+/*********************************************
+ * local types
+ *********************************************/
+
+typedef struct {
+	INT pct;    /* compact blocks with at least this % dead */
+	INT count;  /* number of blocks compacted */
+} COMPACT_PARAM;
 
 /*********************************************
  * local function definitions
@@ -82,6 +99,94 @@ check_offset (BLOCK block, RKEY rkey, INT i)
 	}
 }
 
+/*=================================
+ * live_length -- Sum of lengths of records in block
+ *===============================*/
+static INT32
+live_length (BLOCK block)
+{
+	INT i;
+	INT32 live = 0;
+	for (i = 0; i < nkeys(block); i++)
+		live += lens(block, i);
+	return live;
+}
+/*=================================
+ * append_record -- Add record to end of its block file,
+ *  and rewrite only the block header to point at it
+ *  The space of any earlier version becomes dead, and is
+ *  reclaimed the next time the whole block is rewritten.
+ *  btree:  [in] btree to add record to
+ *  old:    [in] header of block (freed if successful)
+ *  lo:     [in] entry of record in block
+ *  found:  [in] is record replacing an existing entry ?
+ *  rkey, rec, len: [in] record to add
+ * returns FALSE if whole block must be rewritten instead
+ *  (block must split, or would be too fragmented)
+ *===============================*/
+static BOOLEAN
+append_record (BTREE btree, BLOCK old, INT lo, BOOLEAN found
+	, RKEY rkey, RAWRECORD rec, INT len)
+{
+	BLOCK newb;
+	FILE *fp;
+	char scratch[MAXPATHLEN];
+	INT i, n = nkeys(old);
+	INT32 datalen, live, dead;
+	long filelen;
+
+	if (bcompact(btree) <= 0)
+		return FALSE; /* appending disabled */
+	if (!found && n == NORECS - 1)
+		return FALSE; /* must split */
+	snprintf(scratch, sizeof(scratch), "%s/%s", bbasedir(btree), fkey2path(ixself(old)));
+	if (!(fp = fopen(scratch, LLREADBINARYUPDATE LLFILERANDOM)))
+		return FALSE; /* rewrite will report failure */
+	if (fseek(fp, 0, SEEK_END) || (filelen = ftell(fp)) < BUFLEN) {
+		fclose(fp);
+		return FALSE;
+	}
+
+/* check fragmentation block would have after append */
+	datalen = (INT32)(filelen - BUFLEN) + len;
+	live = live_length(old) + len;
+	if (found)
+		live -= lens(old, lo);
+	dead = datalen - live;
+	if (bcompact(btree) < 100
+		&& (double)dead * 100 > (double)datalen * bcompact(btree)) {
+		fclose(fp);
+		return FALSE;
+	}
+
+/* new header is old one, with entry lo pointing at end of file */
+	newb = allocblock();
+	memcpy(newb, old, BUFLEN);
+	if (!found) {
+		for (i = n; i > lo; i--) {
+			rkeys(newb, i) = rkeys(newb, i-1);
+			offs(newb, i) = offs(newb, i-1);
+			lens(newb, i) = lens(newb, i-1);
+		}
+		nkeys(newb) = n + 1;
+	}
+	rkeys(newb, lo) = rkey;
+	offs(newb, lo) = (INT32)(filelen - BUFLEN);
+	lens(newb, lo) = len;
+
+/* data goes out before header, so old header stays valid until then */
+	if (len)
+		CHECKED_fwrite(rec, len, 1, fp, scratch);
+	CHECKED_fflush(fp, scratch);
+	if (fseek(fp, 0, SEEK_SET))
+		FATAL();
+	CHECKED_fwrite(newb, BUFLEN, 1, fp, scratch);
+	CHECKED_fclose(fp, scratch);
+	fdpool_invalidate(btree, ixself(old));
+	putheader(btree, newb);
+	stdfree(old);
+	return TRUE;
+}
 /*=================================
  * bt_addrecord -- Add record to BTREE
  *  btree:  [in] btree to add record to
@@ -92,40 +197,40 @@ check_offset (BLOCK block, RKEY rkey, INT i)
 BOOLEAN
 bt_addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
 {
-	INDEX index;
+	ASSERT(bwrite(btree));
+	if (bbulk(btree))
+		return bulk_addrecord(bbulk(btree), rkey, rec, len);
+	if (bjournaling(btree))
+		return journal_addrecord(btree, rkey, rec, len);
+	addrecord(btree, rkey, rec, len);
+	snap_written(btree);
+	return TRUE;
+}
+/*=================================
+ * addrecord -- Put record into tree
+ *  Changes only files of the version being written
+ *  (see snapshot.c), so readers are undisturbed.
+ *  btree:  [in] btree to add record to
+ *  rkey:   [in] key of record (eg, "     I67")
+ *  record: [in] record data to add
+ *  len:    [in] record length
+ *===============================*/
+static void
+addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
+{
 	BLOCK old, newb, xtra;
-	FKEY nfkey, last = 0, parent;
+	FKEY nfkey, parent, data;
 	INT i, j, k, l, n, lo, hi;
 	BOOLEAN found = FALSE;
 	INT off = 0;
 	FILE *fo=NULL, *ft1=NULL, *ft2=NULL;
 	char scratch0[MAXPATHLEN], scratch1[MAXPATHLEN], scratch2[MAXPATHLEN];
 	char *p = rec;
+	RAWRECORD packed = NULL;
+	BOOLEAN zipped;
 
-/* search for data block that does/should hold record */
-	ASSERT(bwrite(btree));
-	ASSERT(index = bmaster(btree));
-	while (ixtype(index) == BTINDEXTYPE) {
-
-/* maintain "lazy" parent chaining in btree */
-		if (ixparent(index) != last) {
-			ASSERT(index != bmaster(btree));
-			ixparent(index) = last;
-			writeindex(btree, index);
-		}
-		last = ixself(index);
-		n = nkeys(index);
-		nfkey = fkeys(index, 0);
-		for (i = 1; i <= n; i++) {
-			if (cmpkeys(&rkey, &rkeys(index, i)) < 0)
-				break;
-			nfkey = fkeys(index, i);
-		}
-		index = getindex(btree, nfkey);
-	}
-/* have block that may hold older version of record */
-	ixparent(index) = last;
-	old = (BLOCK) index;
+/* get data block that does/should hold record, & path to it, for writing */
+	old = snap_path(btree, &rkey, &data);
 	if (!(nkeys(old) < NORECS)) {
 		char msg[256];
 		snprintf(msg, sizeof(msg),
@@ -134,6 +239,15 @@ bt_addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
 		FATAL2(msg);
 	}
 
+/* record goes in compressed, if its block holds compressed records
+   (an empty block takes the format bt_set_compress asks for) */
+	zipped = nkeys(old) ? blockzipped(btree, old) : bzip(btree);
+	if (zipped && len) {
+		packed = (RAWRECORD) stdalloc(zip_bound(len));
+		len = zip_pack(rec, len, packed);
+		rec = packed;
+	}
+
 /* see if block has earlier version of record */
 	lo = 0;
 	hi = nkeys(old) - 1;
@@ -152,11 +266,21 @@ bt_addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
 		}
 	}
 
-/* construct header for updated data block */
+/* if possible (block is already a copy), just append record
+   & update header in place */
+	if (data == ixself(old)
+		&& zipped == blockzipped(btree, old)
+		&& append_record(btree, old, lo, found, rkey, rec, len)) {
+		if (packed) stdfree(packed);
+		return;
+	}
+
+/* construct header for updated (and compacted) data block */
 	newb = allocblock();
 	ixtype(newb) = ixtype(old);
 	ixparent(newb) = ixparent(old);
 	ixself(newb) = ixself(old);
+	setblockformat(newb, zipped ? BTFMTZIP : 0);
 	n = nkeys(newb) = nkeys(old);
 
 /* put info about all records up to new one in new header */
@@ -193,7 +317,7 @@ bt_addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
 	if (!found) nkeys(newb) = n + 1;
 
 /* must rewrite data block with new record; open original and new */
-	snprintf(scratch0, sizeof(scratch0), "%s/%s", bbasedir(btree), fkey2path(ixself(old)));
+	snprintf(scratch0, sizeof(scratch0), "%s/%s", bbasedir(btree), fkey2path(data));
 	if (!(fo = fopen(scratch0, LLREADBINARY LLFILERANDOM))) {
 		char msg[sizeof(scratch0)+64];
 		snprintf(msg, sizeof(msg),
@@ -245,9 +369,11 @@ bt_addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
 	fclose(fo); /* was opened read-only */
 	snprintf(scratch0, sizeof(scratch0), "%s/tmp1", bbasedir(btree));
 	snprintf(scratch1, sizeof(scratch1), "%s/%s", bbasedir(btree), fkey2path(ixself(old)));
+	fdpool_invalidate(btree, ixself(old));
 	stdfree(old);
+	if (packed) stdfree(packed);
 	movefiles(scratch0, scratch1);
-	return TRUE;	/* return point for non-splitting case */
+	return;	/* return point for non-splitting case */
 
 /* data block must be split for new record; open second temp file */
 splitting:
@@ -281,6 +407,7 @@ splitting:
 	parent = ixparent(newb);
 	xtra = crtblock(btree);
 	ixparent(xtra) = parent;
+	setblockformat(xtra, blockformat(newb));
 	off = 0;
 	for (k = 0, l = n/2; k < n - n/2 + 1; k++, l++) {
 		rkeys(xtra, k) = rkeys(newb, l);
@@ -326,17 +453,203 @@ splitting:
 	CHECKED_fclose(ft1, scratch1);
 	CHECKED_fclose(ft2, scratch2);
 	stdfree(old);
+	if (packed) stdfree(packed);
 	snprintf(scratch1, sizeof(scratch1), "%s/tmp1", bbasedir(btree));
 	snprintf(scratch2, sizeof(scratch2), "%s/%s", bbasedir(btree), fkey2path(nfkey));
+	fdpool_invalidate(btree, nfkey);
 	movefiles(scratch1, scratch2);
 	snprintf(scratch1, sizeof(scratch1), "%s/tmp2", bbasedir(btree));
 	snprintf(scratch2, sizeof(scratch2), "%s/%s", bbasedir(btree), fkey2path(ixself(xtra)));
+	fdpool_invalidate(btree, ixself(xtra));
 	movefiles(scratch1, scratch2);
 
 /* add index of new data block to its parent (may cause more splitting) */
 	addkey(btree, parent, rkeys(xtra, 0), ixself(xtra));
+}
+/*==================================
+ * bt_compact_block -- Rewrite block file without dead space,
+ *  & with records compressed or not as bt_set_compress says
+ *  btree: [in]  database pointer
+ *  block: [I/O] header of block (may be caller's own copy);
+ *               its file key & offsets are updated to match
+ *               new file
+ * The block is written as a copy, if it is published (see
+ *  snapshot.c); the cached header is updated too.
+ *================================*/
+void
+bt_compact_block (BTREE btree, BLOCK block)
+{
+	char scratch0[MAXPATHLEN], scratch1[MAXPATHLEN];
+	FILE *fo, *fn;
+	BLOCK newb, cur, src;
+	RKEY rkey;
+	FKEY data;
+	INT i, n;
+	INT32 off = 0;
+	BOOLEAN fromzip;
+
+	ASSERT(bwrite(btree));
+	ASSERT(ixtype(block) == BTBLOCKTYPE);
+	if (nkeys(block))
+		rkey = rkeys(block, 0);
+	else
+		RKEY_INIT(rkey);
+	cur = snap_path(btree, &rkey, &data);
+	/* caller's header (which may hold fixes) describes data if same file */
+	src = (data == ixself(block)) ? block : cur;
+	n = nkeys(src);
+	fromzip = blockzipped(btree, src);
+	newb = allocblock();
+	memcpy(newb, src, BUFLEN);
+	ixself(newb) = ixself(cur);
+	ixparent(newb) = ixparent(cur);
+	setblockformat(newb, bzip(btree) ? BTFMTZIP : 0);
+
+	snprintf(scratch0, sizeof(scratch0), "%s/%s", bbasedir(btree), fkey2path(data));
+	if (!(fo = fopen(scratch0, LLREADBINARY LLFILERANDOM))) {
+		char msg[sizeof(scratch0)+64];
+		snprintf(msg, sizeof(msg), "Corrupt db -- failed to open blockfile: %s", scratch0);
+		FATAL2(msg);
+	}
+	snprintf(scratch1, sizeof(scratch1), "%s/tmp1", bbasedir(btree));
+	if (!(fn = fopen(scratch1, LLWRITEBINARY LLFILETEMP LLFILERANDOM))) {
+		char msg[sizeof(scratch1)+64];
+		snprintf(msg, sizeof(msg), "Corrupt db -- failed to open temp blockfile: %s", scratch1);
+		FATAL2(msg);
+	}
+	/* header is written again once record lengths are known */
+	ASSERT(fwrite(newb, BUFLEN, 1, fn) == 1);
+	for (i = 0; i < n; i++) {
+		if (fseek(fo, (long)(offs(src, i) + BUFLEN), 0))
+			FATAL();
+		offs(newb, i) = off;
+		if (fromzip == bzip(btree) || !lens(src, i))
+			filecopy(fo, lens(src, i), fn);
+		else
+			lens(newb, i) = convert_record(fo, lens(src, i), fromzip, bzip(btree), fn);
+		off += lens(newb, i);
+	}
+	ASSERT(fseek(fn, 0, SEEK_SET) == 0);
+	ASSERT(fwrite(newb, BUFLEN, 1, fn) == 1);
+	CHECKED_fclose(fn, scratch1);
+	fclose(fo); /* was opened read-only */
+	snprintf(scratch0, sizeof(scratch0), "%s/%s", bbasedir(btree), fkey2path(ixself(cur)));
+	fdpool_invalidate(btree, ixself(cur));
+	movefiles(scratch1, scratch0);
+
+	memcpy(block, newb, BUFLEN);
+	if (cur != block)
+		memcpy(cur, newb, BUFLEN);
+	stdfree(newb);
+	snap_written(btree);
+}
+/*==================================
+ * convert_record -- Copy record between files, compressing
+ *  or expanding it on the way
+ *  fo:      [in]  file positioned at record
+ *  slen:    [in]  length of record as stored there
+ *  fromzip: [in]  is it compressed there ?
+ *  tozip:   [in]  is it to be compressed in new file ?
+ *  fn:      [in]  file to add record to
+ * returns length of record as stored in new file
+ *================================*/
+static INT
+convert_record (FILE * fo, INT slen, BOOLEAN fromzip, BOOLEAN tozip, FILE * fn)
+{
+	char * stored = (char *) stdalloc(slen);
+	char * raw = stored, * out;
+	INT len = slen, outlen;
+
+	ASSERT(fread(stored, slen, 1, fo) == 1);
+	if (fromzip) {
+		if ((len = zip_rawlen(stored, slen)) < 0)
+			FATAL2("Bad compressed record in blockfile");
+		raw = (char *) stdalloc(len + 1);
+		if (!zip_unpack(stored, slen, raw))
+			FATAL2("Bad compressed record in blockfile");
+	}
+	out = raw;
+	outlen = len;
+	if (tozip && len) {
+		out = (char *) stdalloc(zip_bound(len));
+		outlen = zip_pack(raw, len, out);
+	}
+	if (outlen)
+		ASSERT(fwrite(out, outlen, 1, fn) == 1);
+	if (out != raw) stdfree(out);
+	if (raw != stored) stdfree(raw);
+	stdfree(stored);
+	return outlen;
+}
+/*==================================
+ * compact_block_cb -- Compact block if fragmented enough
+ *  callback for traverse_index_blocks from bt_compact
+ *================================*/
+static BOOLEAN
+compact_block_cb (BTREE btree, BLOCK block, void * param)
+{
+	COMPACT_PARAM * cparam = (COMPACT_PARAM *)param;
+	char scratch[MAXPATHLEN];
+	struct stat sbuf;
+	INT32 datalen, dead;
+
+	if (nkeys(block) && (blockzipped(btree, block) ? TRUE : FALSE) != bzip(btree)) {
+		/* records not stored as bt_set_compress says */
+		bt_compact_block(btree, block);
+		++cparam->count;
+		return TRUE;
+	}
+	snprintf(scratch, sizeof(scratch), "%s/%s", bbasedir(btree), fkey2path(ixself(block)));
+	if (stat(scratch, &sbuf) != 0 || sbuf.st_size < BUFLEN)
+		return TRUE;
+	datalen = (INT32)(sbuf.st_size - BUFLEN);
+	dead = datalen - live_length(block);
+	if (dead <= 0)
+		return TRUE;
+	if ((double)dead * 100 < (double)datalen * cparam->pct)
+		return TRUE;
+	bt_compact_block(btree, block);
+	++cparam->count;
 	return TRUE;
 }
+/*==================================
+ * bt_compact -- Compact fragmented block files of btree
+ *  Also rewrites blocks whose records are not compressed (or
+ *  are) as bt_set_compress says they should be.
+ *  btree: [in]  database pointer
+ *  pct:   [in]  only compact blocks with at least this
+ *               percentage of dead space (0 for any)
+ * returns number of block files rewritten
+ *================================*/
+INT
+bt_compact (BTREE btree, INT pct)
+{
+	COMPACT_PARAM param;
+	INDEX master;
+	param.pct = pct;
+	param.count = 0;
+	ASSERT(bwrite(btree));
+	/* traverse tree as it was, while its blocks are replaced by copies */
+	bt_begin_group(btree);
+	master = (INDEX) stdalloc(BUFLEN);
+	memcpy(master, bmaster(btree), BUFLEN);
+	traverse_index_blocks(btree, master, &param, NULL, compact_block_cb);
+	stdfree(master);
+	bt_commit_group(btree);
+	return param.count;
+}
+/*==================================
+ * bt_set_compact_threshold -- Set fragmentation allowed in
+ *  block files before bt_addrecord compacts them
+ *  pct: [in]  percent of dead space allowed;
+ *             0 rewrites block on every update,
+ *             100 or more never compacts automatically
+ *================================*/
+void
+bt_set_compact_threshold (BTREE btree, INT pct)
+{
+	bcompact(btree) = (pct < 0) ? 0 : pct;
+}
 /*==================================
  * readrec -- read record from block
  *  btree: [in]  database pointer
@@ -347,85 +660,138 @@ splitting:
 RAWRECORD
 readrec (BTREE btree, BLOCK block, INT i, INT *plen)
 {
-	char scratch[MAXPATHLEN];
-	FILE *fd=NULL;
+	BTFDSLOT * slot;
 	RAWRECORD rawrec;
 	INT len;
 
-	snprintf(scratch, sizeof(scratch)
-		, "%s%c%s"
-		, bbasedir(btree), LLCHRDIRSEPARATOR, fkey2path(ixself(block)));
-	if (!(fd = fopen(scratch, LLREADBINARY LLFILERANDOM))) {
+	if (!(slot = fdpool_get(btree, ixself(block)))) {
+		char scratch[MAXPATHLEN];
 		char msg[sizeof(scratch)+64];
-		snprintf( msg, sizeof(scratch)+64
+		snprintf(scratch, sizeof(scratch)
+			, "%s%c%s"
+			, bbasedir(btree), LLCHRDIRSEPARATOR, fkey2path(ixself(block)));
+		snprintf( msg, sizeof(msg)
                         , _("Failed (errno=%d) to open blockfile (rkey=%s): %s")
 			, errno, rkey2str(rkeys(block, i)), scratch);
 		FATAL2(msg);
 	}
-	if (fseek(fd, (long)(offs(block, i) + BUFLEN), 0)) {
-		char msg[sizeof(scratch)+64];
-		snprintf( msg, sizeof(scratch)+64
-                        , "Seek to offset (" FMT_INT32 ") failed for blockfile (rkey=%s)"
-			, offs(block,i), rkey2str(rkeys(block, i)));
-		FATAL2(msg);
-	}
 	if ((len = lens(block, i)) == 0) {
 		*plen = 0;
-		fclose(fd); /* readonly */
 		return NULL;
 	}
 	if (len < 0) {
-		char msg[sizeof(scratch)+64];
-		snprintf( msg, sizeof(scratch)+64
+		char msg[MAXPATHLEN+64];
+		snprintf( msg, sizeof(msg)
                         , "Bad len (" FMT_INT ") for blockfile (rkey=%s)"
 			, len, rkey2str(rkeys(block, i)));
 		FATAL2(msg);
 	}
+	if (blockzipped(btree, block)) {
+		if (!(rawrec = expand_record(slot, block, i, plen))) {
+			char msg[MAXPATHLEN+64];
+			snprintf( msg, sizeof(msg)
+				, "Bad compressed record (rkey=%s) in blockfile %s"
+				, rkey2str(rkeys(block, i)), fkey2path(ixself(block)));
+			FATAL2(msg);
+		}
+		return rawrec;
+	}
 	rawrec = (RAWRECORD) stdalloc(len + 1);
-	if (!(fread(rawrec, len, 1, fd) == 1)) {
-		char msg[sizeof(scratch)+64];
-		snprintf( msg, sizeof(scratch)+64
-                        , "Read for " FMT_INT " bytes failed for blockfile (rkey=%s)"
-			, len, rkey2str(rkeys(block, i)));
+	if (fdpool_read(slot, rawrec, len, offs(block, i) + BUFLEN) != len) {
+		char msg[MAXPATHLEN+64];
+		snprintf( msg, sizeof(msg)
+                        , "Read for " FMT_INT " bytes at offset (" FMT_INT32 ") failed for blockfile (rkey=%s)"
+			, len, offs(block, i), rkey2str(rkeys(block, i)));
 		FATAL2(msg);
 	}
-	fclose(fd); /* readonly */
 	rawrec[len] = 0;
 	*plen = len;
 	return rawrec;
 }
+/*==================================
+ * expand_record -- Read & expand compressed record
+ *  slot:  [in]  pooled file of block
+ *  block: [in]  header of block (with compressed records)
+ *  i:     [in]  index of record in block (with len > 0)
+ *  plen:  [out] length of returned record
+ * returns record, or NULL if it could not be read or expanded
+ *================================*/
+static RAWRECORD
+expand_record (BTFDSLOT * slot, BLOCK block, INT i, INT *plen)
+{
+	INT slen = lens(block, i), len;
+	INT32 off = offs(block, i) + BUFLEN;
+	CNSTRING stored = fdpool_view(slot, slen, off);
+	char * buf = NULL;
+	RAWRECORD rawrec = NULL;
+
+	if (!stored) {
+		buf = (char *) stdalloc(slen);
+		if (fdpool_read(slot, buf, slen, off) != slen)
+			goto done;
+		stored = buf;
+	}
+	if ((len = zip_rawlen(stored, slen)) < 0)
+		goto done;
+	rawrec = (RAWRECORD) stdalloc(len + 1);
+	if (!zip_unpack(stored, slen, rawrec)) {
+		stdfree(rawrec);
+		rawrec = NULL;
+		goto done;
+	}
+	rawrec[len] = 0;
+	*plen = len;
+done:
+	if (buf) stdfree(buf);
+	return rawrec;
+}
+/*==================================
+ * bt_check_block_records -- Count records of block which
+ *  cannot be read (compressed records which do not expand)
+ *  btree: [in]  database pointer
+ *  block: [in]  header of block
+ *================================*/
+INT
+bt_check_block_records (BTREE btree, BLOCK block)
+{
+	BTFDSLOT * slot;
+	INT i, len, bad = 0;
+	RAWRECORD rawrec;
+
+	if (!blockzipped(btree, block))
+		return 0;
+	if (!(slot = fdpool_get(btree, ixself(block))))
+		return nkeys(block);
+	for (i = 0; i < nkeys(block); i++) {
+		if (lens(block, i) <= 0)
+			continue;
+		if ((rawrec = expand_record(slot, block, i, &len)) != NULL)
+			stdfree(rawrec);
+		else
+			++bad;
+	}
+	return bad;
+}
 /*===================================
- * bt_getrecord -- Get record from BTREE
- * (ignore deleted records)
+ * lookup_record -- Find block & entry holding record
  *  btree: [in]  database pointer
  *  rkey:  [in]  key to data (eg, "    I313")
- *  plen:  [out] length of returned data
+ *  pi:    [out] index of record in block
+ * returns block (from index cache), or NULL if no such record
  *=================================*/
-RAWRECORD
-bt_getrecord (BTREE btree, const RKEY * rkey, INT *plen)
+static BLOCK
+lookup_record (BTREE btree, const RKEY * rkey, INT *pi)
 {
 	INDEX index;
-	INT i, n, lo, hi;
+	INT lo, hi;
 	FKEY nfkey;
 	BLOCK block;
-	BOOLEAN found = FALSE;
-	RAWRECORD rawrec;
 
-#ifdef DEBUG
-	llwprintf("GETRECORD: rkey: %s\n", rkey2str(*rkey));
-#endif
-	*plen = 0;
 	ASSERT(index = bmaster(btree));
 
 /* search for data block that does/should hold record */
 	while (ixtype(index) == BTINDEXTYPE) {
-		n = nkeys(index);
-		nfkey = fkeys(index, 0);
-		for (i = 1; i <= n; i++) {
-			if (cmpkeys(rkey, &rkeys(index, i)) < 0)
-				break;
-			nfkey = fkeys(index, i);
-		}
+		nfkey = fkeys(index, findslot(index, rkey));
 		index = getindex(btree, nfkey);
 		/* should never revisit the master node */
 		if (ixself(index) == ixself(bmaster(btree))) {
@@ -447,20 +813,95 @@ bt_getrecord (BTREE btree, const RKEY * rkey, INT *plen)
 		else if (rel > 0)
 			lo = ++md;
 		else {
-			found = TRUE;
-			lo = md;
-			break;
+			*pi = md;
+			return block;
 		}
 	}
-	if (!found) return NULL;
+	return NULL;
+}
+/*===================================
+ * readlatest -- Get copy of latest version of record
+ *  from bulk buffer, pending group, or tree
+ *  (as readrec, so DELE records are returned)
+ *  btree: [in]  database pointer
+ *  rkey:  [in]  key to data
+ *  plen:  [out] length of returned data
+ * returns NULL if no such record
+ *=================================*/
+RAWRECORD
+readlatest (BTREE btree, const RKEY * rkey, INT *plen)
+{
+	BLOCK block;
+	INT i=0;
+
+	*plen = 0;
+	if (bbulk(btree))
+		return bulk_getrecord(bbulk(btree), rkey, plen);
+	if (journal_pending(btree, rkey))
+		return journal_getrecord(btree, rkey, plen);
+	if (!(block = lookup_record(btree, rkey, &i)))
+		return NULL;
+	return readrec(btree, block, i, plen);
+}
+/*===================================
+ * bt_getrecord -- Get record from BTREE
+ * (ignore deleted records)
+ *  btree: [in]  database pointer
+ *  rkey:  [in]  key to data (eg, "    I313")
+ *  plen:  [out] length of returned data
+ *=================================*/
+RAWRECORD
+bt_getrecord (BTREE btree, const RKEY * rkey, INT *plen)
+{
+	RAWRECORD rawrec;
 
-	rawrec = readrec(btree, block, lo, plen);
+#ifdef DEBUG
+	llwprintf("GETRECORD: rkey: %s\n", rkey2str(*rkey));
+#endif
+	rawrec = readlatest(btree, rkey, plen);
 	if (rawrec && !strcmp(rawrec, "DELE\n")) {
 		stdfree(rawrec);
 		rawrec=NULL;
 	}
 	return rawrec;
 }
+/*===================================
+ * bt_getrecord_view -- Get read-only view of record in BTREE
+ * (ignore deleted records)
+ *  btree: [in]  database pointer
+ *  rkey:  [in]  key to data (eg, "    I313")
+ *  plen:  [out] length of returned data
+ * Only available for memory mapped (non-writable) btrees,
+ *  & records not compressed (see compress.c);
+ *  returns NULL otherwise, so caller should fall back to
+ *  bt_getrecord. The view is not zero-terminated, must not
+ *  be modified or freed, and is only valid until the next
+ *  call into the btree.
+ *=================================*/
+CNSTRING
+bt_getrecord_view (BTREE btree, const RKEY * rkey, INT *plen)
+{
+	BLOCK block;
+	BTFDSLOT * slot;
+	CNSTRING view;
+	INT i=0, len;
+
+	*plen = 0;
+	if (!bmapped(btree))
+		return NULL;
+	if (!(block = lookup_record(btree, rkey, &i)))
+		return NULL;
+	if ((len = lens(block, i)) <= 0 || blockzipped(btree, block))
+		return NULL;
+	if (!(slot = fdpool_get(btree, ixself(block))))
+		return NULL;
+	if (!(view = fdpool_view(slot, len, offs(block, i) + BUFLEN)))
+		return NULL;
+	if (len == 5 && !strncmp(view, "DELE\n", 5))
+		return NULL;
+	*plen = len;
+	return view;
+}
 /*====================================================
  * isrecord -- See if there is a record with given key
  *==================================================*/
@@ -469,20 +910,19 @@ isrecord (BTREE btree,
           RKEY rkey)
 {
 	INDEX index;
-	INT i, n, lo, hi;
+	INT lo, hi;
 	FKEY nfkey;
 	BLOCK block;
 
+	if (bbulk(btree))
+		return bulk_isrecord(bbulk(btree), rkey);
+	if (journal_pending(btree, &rkey))
+		return TRUE;
+
 /* search for data block that does/should hold record */
 	ASSERT(index = bmaster(btree));
 	while (ixtype(index) == BTINDEXTYPE) {
-		n = nkeys(index);
-		nfkey = fkeys(index, 0);
-		for (i = 1; i <= n; i++) {
-			if (cmpkeys(&rkey, &rkeys(index, i)) < 0)
-				break;
-			nfkey = fkeys(index, i);
-		}
+		nfkey = fkeys(index, findslot(index, &rkey));
 		index = getindex(btree, nfkey);
 	}
 
@@ -6,6 +6,148 @@
 
 #include "btree.h"
 
+/*=======================================
+ * BTFDPOOL -- LRU pool of open (read-only)
+ *  block file descriptors, owned by BTREE
+ *=====================================*/
+#define BTFDPOOL_SIZE 16
+typedef struct tag_btfdslot {
+	FKEY    s_fkey;      /* block file held open */
+	int     s_fd;        /* descriptor, -1 if slot unused */
+	INT     s_used;      /* clock value at last use (for LRU) */
+	char   *s_map;       /* read-only mapping of file, or NULL */
+	INT     s_maplen;    /* length of mapping */
+} BTFDSLOT;
+typedef struct tag_btfdpool {
+	INT       p_nslots;  /* capacity of pool */
+	BTFDSLOT *p_slots;   /* array of p_nslots slots */
+	INT       p_clock;   /* incremented on each use */
+	INT       p_hits;    /* reads served by pooled descriptor */
+	INT       p_misses;  /* reads which had to open file */
+	BOOLEAN   p_mapped;  /* files are memory mapped (read-only btree) */
+} *BTFDPOOL;
+#define bmapped(b)  (bfdpool(b) && bfdpool(b)->p_mapped)
+
+/*=======================================
+ * BTCACHE -- INDEX/BLOCK header cache,
+ *  hashed by FKEY, with LRU eviction
+ *=====================================*/
+#define BTCACHE_DEFAULT_SIZE 256
+typedef struct tag_btcacheent {
+	INDEX   e_index;               /* cached INDEX or BLOCK header */
+	struct tag_btcacheent *e_hnext; /* hash chain (or free list) */
+	struct tag_btcacheent *e_prev;  /* more recently used */
+	struct tag_btcacheent *e_next;  /* less recently used */
+} BTCACHEENT;
+typedef struct tag_btcache {
+	INT          c_max;       /* capacity */
+	INT          c_count;     /* entries in use */
+	INT          c_nbuckets;  /* hash size (power of 2) */
+	BTCACHEENT **c_buckets;   /* hash table */
+	BTCACHEENT  *c_entries;   /* array of c_max entries */
+	BTCACHEENT  *c_free;      /* unused entries */
+	BTCACHEENT  *c_head;      /* most recently used */
+	BTCACHEENT  *c_tail;      /* least recently used */
+	INT          c_hits;
+	INT          c_misses;
+	INT          c_evictions;
+} *BTCACHE;
+
+/*=======================================
+ * BTBULK -- Records buffered for bulk load
+ *  (see bulk.c), owned by BTREE
+ *=====================================*/
+typedef struct tag_btbulkent {
+	RKEY    e_rkey;      /* record key */
+	long    e_off;       /* offset of data in spill file */
+	INT     e_len;       /* length of data */
+} BTBULKENT;
+typedef struct tag_btbulk {
+	FILE      *u_fp;         /* spill file holding record data */
+	char       u_path[MAXPATHLEN];
+	long       u_end;        /* length of spill file */
+	BTBULKENT *u_ents;       /* buffered records */
+	INT        u_count;
+	INT        u_max;
+	INT       *u_hash;       /* open addressing, entry index+1 or 0 */
+	INT        u_nbuckets;   /* power of 2 */
+} *BTBULK;
+
+/*=======================================
+ * FKEYSET -- Set of file keys (see journal.c)
+ *=====================================*/
+typedef struct {
+	FKEY      *fkeys;        /* members, in order added */
+	INT        count;
+	INT        max;
+	INT       *hash;         /* open addressing, index+1 or 0 */
+	INT        nbuckets;     /* power of 2 */
+} FKEYSET;
+
+/*=======================================
+ * BTJOURNAL -- Write-ahead journal of record
+ *  writes (see journal.c), owned by BTREE
+ *=====================================*/
+typedef struct tag_btjournal {
+	FILE      *j_fp;         /* journal file */
+	char       j_path[MAXPATHLEN];
+	BTBULK     j_pending;    /* records of uncommitted group (data in journal) */
+	INT32      j_sum;        /* checksum of uncommitted group */
+	BOOLEAN    j_applying;   /* committed records going into tree */
+	FKEYSET    j_files;      /* files imaged or created since checkpoint */
+	INT        j_commits;    /* groups committed */
+	INT        j_syncs;      /* journal & checkpoint syncs */
+} *BTJOURNAL;
+#define bjournaling(b) (bjournal(b) && !bjournal(b)->j_applying)
+
+/*=======================================
+ * BTSNAP -- Files created & freed by writer
+ *  since versions were published (see
+ *  snapshot.c), owned by BTREE
+ *=====================================*/
+typedef struct tag_btfreed {
+	FKEY       f_fkey;       /* file no longer in tree */
+	INT32      f_born;       /* first version holding it (-1 if unpublished) */
+	INT32      f_gone;       /* first version not holding it */
+	BOOLEAN    f_held;       /* needed by journal recovery until checkpoint */
+} BTFREED;
+typedef struct tag_btborn {
+	FKEY       b_fkey;
+	INT32      b_version;    /* version file was published in */
+} BTBORN;
+typedef struct tag_btsnap {
+	FKEYSET    s_fresh;      /* files created since last publish */
+	BTFREED   *s_freed;      /* files to remove once no reader needs them */
+	INT        s_nfreed;
+	INT        s_maxfreed;
+	INT        s_npublished; /* leading entries of s_freed with f_gone set */
+	FKEY      *s_reuse;      /* file keys of removed files, for reuse */
+	INT        s_nreuse;
+	INT        s_maxreuse;
+	BTBORN    *s_born;       /* open addressing, b_fkey -1 if empty */
+	INT        s_nborn;
+	INT        s_nbuckets;   /* power of 2 */
+	INT        s_depth;      /* nesting of open groups */
+	INT        s_holds;      /* traversals reading files directly */
+	INT        s_writes;     /* writes made, so cursors see change */
+	BOOLEAN    s_dirty;      /* tree changed since last publish */
+	BOOLEAN    s_sweep;      /* look for files left by crashed writer */
+} *BTSNAP;
+
+/*=======================================
+ * Byte ranges of lock file (see lock.c)
+ *=====================================*/
+#define BTLOCK_WRITER   0   /* held by writer */
+#define BTLOCK_SWAP     1   /* keyfile being published (or read) */
+#define BTLOCK_VERSIONS 16  /* + version, held by its readers */
+
+/*=======================================
+ * Default percentage of dead space (left by
+ *  records updated in place) allowed in a block
+ *  file before bt_addrecord compacts it
+ *=====================================*/
+#define BTCOMPACT_DEFAULT_PCT 50
+
 /* addkey.c */ 
 void addkey(BTREE, FKEY, RKEY, FKEY);
 
@@ -14,18 +156,85 @@ BLOCK crtblock(BTREE);
 BLOCK allocblock(void);
 
 /* btree.c */
+RAWRECORD readlatest(BTREE btree, const RKEY * rkey, INT *plen);
 RAWRECORD readrec(BTREE btree, BLOCK block, INT i, INT *plen);
 
+/* bulk.c */
+BOOLEAN bulk_addrecord(BTBULK bulk, RKEY rkey, RAWRECORD rec, INT len);
+BTBULK bulk_create(FILE * fp, CNSTRING path, long end);
+void bulk_free(BTBULK bulk);
+RAWRECORD bulk_getrecord(BTBULK bulk, const RKEY * rkey, INT *plen);
+BOOLEAN bulk_isrecord(BTBULK bulk, RKEY rkey);
+void bulk_putentry(BTBULK bulk, RKEY rkey, long off, INT len);
+void bulk_sort(BTBULK bulk);
+void bulk_traverse(BTBULK bulk, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYKEY func, void * param);
+
+/* compress.c */
+INT zip_bound(INT len);
+INT zip_pack(CNSTRING rec, INT len, char * dst);
+INT zip_rawlen(CNSTRING src, INT slen);
+BOOLEAN zip_unpack(CNSTRING src, INT slen, char * dst);
+
+/* fdpool.c */
+BTFDPOOL fdpool_create(INT n, BOOLEAN mapped);
+void fdpool_free(BTFDPOOL pool);
+BTFDSLOT * fdpool_get(BTREE btree, FKEY fkey);
+void fdpool_prefetch(BTREE btree, FKEY fkey);
+INT fdpool_read(BTFDSLOT * slot, void * buf, INT len, INT32 off);
+CNSTRING fdpool_view(BTFDSLOT * slot, INT len, INT32 off);
+
 /* index.c */
+INDEX cachedindex(BTREE, FKEY);
 INDEX crtindex(BTREE);
+INT findslot(INDEX, const RKEY *);
 void freecache(BTREE);
 INDEX getindex(BTREE, FKEY);
 void initcache(BTREE, INT);
+void purgecache(BTREE);
+void resizecache(BTREE, INT);
 void putheader(BTREE, BLOCK);
 void putindex(BTREE, INDEX);
+void uncacheindex(BTREE, FKEY);
 void writeindex(BTREE, INDEX);
 
+/* journal.c */
+BOOLEAN fkeyset_add(FKEYSET * set, FKEY fkey);
+void fkeyset_clear(FKEYSET * set);
+BOOLEAN fkeyset_has(FKEYSET * set, FKEY fkey);
+BOOLEAN journal_addrecord(BTREE btree, RKEY rkey, RAWRECORD rec, INT len);
+void journal_checkpoint(BTREE btree);
+void journal_close(BTREE btree);
+void journal_commit(BTREE btree);
+RAWRECORD journal_getrecord(BTREE btree, const RKEY * rkey, INT *plen);
+void journal_newfile(BTREE btree, FKEY fkey);
+BOOLEAN journal_open(BTREE btree);
+BOOLEAN journal_pending(BTREE btree, const RKEY * rkey);
+RKEY * journal_pendingkeys(BTREE btree, RKEY lo, RKEY hi, INT * pcount);
+void journal_restore(CNSTRING dir, KEYFILE1 * kfile1);
+
+/* lock.c */
+void lockfile_close(int fd);
+BOOLEAN lockfile_busy(int fd, long off, long len);
+BOOLEAN lockfile_lock(int fd, long off, long len, BOOLEAN excl, BOOLEAN wait);
+int lockfile_open(CNSTRING dir);
+void lockfile_unlock(int fd, long off, long len);
+
+/* opnbtree.c */
+void write_keyfile(BTREE btree);
+
+/* snapshot.c */
+void snap_checkpointed(BTREE btree);
+void snap_close(BTREE btree);
+void snap_freefile(BTREE btree, FKEY fkey);
+void snap_hold(BTREE btree, BOOLEAN on);
+FKEY snap_newfkey(BTREE btree);
+void snap_open(BTREE btree, BOOLEAN crashed);
+BLOCK snap_path(BTREE btree, const RKEY * rkey, FKEY * pdata);
+void snap_publish(BTREE btree);
+void snap_written(BTREE btree);
+
 /* utils.c */
+FKEY fkey_after(FKEY fkey);
 void newmaster(BTREE, INDEX);
 FKEY path2fkey(STRING);
 void nextfkey(BTREE);
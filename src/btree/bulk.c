@@ -0,0 +1,559 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * bulk.c -- Bulk loading of a BTREE
+ *  Between bt_bulk_begin and bt_bulk_end, records added are
+ *  not put into the tree, but buffered: their data goes to a
+ *  spill file, and their keys into a hashed table in memory.
+ *  Reads & traversals are served from the buffer meanwhile.
+ *  bt_bulk_end sorts the buffered records, and writes fully
+ *  packed blocks, then the indices above them, in one pass;
+ *  the new tree then replaces the old one.
+ *  Meant for filling an empty (or nearly empty) database, as
+ *  any records already present are also pulled into memory.
+ *===========================================================*/
+
+#include "sys_inc.h"
+#include "llstdlib.h"
+#include "btreei.h"
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* file keys of the old tree, to be removed once replaced */
+typedef struct {
+	FKEY *fkeys;
+	INT count;
+	INT max;
+} OLDFILES;
+
+#define BULK_MAXLEVELS 16
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static BOOLEAN add_oldfile(OLDFILES * old, FKEY fkey);
+static int cmp_bulkents(const void * el1, const void * el2);
+static BTBULKENT * find_entry(BTBULK bulk, const RKEY * rkey);
+static void free_bulk(BTBULK bulk);
+static INT hash_rkey(BTBULK bulk, const RKEY * rkey);
+static BOOLEAN load_record(RKEY rkey, STRING data, INT len, void * param);
+static BOOLEAN note_oldblock(BTREE btree, BLOCK block, void * param);
+static BOOLEAN note_oldindex(BTREE btree, INDEX index, void * param);
+static void read_data(BTBULK bulk, BTBULKENT * ent, char * buf);
+static void rehash(BTBULK bulk, INT nbuckets);
+static void set_child(INDEX index, INT slot, RKEY rkey, FKEY fkey);
+static BLOCK write_block(BTREE btree, INT first, INT n, FKEY parent);
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * bt_bulk_begin -- Start buffering records for bulk load
+ *  Any records already in the btree are read into the buffer,
+ *  as the whole tree is rebuilt by bt_bulk_end.
+ * returns FALSE if btree is not writable, or already bulk loading
+ *============================================*/
+BOOLEAN
+bt_bulk_begin (BTREE btree)
+{
+	BTBULK bulk;
+	RKEY lo, hi;
+	char path[MAXPATHLEN];
+	FILE *fp;
+
+	if (!bwrite(btree) || bbulk(btree))
+		return FALSE;
+	snprintf(path, sizeof(path), "%s/tmpbulk", bbasedir(btree));
+	if (!(fp = fopen(path, LLWRITEBINARY "+" LLFILETEMP)))
+		return FALSE;
+	/* tree is about to be replaced wholesale, so journal must be empty */
+	if (bjournal(btree))
+		journal_checkpoint(btree);
+	bulk = bulk_create(fp, path, 0);
+
+	/* pull in whatever is in the tree now */
+	lo.r_rkey[0] = 0;
+	hi.r_rkey[0] = 0;
+	traverse_db_rec_rkeys(btree, lo, hi, load_record, bulk);
+	bbulk(btree) = bulk;
+	return TRUE;
+}
+/*==============================================
+ * load_record -- Copy existing record into buffer
+ *  callback for traverse_db_rec_rkeys from bt_bulk_begin
+ *============================================*/
+static BOOLEAN
+load_record (RKEY rkey, STRING data, INT len, void * param)
+{
+	BTBULK bulk = (BTBULK) param;
+	bulk_addrecord(bulk, rkey, data, len);
+	if (data)
+		stdfree(data);
+	return TRUE;
+}
+/*==============================================
+ * bulk_create -- Create empty record buffer
+ *  fp:   [IN]  open file to hold record data (owned by caller)
+ *  path: [IN]  name of that file (for messages)
+ *  end:  [IN]  offset at which to start appending data
+ *============================================*/
+BTBULK
+bulk_create (FILE * fp, CNSTRING path, long end)
+{
+	BTBULK bulk = (BTBULK) stdalloc(sizeof(*bulk));
+	memset(bulk, 0, sizeof(*bulk));
+	bulk->u_fp = fp;
+	llstrncpy(bulk->u_path, path, sizeof(bulk->u_path), 0);
+	bulk->u_end = end;
+	bulk->u_max = 1024;
+	bulk->u_ents = (BTBULKENT *) stdalloc(bulk->u_max * sizeof(BTBULKENT));
+	rehash(bulk, 2048);
+	return bulk;
+}
+/*==============================================
+ * bulk_free -- Free record buffer
+ *  (its file is left to the caller)
+ *============================================*/
+void
+bulk_free (BTBULK bulk)
+{
+	stdfree(bulk->u_ents);
+	stdfree(bulk->u_hash);
+	stdfree(bulk);
+}
+/*==============================================
+ * hash_rkey -- Pick first hash bucket for record key
+ *============================================*/
+static INT
+hash_rkey (BTBULK bulk, const RKEY * rkey)
+{
+	unsigned int h = 2166136261U;
+	INT i;
+	for (i = 0; i < RKEYLEN; i++)
+		h = (h ^ (unsigned char)rkey->r_rkey[i]) * 16777619U;
+	return (INT)(h & (bulk->u_nbuckets - 1));
+}
+/*==============================================
+ * rehash -- Rebuild hash of buffered entries
+ *  nbuckets: [IN]  new size (power of 2)
+ *============================================*/
+static void
+rehash (BTBULK bulk, INT nbuckets)
+{
+	INT i;
+	if (bulk->u_hash)
+		stdfree(bulk->u_hash);
+	bulk->u_nbuckets = nbuckets;
+	bulk->u_hash = (INT *) stdalloc(nbuckets * sizeof(INT));
+	for (i = 0; i < nbuckets; i++)
+		bulk->u_hash[i] = 0;
+	for (i = 0; i < bulk->u_count; i++) {
+		INT h = hash_rkey(bulk, &bulk->u_ents[i].e_rkey);
+		while (bulk->u_hash[h])
+			h = (h + 1) & (nbuckets - 1);
+		bulk->u_hash[h] = i + 1;
+	}
+}
+/*==============================================
+ * find_entry -- Find buffered entry for record key, or NULL
+ *============================================*/
+static BTBULKENT *
+find_entry (BTBULK bulk, const RKEY * rkey)
+{
+	INT h = hash_rkey(bulk, rkey);
+	INT j;
+	while ((j = bulk->u_hash[h]) != 0) {
+		BTBULKENT * ent = &bulk->u_ents[j-1];
+		if (!cmpkeys(rkey, &ent->e_rkey))
+			return ent;
+		h = (h + 1) & (bulk->u_nbuckets - 1);
+	}
+	return NULL;
+}
+/*==============================================
+ * bulk_putentry -- Point buffer entry for key at data
+ *  off:  [IN]  offset of data already in buffer's file
+ *  len:  [IN]  length of data
+ *  Adds entry if key is new, else replaces (space of any
+ *  earlier version is simply abandoned).
+ *============================================*/
+void
+bulk_putentry (BTBULK bulk, RKEY rkey, long off, INT len)
+{
+	BTBULKENT * ent = find_entry(bulk, &rkey);
+
+	if (!ent) {
+		INT h;
+		if (bulk->u_count == bulk->u_max) {
+			BTBULKENT * ents;
+			bulk->u_max *= 2;
+			ents = (BTBULKENT *) stdalloc(bulk->u_max * sizeof(BTBULKENT));
+			memcpy(ents, bulk->u_ents, bulk->u_count * sizeof(BTBULKENT));
+			stdfree(bulk->u_ents);
+			bulk->u_ents = ents;
+		}
+		if (2 * (bulk->u_count + 1) > bulk->u_nbuckets)
+			rehash(bulk, 2 * bulk->u_nbuckets);
+		ent = &bulk->u_ents[bulk->u_count++];
+		ent->e_rkey = rkey;
+		h = hash_rkey(bulk, &rkey);
+		while (bulk->u_hash[h])
+			h = (h + 1) & (bulk->u_nbuckets - 1);
+		bulk->u_hash[h] = bulk->u_count;
+	}
+	ent->e_off = off;
+	ent->e_len = len;
+}
+/*==============================================
+ * bulk_addrecord -- Add (or replace) record in buffer
+ *  Data is appended to buffer's file.
+ *============================================*/
+BOOLEAN
+bulk_addrecord (BTBULK bulk, RKEY rkey, RAWRECORD rec, INT len)
+{
+	if (fseek(bulk->u_fp, bulk->u_end, SEEK_SET))
+		FATAL();
+	if (len)
+		CHECKED_fwrite(rec, len, 1, bulk->u_fp, bulk->u_path);
+	bulk_putentry(bulk, rkey, bulk->u_end, len);
+	bulk->u_end += len;
+	return TRUE;
+}
+/*==============================================
+ * read_data -- Read data of buffered record from spill file
+ *  buf: [OUT] must hold ent->e_len bytes
+ *============================================*/
+static void
+read_data (BTBULK bulk, BTBULKENT * ent, char * buf)
+{
+	if (!ent->e_len)
+		return;
+	if (fseek(bulk->u_fp, ent->e_off, SEEK_SET)
+		|| fread(buf, ent->e_len, 1, bulk->u_fp) != 1) {
+		char msg[MAXPATHLEN+64];
+		snprintf(msg, sizeof(msg), "Failed reading bulk load file: %s", bulk->u_path);
+		FATAL2(msg);
+	}
+}
+/*==============================================
+ * bulk_getrecord -- Get copy of buffered record
+ *  (as readrec, so DELE records are returned)
+ * returns NULL if no such record
+ *============================================*/
+RAWRECORD
+bulk_getrecord (BTBULK bulk, const RKEY * rkey, INT *plen)
+{
+	BTBULKENT * ent = find_entry(bulk, rkey);
+	RAWRECORD rawrec;
+	*plen = 0;
+	if (!ent || !ent->e_len)
+		return NULL;
+	rawrec = (RAWRECORD) stdalloc(ent->e_len + 1);
+	read_data(bulk, ent, rawrec);
+	rawrec[ent->e_len] = 0;
+	*plen = ent->e_len;
+	return rawrec;
+}
+/*==============================================
+ * bulk_isrecord -- Is record in buffer ?
+ *============================================*/
+BOOLEAN
+bulk_isrecord (BTBULK bulk, RKEY rkey)
+{
+	return find_entry(bulk, &rkey) != NULL;
+}
+/*==============================================
+ * cmp_bulkents -- Compare buffered entries for qsort
+ *============================================*/
+static int
+cmp_bulkents (const void * el1, const void * el2)
+{
+	const BTBULKENT * ent1 = (const BTBULKENT *)el1;
+	const BTBULKENT * ent2 = (const BTBULKENT *)el2;
+	return (int)cmpkeys(&ent1->e_rkey, &ent2->e_rkey);
+}
+/*==============================================
+ * bulk_sort -- Put buffered records in key order
+ *============================================*/
+void
+bulk_sort (BTBULK bulk)
+{
+	/* sorting moves entries, so hash must be rebuilt */
+	qsort(bulk->u_ents, bulk->u_count, sizeof(BTBULKENT), cmp_bulkents);
+	rehash(bulk, bulk->u_nbuckets);
+}
+/*==============================================
+ * bulk_traverse -- Traverse buffered records within lo..hi
+ *  same contract as traverse_db_rec_rkeys
+ *============================================*/
+void
+bulk_traverse (BTBULK bulk, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYKEY func, void * param)
+{
+	INT i;
+	bulk_sort(bulk);
+	for (i = 0; i < bulk->u_count; i++) {
+		BTBULKENT * ent = &bulk->u_ents[i];
+		RAWRECORD rawrec;
+		INT len;
+		BOOLEAN rc;
+		if (lo.r_rkey[0] && ll_strncmp(lo.r_rkey, ent->e_rkey.r_rkey, 8) >= 0)
+			continue;
+		if (hi.r_rkey[0] && ll_strncmp(hi.r_rkey, ent->e_rkey.r_rkey, 8) < 0)
+			break;
+		rawrec = bulk_getrecord(bulk, &ent->e_rkey, &len);
+		rc = (*func)(ent->e_rkey, rawrec, len, param);
+		if (rawrec)
+			stdfree(rawrec);
+		if (!rc)
+			return;
+	}
+}
+/*==============================================
+ * add_oldfile -- Remember file of old tree
+ *============================================*/
+static BOOLEAN
+add_oldfile (OLDFILES * old, FKEY fkey)
+{
+	if (old->count == old->max) {
+		FKEY * fkeys;
+		old->max = old->max ? 2 * old->max : 64;
+		fkeys = (FKEY *) stdalloc(old->max * sizeof(FKEY));
+		if (old->count)
+			memcpy(fkeys, old->fkeys, old->count * sizeof(FKEY));
+		if (old->fkeys)
+			stdfree(old->fkeys);
+		old->fkeys = fkeys;
+	}
+	old->fkeys[old->count++] = fkey;
+	return TRUE;
+}
+/*==============================================
+ * note_oldindex, note_oldblock -- Collect files of old tree
+ *  callbacks for traverse_index_blocks from bt_bulk_end
+ *============================================*/
+static BOOLEAN
+note_oldindex (BTREE btree, INDEX index, void * param)
+{
+	btree = btree; /* unused */
+	return add_oldfile((OLDFILES *)param, ixself(index));
+}
+static BOOLEAN
+note_oldblock (BTREE btree, BLOCK block, void * param)
+{
+	btree = btree; /* unused */
+	return add_oldfile((OLDFILES *)param, ixself(block));
+}
+/*==============================================
+ * set_child -- Put child into slot of new index
+ *  Slot 0 has no separating key, but the key is kept
+ *  there as the first key below the index (as addkey does).
+ *============================================*/
+static void
+set_child (INDEX index, INT slot, RKEY rkey, FKEY fkey)
+{
+	rkeys(index, slot) = rkey;
+	fkeys(index, slot) = fkey;
+	nkeys(index) = slot;
+}
+/*==============================================
+ * write_block -- Write new block holding buffered records
+ *  (compressed, if bt_set_compress says so)
+ *  first: [IN]  first (sorted) entry to go in block
+ *  n:     [IN]  number of entries
+ *  parent:[IN]  index which will point to block
+ * returns block header (caller frees)
+ *============================================*/
+static BLOCK
+write_block (BTREE btree, INT first, INT n, FKEY parent)
+{
+	BTBULK bulk = bbulk(btree);
+	BLOCK block = crtblock(btree);
+	char scratch[MAXPATHLEN];
+	char * buf = NULL, * packed = NULL;
+	INT i, buflen = 0, packlen = 0;
+	INT32 off = 0;
+	FILE *fp;
+
+	ixparent(block) = parent;
+	setblockformat(block, bzip(btree) ? BTFMTZIP : 0);
+	nkeys(block) = n;
+	for (i = 0; i < n; i++) {
+		BTBULKENT * ent = &bulk->u_ents[first + i];
+		rkeys(block, i) = ent->e_rkey;
+	}
+	snprintf(scratch, sizeof(scratch), "%s/%s", bbasedir(btree), fkey2path(ixself(block)));
+	if (!(fp = fopen(scratch, LLWRITEBINARY LLFILERANDOM))) {
+		char msg[sizeof(scratch)+64];
+		snprintf(msg, sizeof(msg), "Failed to create blockfile: %s", scratch);
+		FATAL2(msg);
+	}
+	/* header is written again once record lengths are known */
+	ASSERT(fwrite(block, BUFLEN, 1, fp) == 1);
+	for (i = 0; i < n; i++) {
+		BTBULKENT * ent = &bulk->u_ents[first + i];
+		char * out = buf;
+		INT len = ent->e_len;
+		if (len > buflen) {
+			if (buf) stdfree(buf);
+			buflen = len;
+			out = buf = (char *) stdalloc(buflen);
+		}
+		read_data(bulk, ent, buf);
+		if (bzip(btree) && len) {
+			if (zip_bound(len) > packlen) {
+				if (packed) stdfree(packed);
+				packlen = zip_bound(len);
+				packed = (char *) stdalloc(packlen);
+			}
+			len = zip_pack(buf, len, packed);
+			out = packed;
+		}
+		offs(block, i) = off;
+		lens(block, i) = len;
+		off += len;
+		if (len)
+			CHECKED_fwrite(out, len, 1, fp, scratch);
+	}
+	ASSERT(fseek(fp, 0, SEEK_SET) == 0);
+	ASSERT(fwrite(block, BUFLEN, 1, fp) == 1);
+	CHECKED_fclose(fp, scratch);
+	if (buf) stdfree(buf);
+	if (packed) stdfree(packed);
+	return block;
+}
+/*==============================================
+ * bt_bulk_end -- Build btree from buffered records
+ *  Writes sorted records into fully packed blocks, with
+ *  fully packed indices above them, then makes the new
+ *  tree current & frees the files of the old one.
+ * returns FALSE if not bulk loading
+ *============================================*/
+BOOLEAN
+bt_bulk_end (BTREE btree)
+{
+	BTBULK bulk = bbulk(btree);
+	INDEX *levels[BULK_MAXLEVELS];
+	INT nnodes[BULK_MAXLEVELS];
+	INT nblocks, top, h, i;
+	INT perblock = NORECS - 1;  /* as full as bt_addrecord allows */
+	INT fanout = NOENTS - 1;    /* as full as addkey allows */
+	INDEX oldmaster;
+	OLDFILES old;
+
+	if (!bulk)
+		return FALSE;
+
+	/* note files of current tree, before anything changes */
+	memset(&old, 0, sizeof(old));
+	traverse_index_blocks(btree, bmaster(btree), &old, note_oldindex, note_oldblock);
+
+	qsort(bulk->u_ents, bulk->u_count, sizeof(BTBULKENT), cmp_bulkents);
+
+	/* work out shape of new tree; always at least one index */
+	nblocks = (bulk->u_count + perblock - 1) / perblock;
+	if (!nblocks) nblocks = 1;
+	nnodes[0] = nblocks;
+	top = 0;
+	do {
+		++top;
+		ASSERT(top < BULK_MAXLEVELS);
+		nnodes[top] = (nnodes[top-1] + fanout - 1) / fanout;
+	} while (nnodes[top] > 1);
+
+	/* create indices top down, so children know their parents */
+	for (h = top; h >= 1; h--) {
+		levels[h] = (INDEX *) stdalloc(nnodes[h] * sizeof(INDEX));
+		for (i = 0; i < nnodes[h]; i++) {
+			levels[h][i] = crtindex(btree);
+			ixparent(levels[h][i]) = (h == top) ? 0
+				: ixself(levels[h+1][i / fanout]);
+		}
+	}
+
+	/* write blocks, in key order */
+	for (i = 0; i < nblocks; i++) {
+		INDEX parent = levels[1][i / fanout];
+		INT first = i * perblock;
+		INT n = bulk->u_count - first;
+		BLOCK block;
+		if (n > perblock) n = perblock;
+		block = write_block(btree, first, n, ixself(parent));
+		set_child(parent, i % fanout, rkeys(block, 0), ixself(block));
+		stdfree(block);
+	}
+
+	/* link & write indices, bottom up */
+	for (h = 1; h <= top; h++) {
+		for (i = 0; i < nnodes[h]; i++) {
+			INDEX index = levels[h][i];
+			if (h < top)
+				set_child(levels[h+1][i / fanout], i % fanout
+					, rkeys(index, 0), ixself(index));
+			writeindex(btree, index);
+		}
+	}
+
+	/* switch to new tree */
+	oldmaster = bmaster(btree);
+	purgecache(btree);
+	newmaster(btree, levels[top][0]);
+	stdfree(oldmaster);
+	for (h = 1; h <= top; h++) {
+		for (i = 0; i < nnodes[h]; i++) {
+			if (levels[h][i] != bmaster(btree))
+				stdfree(levels[h][i]);
+		}
+		stdfree(levels[h]);
+	}
+
+	/* free old tree, removed once no reader has it (see snapshot.c) */
+	for (i = 0; i < old.count; i++)
+		snap_freefile(btree, old.fkeys[i]);
+	if (old.fkeys)
+		stdfree(old.fkeys);
+
+	free_bulk(bulk);
+	bbulk(btree) = NULL;
+	snap_written(btree);
+	/* new tree was not journalled, so make it durable now */
+	if (bjournal(btree))
+		journal_checkpoint(btree);
+	return TRUE;
+}
+/*==============================================
+ * free_bulk -- Close & remove spill file, free buffer
+ *============================================*/
+static void
+free_bulk (BTBULK bulk)
+{
+	fclose(bulk->u_fp);
+	unlink(bulk->u_path);
+	bulk_free(bulk);
+}
@@ -0,0 +1,301 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * compress.c -- Compressed records of BTREE block files
+ *  Each record of a block marked BTFMTZIP is stored as its
+ *  length (INT32), followed either by the record itself (if
+ *  compressing would not make it smaller), or by the record
+ *  compressed as a series of LZ77 sequences, in the manner of
+ *  LZ4:
+ *
+ *   token     high 4 bits: number of literals, low 4 bits:
+ *             length of match - 4 (15 means more follows, in
+ *             bytes added on until one is not 255)
+ *   literals  bytes copied as is
+ *   offset    (2 bytes, low first) how far back the match is
+ *   match     (copied from offset bytes back)
+ *
+ *  The last sequence has literals only.
+ *  Records are compressed one by one, so that any record can
+ *  be read alone, and so a match may also reach back into a
+ *  fixed dictionary of text common in GEDCOM records, which
+ *  is taken to come just before each record.
+ *  The dictionary is part of the format, & must never change.
+ *===========================================================*/
+
+#include "llstdlib.h"
+/* llstdlib.h pulls in standard.h, config.h, sys_inc.h */
+#include "btreei.h"
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+static const char zip_dict[] =
+	"0 @S1@ SOUR\n1 TITL \n1 AUTH \n1 PUBL \n1 REPO @R"
+	"0 @E1@ EVEN\n0 @X1@ NOTE\n1 CONC \n1 CONT \n2 CONT "
+	"1 NOTE \n2 NOTE \n1 SOUR @S\n2 SOUR @S\n3 PAGE \n3 DATA\n"
+	"1 OCCU \n1 EDUC \n1 RELI \n1 TITL \n1 RESI\n2 ADDR \n"
+	"1 CHAN\n2 DATE \n3 TIME \n1 REFN \n1 _UID \n1 OBJE\n2 FILE "
+	" JAN 1 FEB 1 MAR 1 APR 1 MAY 1 JUN 1 JUL 1 AUG 1"
+	" SEP 1 OCT 1 NOV 1 DEC 1"
+	"\n2 DATE ABT \n2 DATE BEF \n2 DATE AFT \n2 DATE BET "
+	"1 ADOP\n1 BAPM\n1 CHR\n1 BURI\n1 DEAT\n2 DATE \n2 PLAC "
+	"1 DIV\n1 MARR\n2 DATE \n2 PLAC "
+	"0 @F1@ FAM\n1 HUSB @I1@\n1 WIFE @I1@\n1 CHIL @I1@\n1 CHIL @I1@\n"
+	"0 @I1@ INDI\n1 NAME /\n1 SEX M\n1 SEX F\n1 BIRT\n2 DATE \n2 PLAC "
+	"1 FAMC @F1@\n1 FAMS @F1@\n";
+#define ZIP_DICTLEN ((INT)sizeof(zip_dict) - 1)
+
+#define ZIP_HEADLEN  ((INT)sizeof(INT32))  /* stored length of record */
+#define ZIP_MINMATCH 4
+#define ZIP_MAXOFF   65535
+#define ZIP_HASHBITS 12
+#define ZIP_HASHSIZE (1 << ZIP_HASHBITS)
+
+static INT32 dict_hash[ZIP_HASHSIZE]; /* last place of each hash in dictionary */
+static BOOLEAN dict_hashed = FALSE;
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static INT hash4(const unsigned char * p);
+static void hash_dict(void);
+static unsigned char * put_count(unsigned char * op, INT n);
+static BOOLEAN take_count(const unsigned char ** pip, const unsigned char * iend, INT * pn);
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * hash4 -- Hash of 4 bytes at p
+ *============================================*/
+static INT
+hash4 (const unsigned char * p)
+{
+	unsigned long v = p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16)
+		| ((unsigned long)p[3] << 24);
+	return (INT)(((v * 2654435761UL) & 0xffffffffUL) >> (32 - ZIP_HASHBITS));
+}
+/*==============================================
+ * hash_dict -- Note places in dictionary (once)
+ *============================================*/
+static void
+hash_dict (void)
+{
+	INT i;
+	if (dict_hashed)
+		return;
+	for (i = 0; i < ZIP_HASHSIZE; i++)
+		dict_hash[i] = -1;
+	for (i = 0; i + ZIP_MINMATCH <= ZIP_DICTLEN; i++)
+		dict_hash[hash4((const unsigned char *)zip_dict + i)] = i;
+	dict_hashed = TRUE;
+}
+/*==============================================
+ * put_count -- Write remainder of length over 15
+ *============================================*/
+static unsigned char *
+put_count (unsigned char * op, INT n)
+{
+	while (n >= 255) {
+		*op++ = 255;
+		n -= 255;
+	}
+	*op++ = (unsigned char)n;
+	return op;
+}
+/*==============================================
+ * take_count -- Add remainder of length over 15
+ * returns FALSE if input runs out
+ *============================================*/
+static BOOLEAN
+take_count (const unsigned char ** pip, const unsigned char * iend, INT * pn)
+{
+	const unsigned char * ip = *pip;
+	unsigned char c;
+	do {
+		if (ip >= iend)
+			return FALSE;
+		c = *ip++;
+		*pn += c;
+	} while (c == 255);
+	*pip = ip;
+	return TRUE;
+}
+/*==============================================
+ * zip_bound -- Most bytes record of len can take stored
+ *============================================*/
+INT
+zip_bound (INT len)
+{
+	return ZIP_HEADLEN + len;
+}
+/*==============================================
+ * zip_pack -- Compress record for block of format BTFMTZIP
+ *  rec:  [IN]  record
+ *  len:  [IN]  its length (> 0)
+ *  dst:  [OUT] stored form (zip_bound(len) bytes available)
+ * returns length of stored form
+ *============================================*/
+INT
+zip_pack (CNSTRING rec, INT len, char * dst)
+{
+	INT end = ZIP_DICTLEN + len;
+	unsigned char * work = (unsigned char *) stdalloc(end);
+	unsigned char * out = (unsigned char *) stdalloc(len + len/255 + 16);
+	unsigned char * op = out;
+	INT32 * table = (INT32 *) stdalloc(ZIP_HASHSIZE * sizeof(INT32));
+	INT32 rawlen = (INT32)len;
+	INT anchor = ZIP_DICTLEN, i = ZIP_DICTLEN, nlit, packed;
+
+	/* match against dictionary & record as if one text */
+	hash_dict();
+	memcpy(table, dict_hash, ZIP_HASHSIZE * sizeof(INT32));
+	memcpy(work, zip_dict, ZIP_DICTLEN);
+	memcpy(work + ZIP_DICTLEN, rec, len);
+
+	while (i + ZIP_MINMATCH <= end) {
+		INT h = hash4(work + i);
+		INT cand = table[h];
+		INT mlen;
+		table[h] = i;
+		if (cand < 0 || i - cand > ZIP_MAXOFF
+			|| memcmp(work + cand, work + i, ZIP_MINMATCH)) {
+			++i;
+			continue;
+		}
+		for (mlen = ZIP_MINMATCH; i + mlen < end; mlen++) {
+			if (work[cand + mlen] != work[i + mlen])
+				break;
+		}
+		nlit = i - anchor;
+		*op++ = (unsigned char)(((nlit < 15 ? nlit : 15) << 4)
+			| (mlen - ZIP_MINMATCH < 15 ? mlen - ZIP_MINMATCH : 15));
+		if (nlit >= 15)
+			op = put_count(op, nlit - 15);
+		memcpy(op, work + anchor, nlit);
+		op += nlit;
+		*op++ = (unsigned char)((i - cand) & 0xff);
+		*op++ = (unsigned char)((i - cand) >> 8);
+		if (mlen - ZIP_MINMATCH >= 15)
+			op = put_count(op, mlen - ZIP_MINMATCH - 15);
+		i += mlen;
+		anchor = i;
+		/* note place just before here too, for runs of repeats */
+		if (i - 2 > cand && i - 2 + ZIP_MINMATCH <= end)
+			table[hash4(work + i - 2)] = i - 2;
+	}
+	/* rest are literals */
+	nlit = end - anchor;
+	*op++ = (unsigned char)((nlit < 15 ? nlit : 15) << 4);
+	if (nlit >= 15)
+		op = put_count(op, nlit - 15);
+	memcpy(op, work + anchor, nlit);
+	op += nlit;
+
+	packed = (INT)(op - out);
+	memcpy(dst, &rawlen, ZIP_HEADLEN);
+	if (packed < len) {
+		memcpy(dst + ZIP_HEADLEN, out, packed);
+	} else {
+		/* incompressible, so keep as is */
+		memcpy(dst + ZIP_HEADLEN, rec, len);
+		packed = len;
+	}
+	stdfree(table);
+	stdfree(out);
+	stdfree(work);
+	return ZIP_HEADLEN + packed;
+}
+/*==============================================
+ * zip_rawlen -- Length of record from its stored form
+ * returns -1 if stored form is bad
+ *============================================*/
+INT
+zip_rawlen (CNSTRING src, INT slen)
+{
+	INT32 rawlen;
+	if (slen < ZIP_HEADLEN)
+		return -1;
+	memcpy(&rawlen, src, ZIP_HEADLEN);
+	if (rawlen < 0 || (rawlen == 0 && slen > ZIP_HEADLEN))
+		return -1;
+	return (INT)rawlen;
+}
+/*==============================================
+ * zip_unpack -- Expand stored form of record
+ *  src:  [IN]  stored form
+ *  slen: [IN]  its length
+ *  dst:  [OUT] record (zip_rawlen(src, slen) bytes)
+ * returns FALSE if stored form is bad
+ *============================================*/
+BOOLEAN
+zip_unpack (CNSTRING src, INT slen, char * dst)
+{
+	const unsigned char * ip = (const unsigned char *)src + ZIP_HEADLEN;
+	const unsigned char * iend = (const unsigned char *)src + slen;
+	INT rawlen = zip_rawlen(src, slen);
+	INT op = 0;
+
+	if (rawlen < 0)
+		return FALSE;
+	if (slen - ZIP_HEADLEN == rawlen) {
+		/* stored as is */
+		memcpy(dst, ip, rawlen);
+		return TRUE;
+	}
+	while (ip < iend) {
+		INT token = *ip++;
+		INT nlit = token >> 4, mlen = token & 15, off;
+		if (nlit == 15 && !take_count(&ip, iend, &nlit))
+			return FALSE;
+		if (nlit > iend - ip || nlit > rawlen - op)
+			return FALSE;
+		memcpy(dst + op, ip, nlit);
+		ip += nlit;
+		op += nlit;
+		if (ip == iend)
+			break; /* last sequence */
+		if (iend - ip < 2)
+			return FALSE;
+		off = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (mlen == 15 && !take_count(&ip, iend, &mlen))
+			return FALSE;
+		mlen += ZIP_MINMATCH;
+		if (!off || off > op + ZIP_DICTLEN || mlen > rawlen - op)
+			return FALSE;
+		/* copy byte by byte, as match may overlap itself */
+		for ( ; mlen > 0 && op < off; mlen--, op++)
+			dst[op] = zip_dict[ZIP_DICTLEN + op - off];
+		for ( ; mlen > 0; mlen--, op++)
+			dst[op] = dst[op - off];
+	}
+	return op == rawlen;
+}
@@ -0,0 +1,501 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * cursor.c -- Cursor stepping through BTREE records in key
+ *  order, for callers which would rather pull records than
+ *  be called back by traverse_db_rec_rkeys
+ *  A cursor is positioned between two records. It holds its
+ *  own copies of the indices on the path from the master to
+ *  the current data block, and of that block's header, so
+ *  stepping through a block needs no lookups, and records are
+ *  read through the pooled descriptor of the block file. On
+ *  arriving at a block, the next block of the same parent is
+ *  opened & read ahead.
+ *  If the btree is written while a cursor is open, the cursor
+ *  finds its place again (by the key it last returned) in the
+ *  changed tree before its next step. Records written in a
+ *  group not yet committed are read from the journal, & merged
+ *  with those of the tree.
+ * NB: Like traverse_db_rec_rkeys, this covers all records,
+ *  including DELE records.
+ *===========================================================*/
+
+#include "llstdlib.h"
+/* llstdlib.h pulls in standard.h, config.h, sys_inc.h */
+#include "btreei.h"
+
+/*********************************************
+ * local types
+ *********************************************/
+
+#define BTCURSOR_MAXDEPTH 16
+
+struct tag_btcursor {
+	BTREE    c_btree;
+	BOOLEAN  c_keysonly;   /* return keys (& lengths) only */
+	INDEX    c_path[BTCURSOR_MAXDEPTH]; /* copies of indices, master first */
+	INT      c_slot[BTCURSOR_MAXDEPTH]; /* child taken from each */
+	INT      c_depth;      /* indices in path */
+	BLOCK    c_block;      /* copy of current block header */
+	INT      c_pos;        /* entry next returns (prev returns one before) */
+	BOOLEAN  c_bulk;       /* positioned in records buffered for bulk load */
+	INT      c_writes;     /* write count of btree when positioned */
+	RKEY     c_key;        /* key to find place by, if c_haskey */
+	BOOLEAN  c_haskey;
+	BOOLEAN  c_after;      /* place is just after c_key (else before) */
+	BOOLEAN  c_end;        /* place is end (from bt_cursor_seek_end) */
+	RKEY    *c_pend;       /* keys of records pending in journal, in order */
+	INT      c_npend;
+	INT      c_ppos;       /* pending record next returns */
+};
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static void clear_path(BTCURSOR cursor, INT depth);
+static void descend(BTCURSOR cursor, const RKEY * rkey, BOOLEAN last);
+static INT first_at_or_after(BTCURSOR cursor, const RKEY * rkey);
+static INDEX load_node(BTREE btree, FKEY fkey);
+static INT pick_slot(INDEX index, const RKEY * rkey, BOOLEAN last);
+static void position(BTCURSOR cursor, const RKEY * rkey, BOOLEAN last);
+static void read_entry(BTCURSOR cursor, INT i, RKEY * prkey, RAWRECORD * prec, INT * plen);
+static void read_pending(BTCURSOR cursor, INT i, RKEY * prkey, RAWRECORD * prec, INT * plen);
+static void resync(BTCURSOR cursor);
+static BOOLEAN step_back(BTCURSOR cursor);
+static BOOLEAN step_on(BTCURSOR cursor);
+static INT write_count(BTREE btree);
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * bt_cursor_open -- Create cursor on btree
+ *  positioned before its first record
+ *  btree:    [IN]  btree to step through
+ *  keysonly: [IN]  return only keys (& lengths), not data ?
+ *============================================*/
+BTCURSOR
+bt_cursor_open (BTREE btree, BOOLEAN keysonly)
+{
+	BTCURSOR cursor = (BTCURSOR) stdalloc(sizeof(*cursor));
+	cursor->c_btree = btree;
+	cursor->c_keysonly = keysonly;
+	bt_cursor_seek(cursor, NULL);
+	return cursor;
+}
+/*==============================================
+ * bt_cursor_close -- Free cursor
+ *============================================*/
+void
+bt_cursor_close (BTCURSOR cursor)
+{
+	if (!cursor)
+		return;
+	clear_path(cursor, 0);
+	if (cursor->c_pend)
+		stdfree(cursor->c_pend);
+	stdfree(cursor);
+}
+/*==============================================
+ * bt_cursor_seek -- Position cursor before first record
+ *  with key at or after rkey
+ *  rkey:  [IN]  key to seek (NULL for first record)
+ *============================================*/
+void
+bt_cursor_seek (BTCURSOR cursor, const RKEY * rkey)
+{
+	cursor->c_haskey = (rkey != NULL);
+	if (rkey)
+		cursor->c_key = *rkey;
+	cursor->c_after = FALSE;
+	cursor->c_end = FALSE;
+	position(cursor, rkey, FALSE);
+}
+/*==============================================
+ * bt_cursor_seek_end -- Position cursor after last record
+ *  (for stepping backward with bt_cursor_prev)
+ *============================================*/
+void
+bt_cursor_seek_end (BTCURSOR cursor)
+{
+	cursor->c_haskey = FALSE;
+	cursor->c_after = FALSE;
+	cursor->c_end = TRUE;
+	position(cursor, NULL, TRUE);
+}
+/*==============================================
+ * bt_cursor_next -- Step forward over next record
+ *  prkey: [OUT] key of record
+ *  prec:  [OUT] copy of record data (caller frees), or
+ *               NULL if keys only (or record is empty)
+ *  plen:  [OUT] length of record data
+ * returns FALSE if no more records
+ *============================================*/
+BOOLEAN
+bt_cursor_next (BTCURSOR cursor, RKEY * prkey, RAWRECORD * prec, INT * plen)
+{
+	BOOLEAN intree, inpend;
+	INT cmp = -1;
+	resync(cursor);
+	intree = step_on(cursor);
+	inpend = (cursor->c_ppos < cursor->c_npend);
+	if (!intree && !inpend)
+		return FALSE;
+	if (intree && inpend)
+		cmp = cmpkeys(&rkeys(cursor->c_block, cursor->c_pos), &cursor->c_pend[cursor->c_ppos]);
+	else if (inpend)
+		cmp = 1;
+	if (cmp < 0) {
+		read_entry(cursor, cursor->c_pos++, prkey, prec, plen);
+	} else {
+		read_pending(cursor, cursor->c_ppos++, prkey, prec, plen);
+		/* pending record replaces that of tree */
+		if (!cmp)
+			++cursor->c_pos;
+	}
+	cursor->c_key = *prkey;
+	cursor->c_haskey = TRUE;
+	cursor->c_after = TRUE;
+	cursor->c_end = FALSE;
+	return TRUE;
+}
+/*==============================================
+ * bt_cursor_prev -- Step back over previous record
+ *  arguments & return as bt_cursor_next
+ *============================================*/
+BOOLEAN
+bt_cursor_prev (BTCURSOR cursor, RKEY * prkey, RAWRECORD * prec, INT * plen)
+{
+	BOOLEAN intree, inpend;
+	INT cmp = 1;
+	resync(cursor);
+	intree = step_back(cursor);
+	inpend = (cursor->c_ppos > 0);
+	if (!intree && !inpend)
+		return FALSE;
+	if (intree && inpend)
+		cmp = cmpkeys(&rkeys(cursor->c_block, cursor->c_pos-1), &cursor->c_pend[cursor->c_ppos-1]);
+	else if (inpend)
+		cmp = -1;
+	if (cmp > 0) {
+		read_entry(cursor, --cursor->c_pos, prkey, prec, plen);
+	} else {
+		read_pending(cursor, --cursor->c_ppos, prkey, prec, plen);
+		/* pending record replaces that of tree */
+		if (!cmp)
+			--cursor->c_pos;
+	}
+	cursor->c_key = *prkey;
+	cursor->c_haskey = TRUE;
+	cursor->c_after = FALSE;
+	cursor->c_end = FALSE;
+	return TRUE;
+}
+/*==============================================
+ * write_count -- Number of writes made to btree
+ *  (changes if cursor's copies may be out of date)
+ *============================================*/
+static INT
+write_count (BTREE btree)
+{
+	if (bbulk(btree))
+		return bbulk(btree)->u_count;
+	return bsnap(btree) ? bsnap(btree)->s_writes : 0;
+}
+/*==============================================
+ * resync -- Find place again, if btree was written
+ *  since cursor was positioned
+ *============================================*/
+static void
+resync (BTCURSOR cursor)
+{
+	BTREE btree = cursor->c_btree;
+	if (cursor->c_bulk == (bbulk(btree) != NULL)
+		&& cursor->c_writes == write_count(btree))
+		return;
+	if (cursor->c_end) {
+		position(cursor, NULL, TRUE);
+		return;
+	}
+	position(cursor, cursor->c_haskey ? &cursor->c_key : NULL, FALSE);
+	if (!cursor->c_after)
+		return;
+	if (cursor->c_ppos < cursor->c_npend
+		&& !cmpkeys(&cursor->c_pend[cursor->c_ppos], &cursor->c_key))
+		++cursor->c_ppos;
+	if (!step_on(cursor))
+		return;
+	/* skip record already returned, if it is still there */
+	if (cursor->c_bulk) {
+		if (!cmpkeys(&bbulk(btree)->u_ents[cursor->c_pos].e_rkey, &cursor->c_key))
+			++cursor->c_pos;
+	} else if (!cmpkeys(&rkeys(cursor->c_block, cursor->c_pos), &cursor->c_key)) {
+		++cursor->c_pos;
+	}
+}
+/*==============================================
+ * position -- Place cursor before first record at or
+ *  after rkey (or at start, or at end if last)
+ *============================================*/
+static void
+position (BTCURSOR cursor, const RKEY * rkey, BOOLEAN last)
+{
+	BTREE btree = cursor->c_btree;
+	BTBULK bulk = bbulk(btree);
+	RKEY lo, hi;
+
+	clear_path(cursor, 0);
+	if (cursor->c_pend) {
+		stdfree(cursor->c_pend);
+		cursor->c_pend = NULL;
+	}
+	cursor->c_npend = cursor->c_ppos = 0;
+	cursor->c_bulk = (bulk != NULL);
+	if (bulk) {
+		bulk_sort(bulk);
+		cursor->c_pos = last ? bulk->u_count : first_at_or_after(cursor, rkey);
+	} else {
+		cursor->c_path[0] = (INDEX) stdalloc(BUFLEN);
+		memcpy(cursor->c_path[0], bmaster(btree), BUFLEN);
+		cursor->c_slot[0] = pick_slot(cursor->c_path[0], rkey, last);
+		cursor->c_depth = 1;
+		descend(cursor, rkey, last);
+		cursor->c_pos = last ? nkeys(cursor->c_block) : first_at_or_after(cursor, rkey);
+		lo.r_rkey[0] = hi.r_rkey[0] = 0;
+		cursor->c_pend = journal_pendingkeys(btree, lo, hi, &cursor->c_npend);
+		if (last)
+			cursor->c_ppos = cursor->c_npend;
+		else if (rkey)
+			while (cursor->c_ppos < cursor->c_npend
+				&& cmpkeys(&cursor->c_pend[cursor->c_ppos], rkey) < 0)
+				++cursor->c_ppos;
+	}
+	cursor->c_writes = write_count(btree);
+}
+/*==============================================
+ * pick_slot -- Choose child of index to descend to
+ *============================================*/
+static INT
+pick_slot (INDEX index, const RKEY * rkey, BOOLEAN last)
+{
+	if (rkey)
+		return findslot(index, rkey);
+	return last ? nkeys(index) : 0;
+}
+/*==============================================
+ * descend -- Load path down to data block
+ *  from chosen child of last index in path
+ *  rkey:  [IN]  key to follow (if not NULL)
+ *  last:  [IN]  else follow last (rather than first) children
+ *============================================*/
+static void
+descend (BTCURSOR cursor, const RKEY * rkey, BOOLEAN last)
+{
+	BTREE btree = cursor->c_btree;
+	INDEX node, parent;
+	INT level, slot;
+
+	while (TRUE) {
+		level = cursor->c_depth - 1;
+		node = load_node(btree, fkeys(cursor->c_path[level], cursor->c_slot[level]));
+		if (ixtype(node) != BTINDEXTYPE)
+			break;
+		if (cursor->c_depth == BTCURSOR_MAXDEPTH)
+			FATAL2("Btree too deep for cursor");
+		cursor->c_path[cursor->c_depth] = node;
+		cursor->c_slot[cursor->c_depth] = pick_slot(node, rkey, last);
+		++cursor->c_depth;
+	}
+	cursor->c_block = (BLOCK) node;
+
+	/* read ahead block that stepping will come to next */
+	parent = cursor->c_path[cursor->c_depth - 1];
+	slot = cursor->c_slot[cursor->c_depth - 1] + (last ? -1 : 1);
+	if (slot >= 0 && slot <= nkeys(parent))
+		fdpool_prefetch(btree, fkeys(parent, slot));
+}
+/*==============================================
+ * load_node -- Get own copy of index or block header
+ *  from index cache if there, else from its file
+ *  (data blocks are not put in index cache, so that
+ *  stepping through many does not flush it)
+ *============================================*/
+static INDEX
+load_node (BTREE btree, FKEY fkey)
+{
+	INDEX cached = cachedindex(btree, fkey);
+	INDEX node = (INDEX) stdalloc(BUFLEN);
+	BTFDSLOT * slot;
+
+	if (cached) {
+		memcpy(node, cached, BUFLEN);
+		return node;
+	}
+	if (!(slot = fdpool_get(btree, fkey))
+		|| fdpool_read(slot, node, BUFLEN, 0) != BUFLEN) {
+		char msg[64];
+		snprintf(msg, sizeof(msg), "Cursor failed to read btree file %s", fkey2path(fkey));
+		FATAL2(msg);
+	}
+	return node;
+}
+/*==============================================
+ * first_at_or_after -- Entry of first record at or after
+ *  key, in current block (or bulk buffer)
+ *============================================*/
+static INT
+first_at_or_after (BTCURSOR cursor, const RKEY * rkey)
+{
+	INT lo = 0, hi;
+	if (!rkey)
+		return 0;
+	if (cursor->c_bulk) {
+		BTBULK bulk = bbulk(cursor->c_btree);
+		hi = bulk->u_count;
+		while (lo < hi) {
+			INT md = (lo + hi)/2;
+			if (cmpkeys(&bulk->u_ents[md].e_rkey, rkey) < 0)
+				lo = md + 1;
+			else
+				hi = md;
+		}
+		return lo;
+	}
+	hi = nkeys(cursor->c_block);
+	while (lo < hi) {
+		INT md = (lo + hi)/2;
+		if (cmpkeys(&rkeys(cursor->c_block, md), rkey) < 0)
+			lo = md + 1;
+		else
+			hi = md;
+	}
+	return lo;
+}
+/*==============================================
+ * step_on -- Make sure there is an entry at cursor,
+ *  moving on to later blocks if need be
+ * returns FALSE if at end
+ *============================================*/
+static BOOLEAN
+step_on (BTCURSOR cursor)
+{
+	INT level;
+	if (cursor->c_bulk)
+		return cursor->c_pos < bbulk(cursor->c_btree)->u_count;
+	while (cursor->c_pos >= nkeys(cursor->c_block)) {
+		/* climb to nearest index with a later child */
+		for (level = cursor->c_depth - 1; level >= 0; --level) {
+			if (cursor->c_slot[level] < nkeys(cursor->c_path[level]))
+				break;
+		}
+		if (level < 0)
+			return FALSE;
+		clear_path(cursor, level + 1);
+		++cursor->c_slot[level];
+		descend(cursor, NULL, FALSE);
+		cursor->c_pos = 0;
+	}
+	return TRUE;
+}
+/*==============================================
+ * step_back -- Make sure there is an entry before cursor,
+ *  moving back to earlier blocks if need be
+ * returns FALSE if at start
+ *============================================*/
+static BOOLEAN
+step_back (BTCURSOR cursor)
+{
+	INT level;
+	if (cursor->c_bulk)
+		return cursor->c_pos > 0;
+	while (cursor->c_pos <= 0) {
+		/* climb to nearest index with an earlier child */
+		for (level = cursor->c_depth - 1; level >= 0; --level) {
+			if (cursor->c_slot[level] > 0)
+				break;
+		}
+		if (level < 0)
+			return FALSE;
+		clear_path(cursor, level + 1);
+		--cursor->c_slot[level];
+		descend(cursor, NULL, TRUE);
+		cursor->c_pos = nkeys(cursor->c_block);
+	}
+	return TRUE;
+}
+/*==============================================
+ * read_entry -- Return key (& data) of entry i
+ *============================================*/
+static void
+read_entry (BTCURSOR cursor, INT i, RKEY * prkey, RAWRECORD * prec, INT * plen)
+{
+	BTREE btree = cursor->c_btree;
+	if (cursor->c_bulk) {
+		BTBULKENT * ent = &bbulk(btree)->u_ents[i];
+		*prkey = ent->e_rkey;
+		*plen = ent->e_len;
+		*prec = NULL;
+		if (!cursor->c_keysonly)
+			*prec = bulk_getrecord(bbulk(btree), &ent->e_rkey, plen);
+		return;
+	}
+	*prkey = rkeys(cursor->c_block, i);
+	*plen = lens(cursor->c_block, i);
+	*prec = NULL;
+	if (!cursor->c_keysonly)
+		*prec = readrec(btree, cursor->c_block, i, plen);
+}
+/*==============================================
+ * read_pending -- Return key (& data) of pending record i
+ *  (read as it is now, which is from tree if its group
+ *  has committed since cursor was positioned)
+ *============================================*/
+static void
+read_pending (BTCURSOR cursor, INT i, RKEY * prkey, RAWRECORD * prec, INT * plen)
+{
+	*prkey = cursor->c_pend[i];
+	*prec = readlatest(cursor->c_btree, prkey, plen);
+	if (cursor->c_keysonly && *prec) {
+		stdfree(*prec);
+		*prec = NULL;
+	}
+}
+/*==============================================
+ * clear_path -- Free copies below depth of path
+ *  (& block header)
+ *============================================*/
+static void
+clear_path (BTCURSOR cursor, INT depth)
+{
+	while (cursor->c_depth > depth)
+		stdfree(cursor->c_path[--cursor->c_depth]);
+	if (cursor->c_block) {
+		stdfree(cursor->c_block);
+		cursor->c_block = NULL;
+	}
+}
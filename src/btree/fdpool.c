@@ -0,0 +1,293 @@
+/* 
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * fdpool.c -- Pool of open descriptors for BTREE block files
+ *  Record reads go through here, so that a traversal of many
+ *  records in the same block does not open & close the block
+ *  file once per record.
+ *  When the btree is not writable, the pooled files are also
+ *  memory mapped, and reads are served from the mapping.
+ *===========================================================*/
+
+#include <fcntl.h>
+#include "sys_inc.h"
+#include "llstdlib.h"
+/* llstdlib.h pulls in config.h */
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#define BTFD_USE_MMAP 1
+#endif
+#include "btreei.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static void close_slot(BTFDSLOT * slot);
+static BTFDSLOT * find_slot(BTFDPOOL pool, FKEY fkey);
+static void map_slot(BTFDSLOT * slot);
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * fdpool_create -- Create descriptor pool for btree
+ *  n:       [IN]  max number of open block files
+ *  mapped:  [IN]  memory map files as they are opened ?
+ *                 (only valid if btree will not be written)
+ *============================================*/
+BTFDPOOL
+fdpool_create (INT n, BOOLEAN mapped)
+{
+	BTFDPOOL pool = (BTFDPOOL) stdalloc(sizeof(*pool));
+	INT i;
+	n = (n < 1) ? 1 : n;
+	memset(pool, 0, sizeof(*pool));
+	pool->p_nslots = n;
+	pool->p_slots = (BTFDSLOT *) stdalloc(n * sizeof(BTFDSLOT));
+#ifdef BTFD_USE_MMAP
+	pool->p_mapped = mapped;
+#else
+	pool->p_mapped = FALSE;
+	mapped = mapped; /* unused */
+#endif
+	for (i = 0; i < n; i++) {
+		pool->p_slots[i].s_fd = -1;
+		pool->p_slots[i].s_fkey = 0;
+		pool->p_slots[i].s_used = 0;
+		pool->p_slots[i].s_map = NULL;
+		pool->p_slots[i].s_maplen = 0;
+	}
+	return pool;
+}
+/*==============================================
+ * fdpool_free -- Close all descriptors & free pool
+ *============================================*/
+void
+fdpool_free (BTFDPOOL pool)
+{
+	INT i;
+	if (!pool) return;
+	for (i = 0; i < pool->p_nslots; i++)
+		close_slot(&pool->p_slots[i]);
+	stdfree(pool->p_slots);
+	stdfree(pool);
+}
+/*==============================================
+ * close_slot -- Close descriptor held by slot (if any)
+ *============================================*/
+static void
+close_slot (BTFDSLOT * slot)
+{
+#ifdef BTFD_USE_MMAP
+	if (slot->s_map)
+		munmap(slot->s_map, slot->s_maplen);
+#endif
+	slot->s_map = NULL;
+	slot->s_maplen = 0;
+	if (slot->s_fd != -1)
+		close(slot->s_fd);
+	slot->s_fd = -1;
+	slot->s_fkey = 0;
+	slot->s_used = 0;
+}
+/*==============================================
+ * find_slot -- Find slot holding block file, or NULL
+ *============================================*/
+static BTFDSLOT *
+find_slot (BTFDPOOL pool, FKEY fkey)
+{
+	INT i;
+	for (i = 0; i < pool->p_nslots; i++) {
+		BTFDSLOT * slot = &pool->p_slots[i];
+		if (slot->s_fd != -1 && slot->s_fkey == fkey)
+			return slot;
+	}
+	return NULL;
+}
+/*==============================================
+ * map_slot -- Memory map whole file of newly opened slot
+ *  if mapping fails, slot is still usable via its descriptor
+ *============================================*/
+static void
+map_slot (BTFDSLOT * slot)
+{
+#ifdef BTFD_USE_MMAP
+	struct stat sbuf;
+	void * map;
+	if (fstat(slot->s_fd, &sbuf) != 0 || sbuf.st_size <= 0)
+		return;
+	map = mmap(NULL, (size_t)sbuf.st_size, PROT_READ, MAP_SHARED, slot->s_fd, 0);
+	if (map == MAP_FAILED)
+		return;
+	slot->s_map = (char *)map;
+	slot->s_maplen = (INT)sbuf.st_size;
+#else
+	slot = slot; /* unused */
+#endif
+}
+/*==============================================
+ * fdpool_get -- Get pool slot holding open block file
+ *  opens it (evicting least recently used) if not pooled
+ *  btree: [IN]  btree (owns pool & gives base directory)
+ *  fkey:  [IN]  block (or index) file key
+ * returns NULL if file could not be opened (errno is set)
+ * Slot (and any mapping) is only valid until next call.
+ *============================================*/
+BTFDSLOT *
+fdpool_get (BTREE btree, FKEY fkey)
+{
+	BTFDPOOL pool = bfdpool(btree);
+	BTFDSLOT * slot = find_slot(pool, fkey);
+	char scratch[MAXPATHLEN];
+	INT i;
+	int fd;
+
+	if (slot) {
+		++pool->p_hits;
+		slot->s_used = ++pool->p_clock;
+		return slot;
+	}
+	++pool->p_misses;
+	snprintf(scratch, sizeof(scratch), "%s%c%s"
+		, bbasedir(btree), LLCHRDIRSEPARATOR, fkey2path(fkey));
+	if ((fd = open(scratch, O_RDONLY | O_BINARY)) == -1)
+		return NULL;
+	/* pick empty slot, else least recently used */
+	slot = &pool->p_slots[0];
+	for (i = 0; i < pool->p_nslots; i++) {
+		BTFDSLOT * cand = &pool->p_slots[i];
+		if (cand->s_fd == -1) {
+			slot = cand;
+			break;
+		}
+		if (cand->s_used < slot->s_used)
+			slot = cand;
+	}
+	close_slot(slot);
+	slot->s_fd = fd;
+	slot->s_fkey = fkey;
+	slot->s_used = ++pool->p_clock;
+	if (pool->p_mapped)
+		map_slot(slot);
+	return slot;
+}
+/*==============================================
+ * fdpool_invalidate -- Drop pooled descriptor for block file
+ *  Must be called whenever a block file is rewritten or
+ *  replaced (eg, by movefiles), as the pooled descriptor
+ *  would still refer to the old file.
+ *============================================*/
+void
+fdpool_invalidate (BTREE btree, FKEY fkey)
+{
+	BTFDSLOT * slot;
+	if (!bfdpool(btree)) return;
+	if ((slot = find_slot(bfdpool(btree), fkey)) != NULL)
+		close_slot(slot);
+}
+/*==============================================
+ * fdpool_prefetch -- Open block file & ask system to
+ *  start reading it in, as it is likely to be read soon
+ *  (eg, next block of a cursor)
+ *============================================*/
+void
+fdpool_prefetch (BTREE btree, FKEY fkey)
+{
+	BTFDSLOT * slot = fdpool_get(btree, fkey);
+	if (!slot)
+		return;
+#if defined(BTFD_USE_MMAP) && defined(MADV_WILLNEED)
+	if (slot->s_map) {
+		madvise(slot->s_map, slot->s_maplen, MADV_WILLNEED);
+		return;
+	}
+#endif
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+	posix_fadvise(slot->s_fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+}
+/*==============================================
+ * fdpool_view -- Get pointer to bytes at offset in mapped file
+ *  returns NULL if slot is not mapped or range is out of file
+ *============================================*/
+CNSTRING
+fdpool_view (BTFDSLOT * slot, INT len, INT32 off)
+{
+	if (!slot->s_map || off < 0 || len < 0 || off + len > slot->s_maplen)
+		return NULL;
+	return slot->s_map + off;
+}
+/*==============================================
+ * fdpool_read -- Read bytes at offset from pooled file
+ *  copies from mapping if file is mapped
+ *  returns number of bytes read, or -1 on error
+ *============================================*/
+INT
+fdpool_read (BTFDSLOT * slot, void * buf, INT len, INT32 off)
+{
+	char * p = (char *)buf;
+	int fd = slot->s_fd;
+	INT total = 0;
+	CNSTRING view;
+	if ((view = fdpool_view(slot, len, off)) != NULL) {
+		memcpy(buf, view, len);
+		return len;
+	}
+	while (total < len) {
+		INT got;
+#ifdef HAVE_PREAD
+		got = pread(fd, p + total, len - total, (off_t)off + total);
+#else
+		if (lseek(fd, (long)off + total, SEEK_SET) == -1)
+			return -1;
+		got = read(fd, p + total, len - total);
+#endif
+		if (got < 0)
+			return -1;
+		if (got == 0)
+			break;
+		total += got;
+	}
+	return total;
+}
+/*==============================================
+ * bt_get_fdpool_stats -- Report descriptor pool effectiveness
+ *  hits:   [OUT] reads served by an already open descriptor
+ *  misses: [OUT] reads which had to open the block file
+ *============================================*/
+void
+bt_get_fdpool_stats (BTREE btree, INT * hits, INT * misses)
+{
+	BTFDPOOL pool = bfdpool(btree);
+	*hits = pool ? pool->p_hits : 0;
+	*misses = pool ? pool->p_misses : 0;
+}
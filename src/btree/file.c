@@ -167,7 +167,18 @@ write_record_to_file_impl (BTREE btree, RKEY rkey, STRING file
 	FILE *fp;
 	INT len;
 	INT siz;
-	RAWRECORD record = bt_getrecord(btree, &rkey, &len);
+	RAWRECORD record;
+	CNSTRING view;
+	if (!translfnc && (view = bt_getrecord_view(btree, &rkey, &len)) != NULL) {
+		/* mapped btree, so write straight from the block file */
+		if ((fp = fopen(file, mode)) == NULL)
+			return RECORD_ERROR;
+		siz = fwrite(view, 1, len, fp);
+		if (fclose(fp) != 0 || siz != len)
+			return RECORD_ERROR;
+		return RECORD_SUCCESS;
+	}
+	record = bt_getrecord(btree, &rkey, &len);
 	if (record == NULL)
 		return RECORD_NOT_FOUND;
 	if (translfnc) {
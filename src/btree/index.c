@@ -32,8 +32,12 @@
 #include "llstdlib.h"
 #include "btreei.h"
 
-static INT incache (BTREE, FKEY);
 static BOOLEAN cacheindex (BTREE, INDEX);
+static BTCACHEENT * evict_lru (BTCACHE cache);
+static INT hash_fkey (BTCACHE cache, FKEY fkey);
+static BTCACHEENT * incache (BTREE, FKEY);
+static void push_lru (BTCACHE cache, BTCACHEENT *ent);
+static void unlink_lru (BTCACHE cache, BTCACHEENT *ent);
 
 /*======================================
  * crtindex - Create new index for btree
@@ -47,15 +51,7 @@ crtindex (BTREE btree)
 	nkeys(index) = 0;
 	ixparent(index) = 0;
 	ixtype(index) = BTINDEXTYPE;
-	ixself(index) = btree->b_kfile.k_fkey;
-	nextfkey(btree);
-	rewind(bkfp(btree));
-	if (fwrite(&bkfile(btree), sizeof(bkfile(btree)), 1, bkfp(btree)) != 1) {
-		char scratch[200];
-		snprintf(scratch, sizeof(scratch), "Error updating keyfile for new index");
-		fclose(bkfp(btree));
-		FATAL2(scratch);
-	}
+	ixself(index) = snap_newfkey(btree);
 	writeindex(btree, index);
 	return index;
 }
@@ -77,6 +73,7 @@ get_index_file (STRING path, INT len, BTREE btr, FKEY ikey)
  *  ikey:    [IN] index file key (number which indicates a file)
  *  robust:  [IN] flag to tell this function to return (not abort) on errors
  * this is below the level of the index cache
+ * reads from the mapped file if btree is memory mapped
  *===============================*/
 INDEX
 readindex (BTREE btr, FKEY ikey, BOOLEAN robust)
@@ -84,6 +81,16 @@ readindex (BTREE btr, FKEY ikey, BOOLEAN robust)
 	FILE *fi=NULL;
 	INDEX index=NULL;
 	char scratch[400];
+	if (bmapped(btr)) {
+		BTFDSLOT * slot = fdpool_get(btr, ikey);
+		CNSTRING view = slot ? fdpool_view(slot, BUFLEN, 0) : NULL;
+		if (view) {
+			index = (INDEX) stdalloc(BUFLEN);
+			memcpy(index, view, BUFLEN);
+			return index;
+		}
+		/* fall through to report error as usual */
+	}
 	get_index_file(scratch, sizeof(scratch), btr, ikey);
 	if ((fi = fopen(scratch, LLREADBINARY LLFILERANDOM)) == NULL) {
 		if (robust) {
@@ -129,6 +136,46 @@ writeindex (BTREE btr, INDEX index)
 	}
 	fclose(fi);
 }
+/*=================================
+ * findslot - Find child slot of index covering key
+ *  index:    [IN]  index block
+ *  rkey:     [IN]  key being sought
+ * returns i such that rkeys(index,i) <= rkey < rkeys(index,i+1)
+ *  (slot 0 covers all keys below rkeys(index,1))
+ * Keys of an index are sorted, so this is a binary search;
+ *  it is used by every descent from the master index.
+ *===============================*/
+INT
+findslot (INDEX index, const RKEY * rkey)
+{
+	INT lo = 1, hi = nkeys(index), slot = 0;
+	while (lo <= hi) {
+		INT md = (lo + hi)/2;
+		if (cmpkeys(rkey, &rkeys(index, md)) < 0)
+			hi = md - 1;
+		else {
+			slot = md;
+			lo = md + 1;
+		}
+	}
+	return slot;
+}
+/*==============================================
+ * The index cache holds INDEX and BLOCK headers, keyed by
+ * file key. Entries are found through a hash table, and kept
+ * on a doubly linked list in order of use, so that lookup,
+ * promotion and eviction of the least recently used entry
+ * are all constant time.
+ *============================================*/
+/*==============================================
+ * hash_fkey -- Pick hash bucket for file key
+ *============================================*/
+static INT
+hash_fkey (BTCACHE cache, FKEY fkey)
+{
+	unsigned int h = (unsigned int)fkey * 2654435761U;
+	return (INT)((h >> 8) & (cache->c_nbuckets - 1));
+}
 /*==============================================
  * initcache -- Initialize index cache for btree
  *============================================*/
@@ -136,12 +183,26 @@ void
 initcache (BTREE btree, /* btree handle */
            INT n)       /* num cache blocks to allow */
 {
+	BTCACHE cache = (BTCACHE) stdalloc(sizeof(*cache));
 	INT i=0;
 	n = (n < 5) ? 5 : n;
-	bncache(btree) = n;
-	bcache(btree) = (INDEX *) stdalloc(n*sizeof(INDEX));
-	for (i = 0;  i < n;  i++)
-		bcache(btree)[i] = NULL;
+	memset(cache, 0, sizeof(*cache));
+	cache->c_max = n;
+	for (cache->c_nbuckets = 16; cache->c_nbuckets < 2*n; )
+		cache->c_nbuckets *= 2;
+	cache->c_buckets = (BTCACHEENT **) stdalloc(cache->c_nbuckets*sizeof(BTCACHEENT *));
+	for (i = 0; i < cache->c_nbuckets; i++)
+		cache->c_buckets[i] = NULL;
+	cache->c_entries = (BTCACHEENT *) stdalloc(n*sizeof(BTCACHEENT));
+	/* all entries start on free list (chained through e_hnext) */
+	for (i = 0; i < n; i++) {
+		cache->c_entries[i].e_index = NULL;
+		cache->c_entries[i].e_prev = NULL;
+		cache->c_entries[i].e_next = NULL;
+		cache->c_entries[i].e_hnext = (i+1 < n) ? &cache->c_entries[i+1] : NULL;
+	}
+	cache->c_free = &cache->c_entries[0];
+	bcache(btree) = cache;
 }
 /*========================================
  * freecache -- Free index cache for btree
@@ -149,36 +210,139 @@ initcache (BTREE btree, /* btree handle */
 void
 freecache (BTREE btree)
 {
-	INT i=0;
-	INT n = bncache(btree);
-	for (i=0; i<n; ++i) {
-		if (bcache(btree)[i]) {
-			stdfree(bcache(btree)[i]);
-			bcache(btree)[i] = NULL;
-		}
+	BTCACHE cache = bcache(btree);
+	BTCACHEENT *ent;
+	if (!cache) return;
+	for (ent = cache->c_head; ent; ent = ent->e_next)
+		stdfree(ent->e_index);
+	stdfree(cache->c_entries);
+	stdfree(cache->c_buckets);
+	stdfree(cache);
+	bcache(btree) = NULL;
+}
+/*========================================
+ * purgecache -- Drop all INDEX/BLOCKs from cache
+ *  frees them, except master, which BTREE owns
+ *======================================*/
+void
+purgecache (BTREE btree)
+{
+	BTCACHE cache = bcache(btree);
+	BTCACHEENT *ent;
+	INT n = cache->c_max, hits = cache->c_hits, misses = cache->c_misses;
+	INT evictions = cache->c_evictions;
+	for (ent = cache->c_head; ent; ent = ent->e_next) {
+		if (ent->e_index != bmaster(btree))
+			stdfree(ent->e_index);
 	}
-	stdfree(bcache(btree));
+	stdfree(cache->c_entries);
+	stdfree(cache->c_buckets);
+	stdfree(cache);
+	initcache(btree, n);
+	bcache(btree)->c_hits = hits;
+	bcache(btree)->c_misses = misses;
+	bcache(btree)->c_evictions = evictions;
+}
+/*========================================
+ * resizecache -- Change capacity of index cache
+ *  keeps most recently used entries that fit
+ *======================================*/
+void
+resizecache (BTREE btree, INT n)
+{
+	BTCACHE old = bcache(btree);
+	BTCACHEENT *ent;
+	INT hits = old->c_hits, misses = old->c_misses;
+	INT evictions = old->c_evictions;
+	n = (n < 5) ? 5 : n;
+	if (n == old->c_max) return;
+	initcache(btree, n);
+	/* reinsert from least to most recent, so order is kept */
+	for (ent = old->c_tail; ent; ent = ent->e_prev)
+		cacheindex(btree, ent->e_index);
+	bcache(btree)->c_hits = hits;
+	bcache(btree)->c_misses = misses;
+	bcache(btree)->c_evictions = evictions + bcache(btree)->c_evictions;
+	stdfree(old->c_entries);
+	stdfree(old->c_buckets);
+	stdfree(old);
+}
+/*========================================
+ * unlink_lru -- Take entry out of use-ordered list
+ *======================================*/
+static void
+unlink_lru (BTCACHE cache, BTCACHEENT *ent)
+{
+	if (ent->e_prev) ent->e_prev->e_next = ent->e_next;
+	else cache->c_head = ent->e_next;
+	if (ent->e_next) ent->e_next->e_prev = ent->e_prev;
+	else cache->c_tail = ent->e_prev;
+	ent->e_prev = ent->e_next = NULL;
+}
+/*========================================
+ * push_lru -- Put entry at most recently used end
+ *======================================*/
+static void
+push_lru (BTCACHE cache, BTCACHEENT *ent)
+{
+	ent->e_prev = NULL;
+	ent->e_next = cache->c_head;
+	if (cache->c_head) cache->c_head->e_prev = ent;
+	cache->c_head = ent;
+	if (!cache->c_tail) cache->c_tail = ent;
+}
+/*========================================
+ * evict_lru -- Drop least recently used entry
+ *  returns the (now unused) entry
+ *======================================*/
+static BTCACHEENT *
+evict_lru (BTCACHE cache)
+{
+	BTCACHEENT *ent = cache->c_tail, **pp;
+	ASSERT(ent);
+	unlink_lru(cache, ent);
+	pp = &cache->c_buckets[hash_fkey(cache, ixself(ent->e_index))];
+	while (*pp != ent)
+		pp = &(*pp)->e_hnext;
+	*pp = ent->e_hnext;
+	stdfree(ent->e_index);
+	ent->e_index = NULL;
+	ent->e_hnext = NULL;
+	--cache->c_count;
+	++cache->c_evictions;
+	return ent;
 }
 /*============================================
  * cacheindex -- Place INDEX or BLOCK in cache
+ *  If an entry with the same file key is cached, it is
+ *  replaced (but not freed - the caller owns it)
  *==========================================*/
 static BOOLEAN
 cacheindex (BTREE btree, /* btree handle */
             INDEX index) /* INDEX or BLOCK */
 {
-	INT n = bncache(btree);
-	INDEX *indices = bcache(btree);
-	INT j = incache(btree, ixself(index));
-	if (j == -1) {	/* index not in cache */
-		if (indices[n-1]) stdfree(indices[n-1]);
-		for (j = n - 1; j > 0; --j)
-			indices[j] = indices[j - 1];
-		indices[0] = index;
-	} else {	/* index is in cache */
-		for (; j > 0; --j)
-			indices[j] = indices[j - 1];
-		indices[0] = index;
+	BTCACHE cache = bcache(btree);
+	BTCACHEENT *ent = incache(btree, ixself(index));
+	INT h;
+	if (ent) {	/* index is in cache */
+		ent->e_index = index;
+		unlink_lru(cache, ent);
+		push_lru(cache, ent);
+		return TRUE;
+	}
+	/* index not in cache */
+	if (cache->c_free) {
+		ent = cache->c_free;
+		cache->c_free = ent->e_hnext;
+	} else {
+		ent = evict_lru(cache);
 	}
+	ent->e_index = index;
+	h = hash_fkey(cache, ixself(index));
+	ent->e_hnext = cache->c_buckets[h];
+	cache->c_buckets[h] = ent;
+	push_lru(cache, ent);
+	++cache->c_count;
 	return TRUE;
 }
 /*================================
@@ -190,16 +354,20 @@ cacheindex (BTREE btree, /* btree handle */
 INDEX
 getindex (BTREE btree, FKEY fkey)
 {
-	INT j;
+	BTCACHEENT *ent;
 	INDEX index;
 	if (fkey == ixself(bmaster(btree))) return bmaster(btree);
-	if ((j = incache(btree, fkey)) == -1) {	/* not in cache */
+	if ((ent = incache(btree, fkey)) == NULL) {	/* not in cache */
 		BOOLEAN robust = FALSE; /* abort on error */
+		++bcache(btree)->c_misses;
 		index = readindex(btree, fkey, robust);
 		cacheindex(btree, index);
 		return index;
 	}
-	return (bcache(btree))[j];
+	++bcache(btree)->c_hits;
+	unlink_lru(bcache(btree), ent);
+	push_lru(bcache(btree), ent);
+	return ent->e_index;
 }
 /*=====================================
  * putindex -- Put out index - cache it
@@ -222,17 +390,72 @@ putheader (BTREE btree,
 	cacheindex(btree, (INDEX) block);
 }
 /*============================================================
- * incache -- If INDEX is in cache return index else return -1
+ * uncacheindex -- Drop INDEX or BLOCK from cache, if there
+ *  (for file being removed); frees it, unless it is master
  *==========================================================*/
-static INT
+void
+uncacheindex (BTREE btree, FKEY fkey)
+{
+	BTCACHE cache = bcache(btree);
+	BTCACHEENT *ent = incache(btree, fkey), **pp;
+	if (!ent) return;
+	unlink_lru(cache, ent);
+	pp = &cache->c_buckets[hash_fkey(cache, fkey)];
+	while (*pp != ent)
+		pp = &(*pp)->e_hnext;
+	*pp = ent->e_hnext;
+	if (ent->e_index != bmaster(btree))
+		stdfree(ent->e_index);
+	ent->e_index = NULL;
+	ent->e_hnext = cache->c_free;
+	cache->c_free = ent;
+	--cache->c_count;
+}
+/*============================================================
+ * incache -- If INDEX is in cache return its entry else NULL
+ *==========================================================*/
+static BTCACHEENT *
 incache (BTREE btree,
          FKEY fkey)
 {
-	INT i, n = bncache(btree);
-	INDEX index, *indices = bcache(btree);
-	for (i = 0; i < n; i++) {
-		if ((index = *indices++) == NULL) return -1;
-		if (ixself(index) == fkey) return i;
+	BTCACHE cache = bcache(btree);
+	BTCACHEENT *ent = cache->c_buckets[hash_fkey(cache, fkey)];
+	for ( ; ent; ent = ent->e_hnext) {
+		if (ixself(ent->e_index) == fkey) return ent;
 	}
-	return -1;
+	return NULL;
+}
+/*============================================================
+ * cachedindex -- Return cached INDEX or BLOCK, or NULL
+ *  does not read from disk, nor count as a use
+ *==========================================================*/
+INDEX
+cachedindex (BTREE btree, FKEY fkey)
+{
+	BTCACHEENT *ent;
+	if (fkey == ixself(bmaster(btree))) return bmaster(btree);
+	ent = incache(btree, fkey);
+	return ent ? ent->e_index : NULL;
+}
+/*============================================================
+ * bt_set_index_cache_size -- Change number of cached INDEX/BLOCKs
+ *==========================================================*/
+void
+bt_set_index_cache_size (BTREE btree, INT n)
+{
+	resizecache(btree, n);
+}
+/*============================================================
+ * bt_get_index_cache_stats -- Report index cache effectiveness
+ *  stats: [OUT] counters & current size of cache
+ *==========================================================*/
+void
+bt_get_index_cache_stats (BTREE btree, BTCACHESTATS * stats)
+{
+	BTCACHE cache = bcache(btree);
+	stats->capacity = cache->c_max;
+	stats->count = cache->c_count;
+	stats->hits = cache->c_hits;
+	stats->misses = cache->c_misses;
+	stats->evictions = cache->c_evictions;
 }
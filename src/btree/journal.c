@@ -0,0 +1,720 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * journal.c -- Write-ahead journal for BTREE record writes
+ *  Records written by bt_addrecord are first appended to the
+ *  journal file in the database directory, and held there
+ *  (readable through the pending buffer) until their group
+ *  commits. A group is bt_begin_group .. bt_commit_group (a
+ *  write outside any group is a group by itself).
+ *
+ *  To commit, the journal gets an image of the keyfile (if
+ *  it has none since the last checkpoint), then a commit
+ *  entry, and is synced once. Only then are the records put
+ *  into the tree. Tree files are never changed once their
+ *  version is published (see snapshot.c), so the keyfile,
+ *  naming the master index, is all the journal must image;
+ *  the files of the tree it names are kept until the next
+ *  checkpoint.
+ *
+ *  At a checkpoint the new tree is published, its files are
+ *  synced, and the journal emptied. Recovery, when the
+ *  database is next opened for writing, puts back the master
+ *  index of the last checkpoint, and replays each committed
+ *  group in turn.
+ *===========================================================*/
+
+#include "sys_inc.h"
+#include "llstdlib.h"
+#include "btreei.h"
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* header of each journal entry; data (if any) follows */
+typedef struct {
+	INT32 h_type;    /* JRNL_xxx */
+	INT32 h_len;     /* length of data following */
+	INT32 h_sum;     /* COMMIT: checksum of whole group */
+	FKEY  h_fkey;    /* IMAGE: file imaged (or JRNL_KEYFILE) */
+	RKEY  h_rkey;    /* ADD: record key */
+} JRNLHDR;
+
+enum { JRNL_ADD=1, JRNL_IMAGE, JRNL_COMMIT };
+
+/* called for each entry of a committed group */
+typedef void (*JRNL_FUNC)(FILE * fp, JRNLHDR * hdr, long off, void * param);
+
+/* state carried through recovery */
+typedef struct {
+	FKEYSET    *r_done;    /* files already put back */
+	KEYFILE1   *r_kfile1;  /* keyfile contents being opened */
+	CNSTRING    r_dir;
+	BTREE       r_btree;
+	BTBULK      r_group;   /* records of group being replayed */
+} RECOVERY;
+
+/* stands for keyfile among file keys (aa/aa is 0) */
+#define JRNL_KEYFILE ((FKEY)-1)
+
+#define JRNL_MAGIC "LLJRNL01"
+#define JRNL_MAGICLEN 8
+/* commit early if this many records are pending */
+#define JRNL_MAXPENDING 2048
+/* checkpoint once journal grows past this */
+#define JRNL_CHECKPOINT_SIZE (8*1048576L)
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static BOOLEAN apply_record(RKEY rkey, STRING data, INT len, void * param);
+static void apply_pending(BTREE btree, BTBULK pending);
+static void checksum(INT32 * sum, const void * buf, INT len);
+static FILE * create_journal(CNSTRING path);
+static void file_path(STRING path, INT len, CNSTRING dir, FKEY fkey);
+static INT hash_fkey(FKEYSET * set, FKEY fkey);
+static void image_keyfile(BTREE btree);
+static void note_image(FILE * fp, JRNLHDR * hdr, long off, void * param);
+static void replay_entry(FILE * fp, JRNLHDR * hdr, long off, void * param);
+static void restore_image(FILE * fp, JRNLHDR * hdr, long off, void * param);
+static void scan_journal(FILE * fp, JRNL_FUNC func, void * param);
+static void sync_file(FILE * fp);
+static void sync_path(CNSTRING path);
+static void write_entry(BTJOURNAL jrnl, JRNLHDR * hdr, const void * data);
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * fkeyset_add -- Add file key to set, unless present
+ * returns FALSE if already present
+ *============================================*/
+BOOLEAN
+fkeyset_add (FKEYSET * set, FKEY fkey)
+{
+	INT h, j;
+	if (2 * (set->count + 1) > set->nbuckets) {
+		INT i, n = set->nbuckets ? 2 * set->nbuckets : 128;
+		if (set->hash)
+			stdfree(set->hash);
+		set->hash = (INT *) stdalloc(n * sizeof(INT));
+		memset(set->hash, 0, n * sizeof(INT));
+		set->nbuckets = n;
+		for (i = 0; i < set->count; i++) {
+			h = hash_fkey(set, set->fkeys[i]);
+			while (set->hash[h])
+				h = (h + 1) & (set->nbuckets - 1);
+			set->hash[h] = i + 1;
+		}
+	}
+	h = hash_fkey(set, fkey);
+	while ((j = set->hash[h]) != 0) {
+		if (set->fkeys[j-1] == fkey)
+			return FALSE;
+		h = (h + 1) & (set->nbuckets - 1);
+	}
+	if (set->count == set->max) {
+		FKEY * fkeys;
+		set->max = set->max ? 2 * set->max : 64;
+		fkeys = (FKEY *) stdalloc(set->max * sizeof(FKEY));
+		if (set->count)
+			memcpy(fkeys, set->fkeys, set->count * sizeof(FKEY));
+		if (set->fkeys)
+			stdfree(set->fkeys);
+		set->fkeys = fkeys;
+	}
+	set->fkeys[set->count++] = fkey;
+	set->hash[h] = set->count;
+	return TRUE;
+}
+/*==============================================
+ * fkeyset_has -- Is file key in set ?
+ *============================================*/
+BOOLEAN
+fkeyset_has (FKEYSET * set, FKEY fkey)
+{
+	INT h, j;
+	if (!set->count)
+		return FALSE;
+	h = hash_fkey(set, fkey);
+	while ((j = set->hash[h]) != 0) {
+		if (set->fkeys[j-1] == fkey)
+			return TRUE;
+		h = (h + 1) & (set->nbuckets - 1);
+	}
+	return FALSE;
+}
+/*==============================================
+ * hash_fkey -- Pick first hash bucket for file key
+ *============================================*/
+static INT
+hash_fkey (FKEYSET * set, FKEY fkey)
+{
+	unsigned int h = (unsigned int)fkey * 2654435761U;
+	return (INT)(h & (set->nbuckets - 1));
+}
+/*==============================================
+ * fkeyset_clear -- Empty set & free its storage
+ *============================================*/
+void
+fkeyset_clear (FKEYSET * set)
+{
+	if (set->fkeys)
+		stdfree(set->fkeys);
+	if (set->hash)
+		stdfree(set->hash);
+	memset(set, 0, sizeof(*set));
+}
+/*==============================================
+ * file_path -- Path of tree file (or of keyfile)
+ *============================================*/
+static void
+file_path (STRING path, INT len, CNSTRING dir, FKEY fkey)
+{
+	if (fkey == JRNL_KEYFILE)
+		snprintf(path, len, "%s/key", dir);
+	else
+		snprintf(path, len, "%s/%s", dir, fkey2path(fkey));
+}
+/*==============================================
+ * checksum -- Fold bytes into running group checksum
+ *============================================*/
+static void
+checksum (INT32 * sum, const void * buf, INT len)
+{
+	const unsigned char * p = (const unsigned char *)buf;
+	unsigned int h = (unsigned int)*sum;
+	INT i;
+	for (i = 0; i < len; i++)
+		h = (h ^ p[i]) * 16777619U;
+	*sum = (INT32)h;
+}
+/*==============================================
+ * sync_file -- Flush stream & force it to disk
+ *============================================*/
+static void
+sync_file (FILE * fp)
+{
+	if (fflush(fp) != 0)
+		FATAL();
+#if defined(HAVE_FSYNC)
+	fsync(fileno(fp));
+#elif defined(WIN32)
+	_commit(_fileno(fp));
+#endif
+}
+/*==============================================
+ * sync_path -- Force file to disk (if it exists)
+ *============================================*/
+static void
+sync_path (CNSTRING path)
+{
+	FILE * fp = fopen(path, LLREADBINARYUPDATE);
+	if (fp) {
+		sync_file(fp);
+		fclose(fp);
+	}
+}
+/*==============================================
+ * create_journal -- Create (or empty) journal file
+ *============================================*/
+static FILE *
+create_journal (CNSTRING path)
+{
+	FILE * fp = fopen(path, LLWRITEBINARY "+");
+	if (!fp)
+		return NULL;
+	if (fwrite(JRNL_MAGIC, JRNL_MAGICLEN, 1, fp) != 1) {
+		fclose(fp);
+		return NULL;
+	}
+	return fp;
+}
+/*==============================================
+ * write_entry -- Append entry to journal
+ *  data: [IN]  hdr->h_len bytes (may be NULL if 0)
+ *  (also adds it to checksum of group being written)
+ *============================================*/
+static void
+write_entry (BTJOURNAL jrnl, JRNLHDR * hdr, const void * data)
+{
+	BTBULK pending = jrnl->j_pending;
+	if (fseek(jrnl->j_fp, pending->u_end, SEEK_SET))
+		FATAL();
+	CHECKED_fwrite(hdr, sizeof(*hdr), 1, jrnl->j_fp, jrnl->j_path);
+	if (hdr->h_type != JRNL_COMMIT)
+		checksum(&jrnl->j_sum, hdr, sizeof(*hdr));
+	pending->u_end += sizeof(*hdr);
+	if (hdr->h_len && data) {
+		CHECKED_fwrite(data, hdr->h_len, 1, jrnl->j_fp, jrnl->j_path);
+		checksum(&jrnl->j_sum, data, hdr->h_len);
+		pending->u_end += hdr->h_len;
+	}
+}
+/*==============================================
+ * journal_addrecord -- Add record to pending group
+ *  commits at once if no group is open
+ *============================================*/
+BOOLEAN
+journal_addrecord (BTREE btree, RKEY rkey, RAWRECORD rec, INT len)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	JRNLHDR hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.h_type = JRNL_ADD;
+	hdr.h_len = len;
+	hdr.h_rkey = rkey;
+	write_entry(jrnl, &hdr, NULL);
+	/* data goes in through the buffer, which notes where it is */
+	if (len)
+		checksum(&jrnl->j_sum, rec, len);
+	bulk_addrecord(jrnl->j_pending, rkey, rec, len);
+	/* cursors must find their place again, to see it */
+	++bsnap(btree)->s_writes;
+	if (!bsnap(btree)->s_depth || jrnl->j_pending->u_count >= JRNL_MAXPENDING)
+		journal_commit(btree);
+	return TRUE;
+}
+/*==============================================
+ * journal_pending -- Is record waiting in pending group ?
+ *============================================*/
+BOOLEAN
+journal_pending (BTREE btree, const RKEY * rkey)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	return jrnl && jrnl->j_pending && jrnl->j_pending->u_count
+		&& bulk_isrecord(jrnl->j_pending, *rkey);
+}
+/*==============================================
+ * journal_getrecord -- Get copy of pending record
+ *============================================*/
+RAWRECORD
+journal_getrecord (BTREE btree, const RKEY * rkey, INT *plen)
+{
+	return bulk_getrecord(bjournal(btree)->j_pending, rkey, plen);
+}
+/*==============================================
+ * journal_pendingkeys -- Keys of pending records within span
+ *  lo, hi: [IN]  span, as for traverse_db_rec_rkeys
+ *  pcount: [OUT] number of keys returned
+ * returns keys in order (caller frees), or NULL if none
+ *  Traversals merge these with the tree, so that they see
+ *  writes of an open group without committing it.
+ *============================================*/
+RKEY *
+journal_pendingkeys (BTREE btree, RKEY lo, RKEY hi, INT * pcount)
+{
+	BTBULK pending = bjournaling(btree) ? bjournal(btree)->j_pending : NULL;
+	RKEY * keys;
+	INT i, n=0;
+
+	*pcount = 0;
+	if (!pending || !pending->u_count)
+		return NULL;
+	bulk_sort(pending);
+	keys = (RKEY *) stdalloc(pending->u_count * sizeof(RKEY));
+	for (i = 0; i < pending->u_count; i++) {
+		RKEY * rkey = &pending->u_ents[i].e_rkey;
+		if (lo.r_rkey[0] && ll_strncmp(lo.r_rkey, rkey->r_rkey, 8) >= 0)
+			continue;
+		if (hi.r_rkey[0] && ll_strncmp(hi.r_rkey, rkey->r_rkey, 8) < 0)
+			break;
+		keys[n++] = *rkey;
+	}
+	if (!n) {
+		stdfree(keys);
+		return NULL;
+	}
+	*pcount = n;
+	return keys;
+}
+/*==============================================
+ * image_keyfile -- Append image of keyfile to journal
+ *  unless it already has one since last checkpoint
+ *  (keyfile is held open, so image it from memory)
+ *============================================*/
+static void
+image_keyfile (BTREE btree)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	JRNLHDR hdr;
+
+	if (!fkeyset_add(&jrnl->j_files, JRNL_KEYFILE))
+		return;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.h_type = JRNL_IMAGE;
+	hdr.h_len = sizeof(KEYFILE1);
+	hdr.h_fkey = JRNL_KEYFILE;
+	write_entry(jrnl, &hdr, &bkfile(btree));
+}
+/*==============================================
+ * journal_commit -- Commit pending group
+ *  images keyfile, writes commit entry, syncs journal
+ *  (once), then puts records into tree
+ *============================================*/
+void
+journal_commit (BTREE btree)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	BTBULK pending = jrnl->j_pending;
+	JRNLHDR hdr;
+
+	if (!pending->u_count)
+		return;
+	image_keyfile(btree);
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.h_type = JRNL_COMMIT;
+	hdr.h_sum = jrnl->j_sum;
+	write_entry(jrnl, &hdr, NULL);
+	sync_file(jrnl->j_fp);
+	++jrnl->j_commits;
+	++jrnl->j_syncs;
+
+	apply_pending(btree, pending);
+	jrnl->j_pending = bulk_create(jrnl->j_fp, jrnl->j_path, pending->u_end);
+	jrnl->j_sum = 0;
+	bulk_free(pending);
+	if (jrnl->j_pending->u_end > JRNL_CHECKPOINT_SIZE)
+		journal_checkpoint(btree);
+}
+/*==============================================
+ * apply_pending -- Put records of committed group into tree
+ *  in key order, so replay makes exactly the same changes
+ *============================================*/
+static void
+apply_pending (BTREE btree, BTBULK pending)
+{
+	RKEY lo, hi;
+	BTJOURNAL jrnl = bjournal(btree);
+	lo.r_rkey[0] = 0;
+	hi.r_rkey[0] = 0;
+	jrnl->j_applying = TRUE;
+	bulk_traverse(pending, lo, hi, apply_record, btree);
+	jrnl->j_applying = FALSE;
+	snap_written(btree);
+}
+/*==============================================
+ * apply_record -- Put one committed record into tree
+ *  callback for bulk_traverse from apply_pending
+ *============================================*/
+static BOOLEAN
+apply_record (RKEY rkey, STRING data, INT len, void * param)
+{
+	BTREE btree = (BTREE) param;
+	return bt_addrecord(btree, rkey, data ? data : "", len);
+}
+/*==============================================
+ * journal_newfile -- Note tree file created since checkpoint
+ *  (so checkpoint syncs it)
+ *============================================*/
+void
+journal_newfile (BTREE btree, FKEY fkey)
+{
+	fkeyset_add(&bjournal(btree)->j_files, fkey);
+}
+/*==============================================
+ * journal_checkpoint -- Make tree durable & empty journal
+ *  commits any pending group, & publishes tree, first
+ *============================================*/
+void
+journal_checkpoint (BTREE btree)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	char path[MAXPATHLEN];
+	INT i;
+
+	journal_commit(btree);
+	/* journal is emptied, so its master must be in keyfile */
+	snap_publish(btree);
+	if (jrnl->j_pending->u_end <= JRNL_MAGICLEN && !jrnl->j_files.count)
+		return;
+	sync_file(bkfp(btree));
+	for (i = 0; i < jrnl->j_files.count; i++) {
+		if (jrnl->j_files.fkeys[i] == JRNL_KEYFILE)
+			continue;
+		file_path(path, sizeof(path), bbasedir(btree), jrnl->j_files.fkeys[i]);
+		sync_path(path);
+	}
+	fkeyset_clear(&jrnl->j_files);
+	fclose(jrnl->j_fp);
+	if (!(jrnl->j_fp = create_journal(jrnl->j_path))) {
+		char msg[MAXPATHLEN+64];
+		snprintf(msg, sizeof(msg), "Failed to reset journal: %s", jrnl->j_path);
+		FATAL2(msg);
+	}
+	bulk_free(jrnl->j_pending);
+	jrnl->j_pending = bulk_create(jrnl->j_fp, jrnl->j_path, JRNL_MAGICLEN);
+	++jrnl->j_syncs;
+	/* files of older tree are no longer needed for recovery */
+	snap_checkpointed(btree);
+}
+/*==============================================
+ * scan_journal -- Visit entries of committed groups
+ *  Stops at first torn or uncommitted group, which
+ *  never reached the tree.
+ *============================================*/
+static void
+scan_journal (FILE * fp, JRNL_FUNC func, void * param)
+{
+	char magic[JRNL_MAGICLEN];
+	long start = JRNL_MAGICLEN, pos;
+	char * buf = NULL;
+	INT buflen = 0;
+	INT32 sum = 0;
+	JRNLHDR hdr;
+
+	rewind(fp);
+	if (fread(magic, JRNL_MAGICLEN, 1, fp) != 1
+		|| memcmp(magic, JRNL_MAGIC, JRNL_MAGICLEN))
+		return;
+	pos = start;
+	while (fread(&hdr, sizeof(hdr), 1, fp) == 1) {
+		pos += sizeof(hdr);
+		if (hdr.h_type == JRNL_COMMIT) {
+			long next = pos;
+			if (hdr.h_sum != sum)
+				break;
+			/* good group; visit its entries */
+			if (fseek(fp, start, SEEK_SET))
+				break;
+			pos = start;
+			while (pos < next && fread(&hdr, sizeof(hdr), 1, fp) == 1) {
+				pos += sizeof(hdr);
+				(*func)(fp, &hdr, pos, param);
+				pos += hdr.h_len;
+				if (fseek(fp, pos, SEEK_SET))
+					FATAL();
+			}
+			start = next;
+			sum = 0;
+			continue;
+		}
+		if (hdr.h_type != JRNL_ADD && hdr.h_type != JRNL_IMAGE)
+			break;
+		if (hdr.h_len < 0)
+			break;
+		checksum(&sum, &hdr, sizeof(hdr));
+		if (hdr.h_len > buflen) {
+			if (buf) stdfree(buf);
+			buflen = hdr.h_len;
+			buf = (char *) stdalloc(buflen);
+		}
+		if (hdr.h_len && fread(buf, hdr.h_len, 1, fp) != 1)
+			break;
+		checksum(&sum, buf, hdr.h_len);
+		pos += hdr.h_len;
+	}
+	if (buf) stdfree(buf);
+}
+/*==============================================
+ * journal_restore -- Put back images from journal
+ *  First step of recovery, done while opening database
+ *  for writing, before the master index is read.
+ *  dir:    [IN]  database directory
+ *  kfile1: [I/O] keyfile contents (master is put back
+ *                here, for caller to write)
+ *============================================*/
+void
+journal_restore (CNSTRING dir, KEYFILE1 * kfile1)
+{
+	char path[MAXPATHLEN];
+	FKEYSET done;
+	RECOVERY rec;
+	FILE * fp;
+
+	snprintf(path, sizeof(path), "%s/journal", dir);
+	if (!(fp = fopen(path, LLREADBINARY)))
+		return;
+	memset(&done, 0, sizeof(done));
+	memset(&rec, 0, sizeof(rec));
+	rec.r_done = &done;
+	rec.r_kfile1 = kfile1;
+	rec.r_dir = dir;
+	scan_journal(fp, restore_image, &rec);
+	fclose(fp);
+	fkeyset_clear(&done);
+}
+/*==============================================
+ * restore_image -- Put back file from its first image
+ *  callback for scan_journal from journal_restore
+ *  (first image of a file is its state at checkpoint)
+ *============================================*/
+static void
+restore_image (FILE * fp, JRNLHDR * hdr, long off, void * param)
+{
+	RECOVERY * rec = (RECOVERY *)param;
+	char path[MAXPATHLEN];
+	char * data;
+	FILE * fo;
+
+	off = off; /* unused, fp is positioned at data */
+	if (hdr->h_type != JRNL_IMAGE || !fkeyset_add(rec->r_done, hdr->h_fkey))
+		return;
+	data = (char *) stdalloc(hdr->h_len + 1);
+	if (hdr->h_len && fread(data, hdr->h_len, 1, fp) != 1)
+		FATAL();
+	if (hdr->h_fkey == JRNL_KEYFILE) {
+		/* next file key is left alone, so as not to reuse
+		those of files written since (which may be read) */
+		KEYFILE1 * kimage = (KEYFILE1 *)data;
+		rec->r_kfile1->k_mkey = kimage->k_mkey;
+	} else {
+		/* journal of older version, which imaged tree files */
+		file_path(path, sizeof(path), rec->r_dir, hdr->h_fkey);
+		if (!mkalldirs(path) || !(fo = fopen(path, LLWRITEBINARY))
+			|| (hdr->h_len && fwrite(data, hdr->h_len, 1, fo) != 1)) {
+			char msg[sizeof(path)+64];
+			snprintf(msg, sizeof(msg), "Failed to restore file from journal: %s", path);
+			FATAL2(msg);
+		}
+		sync_file(fo);
+		fclose(fo);
+	}
+	stdfree(data);
+}
+/*==============================================
+ * journal_open -- Start journalling writes to btree
+ *  Replays whatever the journal holds (as recovery, after
+ *  journal_restore), checkpoints, and leaves journal empty.
+ * returns FALSE if journal file could not be created
+ *============================================*/
+BOOLEAN
+journal_open (BTREE btree)
+{
+	BTJOURNAL jrnl;
+	RECOVERY rec;
+	FILE * fp;
+
+	if (!bwrite(btree) || bjournal(btree))
+		return FALSE;
+	jrnl = (BTJOURNAL) stdalloc(sizeof(*jrnl));
+	memset(jrnl, 0, sizeof(*jrnl));
+	snprintf(jrnl->j_path, sizeof(jrnl->j_path), "%s/journal", bbasedir(btree));
+	bjournal(btree) = jrnl;
+
+	/* replay committed groups, then sync tree, before emptying journal */
+	if ((fp = fopen(jrnl->j_path, LLREADBINARY)) != NULL) {
+		memset(&rec, 0, sizeof(rec));
+		rec.r_btree = btree;
+		scan_journal(fp, note_image, &rec);
+		scan_journal(fp, replay_entry, &rec);
+		fclose(fp);
+		if (jrnl->j_files.count) {
+			char path[MAXPATHLEN];
+			INT i;
+			sync_file(bkfp(btree));
+			for (i = 0; i < jrnl->j_files.count; i++) {
+				if (jrnl->j_files.fkeys[i] == JRNL_KEYFILE)
+					continue;
+				file_path(path, sizeof(path), bbasedir(btree), jrnl->j_files.fkeys[i]);
+				sync_path(path);
+			}
+		}
+		fkeyset_clear(&jrnl->j_files);
+	}
+	if (!(jrnl->j_fp = create_journal(jrnl->j_path))) {
+		stdfree(jrnl);
+		bjournal(btree) = NULL;
+		return FALSE;
+	}
+	jrnl->j_pending = bulk_create(jrnl->j_fp, jrnl->j_path, JRNL_MAGICLEN);
+	snap_checkpointed(btree);
+	return TRUE;
+}
+/*==============================================
+ * note_image -- Note file put back by recovery
+ *  callback for scan_journal from journal_open
+ *============================================*/
+static void
+note_image (FILE * fp, JRNLHDR * hdr, long off, void * param)
+{
+	RECOVERY * rec = (RECOVERY *)param;
+	fp = fp; /* unused */
+	off = off; /* unused */
+	if (hdr->h_type == JRNL_IMAGE)
+		fkeyset_add(&bjournal(rec->r_btree)->j_files, hdr->h_fkey);
+}
+/*==============================================
+ * replay_entry -- Gather records of committed group, and
+ *  put them into tree at its commit (as journal_commit did)
+ *  callback for scan_journal from journal_open
+ *============================================*/
+static void
+replay_entry (FILE * fp, JRNLHDR * hdr, long off, void * param)
+{
+	RECOVERY * rec = (RECOVERY *)param;
+	if (!rec->r_group)
+		rec->r_group = bulk_create(fp, bjournal(rec->r_btree)->j_path, 0);
+	if (hdr->h_type == JRNL_ADD) {
+		bulk_putentry(rec->r_group, hdr->h_rkey, off, hdr->h_len);
+	} else if (hdr->h_type == JRNL_COMMIT) {
+		/* scan_journal repositions fp after this */
+		apply_pending(rec->r_btree, rec->r_group);
+		bulk_free(rec->r_group);
+		rec->r_group = NULL;
+	}
+}
+/*==============================================
+ * journal_close -- Checkpoint & remove journal
+ *============================================*/
+void
+journal_close (BTREE btree)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	if (!jrnl)
+		return;
+	journal_checkpoint(btree);
+	fclose(jrnl->j_fp);
+	unlink(jrnl->j_path);
+	bulk_free(jrnl->j_pending);
+	fkeyset_clear(&jrnl->j_files);
+	stdfree(jrnl);
+	bjournal(btree) = NULL;
+}
+/*==============================================
+ * bt_set_journal -- Turn journalling of writes on or off
+ *============================================*/
+void
+bt_set_journal (BTREE btree, BOOLEAN on)
+{
+	if (on && !bjournal(btree))
+		journal_open(btree);
+	else if (!on && bjournal(btree))
+		journal_close(btree);
+}
+/*==============================================
+ * bt_get_journal_stats -- Report group commits & syncs
+ *============================================*/
+void
+bt_get_journal_stats (BTREE btree, INT * commits, INT * syncs)
+{
+	BTJOURNAL jrnl = bjournal(btree);
+	*commits = jrnl ? jrnl->j_commits : 0;
+	*syncs = jrnl ? jrnl->j_syncs : 0;
+}
@@ -0,0 +1,220 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * lock.c -- Advisory locks coordinating writer & readers
+ *  Locks are taken on byte ranges of the file "lock" in the
+ *  database directory (not on the keyfile, as closing any
+ *  descriptor of a file drops a process's locks on it, and
+ *  the keyfile is opened elsewhere, eg, by lldump).
+ *  The operating system drops the locks of a process which
+ *  dies, so a crashed writer or reader leaves nothing behind.
+ *
+ *  BTLOCK_WRITER    exclusive, held by the writer while open
+ *  BTLOCK_SWAP      exclusive while the writer writes the
+ *                   keyfile; shared while a reader opening
+ *                   reads it & locks its version
+ *  BTLOCK_VERSIONS  + version: shared, held by each reader on
+ *                   the version of the tree it is reading
+ *===========================================================*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include "sys_inc.h"
+#include "llstdlib.h"
+/* llstdlib.h pulls in config.h */
+#ifdef WIN32
+#include <windows.h>
+#define BTLOCK_USE_WIN32 1
+#elif defined(F_SETLK)
+#define BTLOCK_USE_FCNTL 1
+#endif
+#include "btreei.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static BOOLEAN set_lock(int fd, long off, long len, int type, BOOLEAN wait);
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * lockfile_open -- Open (creating if need be) lock file
+ *  dir:     [IN]  database directory
+ * returns descriptor, or -1 if locking is not available
+ *  (not supported, or file can neither be created nor read,
+ *  in which case no writer can be using the database either)
+ *============================================*/
+int
+lockfile_open (CNSTRING dir)
+{
+#if defined(BTLOCK_USE_FCNTL) || defined(BTLOCK_USE_WIN32)
+	char path[MAXPATHLEN];
+	int fd;
+	snprintf(path, sizeof(path), "%s%c%s", dir, LLCHRDIRSEPARATOR, "lock");
+	if ((fd = open(path, O_RDWR | O_CREAT | O_BINARY, 0666)) == -1)
+		fd = open(path, O_RDONLY | O_BINARY);
+	return fd;
+#else
+	dir = dir; /* unused */
+	return -1;
+#endif
+}
+/*==============================================
+ * lockfile_close -- Close lock file, dropping its locks
+ *============================================*/
+void
+lockfile_close (int fd)
+{
+	if (fd != -1)
+		close(fd);
+}
+/*==============================================
+ * set_lock -- Lock or unlock byte range of lock file
+ *  type: [IN]  1=shared, 2=exclusive, 0=unlock
+ *  len:  [IN]  0 means to end of file (& beyond)
+ *  wait: [IN]  block until lock is granted ?
+ * returns FALSE if lock is held by another process
+ *============================================*/
+static BOOLEAN
+set_lock (int fd, long off, long len, int type, BOOLEAN wait)
+{
+#if defined(BTLOCK_USE_FCNTL)
+	struct flock fl;
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = (type == 2) ? F_WRLCK : (type == 1) ? F_RDLCK : F_UNLCK;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = (off_t)off;
+	fl.l_len = (off_t)len;
+	while (fcntl(fd, wait ? F_SETLKW : F_SETLK, &fl) == -1) {
+		if (errno != EINTR || !wait)
+			return FALSE;
+	}
+	return TRUE;
+#elif defined(BTLOCK_USE_WIN32)
+	HANDLE h = (HANDLE)_get_osfhandle(fd);
+	DWORD lenlo = len ? (DWORD)len : MAXDWORD;
+	DWORD lenhi = len ? 0 : MAXDWORD;
+	OVERLAPPED ov;
+	memset(&ov, 0, sizeof(ov));
+	ov.Offset = (DWORD)off;
+	if (!type)
+		return UnlockFileEx(h, 0, lenlo, lenhi, &ov) ? TRUE : FALSE;
+	return LockFileEx(h
+		, (type == 2 ? LOCKFILE_EXCLUSIVE_LOCK : 0)
+			| (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY)
+		, 0, lenlo, lenhi, &ov) ? TRUE : FALSE;
+#else
+	fd = fd; /* unused */
+	off = off; /* unused */
+	len = len; /* unused */
+	type = type; /* unused */
+	wait = wait; /* unused */
+	return TRUE;
+#endif
+}
+/*==============================================
+ * lockfile_lock -- Take lock on byte range
+ *  excl: [IN]  exclusive (else shared) ?
+ *  wait: [IN]  block until granted (else fail at once) ?
+ * returns FALSE if not granted
+ *============================================*/
+BOOLEAN
+lockfile_lock (int fd, long off, long len, BOOLEAN excl, BOOLEAN wait)
+{
+	if (fd == -1)
+		return TRUE;
+	return set_lock(fd, off, len, excl ? 2 : 1, wait);
+}
+/*==============================================
+ * lockfile_unlock -- Release lock on byte range
+ *============================================*/
+void
+lockfile_unlock (int fd, long off, long len)
+{
+	if (fd != -1)
+		set_lock(fd, off, len, 0, FALSE);
+}
+/*==============================================
+ * lockfile_busy -- Does another process hold any lock
+ *  in byte range ?
+ *  len: [IN]  0 means to end of file (& beyond)
+ *============================================*/
+BOOLEAN
+lockfile_busy (int fd, long off, long len)
+{
+#if defined(BTLOCK_USE_FCNTL)
+	struct flock fl;
+	if (fd == -1)
+		return FALSE;
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = (off_t)off;
+	fl.l_len = (off_t)len;
+	if (fcntl(fd, F_GETLK, &fl) == -1)
+		return TRUE; /* cannot tell, so assume so */
+	return fl.l_type != F_UNLCK;
+#else
+	/* no way to ask, so try for it */
+	if (fd == -1 || !set_lock(fd, off, len, 2, FALSE))
+		return fd != -1;
+	set_lock(fd, off, len, 0, FALSE);
+	return FALSE;
+#endif
+}
+/*==============================================
+ * bt_database_in_use -- Is database open by anyone ?
+ *  (for changes which need it unused, such as locking it)
+ *  Not for a database this process has open, as closing the
+ *  lock file here would drop this process's locks on it.
+ *  dir:     [IN]  database directory
+ *  lldberr: [OUT] BTERR_WRITER or BTERR_READERS, if in use
+ *============================================*/
+BOOLEAN
+bt_database_in_use (CNSTRING dir, INT *lldberr)
+{
+	int fd = lockfile_open(dir);
+	BOOLEAN used = FALSE;
+	if (fd == -1)
+		return FALSE;
+	if (lockfile_busy(fd, BTLOCK_WRITER, 1)) {
+		*lldberr = BTERR_WRITER;
+		used = TRUE;
+	} else if (lockfile_busy(fd, BTLOCK_SWAP, 0)) {
+		/* readers (or one opening) */
+		*lldberr = BTERR_READERS;
+		used = TRUE;
+	}
+	lockfile_close(fd);
+	return used;
+}
@@ -81,9 +81,12 @@ struct _lldberrstr
  *********************************************/
 
 /* alphabetical */
+static BOOLEAN clear_format(BTREE btree, BLOCK block, void * param);
 static void init_keyfile1(KEYFILE1 * kfile1);
 static void init_keyfile2(KEYFILE2 * kfile2);
 static BOOLEAN initbtree (STRING basedir, INT *lldberr);
+static BOOLEAN write_keyfile_ok(BTREE btree);
+static BOOLEAN write_keyfile2_version(BTREE btree, INT32 version);
 
 /*********************************************
  * local function definitions
@@ -133,7 +136,8 @@ validate_keyfile2 (KEYFILE2 * kfile2, INT *lldberr)
 		*lldberr = BTERR_ALIGNKF;
 		return FALSE;
 	}
-	if (kfile2->version != KF2_VER)
+	if ((kfile2->version & ~KF2_VER_NAMES) != KF2_VER
+		&& (kfile2->version & ~KF2_VER_NAMES) != KF2_VER_ZIP)
 	{
 		*lldberr = BTERR_VERKF;
 		return FALSE;
@@ -160,7 +164,10 @@ bt_openbtree (STRING dir, BOOLEAN cflag, INT writ, BOOLEAN immut, INT *lldberr)
 	struct stat sbuf;
 	KEYFILE1 kfile1;
 	KEYFILE2 kfile2;
+	KEYFILE3 kfile3;
 	BOOLEAN keyed2 = FALSE;
+	BOOLEAN writer = FALSE, crashed = FALSE, swapped = FALSE;
+	int lockfd = -1;
 	STRING dbmode;
 
 	/* we only allow 150 characters in base directory name */
@@ -232,6 +239,13 @@ immutretry:
 		*lldberr = BTERR_KFILE;
 		goto failopenbtree;
 	}
+	/* writer is whoever holds writer lock (see lock.c) */
+	lockfd = lockfile_open(dir);
+	writer = writ>0 && !immut
+		&& lockfile_lock(lockfd, BTLOCK_WRITER, 1, TRUE, FALSE);
+	/* keep keyfile from changing while we read it */
+	lockfile_lock(lockfd, BTLOCK_SWAP, 1, writer, TRUE);
+	swapped = TRUE;
 	if (fread(&kfile1, sizeof(kfile1), 1, fk) != 1) {
 		*lldberr = BTERR_KFILE;
 		goto failopenbtree;
@@ -243,24 +257,39 @@ immutretry:
 			goto failopenbtree; /* validate set *lldberr */
 		keyed2=TRUE;
 	}
-	if (writ < 2 && kfile1.k_ostat == -2)
+	/* KEYFILE3 is absent from databases last written before it */
+	if (!keyed2 || fread(&kfile3, sizeof(kfile3), 1, fk) != 1)
+		kfile3.k_version = 0;
+	if (writ < 2 && kfile1.k_ostat == -2) {
 		immut = TRUE; /* keyfile contains the flag for immutable access only */
-	/* if not immutable, handle reader/writer protection update */
+		if (writer)
+			lockfile_unlock(lockfd, BTLOCK_WRITER, 1);
+		writer = FALSE;
+	}
+	/* if not immutable, handle reader/writer protection */
 	if (!immut) {
-		if (kfile1.k_ostat == -1) {
-			*lldberr = BTERR_WRITER;
-			goto failopenbtree;
-		}
 		if (kfile1.k_ostat == -2) {
 			*lldberr = BTERR_LOCKED;
 			goto failopenbtree;
 		}
-
+		/* without locking, ostat is all that shows a writer */
+		if (lockfd == -1 && kfile1.k_ostat == -1)
+			writer = FALSE;
+		if (!writer && (writ == 2 || (lockfd == -1 && kfile1.k_ostat == -1))) {
+			*lldberr = BTERR_WRITER;
+			goto failopenbtree;
+		}
+	}
+	if (writer) {
+		/* ostat of -1 with no writer lock held is a crashed writer */
+		INT32 mkey = kfile1.k_mkey;
+		crashed = (kfile1.k_ostat == -1);
+		/* writer puts back files of any interrupted commit */
+		journal_restore(dir, &kfile1);
+		if (kfile1.k_mkey != mkey)
+			++kfile3.k_version;
 	/* Update key file for this new opening */
-		if (writ>0 && (kfile1.k_ostat == 0))
-			kfile1.k_ostat = -1;
-		else
-			kfile1.k_ostat++;
+		kfile1.k_ostat = -1;
 		rewind(fk);
 		if (fwrite(&kfile1, sizeof(kfile1), 1, fk) != 1) {
 			*lldberr = BTERR_KFILE;
@@ -274,10 +303,22 @@ immutretry:
 				goto failopenbtree;
 			}
 		}
-		if (fflush(fk) != 0) {
+		if (fseek(fk, (long)(sizeof(kfile1) + sizeof(kfile2)), SEEK_SET)
+			|| fwrite(&kfile3, sizeof(kfile3), 1, fk) != 1
+			|| fflush(fk) != 0) {
 			*lldberr = BTERR_KFILE;
 			goto failopenbtree;
 		}
+	} else if (!immut) {
+		/* reader pins version it read (see snapshot.c) */
+		lockfile_lock(lockfd, BTLOCK_VERSIONS + kfile3.k_version, 1, FALSE, TRUE);
+	}
+	lockfile_unlock(lockfd, BTLOCK_SWAP, 1);
+	swapped = FALSE;
+	if (immut) {
+		/* nobody may write immutable database, so no locks needed */
+		lockfile_close(lockfd);
+		lockfd = -1;
 	}
 
 /* Create BTREE structure */
@@ -293,17 +334,32 @@ immutretry:
 		goto failopenbtree;
 	}
 	
-	bwrite(btree) = !immut && writ && (kfile1.k_ostat == -1);
+	bwrite(btree) = !immut && writ && writer;
 	bimmut(btree) = immut; /* includes case that ostat is -2 */
 	bkfp(btree) = fk;
 	btree->b_kfile.k_mkey = kfile1.k_mkey;
 	btree->b_kfile.k_fkey = kfile1.k_fkey;
 	btree->b_kfile.k_ostat = kfile1.k_ostat;
-	initcache(btree, 20);
+	btree->b_kfile3 = kfile3;
+	bkf2ver(btree) = keyed2 ? kfile2.version : KF2_VER;
+	bzip(btree) = bkf2zip(btree);
+	blockfd(btree) = lockfd;
+	initcache(btree, BTCACHE_DEFAULT_SIZE);
+	bcompact(btree) = BTCOMPACT_DEFAULT_PCT;
+	/* readers are mapped; writer never changes files they read */
+	bfdpool(btree) = fdpool_create(BTFDPOOL_SIZE, !bwrite(btree));
+	/* writer replays committed groups from journal, & keeps journal */
+	if (bwrite(btree)) {
+		snap_open(btree, crashed);
+		journal_open(btree);
+	}
 	return btree;
 
 failopenbtree:
 	if (fk) fclose(fk);
+	if (swapped)
+		lockfile_unlock(lockfd, BTLOCK_SWAP, 1);
+	lockfile_close(lockfd);
 	return NULL;
 }
 /*==================================
@@ -414,51 +470,26 @@ initbtree_exit:
 BOOLEAN
 closebtree (BTREE btree)
 {
-	FILE *fk=NULL;
-	KEYFILE1 kfile1;
-	BOOLEAN result=FALSE;
-	if (btree && ((fk = bkfp(btree)) != NULL) && !bimmut(btree)) {
-		kfile1 = btree->b_kfile;
-		if (kfile1.k_ostat <= 0) {
-			/* writer-locked, should be -1 because we don't
-			cater for multiple writers */
-			kfile1.k_ostat = 0;
-		} else { /* read-only, get current shared status */
-			rewind(fk);
-			if (fread(&kfile1, sizeof(kfile1), 1, fk) != 1) {
-				/* *lldberr = BTERR_KFILE */
-				/* closebtree does not report specific errors */
-				goto exit_closebtree;
-			}
-			if (kfile1.k_ostat <= 0) {
-				/* probably someone has forcibly opened it for write,
-				making this -1, and may also have since closed it, leaving
-				it at 0 */
-				result=TRUE;
-				goto exit_closebtree;
-			}
-			kfile1.k_ostat--;
-		}
-		rewind(fk);
-		if (fwrite(&kfile1, sizeof(kfile1), 1, fk) != 1) {
-			/* *lldberr = BTERR_KFILE */
-			/* closebtree does not report specific errors */
-			goto exit_closebtree;
-		}
-		if (fclose(fk) != 0) {
-			fk = NULL;
-			/* *lldberr = BTERR_KFILE; */
-			goto exit_closebtree;
-		}
-		fk = NULL;
-
-		result=TRUE;
-	} else {
-		result=TRUE;
+	BOOLEAN result=TRUE;
+	/* finish any bulk load rather than lose it */
+	if (btree && bbulk(btree))
+		bt_bulk_end(btree);
+	if (btree && bjournal(btree))
+		journal_close(btree);
+	if (btree && bsnap(btree))
+		snap_close(btree);
+	if (btree && bwrite(btree)) {
+		/* writer marks keyfile closed (readers leave it alone) */
+		lockfile_lock(blockfd(btree), BTLOCK_SWAP, 1, TRUE, TRUE);
+		bkfile(btree).k_ostat = 0;
+		result = write_keyfile_ok(btree);
+		lockfile_unlock(blockfd(btree), BTLOCK_SWAP, 1);
 	}
-exit_closebtree:
-	if (fk) fclose(fk);
 	if (btree) {
+		if (bkfp(btree) && fclose(bkfp(btree)) != 0)
+			result = FALSE;
+		lockfile_close(blockfd(btree));
+		fdpool_free(bfdpool(btree));
 		freecache(btree);
 		if(bmaster(btree)) {
 			stdfree(bmaster(btree));
@@ -468,6 +499,121 @@ exit_closebtree:
 	}
 	return result;
 }
+/*==========================
+ * bt_set_compress -- Set whether blocks written from now on
+ *  hold compressed records (see compress.c)
+ *  Turning it on marks the keyfile as holding compressed
+ *  records (which older versions then refuse to open).
+ *  The format field of block headers was padding until then,
+ *  so it is first cleared in every block of the tree.
+ * returns FALSE if keyfile could not be marked
+ *========================*/
+BOOLEAN
+bt_set_compress (BTREE btree, BOOLEAN on)
+{
+	if (!bwrite(btree))
+		return !on;
+	if (on && !bkf2zip(btree)) {
+		INT32 version = KF2_VER_ZIP | (bkf2ver(btree) & KF2_VER_NAMES);
+		/* recovery must not go back to a tree not cleared */
+		if (bjournal(btree))
+			journal_checkpoint(btree);
+		traverse_index_blocks(btree, bmaster(btree), NULL, NULL, clear_format);
+		if (!write_keyfile2_version(btree, version))
+			return FALSE;
+	}
+	bzip(btree) = on;
+	return TRUE;
+}
+/*==========================
+ * clear_format -- Zero format field of block header
+ *  written before it had one (rewriting header in place,
+ *  which readers of older versions do not look at)
+ *  callback for traverse_index_blocks from bt_set_compress
+ *========================*/
+static BOOLEAN
+clear_format (BTREE btree, BLOCK block, void * param)
+{
+	char scratch[MAXPATHLEN];
+	INDEX cached;
+	FILE *fp;
+
+	param = param; /* unused */
+	if (!blockformat(block))
+		return TRUE;
+	setblockformat(block, 0);
+	snprintf(scratch, sizeof(scratch), "%s/%s", bbasedir(btree), fkey2path(ixself(block)));
+	if (!(fp = fopen(scratch, LLREADBINARYUPDATE LLFILERANDOM)))
+		FATAL2(scratch);
+	CHECKED_fwrite(block, BUFLEN, 1, fp, scratch);
+	CHECKED_fclose(fp, scratch);
+	if ((cached = cachedindex(btree, ixself(block))))
+		setblockformat((BLOCK)cached, 0);
+	return TRUE;
+}
+/*==========================
+ * bt_set_split_names -- Mark keyfile as allowing name records
+ *  split into parts (see gedlib/names.c), which older versions
+ *  then refuse to open
+ * returns FALSE if keyfile could not be marked
+ *========================*/
+BOOLEAN
+bt_set_split_names (BTREE btree)
+{
+	if (!bwrite(btree))
+		return FALSE;
+	if (bkf2names(btree))
+		return TRUE;
+	return write_keyfile2_version(btree, bkf2ver(btree) | KF2_VER_NAMES);
+}
+/*==========================
+ * write_keyfile2_version -- Rewrite KEYFILE2 with new version
+ *========================*/
+static BOOLEAN
+write_keyfile2_version (BTREE btree, INT32 version)
+{
+	KEYFILE2 kfile2;
+	FILE *fk = bkfp(btree);
+	BOOLEAN ok;
+
+	init_keyfile2(&kfile2);
+	kfile2.version = version;
+	lockfile_lock(blockfd(btree), BTLOCK_SWAP, 1, TRUE, TRUE);
+	ok = !fseek(fk, (long)sizeof(KEYFILE1), SEEK_SET)
+		&& fwrite(&kfile2, sizeof(kfile2), 1, fk) == 1
+		&& fflush(fk) == 0;
+	lockfile_unlock(blockfd(btree), BTLOCK_SWAP, 1);
+	if (ok)
+		bkf2ver(btree) = version;
+	return ok;
+}
+/*==========================
+ * write_keyfile -- Write keyfile from BTREE
+ *  (KEYFILE1 & KEYFILE3; KEYFILE2 does not change)
+ *========================*/
+void
+write_keyfile (BTREE btree)
+{
+	if (!write_keyfile_ok(btree))
+		FATAL2("Error writing keyfile");
+}
+/*==========================
+ * write_keyfile_ok -- Write keyfile from BTREE
+ * returns FALSE if it could not be written
+ *========================*/
+static BOOLEAN
+write_keyfile_ok (BTREE btree)
+{
+	FILE *fk = bkfp(btree);
+	rewind(fk);
+	if (fwrite(&bkfile(btree), sizeof(KEYFILE1), 1, fk) != 1)
+		return FALSE;
+	if (fseek(fk, (long)(sizeof(KEYFILE1) + sizeof(KEYFILE2)), SEEK_SET))
+		return FALSE;
+	if (fwrite(&btree->b_kfile3, sizeof(KEYFILE3), 1, fk) != 1)
+		return FALSE;
+	return fflush(fk) == 0;
+}
 /*============================================
  * getlldberrstr - Get string for lldberr value
  *==========================================*/
@@ -0,0 +1,622 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * snapshot.c -- Published versions of BTREE, which readers
+ *  can go on reading while the writer changes the tree
+ *  The writer never changes a file which is in a published
+ *  version. The first change to an index or block in a new
+ *  version goes to a copy under a new file key, as does the
+ *  change this makes to its parent, and so on up to a new
+ *  master index. The keyfile is then rewritten, naming the
+ *  new master & the next version number, when the writes are
+ *  published (after each write, or at the end of a group).
+ *
+ *  A reader pins the version it opened with a shared lock on
+ *  that version's byte of the lock file (see lock.c), and so
+ *  reads one consistent tree however far the writer goes on.
+ *  A file freed by a version is removed once no reader holds
+ *  any version which had it (and, when journalling, once the
+ *  journal no longer needs it for recovery); its file key is
+ *  then reused.
+ *
+ *  Files freed but not yet removed when the writer closes are
+ *  listed in the file "free", for the next writer. After a
+ *  crash, the next writer sweeps out any files left behind,
+ *  once no readers remain.
+ *===========================================================*/
+
+#include "sys_inc.h"
+#include "llstdlib.h"
+#include "btreei.h"
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static void add_freed(BTSNAP snap, FKEY fkey, INT32 born, INT32 gone, BOOLEAN held);
+static BOOLEAN add_liveblock(BTREE btree, BLOCK block, void * param);
+static BOOLEAN add_liveindex(BTREE btree, INDEX index, void * param);
+static INT32 born_lookup(BTSNAP snap, FKEY fkey);
+static void born_set(BTSNAP snap, FKEY fkey, INT32 version);
+static void drop_file(BTREE btree, FKEY fkey);
+static INT hash_fkey(BTSNAP snap, FKEY fkey);
+static BOOLEAN own_master(BTREE btree);
+static void push_reuse(BTSNAP snap, FKEY fkey);
+static void read_freelist(BTREE btree);
+static void reclaim(BTREE btree);
+static void sweep(BTREE btree);
+static void write_freelist(BTREE btree);
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+#define SNAP_FREEMAGIC "LLFREE01"
+#define SNAP_FREEMAGICLEN 8
+/* number of file keys nextfkey can hand out */
+#define SNAP_MAXFKEYS (676*676)
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * snap_open -- Start tracking versions for writer
+ *  crashed: [IN]  did previous writer not close database ?
+ *============================================*/
+void
+snap_open (BTREE btree, BOOLEAN crashed)
+{
+	BTSNAP snap = (BTSNAP) stdalloc(sizeof(*snap));
+	memset(snap, 0, sizeof(*snap));
+	bsnap(btree) = snap;
+	read_freelist(btree);
+	snap->s_sweep = crashed;
+}
+/*==============================================
+ * snap_close -- Publish last writes, & remove what
+ *  files can be, listing the rest for next writer
+ *============================================*/
+void
+snap_close (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	if (!snap)
+		return;
+	snap->s_depth = 0;
+	snap->s_holds = 0;
+	snap_publish(btree);
+	reclaim(btree);
+	write_freelist(btree);
+	fkeyset_clear(&snap->s_fresh);
+	if (snap->s_freed)
+		stdfree(snap->s_freed);
+	if (snap->s_reuse)
+		stdfree(snap->s_reuse);
+	if (snap->s_born)
+		stdfree(snap->s_born);
+	stdfree(snap);
+	bsnap(btree) = NULL;
+}
+/*==============================================
+ * snap_newfkey -- File key for new file of tree
+ *  reuses that of a removed file, if any
+ *============================================*/
+FKEY
+snap_newfkey (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	FKEY fkey;
+	if (snap->s_nreuse)
+		fkey = snap->s_reuse[--snap->s_nreuse];
+	else {
+		fkey = bkfile(btree).k_fkey;
+		nextfkey(btree);
+	}
+	fkeyset_add(&snap->s_fresh, fkey);
+	snap->s_dirty = TRUE;
+	if (bjournal(btree))
+		journal_newfile(btree, fkey);
+	return fkey;
+}
+/*==============================================
+ * snap_freefile -- Note file no longer in tree
+ *  (it is removed once no reader can need it)
+ *============================================*/
+void
+snap_freefile (BTREE btree, FKEY fkey)
+{
+	BTSNAP snap = bsnap(btree);
+	INT32 born = fkeyset_has(&snap->s_fresh, fkey) ? -1 : born_lookup(snap, fkey);
+	BOOLEAN held = bjournal(btree) && !fkeyset_has(&bjournal(btree)->j_files, fkey);
+	add_freed(snap, fkey, born, 0, held);
+	snap->s_dirty = TRUE;
+}
+/*==============================================
+ * add_freed -- Append entry to list of freed files
+ *============================================*/
+static void
+add_freed (BTSNAP snap, FKEY fkey, INT32 born, INT32 gone, BOOLEAN held)
+{
+	BTFREED * ent;
+	if (snap->s_nfreed == snap->s_maxfreed) {
+		BTFREED * freed;
+		snap->s_maxfreed = snap->s_maxfreed ? 2 * snap->s_maxfreed : 64;
+		freed = (BTFREED *) stdalloc(snap->s_maxfreed * sizeof(BTFREED));
+		if (snap->s_nfreed)
+			memcpy(freed, snap->s_freed, snap->s_nfreed * sizeof(BTFREED));
+		if (snap->s_freed)
+			stdfree(snap->s_freed);
+		snap->s_freed = freed;
+	}
+	ent = &snap->s_freed[snap->s_nfreed++];
+	ent->f_fkey = fkey;
+	ent->f_born = born;
+	ent->f_gone = gone;
+	ent->f_held = held;
+}
+/*==============================================
+ * push_reuse -- Add file key of removed file to reuse list
+ *============================================*/
+static void
+push_reuse (BTSNAP snap, FKEY fkey)
+{
+	if (snap->s_nreuse == snap->s_maxreuse) {
+		FKEY * reuse;
+		snap->s_maxreuse = snap->s_maxreuse ? 2 * snap->s_maxreuse : 64;
+		reuse = (FKEY *) stdalloc(snap->s_maxreuse * sizeof(FKEY));
+		if (snap->s_nreuse)
+			memcpy(reuse, snap->s_reuse, snap->s_nreuse * sizeof(FKEY));
+		if (snap->s_reuse)
+			stdfree(snap->s_reuse);
+		snap->s_reuse = reuse;
+	}
+	snap->s_reuse[snap->s_nreuse++] = fkey;
+}
+/*==============================================
+ * hash_fkey -- Pick first bucket of born map for file key
+ *============================================*/
+static INT
+hash_fkey (BTSNAP snap, FKEY fkey)
+{
+	unsigned int h = (unsigned int)fkey * 2654435761U;
+	return (INT)(h & (snap->s_nbuckets - 1));
+}
+/*==============================================
+ * born_lookup -- Version in which file was published
+ *  0 (so, any version) if not published by this writer
+ *============================================*/
+static INT32
+born_lookup (BTSNAP snap, FKEY fkey)
+{
+	INT h;
+	if (!snap->s_nbuckets)
+		return 0;
+	for (h = hash_fkey(snap, fkey); snap->s_born[h].b_fkey != -1
+		; h = (h + 1) & (snap->s_nbuckets - 1)) {
+		if (snap->s_born[h].b_fkey == fkey)
+			return snap->s_born[h].b_version;
+	}
+	return 0;
+}
+/*==============================================
+ * born_set -- Note version in which file was published
+ *  (file keys are reused, so entries are never removed)
+ *============================================*/
+static void
+born_set (BTSNAP snap, FKEY fkey, INT32 version)
+{
+	INT h;
+	if (2 * (snap->s_nborn + 1) > snap->s_nbuckets) {
+		BTBORN * old = snap->s_born;
+		INT i, n = snap->s_nbuckets;
+		snap->s_nbuckets = n ? 2 * n : 256;
+		snap->s_born = (BTBORN *) stdalloc(snap->s_nbuckets * sizeof(BTBORN));
+		for (i = 0; i < snap->s_nbuckets; i++)
+			snap->s_born[i].b_fkey = -1;
+		for (i = 0; i < n; i++) {
+			if (old[i].b_fkey == -1)
+				continue;
+			h = hash_fkey(snap, old[i].b_fkey);
+			while (snap->s_born[h].b_fkey != -1)
+				h = (h + 1) & (snap->s_nbuckets - 1);
+			snap->s_born[h] = old[i];
+		}
+		if (old)
+			stdfree(old);
+	}
+	for (h = hash_fkey(snap, fkey); snap->s_born[h].b_fkey != -1
+		; h = (h + 1) & (snap->s_nbuckets - 1)) {
+		if (snap->s_born[h].b_fkey == fkey) {
+			snap->s_born[h].b_version = version;
+			return;
+		}
+	}
+	snap->s_born[h].b_fkey = fkey;
+	snap->s_born[h].b_version = version;
+	++snap->s_nborn;
+}
+/*==============================================
+ * own_master -- Make master index one of this version
+ *  copying it to a new file if it is published
+ * returns TRUE if copied (& so not yet written)
+ *============================================*/
+static BOOLEAN
+own_master (BTREE btree)
+{
+	INDEX old = bmaster(btree), master;
+	if (fkeyset_has(&bsnap(btree)->s_fresh, ixself(old)))
+		return FALSE;
+	master = (INDEX) stdalloc(BUFLEN);
+	memcpy(master, old, BUFLEN);
+	ixself(master) = snap_newfkey(btree);
+	ixparent(master) = 0;
+	snap_freefile(btree, ixself(old));
+	newmaster(btree, master);
+	/* old master is left to cache, for any traversal still in it */
+	putheader(btree, (BLOCK)old);
+	return TRUE;
+}
+/*==============================================
+ * snap_path -- Make path from master to block for key
+ *  all of this version, ready to be changed
+ *  Each index or block on the path which is published is
+ *  replaced by a copy under a new file key (& its parent
+ *  pointed at that), and parent pointers along the path
+ *  are set (as the "lazy" parent chaining of btree).
+ *  Indices changed are written; the block is not, as the
+ *  caller is about to rewrite it.
+ *  rkey:  [IN]  key of record to be written
+ *  pdata: [OUT] file holding data of block's records (the
+ *               published one, if block was just copied)
+ * returns block header (from index cache)
+ *============================================*/
+BLOCK
+snap_path (BTREE btree, const RKEY * rkey, FKEY * pdata)
+{
+	BTSNAP snap = bsnap(btree);
+	INDEX index, child, copy;
+	BOOLEAN idirty, cdirty;
+	FKEY nfkey;
+	INT slot;
+
+	idirty = own_master(btree);
+	index = bmaster(btree);
+	while (TRUE) {
+		slot = findslot(index, rkey);
+		nfkey = fkeys(index, slot);
+		child = getindex(btree, nfkey);
+		cdirty = FALSE;
+		if (!fkeyset_has(&snap->s_fresh, nfkey)) {
+			/* first change to child in this version; change a copy */
+			copy = (INDEX) stdalloc(BUFLEN);
+			memcpy(copy, child, BUFLEN);
+			ixself(copy) = snap_newfkey(btree);
+			snap_freefile(btree, nfkey);
+			fkeys(index, slot) = ixself(copy);
+			idirty = TRUE;
+			putheader(btree, (BLOCK)copy);
+			child = copy;
+			cdirty = TRUE;
+		}
+		if (ixparent(child) != ixself(index)) {
+			ixparent(child) = ixself(index);
+			cdirty = TRUE;
+		}
+		if (idirty)
+			writeindex(btree, index);
+		if (ixtype(child) != BTINDEXTYPE) {
+			*pdata = nfkey;
+			return (BLOCK)child;
+		}
+		index = child;
+		idirty = cdirty;
+	}
+}
+/*==============================================
+ * snap_written -- Publish write just made to tree
+ *  unless it is part of an open group (or of a committed
+ *  group still going into the tree)
+ *============================================*/
+void
+snap_written (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	if (!snap)
+		return;
+	++snap->s_writes;
+	if (snap->s_depth)
+		return;
+	if (bjournal(btree) && bjournal(btree)->j_applying)
+		return;
+	snap_publish(btree);
+}
+/*==============================================
+ * snap_publish -- Make current tree the next version
+ *  Writes master & version to keyfile (which readers
+ *  opening meanwhile wait for), then removes what files
+ *  freed by earlier versions no reader still needs.
+ *============================================*/
+void
+snap_publish (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	INT32 version;
+	INT i;
+
+	if (!snap || !snap->s_dirty)
+		return;
+	version = ++bversion(btree);
+	bkfile(btree).k_mkey = ixself(bmaster(btree));
+	lockfile_lock(blockfd(btree), BTLOCK_SWAP, 1, TRUE, TRUE);
+	write_keyfile(btree);
+	lockfile_unlock(blockfd(btree), BTLOCK_SWAP, 1);
+
+	for (i = snap->s_npublished; i < snap->s_nfreed; i++) {
+		BTFREED * ent = &snap->s_freed[i];
+		if (ent->f_born < 0)
+			ent->f_born = version; /* never published */
+		ent->f_gone = version;
+	}
+	snap->s_npublished = snap->s_nfreed;
+	for (i = 0; i < snap->s_fresh.count; i++)
+		born_set(snap, snap->s_fresh.fkeys[i], version);
+	fkeyset_clear(&snap->s_fresh);
+	snap->s_dirty = FALSE;
+	reclaim(btree);
+}
+/*==============================================
+ * reclaim -- Remove freed files no reader can need
+ *  A reader holds the version it is reading, and a file
+ *  is in versions born .. gone-1.
+ *============================================*/
+static void
+reclaim (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	int fd = blockfd(btree);
+	INT32 born = -1, gone = -1;
+	BOOLEAN readers, busy = FALSE;
+	INT i, j, dropped = 0;
+
+	if (snap->s_holds)
+		return;
+	readers = lockfile_busy(fd, BTLOCK_VERSIONS, 0);
+	for (i = j = 0; i < snap->s_nfreed; i++) {
+		BTFREED * ent = &snap->s_freed[i];
+		BOOLEAN keep = (i >= snap->s_npublished) || ent->f_held;
+		if (!keep && readers && ent->f_born < ent->f_gone) {
+			/* consecutive entries mostly share versions */
+			if (ent->f_born != born || ent->f_gone != gone) {
+				born = ent->f_born;
+				gone = ent->f_gone;
+				busy = lockfile_busy(fd, BTLOCK_VERSIONS + born, gone - born);
+			}
+			keep = busy;
+		}
+		if (keep) {
+			snap->s_freed[j++] = *ent;
+		} else {
+			drop_file(btree, ent->f_fkey);
+			++dropped;
+		}
+	}
+	snap->s_nfreed = j;
+	snap->s_npublished -= dropped;
+	if (snap->s_sweep && !snap->s_nfreed && !snap->s_dirty
+		&& !snap->s_depth && !readers)
+		sweep(btree);
+}
+/*==============================================
+ * drop_file -- Remove file no longer needed
+ *============================================*/
+static void
+drop_file (BTREE btree, FKEY fkey)
+{
+	char path[MAXPATHLEN];
+	uncacheindex(btree, fkey);
+	fdpool_invalidate(btree, fkey);
+	snprintf(path, sizeof(path), "%s/%s", bbasedir(btree), fkey2path(fkey));
+	unlink(path);
+	push_reuse(bsnap(btree), fkey);
+}
+/*==============================================
+ * snap_checkpointed -- Journal no longer needs files
+ *  of trees before its checkpoint, so let them go
+ *============================================*/
+void
+snap_checkpointed (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	INT i;
+	if (!snap)
+		return;
+	for (i = 0; i < snap->s_nfreed; i++)
+		snap->s_freed[i].f_held = FALSE;
+	reclaim(btree);
+}
+/*==============================================
+ * snap_hold -- Start (or end) traversal which reads
+ *  files of tree directly, so none may be removed
+ *============================================*/
+void
+snap_hold (BTREE btree, BOOLEAN on)
+{
+	BTSNAP snap = bsnap(btree);
+	if (!snap)
+		return;
+	if (on)
+		++snap->s_holds;
+	else
+		--snap->s_holds;
+}
+/*==============================================
+ * sweep -- Remove files in no version of tree
+ *  (left by a writer which crashed)
+ *  Only done with no readers, so only the current version
+ *  matters; every file key handed out is checked.
+ *============================================*/
+static void
+sweep (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	FKEYSET live;
+	FKEY fkey;
+	INT n;
+
+	memset(&live, 0, sizeof(live));
+	traverse_index_blocks(btree, bmaster(btree), &live, add_liveindex, add_liveblock);
+	snap->s_nreuse = 0;
+	if (!fkeyset_has(&live, path2fkey("aa/aa")))
+		drop_file(btree, path2fkey("aa/aa"));
+	if (!fkeyset_has(&live, path2fkey("ab/aa")))
+		drop_file(btree, path2fkey("ab/aa"));
+	for (fkey = path2fkey("ab/ab"), n = 0
+		; fkey != bkfile(btree).k_fkey && n < SNAP_MAXFKEYS
+		; fkey = fkey_after(fkey), n++) {
+		if (!fkeyset_has(&live, fkey))
+			drop_file(btree, fkey);
+	}
+	fkeyset_clear(&live);
+	snap->s_sweep = FALSE;
+}
+/*==============================================
+ * add_liveindex, add_liveblock -- Note file in tree
+ *  callbacks for traverse_index_blocks from sweep
+ *============================================*/
+static BOOLEAN
+add_liveindex (BTREE btree, INDEX index, void * param)
+{
+	btree = btree; /* unused */
+	fkeyset_add((FKEYSET *)param, ixself(index));
+	return TRUE;
+}
+static BOOLEAN
+add_liveblock (BTREE btree, BLOCK block, void * param)
+{
+	btree = btree; /* unused */
+	fkeyset_add((FKEYSET *)param, ixself(block));
+	return TRUE;
+}
+/*==============================================
+ * write_freelist -- List freed files not yet removed,
+ *  & file keys free for reuse, for next writer
+ *  (file "free": magic, counts, then entries)
+ *============================================*/
+static void
+write_freelist (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	char path[MAXPATHLEN];
+	INT32 hdr[2], ent[3];
+	BOOLEAN ok;
+	FILE * fp;
+	INT i;
+
+	if (!snap->s_nfreed && !snap->s_nreuse)
+		return;
+	snprintf(path, sizeof(path), "%s/free", bbasedir(btree));
+	if (!(fp = fopen(path, LLWRITEBINARY)))
+		return; /* files are simply left behind */
+	hdr[0] = snap->s_nfreed;
+	hdr[1] = snap->s_nreuse;
+	ok = fwrite(SNAP_FREEMAGIC, SNAP_FREEMAGICLEN, 1, fp) == 1
+		&& fwrite(hdr, sizeof(hdr), 1, fp) == 1;
+	for (i = 0; ok && i < snap->s_nfreed; i++) {
+		ent[0] = snap->s_freed[i].f_fkey;
+		ent[1] = snap->s_freed[i].f_born;
+		ent[2] = snap->s_freed[i].f_gone;
+		ok = fwrite(ent, sizeof(ent), 1, fp) == 1;
+	}
+	if (ok && snap->s_nreuse)
+		ok = fwrite(snap->s_reuse, sizeof(FKEY), snap->s_nreuse, fp)
+			== (size_t)snap->s_nreuse;
+	if (fclose(fp) != 0 || !ok)
+		unlink(path); /* partial list could reuse a file in use */
+}
+/*==============================================
+ * read_freelist -- Take over list left by last writer
+ *  The file is removed, as it is out of date as soon as
+ *  this writer changes anything.
+ *============================================*/
+static void
+read_freelist (BTREE btree)
+{
+	BTSNAP snap = bsnap(btree);
+	char path[MAXPATHLEN], magic[SNAP_FREEMAGICLEN];
+	INT32 hdr[2], ent[3];
+	FKEY fkey;
+	FILE * fp;
+	INT i;
+
+	snprintf(path, sizeof(path), "%s/free", bbasedir(btree));
+	if (!(fp = fopen(path, LLREADBINARY)))
+		return;
+	if (fread(magic, SNAP_FREEMAGICLEN, 1, fp) == 1
+		&& !memcmp(magic, SNAP_FREEMAGIC, SNAP_FREEMAGICLEN)
+		&& fread(hdr, sizeof(hdr), 1, fp) == 1) {
+		for (i = 0; i < hdr[0] && fread(ent, sizeof(ent), 1, fp) == 1; i++)
+			add_freed(snap, ent[0], ent[1], ent[2], FALSE);
+		snap->s_npublished = snap->s_nfreed;
+		for (i = 0; i < hdr[1] && fread(&fkey, sizeof(fkey), 1, fp) == 1; i++)
+			push_reuse(snap, fkey);
+	}
+	fclose(fp);
+	unlink(path);
+}
+/*==============================================
+ * bt_begin_group -- Open group of writes to commit together
+ *  Groups nest; writes commit (& are published to readers)
+ *  when outermost group closes (or commit earlier, if very
+ *  many are pending). Until then, lookups, traversals &
+ *  cursors read them from the journal.
+ * returns FALSE if btree is not open for writing
+ *============================================*/
+BOOLEAN
+bt_begin_group (BTREE btree)
+{
+	if (!btree || !bsnap(btree))
+		return FALSE;
+	++bsnap(btree)->s_depth;
+	return TRUE;
+}
+/*==============================================
+ * bt_commit_group -- Close group of writes
+ *  commits & publishes them if this was the outermost group
+ *============================================*/
+BOOLEAN
+bt_commit_group (BTREE btree)
+{
+	BTSNAP snap = btree ? bsnap(btree) : NULL;
+	if (!snap || !snap->s_depth)
+		return FALSE;
+	if (!--snap->s_depth) {
+		if (bjournal(btree))
+			journal_commit(btree);
+		snap_publish(btree);
+	}
+	return TRUE;
+}
@@ -32,13 +32,29 @@
 #include "llstdlib.h"
 #include "btreei.h"
 
+/*********************************************
+ * local types
+ *********************************************/
+
+/* pending writes merged into traversal of tree */
+typedef struct {
+	BTREE    m_btree;
+	RKEY    *m_keys;      /* keys of pending records in span, in order */
+	INT      m_count;
+	INT      m_next;      /* first not yet visited */
+	TRAV_RECORD_FUNC_BYKEY m_func;
+	void    *m_param;
+} MERGEPARAM;
+
 /*********************************************
  * local function prototypes
  *********************************************/
 
 /* alphabetical */
+static BOOLEAN merge_record(RKEY rkey, STRING data, INT len, void * param);
 static BOOLEAN traverse_block(BTREE btree, BLOCK block, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYKEY, void * param);
 static BOOLEAN traverse_index(BTREE btree, INDEX index, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYKEY, void * param);
+static BOOLEAN visit_pending(MERGEPARAM * merge);
 
 /*********************************************
  * local function definitions
@@ -64,17 +80,20 @@ traverse_index_blocks (BTREE btree, INDEX index, void *param
 		return FALSE;
 	if (ixtype(index) == BTINDEXTYPE) {
 		INT i, n;
+		BOOLEAN rc = TRUE;
 		if (ifunc != NULL && !(*ifunc)(btree, index, param))
 			return FALSE;
+		/* files being read must outlast any writes made meanwhile */
+		snap_hold(btree, TRUE);
 		n = nkeys(index);
-		for (i = 0; i <= n; i++) {
-			BOOLEAN rc, robust=FALSE;
+		for (i = 0; rc && i <= n; i++) {
+			BOOLEAN robust=FALSE;
 			newdex = readindex(btree, fkeys(index, i), robust);
 			rc = traverse_index_blocks(btree, newdex, param, ifunc, dfunc);
 			stdfree(newdex);
-			if (!rc) return FALSE;
 		}
-		return TRUE;
+		snap_hold(btree, FALSE);
+		return rc;
 	}
 	if (dfunc != NULL)
 		return (*dfunc)(btree, (BLOCK)index, param);
@@ -136,12 +155,8 @@ traverse_index (BTREE btree, INDEX index, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYK
 	i=1;
 	n = nkeys(index); /* caller loaded index */
 	/* advance over any below lo */
-	if (lo.r_rkey[0]) {
-		for (i=1; i<=n; i++) {
-			if (ll_strncmp(lo.r_rkey, rkeys(index, i).r_rkey, 8) < 0)
-				break;
-		}
-	}
+	if (lo.r_rkey[0])
+		i = findslot(index, &lo) + 1;
 	ilo=i;
 	/* process all until above hi */
 	for ( ; i<=n+1; i++) {
@@ -177,7 +192,67 @@ void
 traverse_db_rec_rkeys (BTREE btree, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYKEY func, void * param)
 {
 	INDEX index;
+	MERGEPARAM merge;
+	if (bbulk(btree)) {
+		bulk_traverse(bbulk(btree), lo, hi, func, param);
+		return;
+	}
 	ASSERT(index = bmaster(btree));
-	traverse_index(btree, index, lo, hi, func, param);
+	/* pending writes (of an open group) are read from journal */
+	merge.m_keys = journal_pendingkeys(btree, lo, hi, &merge.m_count);
+	if (!merge.m_keys) {
+		snap_hold(btree, TRUE);
+		traverse_index(btree, index, lo, hi, func, param);
+		snap_hold(btree, FALSE);
+		return;
+	}
+	merge.m_btree = btree;
+	merge.m_next = 0;
+	merge.m_func = func;
+	merge.m_param = param;
+	snap_hold(btree, TRUE);
+	if (traverse_index(btree, index, lo, hi, merge_record, &merge)) {
+		while (merge.m_next < merge.m_count && visit_pending(&merge))
+			;
+	}
+	snap_hold(btree, FALSE);
+	stdfree(merge.m_keys);
+}
+/*====================================================
+ * merge_record -- Visit record of tree, after any pending
+ *  records before it (& instead of it, if it is pending)
+ *  callback for traverse_index from traverse_db_rec_rkeys
+ *==================================================*/
+static BOOLEAN
+merge_record (RKEY rkey, STRING data, INT len, void * param)
+{
+	MERGEPARAM * merge = (MERGEPARAM *)param;
+	INT cmp;
+	while (merge->m_next < merge->m_count
+		&& (cmp = cmpkeys(&merge->m_keys[merge->m_next], &rkey)) <= 0) {
+		if (!visit_pending(merge))
+			return FALSE;
+		if (!cmp)
+			return TRUE;
+	}
+	return (*merge->m_func)(rkey, data, len, merge->m_param);
+}
+/*====================================================
+ * visit_pending -- Visit next pending record
+ *  (read as it is now, which is from tree if callback
+ *  wrote enough to commit the group meanwhile)
+ *==================================================*/
+static BOOLEAN
+visit_pending (MERGEPARAM * merge)
+{
+	RKEY rkey = merge->m_keys[merge->m_next++];
+	RAWRECORD rawrec;
+	INT len;
+	BOOLEAN rc;
+	rawrec = readlatest(merge->m_btree, &rkey, &len);
+	rc = (*merge->m_func)(rkey, rawrec, len, merge->m_param);
+	if (rawrec)
+		stdfree(rawrec);
+	return rc;
 }
 
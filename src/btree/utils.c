@@ -97,7 +97,8 @@ fkey2path (FKEY fkey)
 	return path;
 }
 /*==============================================
- * nextfkey -- Increment next file key for BTREE
+ * fkey_after -- File key following given one
+ *  in the sequence handed out by nextfkey
  *============================================*/
 /* Explanation of FKEY algorithm, by example.
  *
@@ -124,13 +125,11 @@ fkey2path (FKEY fkey)
  * 
  * This is curious pattern and will be difficult to optimize.
  */
-void
-nextfkey (BTREE btree)
+FKEY
+fkey_after (FKEY fkey)
 {
-	FKEY fkey = btree->b_kfile.k_fkey;
 	INT16 hi = (fkey & 0xffff0000) >> 16;
 	INT16 lo = fkey & 0x0000ffff;
-	char scratch[MAXPATHLEN];
 
 	/* Case 1: HI=0000 LO=xxxx */
 	if (hi == lo)
@@ -149,6 +148,20 @@ nextfkey (BTREE btree)
         {
 		fkey += 0x00020000;
 		fkey &= 0xffff0000;
+	}
+	return fkey;
+}
+/*==============================================
+ * nextfkey -- Increment next file key for BTREE
+ *  creating directory for it if new (case 4)
+ *============================================*/
+void
+nextfkey (BTREE btree)
+{
+	FKEY fkey = fkey_after(btree->b_kfile.k_fkey);
+	char scratch[MAXPATHLEN];
+
+	if (!(fkey & 0x0000ffff)) {
 		snprintf(scratch, sizeof(scratch), "%s/%s", btree->b_basedir, fkey2path(fkey));
 		if (!mkalldirs(scratch))
 			FATAL();
@@ -157,20 +170,12 @@ nextfkey (BTREE btree)
 }
 /*==========================================
  * newmaster -- Change master index of BTREE
+ *  The keyfile is not written until the new
+ *  tree is published (see snapshot.c).
  *========================================*/
 void
 newmaster (BTREE btree, INDEX master)
 {
-	/*
-	Assumes our keyfile is valid
-	so it is important that we got an exclusive writer lock
-	*/
-	btree->b_kfile.k_mkey = ixself(master);
-	rewind(btree->b_kfp);
-	if (fwrite(&btree->b_kfile, sizeof(btree->b_kfile), 1, btree->b_kfp) != 1) {
-		char scratch[400];
-		snprintf(scratch, sizeof(scratch), "Error rewriting master block: %s", fkey2path(ixself(master)));
-		FATAL2(scratch);
-	}
 	btree->b_master = master;
+	bsnap(btree)->s_dirty = TRUE;
 }
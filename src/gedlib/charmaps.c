@@ -65,10 +65,21 @@ struct tag_xnode {
 };
 
 /* root of a custom character translation table */
+/* The xnode trees are compiled into a byte-level DFA: state 0 is the
+ * start, and every xnode is one state. States with transitions are
+ * numbered first, so only they need a row of the next table. Bytes
+ * that occur in no pattern share byte class 0, which leads nowhere. */
 struct tag_trantable {
 	XNODE start[256];
 	char name[20];
 	INT total;
+	INT nstates;		/* # states of DFA (xnodes + start) */
+	INT nrows;		/* # states with transitions */
+	INT nclasses;		/* # byte classes */
+	uchar bclass[256];	/* byte class of each byte */
+	char unmapped[256];	/* set if byte begins no pattern */
+	INT32 *next;		/* next state, by row & byte class (0 if none) */
+	CNSTRING *replace;	/* translation if state ends a pattern, else NULL */
 };
 
 
@@ -83,6 +94,10 @@ struct tag_trantable {
  *********************************************/
 
 /* alphabetical */
+static void append_bytes(ZSTR zout, CNSTRING str, INT len);
+static void compile_trantable(TRANTABLE tt);
+static void compile_xnodes(TRANTABLE tt, INT from, XNODE node, INT * prow, INT * pleaf);
+static INT count_xnodes(XNODE node, uchar * used, INT * pinner);
 static XNODE create_xnode(XNODE, INT, STRING);
 static BOOLEAN init_map_from_str(STRING str, CNSTRING mapname, TRANTABLE * ptt, ZSTR zerr);
 static void maperror(CNSTRING errmsg);
@@ -120,6 +135,7 @@ create_trantable (STRING *lefts, STRING *rights, INT n, STRING name)
 	STRING left, right;
 	INT i, c;
 	XNODE node;
+	memset(tt, 0, sizeof(*tt));
 	tt->name[0] = 0;
 	tt->total = n;
 	llstrncpy(tt->name, name, sizeof(tt->name), uu8);
@@ -142,8 +158,74 @@ create_trantable (STRING *lefts, STRING *rights, INT n, STRING name)
 		node->count = strlen(right);
 		node->replace = right;
 	}
+	compile_trantable(tt);
 	return tt;
 }
+/*=============================================
+ * compile_trantable -- Build DFA from xnode trees
+ *  (after all patterns are in the trees)
+ *===========================================*/
+static void
+compile_trantable (TRANTABLE tt)
+{
+	uchar used[256];
+	INT i, nodes=0, inner=0, row=0, leaf;
+	memset(used, 0, sizeof(used));
+	for (i = 0; i < 256; i++)
+		nodes += count_xnodes(tt->start[i], used, &inner);
+	/* number the byte classes in byte order */
+	tt->nclasses = 1;
+	for (i = 0; i < 256; i++)
+		tt->bclass[i] = used[i] ? tt->nclasses++ : 0;
+	tt->nstates = nodes+1;
+	tt->nrows = inner+1;
+	tt->next = (INT32 *)stdalloc(tt->nrows*tt->nclasses*sizeof(tt->next[0]));
+	memset(tt->next, 0, tt->nrows*tt->nclasses*sizeof(tt->next[0]));
+	tt->replace = (CNSTRING *)stdalloc(tt->nstates*sizeof(tt->replace[0]));
+	tt->replace[0] = NULL;
+	leaf = inner;
+	for (i = 0; i < 256; i++) {
+		compile_xnodes(tt, 0, tt->start[i], &row, &leaf);
+		tt->unmapped[i] = !tt->next[tt->bclass[i]];
+	}
+	ASSERT(row == inner && leaf == nodes);
+}
+/*=============================================
+ * count_xnodes -- Count xnodes of tree & mark their bytes
+ *  node:   [IN]  first of a list of siblings
+ *  used:   [I/O] set for each byte seen
+ *  pinner: [I/O] incremented for each xnode with children
+ *===========================================*/
+static INT
+count_xnodes (XNODE node, uchar * used, INT * pinner)
+{
+	INT count=0;
+	for ( ; node; node = node->sibling) {
+		used[(uchar)node->achar] = 1;
+		if (node->child)
+			++(*pinner);
+		count += 1 + count_xnodes(node->child, used, pinner);
+	}
+	return count;
+}
+/*=============================================
+ * compile_xnodes -- Add states & transitions for xnodes
+ *  from:   [IN]  state of parent
+ *  node:   [IN]  first of a list of siblings
+ *  prow:   [I/O] last state number given to an xnode with children
+ *  pleaf:  [I/O] last state number given to an xnode without
+ *===========================================*/
+static void
+compile_xnodes (TRANTABLE tt, INT from, XNODE node, INT * prow, INT * pleaf)
+{
+	INT state;
+	for ( ; node; node = node->sibling) {
+		state = node->child ? ++(*prow) : ++(*pleaf);
+		tt->next[from*tt->nclasses + tt->bclass[(uchar)node->achar]] = state;
+		tt->replace[state] = node->replace;
+		compile_xnodes(tt, state, node->child, prow, pleaf);
+	}
+}
 /*=============================
  * create_xnode -- Create XNODE
  *  parent:  [in] parent of node to be created
@@ -190,6 +272,8 @@ remove_trantable (TRANTABLE tt)
 	if (!tt) return;
 	for (i = 0; i < 256; i++)
 		remove_xnodes(tt->start[i]);
+	stdfree(tt->next);
+	stdfree(tt->replace);
 	stdfree(tt);
 }
 /*====================================
@@ -212,53 +296,27 @@ remove_xnodes (XNODE node)
  * returns length of input matched
  * match string output points directly into trans table
  * memory, so it is longer-lived than a static buffer
+ * Runs the DFA as far as it goes, and keeps the longest
+ * pattern that had a translation along the way
  * Created: 2001/07/21 (Perry Rapp)
  *=================================================*/
 static INT
 translate_match (TRANTABLE tt, CNSTRING in, CNSTRING * out)
 {
-	XNODE node, chnode;
-	INT nxtch;
+	INT state=0, matched=0;
 	CNSTRING q = in;
-	node = tt->start[(uchar)*in];
-	if (!node) {
-		*out = "";
-		return 0;
-	}
-	q = in+1;
-/* Match as far as possible */
-	while (*q && node->child) {
-		nxtch = (uchar)*q;
-		chnode = node->child;
-		while (chnode && chnode->achar != nxtch)
-			chnode = chnode->sibling;
-		if (!chnode) break;
-		node = chnode;
-		q++;
-	}
-	while (TRUE) {
-		if (node->replace) {
-			/* replacing match */
-			*out = node->replace;
-			return q - in;
+	*out = "";
+	while (*q && state < tt->nrows) {
+		state = tt->next[state*tt->nclasses + tt->bclass[(uchar)*q]];
+		if (!state)
+			break;
+		++q;
+		if (tt->replace[state]) {
+			*out = tt->replace[state];
+			matched = q - in;
 		}
-		/* no replacement, only partial match,
-		climb back & keep looking - we might have gone past
-		a shorter but full (replacing) match */
-		if (node->parent) {
-			node = node->parent;
-			--q;
-			continue;
-		}
-		/*
-		no replacement matches
-		(climbed all the way back to start
-		*/
-		ASSERT(q == in+1);
-		*out = "";
-		return 0;
 	}
-	return 0;
+	return matched;
 }
 /*===================================================
  * init_map_from_rec -- Init single translation table
@@ -648,33 +706,61 @@ show_xnode (XNODE node)
 void
 custom_translatez (ZSTR zstr, TRANTABLE tt)
 {
-	ZSTR zout = custom_translate(zs_str(zstr), tt);
-	zs_setz(zstr, zout);
-	zs_free(&zout);
+	ZSTR zout=0;
+	CNSTRING p = zs_str(zstr);
+	/* nothing to do unless some byte begins a pattern */
+	while (*p && tt->unmapped[(uchar)*p])
+		++p;
+	if (!*p)
+		return;
+	zout = custom_translate(zs_str(zstr), tt);
+	zs_move(zstr, &zout);
 }
 /*===================================================
  * custom_translate -- Translate string via custom translation table
  *  str:  [IN]  string to be translated
  *  tt:   [IN]  custom translation table
  * returns translated string
+ * Runs of bytes that begin no pattern (eg, ASCII, for
+ * tables from UTF-8) are copied over as a block
  *=================================================*/
 ZSTR
 custom_translate (CNSTRING str, TRANTABLE tt)
 {
 	ZSTR zout = zs_newn((unsigned int)(strlen(str)*1.3+2));
-	CNSTRING p = str;
+	CNSTRING p = str, run;
 	while (*p) {
 		CNSTRING tmp;
-		INT len = translate_match(tt, p, &tmp);
+		INT len;
+		run = p;
+		while (*p && tt->unmapped[(uchar)*p])
+			++p;
+		if (p > run)
+			append_bytes(zout, run, p - run);
+		if (!*p)
+			break;
+		len = translate_match(tt, p, &tmp);
 		if (len) {
 			p += len;
-			zs_apps(zout, tmp);
+			append_bytes(zout, tmp, strlen(tmp));
 		} else {
-			zs_appc(zout, *p++);
+			append_bytes(zout, p++, 1);
 		}
 	}
 	return zout;
 }
+/*===================================================
+ * append_bytes -- Append len bytes of str to zout
+ *=================================================*/
+static void
+append_bytes (ZSTR zout, CNSTRING str, INT len)
+{
+	unsigned int zlen = zs_len(zout);
+	char * ptr = zs_reserve(zout, zlen+len+1) + zlen;
+	memcpy(ptr, str, len);
+	ptr[len] = 0;
+	zs_set_len(zout, zlen+len);
+}
 /*===================================================
  * custom_sort -- Compare two strings with custom sort
  * returns FALSE if no custom sort table
@@ -64,7 +64,6 @@ static BOOLEAN open_database_impl(LLDATABASE lldb, INT alteration, INT *lldberr)
  *********************************************/
 
 static void (*f_dbnotify)(STRING db, BOOLEAN opening) = 0;
-static int rdr_count = 0;
 
 /*********************************************
  * local & exported function definitions
@@ -121,9 +120,8 @@ alterdb (INT alteration, INT *lldberr)
 			*lldberr = BTERR_LOCKED;
 			goto force_open_db_exit;
 		}
-		if (kfile1.k_ostat != 0) {
+		if (bt_database_in_use(readpath, lldberr)) {
 			/* can't lock a db unless it is unused currently*/
-			*lldberr = kfile1.k_ostat < 0 ? BTERR_WRITER : BTERR_READERS;
 			goto force_open_db_exit;
 		}
 		kfile1.k_ostat = -2;
@@ -160,7 +158,6 @@ force_open_db_exit:
 static BOOLEAN
 open_database_impl (LLDATABASE lldb, INT alteration, INT *lldberr)
 {
-	int c;
 	INT writ = !readonly + writeable;
 	BTREE btree = 0;
 
@@ -176,13 +173,7 @@ open_database_impl (LLDATABASE lldb, INT alteration, INT *lldberr)
 	readonly = !bwrite(btree);
 	immutable = bimmut(btree);
 	if (readonly && writeable) {
-		c = bkfile(btree).k_ostat;
-		if (c < 0) {
-			*lldberr = BTERR_WRITER;
-		} else {
-			rdr_count = c-1;
-			*lldberr = BTERR_READERS;
-		}
+		*lldberr = immutable ? BTERR_LOCKED : BTERR_WRITER;
 		return FALSE;
 	}
 	return TRUE;
@@ -327,11 +318,7 @@ describe_dberror (INT dberr, STRING buffer, INT buflen)
 		llstrapps(b, n, u8,  _("Existing database found."));
 		break;
 	case BTERR_READERS:
-		llstrappf(b, n, u8
-			, _pl("The database is already opened for read access by %d user."
-				, "The database is already opened for read access by %d users."
-				, rdr_count)
-			, rdr_count);
+		llstrapps(b, n, u8,  _("The database is already opened for read access."));
 		break;
 	case BTERR_BADPROPS:
 		llstrapps(b, n, u8,  _("Invalid properties set for new database"));
@@ -11,6 +11,13 @@ ZSTR custom_translate(CNSTRING str, TRANTABLE tt);
 void custom_translatez(ZSTR zstr, TRANTABLE tt);
 BOOLEAN init_map_from_file(CNSTRING file, CNSTRING mapname, TRANTABLE*, ZSTR zerr);
 
+/* kinship.c */
+typedef void (*KIN_FOUND_FNC)(INT32 keynum, INT gen, VPTR param);
+void kin_ancestors(INT32 * starts, INT nstarts, KIN_FOUND_FNC fnc, VPTR param);
+void kin_descendants(INT32 * starts, INT nstarts, KIN_FOUND_FNC fnc, VPTR param);
+void kin_free(void);
+void kin_note_record(CNSTRING key, CNSTRING rec, INT len);
+
 /* keytonod.c */
 void cel_remove_record(CACHEEL cel, RECORD rec);
 NODE is_cel_loaded(CACHEEL cel);
@@ -20,9 +27,15 @@ void init_win32_gettext_shim(void);
 void llgettext_init(CNSTRING domain, CNSTRING codeset);
 void update_textdomain_localedir(CNSTRING domain, CNSTRING prefix);
 
+/* namegram.c */
+void gram_add_name(CNSTRING name, CNSTRING key);
+void gram_free(void);
+void gram_remove_name(CNSTRING name, CNSTRING key);
+
 /* names.c */
 RECORD id_by_key(CNSTRING name, char ctype);
 BOOLEAN rkey_eq(const RKEY * rkey1, const RKEY * rkey2);
+void squeeze(CNSTRING in, STRING out);
 
 /* node.c */
 void check_node_leaks(void);
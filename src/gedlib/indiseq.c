@@ -97,6 +97,22 @@ struct tag_sortel {
 #define sprn(s) ((s)->s_prn)
 #define spri(s) ((s)->s_pri)
 
+/*==================================================================
+ * SEQKEYS -- Counts of the keys of a sequence, by key code (type
+ *   letter & number), in an open addressed hash table, so that
+ *   membership tests need not scan the sequence; made the first
+ *   time one is wanted of a long enough sequence, and kept in step
+ *   as elements come and go
+ *================================================================*/
+struct tag_seqkeys {
+	INT32 * codes;   /* key codes (0 for empty slot) */
+	INT32 * counts;  /* elements with each key */
+	INT32 size;      /* slots (power of 2) */
+	INT32 used;      /* slots holding codes */
+	BOOLEAN bad;     /* holds key without code ? (so not used) */
+};
+#define SEQKEYS_MIN 8  /* shorter sequences are just scanned */
+
 /*********************************************
  * local function prototypes
  *********************************************/
@@ -105,6 +121,7 @@ struct tag_sortel {
 static void append_all_tags(INDISEQ, NODE, STRING tagname, BOOLEAN recurse, BOOLEAN nonptrs);
 static void append_indiseq_impl(INDISEQ seq, STRING key, 
 	CNSTRING name, UNION val, BOOLEAN sure, BOOLEAN alloc);
+static void append_kin(INT32 keynum, INT gen, VPTR param);
 static void calc_indiseq_name_el(INDISEQ seq, INT index);
 static INT canonkey_compare(SORTEL el1, SORTEL el2, VPTR param);
 static INT canonkey_order(char c);
@@ -117,10 +134,19 @@ static INDISEQ dupseq(INDISEQ seq);
 static STRING get_print_el(INDISEQ, INT i, INT len, RFMT rfmt);
 static BOOLEAN is_locale_current(INDISEQ seq);
 static INT key_compare(SORTEL el1, SORTEL el2, VPTR param);
+static INDISEQ keylist_to_indiseq(LIST list);
 static INT name_compare(SORTEL el1, SORTEL el2, VPTR param);
 static void llqsort2(SORTEL *data, ELCMPFNC cmp, VPTR param, INT a, INT b);
 static void partition2(SORTEL *arr, ELCMPFNC cmp, VPTR param, INT a, INT b, INT *pi, INT *pj);
 static STRING qkey_to_name(STRING key);
+static BOOLEAN seq_has_key(INDISEQ seq, CNSTRING key);
+static INT32 * seq_keynums(INDISEQ seq);
+static void seqkeys_build(INDISEQ seq);
+static INT32 seqkeys_code(CNSTRING key);
+static void seqkeys_count(INDISEQ seq, CNSTRING key, INT delta);
+static void seqkeys_free(INDISEQ seq);
+static void seqkeys_grow(struct tag_seqkeys * sk, INT32 size);
+static INT32 seqkeys_slot(struct tag_seqkeys * sk, INT32 code);
 static void update_locale(INDISEQ seq);
 static INT value_compare(SORTEL el1, SORTEL el2, VPTR param);
 
@@ -215,6 +241,7 @@ remove_indiseq (INDISEQ seq)
 	stdfree(IData(seq));
 	if (ILocale(seq))
 		stdfree(ILocale(seq));
+	seqkeys_free(seq);
 	stdfree(seq);
 }
 /*==============================
@@ -392,7 +419,7 @@ static void
 append_indiseq_impl (INDISEQ seq, STRING key, CNSTRING name, UNION val
 	, BOOLEAN sure, BOOLEAN alloc)
 {
-	INT i, m, n;
+	INT i, m, n, flags;
 	SORTEL el, *new, *old;
 	if (!seq || !key) return;
 	n = ISize(seq);
@@ -403,17 +430,12 @@ append_indiseq_impl (INDISEQ seq, STRING key, CNSTRING name, UNION val
 			why FAM seqs didn't do dupcheck */
 		BOOLEAN dupcheck = (*key != 'F' && *key != 'I')
 			|| (*key == 'I' && !name);
-		if (dupcheck)
-		{
-			for (i = 0; i < n; i++) {
-				if (eqstr(key, skey(old[i]))) {
-						/* failed dupe check - bail */
-					if (alloc)
-						stdfree(key);
-					deleteval(seq, val);
-					return;
-				}
-			}
+		if (dupcheck && seq_has_key(seq, key)) {
+				/* failed dupe check - bail */
+			if (alloc)
+				stdfree(key);
+			deleteval(seq, val);
+			return;
 		}
 	}
 	el = (SORTEL) stdalloc(sizeof(*el));
@@ -428,8 +450,12 @@ append_indiseq_impl (INDISEQ seq, STRING key, CNSTRING name, UNION val
 			snam(el) = NULL;
 	}
 	sval(el) = val;
-	spri(el) = 0;
+	spri(el) = atoi(skey(el) + 1);
 	sprn(el) = NULL;
+	/* appending in strictly rising key order keeps it sorted & unique */
+	flags = KEYSORT|UNIQUED;
+	if (n && ((IFlags(seq) & flags) != flags || spri(old[n-1]) >= spri(el)))
+		flags = 0;
 	if ((n = ISize(seq)) >= IMax(seq))  {
 		m = 3*n;
 		new = (SORTEL *) stdalloc(m*sizeof(SORTEL));
@@ -440,7 +466,8 @@ append_indiseq_impl (INDISEQ seq, STRING key, CNSTRING name, UNION val
 		IMax(seq) = m;
 	}
 	old[ISize(seq)++] = el;
-	IFlags(seq) = 0;
+	IFlags(seq) = flags;
+	seqkeys_count(seq, skey(el), +1);
 }
 /*=========================================================
  * rename_indiseq -- Update element name with standard name
@@ -453,7 +480,7 @@ rename_indiseq (INDISEQ seq, STRING key)
 {
 	INT i, n;
 	SORTEL *data;
-	if (!seq || !key || *key != 'I') return;
+	if (!seq || !key || *key != 'I' || !seq_has_key(seq, key)) return;
 	n = ISize(seq);
 	data = IData(seq);
 	for (i = 0; i < n; i++) {
@@ -473,10 +500,30 @@ rename_indiseq (INDISEQ seq, STRING key)
 BOOLEAN
 in_indiseq (INDISEQ seq, STRING key)
 {
-	INT i, len;
+	if (!seq || !key) return FALSE;
+	return seq_has_key(seq, key);
+}
+/*==============================================
+ * seq_has_key -- Has sequence element with key ?
+ *  (using counts of keys, for long sequences)
+ *=============================================*/
+static BOOLEAN
+seq_has_key (INDISEQ seq, CNSTRING key)
+{
+	struct tag_seqkeys * sk;
 	SORTEL *data;
+	INT i, len;
 
-	if (!seq || !key) return FALSE;
+	if (!IKeys(seq) && ISize(seq) >= SEQKEYS_MIN)
+		seqkeys_build(seq);
+	if ((sk = IKeys(seq)) && !sk->bad) {
+		/* key without code cannot equal any coded key */
+		INT32 code = seqkeys_code(key);
+		if (!code)
+			return FALSE;
+		i = seqkeys_slot(sk, code);
+		return sk->codes[i] && sk->counts[i] > 0;
+	}
 	len = ISize(seq);
 	data = IData(seq);
 	for (i = 0; i < len; i++) {
@@ -484,6 +531,125 @@ in_indiseq (INDISEQ seq, STRING key)
 	}
 	return FALSE;
 }
+/*==============================================
+ * seqkeys_build -- Count keys of sequence
+ *=============================================*/
+static void
+seqkeys_build (INDISEQ seq)
+{
+	struct tag_seqkeys * sk;
+	INT32 size = 16;
+	while (size < 2*(ISize(seq)+1))
+		size *= 2;
+	sk = (struct tag_seqkeys *) stdalloc(sizeof(*sk));
+	memset(sk, 0, sizeof(*sk));
+	IKeys(seq) = sk;
+	seqkeys_grow(sk, size);
+	FORINDISEQ(seq, el, num)
+		seqkeys_count(seq, skey(el), +1);
+	ENDINDISEQ
+}
+/*==============================================
+ * seqkeys_code -- Code of key (eg, I12) for counting
+ *  returns 0 for key not of letter & number (up to
+ *  9999999, without leading zeros)
+ *=============================================*/
+static INT32
+seqkeys_code (CNSTRING key)
+{
+	INT32 num = 0;
+	INT i;
+	if (key[0] < 'A' || key[0] > 'Z' || key[1] < '1' || key[1] > '9')
+		return 0;
+	for (i = 1; key[i]; i++) {
+		if (i > 7 || key[i] < '0' || key[i] > '9')
+			return 0;
+		num = num*10 + (key[i] - '0');
+	}
+	return ((INT32)(key[0] - 'A' + 1) << 24) | num;
+}
+/*==============================================
+ * seqkeys_count -- Add delta to count of key
+ *  (if sequence has counts)
+ *=============================================*/
+static void
+seqkeys_count (INDISEQ seq, CNSTRING key, INT delta)
+{
+	struct tag_seqkeys * sk = IKeys(seq);
+	INT32 code, i;
+	if (!sk || sk->bad)
+		return;
+	if (!(code = seqkeys_code(key))) {
+		/* give up on counts, & scan this sequence */
+		seqkeys_grow(sk, 0);
+		sk->bad = TRUE;
+		return;
+	}
+	if (2*(sk->used+1) > sk->size)
+		seqkeys_grow(sk, 2*sk->size);
+	i = seqkeys_slot(sk, code);
+	if (!sk->codes[i]) {
+		sk->codes[i] = code;
+		sk->counts[i] = 0;
+		++sk->used;
+	}
+	sk->counts[i] += delta;
+}
+/*==============================================
+ * seqkeys_free -- Free counts of keys of sequence
+ *=============================================*/
+static void
+seqkeys_free (INDISEQ seq)
+{
+	if (!IKeys(seq))
+		return;
+	seqkeys_grow(IKeys(seq), 0);
+	stdfree(IKeys(seq));
+	IKeys(seq) = NULL;
+}
+/*==============================================
+ * seqkeys_grow -- Move counts into table of size slots
+ *  (dropping keys no longer counted), or free them if 0
+ *=============================================*/
+static void
+seqkeys_grow (struct tag_seqkeys * sk, INT32 size)
+{
+	INT32 * codes = sk->codes, * counts = sk->counts;
+	INT32 i, j, oldsize = sk->size;
+	sk->codes = sk->counts = 0;
+	sk->size = size;
+	sk->used = 0;
+	if (size) {
+		sk->codes = (INT32 *) stdalloc(size*sizeof(INT32));
+		sk->counts = (INT32 *) stdalloc(size*sizeof(INT32));
+		memset(sk->codes, 0, size*sizeof(INT32));
+		for (i = 0; i < oldsize; i++) {
+			if (!codes[i] || !counts[i])
+				continue;
+			j = seqkeys_slot(sk, codes[i]);
+			sk->codes[j] = codes[i];
+			sk->counts[j] = counts[i];
+			++sk->used;
+		}
+	}
+	if (codes) {
+		stdfree(codes);
+		stdfree(counts);
+	}
+}
+/*==============================================
+ * seqkeys_slot -- Find slot of code, or empty slot for it
+ *=============================================*/
+static INT32
+seqkeys_slot (struct tag_seqkeys * sk, INT32 code)
+{
+	INT32 mask = sk->size - 1;
+	unsigned long h = ((unsigned long)code * 2654435761UL) & 0xffffffffUL;
+	INT32 i = (INT32)((h ^ (h >> 16)) & mask);
+	while (sk->codes[i] && sk->codes[i] != code)
+		i = (i + 1) & mask;
+	return i;
+}
 /*===============================================================
  * delete_indiseq -- Remove el from sequence
  *  if key & name given, look for element matching both
@@ -503,7 +669,7 @@ delete_indiseq (INDISEQ seq, STRING key, STRING name, INT index)
 	len = ISize(seq);
 	data = IData(seq);
 	if (key) {
-		if (*key != 'I') return FALSE;
+		if (*key != 'I' || !seq_has_key(seq, key)) return FALSE;
 		for (i = 0; i < len; i++) {
 			if (eqstr(key, skey(data[i])) && (!name ||
 			    eqstr(name, snam(data[i])))) break;
@@ -517,6 +683,7 @@ delete_indiseq (INDISEQ seq, STRING key, STRING name, INT index)
 	for (i = index; i < len; i++)
 		data[i] = data[i+1];
 	ISize(seq)--;
+	seqkeys_count(seq, skey(el), -1);
 	delete_el(seq, el);
 	stdfree(el);
 	return TRUE;
@@ -934,8 +1101,6 @@ llqsort2 (SORTEL *data, ELCMPFNC cmp, VPTR param, INT a, INT b)
 }
 /*==================================================================
  * unique_indiseq -- Remove identical (key, name) els from sequence
- * NOTE: this routine has MEMORY LEAK -- it doesn't free storage for
- *   els removed from sequence
  *================================================================*/
 void
 unique_indiseq (INDISEQ seq)
@@ -952,7 +1117,9 @@ unique_indiseq (INDISEQ seq)
 			d[++j] = d[i];
 		} else {
 			/* TO DO - this is untested - Perry 2001/03/25 */
+			seqkeys_count(seq, skey(d[i]), -1);
 			delete_el(seq, d[i]);
+			stdfree(d[i]);
 		}
 	ISize(seq) = j + 1;
 	IFlags(seq) |= UNIQUED;
@@ -1076,9 +1243,6 @@ union_indiseq (INDISEQ one, INDISEQ two)
 		append_indiseq_impl(three, key, NULL, uval, TRUE, TRUE);
 		j++;
 	}
-	FORINDISEQ(three, el, num)
-		spri(el) = atoi(skey(el) + 1);
-	ENDINDISEQ
 	IFlags(three) = KEYSORT|UNIQUED;
 	return three;
 }
@@ -1120,9 +1284,6 @@ intersect_indiseq (INDISEQ one, INDISEQ two)
 			i++, j++;
 		}
 	}
-	FORINDISEQ(three, el, num)
-		spri(el) = atoi(skey(el) + 1);
-	ENDINDISEQ
 	IFlags(three) = KEYSORT|UNIQUED;
 	return three;
 }
@@ -1174,9 +1335,6 @@ difference_indiseq (INDISEQ one, INDISEQ two)
 		append_indiseq_impl(three, key, NULL, uval, TRUE, TRUE);
 		i++;
 	}
-	FORINDISEQ(three, el, num)
-		spri(el) = atoi(skey(el) + 1);
-	ENDINDISEQ
 	IFlags(three) = KEYSORT|UNIQUED;
 	return three;
 }
@@ -1515,125 +1673,71 @@ sibling_indiseq (INDISEQ seq, BOOLEAN close)
 	remove_indiseq(fseq);
 	return sseq;
 }
+/*=========================================================
+ * append_kin -- Append person found by kinship walk
+ *  param:  [IN]  original & result sequences
+ *=======================================================*/
+static void
+append_kin (INT32 keynum, INT gen, VPTR param)
+{
+	INDISEQ * seqs = (INDISEQ *)param;
+	char key[12]; /* I & up to 10 digits */
+	UNION uval;
+	snprintf(key, sizeof(key), "I" FMT_INT32, keynum);
+	uval = creategenval(seqs[0], gen);
+	append_indiseq_pval(seqs[1], key, NULL, uval.w, TRUE);
+}
+/*=========================================================
+ * seq_keynums -- Key numbers of people of sequence
+ *  (0 for any element not a person)
+ *  returns array, which caller must free
+ *=======================================================*/
+static INT32 *
+seq_keynums (INDISEQ seq)
+{
+	INT32 * keynums = (INT32 *) stdalloc((ISize(seq)+1)*sizeof(INT32));
+	FORINDISEQ(seq, el, num)
+		keynums[num] = (skey(el)[0] == 'I') ? (INT32)atoi(skey(el)+1) : 0;
+	ENDINDISEQ
+	return keynums;
+}
 /*=========================================================
  * ancestor_indiseq -- Create ancestor sequence of sequence
  *  values are created with the generation number
  *  (via value function table)
+ *  (walks kinship index, see kin_ancestors)
  *=======================================================*/
 INDISEQ
 ancestor_indiseq (INDISEQ seq)
 {
-	/* table lists people already listed (values unused) */
-	TABLE tab;
-	LIST anclist, genlist;
-	INDISEQ anc=0;
-	NODE indi=0;
-	STRING key, pkey;
-	INTPTR gen=0;
-	INT fnum=0, snum=0;
-	UNION uval;
+	INDISEQ seqs[2];
+	INT32 * keynums;
 	if (!seq) return NULL;
-		/* table of people already added */
-	tab = create_table_vptr();
-		/* paired processing list - see comments in descendant_indiseq code */
-	anclist = create_list();
-	genlist = create_list();
-	anc = create_indiseq_impl(IValtype(seq), IValfnctbl(seq));
-	FORINDISEQ(seq, el, num)
-		enqueue_list(anclist, (VPTR)skey(el));
-		enqueue_list(genlist, (VPTR)gen);
-	ENDINDISEQ
-	while (!is_empty_list(anclist)) {
-		key = (STRING) dequeue_list(anclist);
-		gen = (INTPTR)dequeue_list(genlist) + 1;
-		indi = key_to_indi(key);
-
-		FORFAMCS(indi, fam, fath, moth, fnum)
-			FORFAMSPOUSES(fam, spouse, snum)
-				if (spouse && !in_table(tab, pkey = indi_to_key(spouse))) {
-						/* copy key for list, others make their own copies */
-					uval = creategenval(seq, gen);
-					append_indiseq_pval(anc, pkey, NULL, uval.w, TRUE);
-					enqueue_list(anclist, (VPTR)strsave(pkey));
-					enqueue_list(genlist, (VPTR)gen);
-					insert_table_ptr(tab, pkey, 0);
-				}
-			ENDFAMSPOUSES
-		ENDFAMCS
-	}
-	destroy_table(tab);
-	destroy_empty_list(anclist);
-	destroy_empty_list(genlist);
-	return anc;
+	seqs[0] = seq;
+	seqs[1] = create_indiseq_impl(IValtype(seq), IValfnctbl(seq));
+	keynums = seq_keynums(seq);
+	kin_ancestors(keynums, ISize(seq), append_kin, seqs);
+	stdfree(keynums);
+	return seqs[1];
 }
 /*=============================================================
  * descendant_indiseq -- Create descendant sequence of sequence
  *  values are created with the generation number
  *  (passed to create_value callback)
+ *  (walks kinship index, see kin_descendants)
  *===========================================================*/
 INDISEQ
 descendent_indiseq (INDISEQ seq)
 {
-	INTPTR gen = 0;
-	/* itab lists people already entered, ftab families
-	(values in both are unused) */
-	TABLE itab, ftab;
-	LIST deslist, genlist;
-	INDISEQ des;
-	NODE indi;
-	STRING key, dkey, fkey;
-	UNION uval;
+	INDISEQ seqs[2];
+	INT32 * keynums;
 	if (!seq) return NULL;
-		/* itab = people already added, value irrelevant */
-	itab = create_table_vptr();
-		/* ftab = families already added (processed), value irrelevant */
-	ftab = create_table_vptr();
-		/*
-		deslist & genlist are paired - 
-		dequeue the person from deslist & the generation
-		from genlist, for one person to be processed
-		(added to result & all children added to processing list)
-		(deslist does not own its strings)
-		*/
-	deslist = create_list();
-	genlist = create_list();
-		/* result indiseq */
-	des = create_indiseq_impl(IValtype(seq), IValfnctbl(seq));
-		/* add everyone from original seq to processing list */
-	FORINDISEQ(seq, el, num)
-		enqueue_list(deslist, (VPTR)skey(el));
-		enqueue_list(genlist, (VPTR)gen);
-	ENDINDISEQ
-		/* loop until processing list is empty */
-	while (!is_empty_list(deslist)) {
-		INT num1, num2;
-		key = (STRING) dequeue_list(deslist);
-		gen = (INTPTR)dequeue_list(genlist) + 1;
-		indi = key_to_indi(key);
-		FORFAMS(indi, fam, num1)
-				/* skip families already processed */
-			if (in_table(ftab, fkey = fam_to_key(fam)))
-				continue;
-			insert_table_ptr(ftab, fkey, 0);
-			FORCHILDRENx(fam, child, num2)
-					/* only do people not processed */
-				if (!in_table(itab,
-				    dkey = indi_to_key(child))) {
-						/* copy key for list, others make their own copies */
-					uval = creategenval(seq, gen);
-						/* add person to output */
-					append_indiseq_pval(des, strsave(dkey), NULL, uval.w, TRUE);
-						/* also want descendants, so add person to processing list */
-					enqueue_list(deslist, (VPTR)strsave(dkey));
-					enqueue_list(genlist, (VPTR)gen);
-					insert_table_ptr(itab, dkey, 0);
-				}
-			ENDCHILDRENx
-		ENDFAMS
-	}
-	destroy_table(itab);
-	destroy_table(ftab);
-	return des;
+	seqs[0] = seq;
+	seqs[1] = create_indiseq_impl(IValtype(seq), IValfnctbl(seq));
+	keynums = seq_keynums(seq);
+	kin_descendants(keynums, ISize(seq), append_kin, seqs);
+	stdfree(keynums);
+	return seqs[1];
 }
 /*========================================================
  * spouse_indiseq -- Create spouses sequence of a sequence
@@ -1672,11 +1776,27 @@ spouse_indiseq (INDISEQ seq)
 INDISEQ
 name_to_indiseq (STRING name)
 {
-	INDISEQ seq = NULL;
-	LIST list=0;
 	if (!name || *name == 0) return NULL;
-
-	list = find_indis_by_name(name);
+	return keylist_to_indiseq(find_indis_by_name(name));
+}
+/*============================================================
+ * words_to_indiseq -- Return person sequence whose names match
+ *  words of search (see find_indis_by_words)
+ *==========================================================*/
+INDISEQ
+words_to_indiseq (STRING words)
+{
+	if (!words || *words == 0) return NULL;
+	return keylist_to_indiseq(find_indis_by_words(words));
+}
+/*============================================================
+ * keylist_to_indiseq -- Return person sequence of keys found
+ *  by name, sorted by name (NULL if none), & free list
+ *==========================================================*/
+static INDISEQ
+keylist_to_indiseq (LIST list)
+{
+	INDISEQ seq = NULL;
 	ASSERT(list);
 	if (length_list(list)) {
 		LIST_ITER listit=0;
@@ -1690,7 +1810,8 @@ name_to_indiseq (STRING name)
 			append_indiseq_null(seq, strsave(key), NULL, TRUE, TRUE);
 		}
 		end_list_iter(&listit);
-		/* may have duplicates from multiple soundexes or wildcard searches */
+		/* may have duplicates from multiple soundexes or wildcard searches,
+		or from several names of a person */
 		unique_indiseq(seq);
 		/* people like to see lists alphabetically by name */
 		namesort_indiseq(seq);
@@ -1904,6 +2025,7 @@ rec_to_indiseq (RECORD rec)
  *  name:  [IN]  name to search for
  *  ctype: [IN]  type of record (eg, 'I') (0 for any)
  * The rules of search precedence are implemented here:
+ *  0. words of search, after a leading ~
  *  1. named indiset
  *  2. key, with or without the leading "I"
  *  3. REFN
@@ -1916,6 +2038,8 @@ str_to_indiseq (STRING name, char ctype)
 	INDISEQ seq;
 	/* 'B' is a code meaning try persons first, but allow any type */
 	char cmatch = (ctype == 'B' ? 0 : ctype);
+	if (name[0] == '~')
+		return words_to_indiseq(name + 1);
 	seq = find_named_seq(name);
 	if (!seq) seq = key_to_indiseq(name, cmatch);
 	if (!seq) seq = refn_to_indiseq(name, cmatch, NAMESORT);
@@ -30,6 +30,7 @@
 
 #include "llstdlib.h"
 #include "gedcom.h"
+#include "gedcomi.h"
 #include "btree.h"
 
 extern BTREE BTR;
@@ -54,6 +55,9 @@ retrieve_raw_record (CNSTRING key, INT *plen)
 BOOLEAN
 store_record (CNSTRING key, STRING rec, INT len)
 {
+	/* cache must not rebuild record as it was */
+	forget_parsed_record(key);
+	kin_note_record(key, rec, len);
 	return bt_addrecord (BTR, str2rkey(key), rec, len);
 }
 /*=========================================
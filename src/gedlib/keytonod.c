@@ -38,6 +38,7 @@
 #include "liflines.h"
 #include "feedback.h"
 #include "zstr.h"
+#include "lloptions.h"
 
 /*********************************************
  * global variables (no header)
@@ -59,6 +60,12 @@ struct tag_cacheel {
 	INT c_lock;       /* lock count (includes report locks) */
 	INT c_rptlock;    /* report lock count */
 	RECORD c_record;
+	struct tag_cache * c_cache; /* cache of its record type */
+	INT c_list;       /* list it is on (CEL_A1IN etc) */
+	INT c_home;       /* list it goes back to when unlocked */
+	INT c_size;       /* bytes charged to cache for it */
+	STRING c_bin;     /* binary form of record as read, if any */
+	INT c_binlen;     /* its length */
 };
 #define cnode(e)      ((e)->c_node)
 #define cprev(e)      ((e)->c_prev)
@@ -67,28 +74,78 @@ struct tag_cacheel {
 #define cclock(e)     ((e)->c_lock)
 #define ccrptlock(e)  ((e)->c_rptlock)
 #define crecord(e)    ((e)->c_record)
+#define ccache(e)     ((e)->c_cache)
+#define clist(e)      ((e)->c_list)
+#define chome(e)      ((e)->c_home)
+#define csize(e)      ((e)->c_size)
+#define cbin(e)       ((e)->c_bin)
+#define cbinlen(e)    ((e)->c_binlen)
 
 /*==============================
  * CACHE -- Internal cache type.
+ *  One per record type, for looking up its keys; the
+ *  elements of all of them share one byte budget, and
+ *  are kept on the lists below
  *============================*/
-typedef struct {
+typedef struct tag_cache {
 	char c_name[5];
 	TABLE c_data;        /* table of keys */
-	CACHEEL c_firstdir;  /* first direct */
-	CACHEEL c_lastdir;   /* last direct */
-	CACHEEL c_array;     /* big array of cacheels, all alloc'd in a block */
-	CACHEEL c_free;      /* root of free list */
-	INT c_maxdir;        /* max in direct */
-	INT c_sizedir;       /* cur in direct */
+	INT c_count;         /* number of elements cached */
+	INT c_bytes;         /* bytes charged for them */
 } *CACHE;
 #define cacname(c)     ((c)->c_name)
 #define cacdata(c)     ((c)->c_data)
-#define cacfirstdir(c) ((c)->c_firstdir)
-#define caclastdir(c)  ((c)->c_lastdir)
-#define cacarray(e) ((e)->c_array)
-#define cacfree(e) ((e)->c_free)
-#define cacmaxdir(c)   ((c)->c_maxdir)
-#define cacsizedir(c)  ((c)->c_sizedir)
+#define caccount(c)    ((c)->c_count)
+#define cacbytes(c)    ((c)->c_bytes)
+
+/*==============================
+ * CACHELIST -- List of cache elements
+ *  Records are kept 2Q fashion: a record read once goes on
+ *  A1in, which is FIFO & held to a quarter of the budget,
+ *  so a sweep through the database (eg, forindi) only cycles
+ *  records through A1in. A record wanted again soon after
+ *  it has left A1in (its key is still among the ghosts) goes
+ *  on Am, which is LRU, & holds the working set.
+ *  Locked records are set aside, so eviction need not skip
+ *  past them.
+ *============================*/
+typedef struct {
+	CACHEEL l_first;     /* newest or most recently used */
+	CACHEEL l_last;      /* next to evict */
+	INT l_count;
+	INT l_bytes;
+} CACHELIST;
+#define CEL_FREE    0    /* not in cache */
+#define CEL_A1IN    1    /* read once */
+#define CEL_AM      2    /* used again */
+#define CEL_LOCKED  3    /* locked, so not to be evicted */
+
+/*==============================
+ * CELCHUNK -- Cache elements, allocated a block at a time
+ *  (elements are never freed until the caches are, as
+ *  records & nodes may still point to them)
+ *============================*/
+#define CELCHUNK 256
+typedef struct tag_celchunk {
+	struct tag_celchunk * next;
+	struct tag_cacheel cels[CELCHUNK];
+} *CELCHUNKP;
+
+/*==============================
+ * PARSEDREC -- Record evicted from cache, kept in binary form
+ *  (see node_to_binary), so that it can be rebuilt without
+ *  parsing its text if wanted again
+ *  The binary form is made as the record is read from the
+ *  database, & stays with the record while it is cached, so
+ *  that changes made to the record in memory are not kept.
+ *============================*/
+typedef struct tag_parsedrec {
+	STRING p_key;
+	STRING p_bin;        /* binary form */
+	INT p_len;           /* its length */
+	struct tag_parsedrec * p_prev;  /* more recently evicted */
+	struct tag_parsedrec * p_next;  /* less recently evicted */
+} *PARSEDREC;
 
 
 /*********************************************
@@ -97,11 +154,16 @@ typedef struct {
 
 /* static void add_record_to_direct(CACHE cache, RECORD rec, STRING key); */
 static void cache_get_lock_counts(CACHE ca, INT * locks);
-static CACHE create_cache(STRING name, INT dirsize);
+static CACHE create_cache(STRING name);
 static void delete_cache(CACHE * pcache);
+static void charge_cel(CACHEEL cel, INT delta);
 static void ensure_cel_has_record(CACHEEL cel);
+static void free_ghosts(void);
+static void free_parsed(void);
 static ZSTR get_cache_stats(CACHE ca);
-static CACHEEL get_free_cacheel(CACHE cache);
+static CACHEEL get_free_cacheel(void);
+static void ghost_add(CNSTRING key);
+static BOOLEAN ghost_take(CNSTRING key);
 static void init_cel(CACHEEL cel);
 static CACHEEL key_to_cacheel(CACHE cache, CNSTRING key, STRING tag, INT reportmode);
 static CACHEEL key_to_even_cacheel(CNSTRING key);
@@ -110,8 +172,16 @@ static RECORD key_to_record_impl(CNSTRING key, INT reportmode);
 static RECORD key_typed_to_record(CACHE cache, CNSTRING key, STRING tag);
 static CACHEEL key_to_othr_cacheel(CNSTRING key);
 static CACHEEL key_to_sour_cacheel(CNSTRING key);
+static void list_push(CACHEEL cel, INT which);
+static void list_remove(CACHEEL cel);
+static void make_room(INT size);
 static CACHEEL node_to_cache(CACHE, NODE);
-static void put_node_in_cache(CACHE cache, CACHEEL cel, NODE node, STRING key);
+static INT node_tree_size(NODE node);
+static void parsed_drop(PARSEDREC prec);
+static void parsed_put(CNSTRING key, STRING bin, INT len);
+static STRING parsed_take(CNSTRING key, INT *plen);
+static void put_node_in_cache(CACHE cache, CACHEEL cel, NODE node, STRING key, INT size, INT which);
+static void relist_cel(CACHEEL cel);
 static void remove_cel_from_cache(CACHE cache, CACHEEL cel, BOOLEAN delcache);
 static NODE qkey_to_node(CACHE cache, CNSTRING key, STRING tag);
 static RECORD qkey_typed_to_record(CACHE cache, CNSTRING key, STRING tag);
@@ -119,11 +189,13 @@ static RECORD qkey_typed_to_record(CACHE cache, CNSTRING key, STRING tag);
 static void remove_from_cache(CACHE, CNSTRING);
 
 
-INT csz_indi = 200;		/* cache size for indi */
-INT csz_fam = 200;		/* cache size for fam */
-INT csz_sour = 200;		/* cache size for sour */
-INT csz_even = 200;		/* cache size for even */
-INT csz_othr = 200;		/* cache size for othr */
+/* records kept in cache however far over budget (-c option);
+ together these are the least number of records cached */
+INT csz_indi = 200;		/* least kept for indi */
+INT csz_fam = 200;		/* least kept for fam */
+INT csz_sour = 200;		/* least kept for sour */
+INT csz_even = 200;		/* least kept for even */
+INT csz_othr = 200;		/* least kept for othr */
 
 /*********************************************
  * local variables
@@ -131,6 +203,26 @@ INT csz_othr = 200;		/* cache size for othr */
 
 static CACHE indicache, famcache, evencache, sourcache, othrcache;
 
+static CACHELIST cel_lists[4];   /* indexed by CEL_A1IN etc */
+static CACHEEL cel_free = NULL;  /* elements not in use */
+static CELCHUNKP cel_chunks = NULL;
+static INT cache_budget = 0;     /* bytes allowed for all records cached */
+static INT cache_least = 0;      /* records kept however far over budget */
+static INT cache_used = 0;       /* bytes charged for records cached */
+static INT cache_hits = 0, cache_misses = 0, cache_evictions = 0;
+
+/* keys of records recently evicted from A1in, in a ring, oldest
+ first; the table maps each to its slot in the ring */
+static TABLE ghost_keys = NULL;
+static STRING * ghost_ring = NULL;
+static INT ghost_max = 0, ghost_next = 0;
+
+/* records evicted, in binary form, most recently evicted first */
+static TABLE parsed_keys = NULL; /* key -> PARSEDREC */
+static PARSEDREC parsed_first = NULL, parsed_last = NULL;
+static INT parsed_budget = 0;    /* bytes allowed for them */
+static INT parsed_used = 0, parsed_hits = 0;
+
 static CNSTRING cel_magic = "CEL_MAGIC"; /* fixed pointer to identify cel */
 
 /* keybuf circular list of last 10 keys we looked up in cache 
@@ -510,15 +602,33 @@ key_to_othr_cacheel (CNSTRING key)
 }
 /*======================================
  * init_caches -- Create and init caches
+ *  RecordCacheMB option sets the budget (default 4), &
+ *  ParsedCacheMB that for evicted records (default 4)
  *====================================*/
 void
 init_caches (void)
 {
-	indicache = create_cache("INDI", csz_indi);
-	famcache  = create_cache("FAM", csz_fam);
-	evencache = create_cache("EVEN", csz_even);
-	sourcache = create_cache("SOUR", csz_sour);
-	othrcache = create_cache("OTHR", csz_othr);
+	INT mb = getlloptint("RecordCacheMB", 4);
+	if (mb < 1) mb = 1;
+	cache_budget = mb * 1048576;
+	cache_least = csz_indi + csz_fam + csz_sour + csz_even + csz_othr;
+	cache_used = cache_hits = cache_misses = cache_evictions = 0;
+	memset(cel_lists, 0, sizeof(cel_lists));
+	/* remember about as many evicted keys as records fit */
+	ghost_max = cache_budget / 1024;
+	ghost_next = 0;
+	ghost_ring = (STRING *) stdalloc(ghost_max * sizeof(ghost_ring[0]));
+	ghost_keys = create_table_vptr(); /* pointers into ghost_ring */
+	/* ParsedCacheMB option sets budget for records in binary form */
+	mb = getlloptint("ParsedCacheMB", 4);
+	parsed_budget = (mb > 0) ? mb * 1048576 : 0;
+	parsed_used = parsed_hits = 0;
+	parsed_keys = create_table_vptr(); /* PARSEDRECs, owned by list */
+	indicache = create_cache("INDI");
+	famcache  = create_cache("FAM");
+	evencache = create_cache("EVEN");
+	sourcache = create_cache("SOUR");
+	othrcache = create_cache("OTHR");
 }
 /*======================================
  * free_caches -- Release cache memory
@@ -527,21 +637,27 @@ init_caches (void)
 void
 free_caches (void)
 {
+	CELCHUNKP chunk;
 	delete_cache(&indicache);
 	delete_cache(&famcache);
 	delete_cache(&evencache);
 	delete_cache(&sourcache);
 	delete_cache(&othrcache);
+	free_ghosts();
+	free_parsed();
+	while ((chunk = cel_chunks) != NULL) {
+		cel_chunks = chunk->next;
+		stdfree(chunk);
+	}
+	cel_free = NULL;
 }
 /*=============================
  * create_cache -- Create cache
  *===========================*/
 static CACHE
-create_cache (STRING name, INT dirsize)
+create_cache (STRING name)
 {
 	CACHE cache;
-	INT i;
-	if (dirsize < 1) dirsize = 1;
 	cache = (CACHE) stdalloc(sizeof(*cache));
 	memset(cache, 0, sizeof(*cache));
 	llstrncpy(cacname(cache), name, sizeof(cacname(cache)), uu8);
@@ -550,23 +666,7 @@ create_cache (STRING name, INT dirsize)
 	caches, but right now (2003-10-08), tables do not expose a 
 	method to set their hash size.
 	*/
-	cacdata(cache) = create_table_vptr(); /* pointers to cache elements, owned by cacarray */
-	cacfirstdir(cache) = caclastdir(cache) = NULL;
-	cacsizedir(cache) = 0;
-	cacmaxdir(cache) = dirsize;
-	/* Allocate all the cache elements in a big block */
-	cacarray(cache) = (CACHEEL) stdalloc(cacmaxdir(cache) * sizeof(cacarray(cache)[0]));
-	/* Link all the elements together on the free list */
-	for (i=0; i<cacmaxdir(cache); ++i) {
-		CACHEEL cel = &cacarray(cache)[i];
-		CACHEEL celnext = cacfree(cache);
-		init_cel(cel);
-		if (celnext) {
-			cnext(cel) = celnext;
-			cprev(celnext) = cel;
-		}
-		cacfree(cache) = cel;
-	}
+	cacdata(cache) = create_table_vptr(); /* pointers to cache elements, owned by cel_chunks */
 	return cache;
 }
 /*=============================
@@ -575,20 +675,22 @@ create_cache (STRING name, INT dirsize)
 static void
 delete_cache (CACHE * pcache)
 {
-	INT num=0;
+	INT num=0, which;
 	CACHE cache = *pcache;
-	CACHEEL frst=0;
+	CACHEEL cel=0, next=0;
 	if (!cache) return;
-	/* Loop through all cache elements, freeing each */
-	while ((frst = cacfirstdir(cache)) != 0) {
-		BOOLEAN delcache = TRUE;
-		remove_cel_from_cache(cache, frst, delcache);
+	/* Loop through all cache elements of this cache, freeing each */
+	for (which = CEL_A1IN; which <= CEL_LOCKED; ++which) {
+		for (cel = cel_lists[which].l_first; cel; cel = next) {
+			BOOLEAN delcache = TRUE;
+			next = cnext(cel);
+			if (ccache(cel) == cache)
+				remove_cel_from_cache(cache, cel, delcache);
+		}
 	}
-	/* TODO: Need to delete cache elements on free list */
 	num = get_table_count(cacdata(cache));
 	ASSERT(num == 0);
 	destroy_table(cacdata(cache));
-	stdfree(cacarray(cache));
 	stdfree(cache);
 	*pcache = 0;
 }
@@ -602,48 +704,262 @@ init_cel (CACHEEL cel)
 	cel->c_magic = cel_magic;
 }
 /*=================================================
- * remove_direct -- Unlink CACHEEL from direct list
+ * list_remove -- Unlink CACHEEL from its list
  *===============================================*/
 static void
-remove_direct (CACHE cache, CACHEEL cel)
+list_remove (CACHEEL cel)
 {
+	CACHELIST * list;
 	CACHEEL prev = cprev(cel);
 	CACHEEL next = cnext(cel);
-	ASSERT(cache);
 	ASSERT(cel);
+	ASSERT(clist(cel) != CEL_FREE);
+	list = &cel_lists[clist(cel)];
 	if (prev) cnext(prev) = next;
 	if (next) cprev(next) = prev;
-	if (!prev) cacfirstdir(cache) = next;
-	if (!next) caclastdir(cache) = prev;
-	cacsizedir(cache)--;
+	if (!prev) list->l_first = next;
+	if (!next) list->l_last = prev;
+	list->l_count--;
+	list->l_bytes -= csize(cel);
+	cprev(cel) = cnext(cel) = NULL;
+	clist(cel) = CEL_FREE;
 }
 /*===========================================================
- * first_direct -- Make unlinked CACHEEL first in direct list
+ * list_push -- Make unlinked CACHEEL first in list
+ *  which:  [IN]  CEL_A1IN, CEL_AM or CEL_LOCKED
  *=========================================================*/
 static void
-first_direct (CACHE cache, CACHEEL cel)
+list_push (CACHEEL cel, INT which)
 {
-	CACHEEL frst = cacfirstdir(cache);
-	ASSERT(cache);
+	CACHELIST * list = &cel_lists[which];
+	CACHEEL frst = list->l_first;
 	ASSERT(cel);
-	cacsizedir(cache)++;
+	ASSERT(clist(cel) == CEL_FREE);
+	list->l_count++;
+	list->l_bytes += csize(cel);
 	cprev(cel) = NULL;
 	cnext(cel) = frst;
 	if (frst) cprev(frst) = cel;
-	if (!frst) caclastdir(cache) = cel;
-	cacfirstdir(cache) = cel;
+	if (!frst) list->l_last = cel;
+	list->l_first = cel;
+	clist(cel) = which;
 }
 /*============================================================
- * direct_to_first -- Make direct CACHEEL first in direct list
+ * relist_cel -- Move CACHEEL whose lock count changed
+ *  Locked elements are set aside, & unlocked ones go back
+ *  (as newest) to the list they were on before, so locking
+ *  a record (as forindi does each in turn) is not taken as
+ *  its being used again
  *==========================================================*/
 static void
-direct_to_first (CACHE cache, CACHEEL cel)
+relist_cel (CACHEEL cel)
 {
-	ASSERT(cache);
-	ASSERT(cel);
-	if (cel == cacfirstdir(cache)) return;
-	remove_direct(cache, cel);
-	first_direct(cache, cel);
+	INT which = cclock(cel) ? CEL_LOCKED : chome(cel);
+	if (clist(cel) == which) return;
+	if (which == CEL_LOCKED)
+		chome(cel) = clist(cel);
+	list_remove(cel);
+	list_push(cel, which);
+}
+/*============================================================
+ * ghost_add -- Remember key of record evicted from A1in
+ *  (forgetting oldest, if ring is full)
+ *==========================================================*/
+static void
+ghost_add (CNSTRING key)
+{
+	STRING * slot;
+	if (!ghost_max || valueof_ptr(ghost_keys, key))
+		return;
+	slot = &ghost_ring[ghost_next];
+	if (*slot) {
+		delete_table_element(ghost_keys, *slot);
+		stdfree(*slot);
+	}
+	*slot = strsave(key);
+	insert_table_ptr(ghost_keys, *slot, slot);
+	if (++ghost_next == ghost_max)
+		ghost_next = 0;
+}
+/*============================================================
+ * ghost_take -- Was record evicted from A1in lately ?
+ *  (& forget it, if so)
+ *==========================================================*/
+static BOOLEAN
+ghost_take (CNSTRING key)
+{
+	STRING * slot;
+	if (!ghost_keys || !(slot = (STRING *) valueof_ptr(ghost_keys, key)))
+		return FALSE;
+	delete_table_element(ghost_keys, key);
+	stdfree(*slot);
+	*slot = NULL;
+	return TRUE;
+}
+/*============================================================
+ * free_ghosts -- Forget all keys of evicted records
+ *==========================================================*/
+static void
+free_ghosts (void)
+{
+	INT i;
+	if (!ghost_keys) return;
+	destroy_table(ghost_keys);
+	ghost_keys = NULL;
+	for (i = 0; i < ghost_max; ++i) {
+		if (ghost_ring[i])
+			stdfree(ghost_ring[i]);
+	}
+	stdfree(ghost_ring);
+	ghost_ring = NULL;
+	ghost_max = ghost_next = 0;
+}
+/*============================================================
+ * make_room -- Evict records until another of size fits
+ *  Takes from A1in while it holds more than its quarter
+ *  of the budget, else from Am
+ *  If all else is locked, cache goes over budget
+ *==========================================================*/
+static void
+make_room (INT size)
+{
+	CACHELIST * a1in = &cel_lists[CEL_A1IN];
+	CACHELIST * am = &cel_lists[CEL_AM];
+	while (cache_used + size > cache_budget
+		&& a1in->l_count + am->l_count + cel_lists[CEL_LOCKED].l_count
+			> cache_least) {
+		CACHEEL cel;
+		if (a1in->l_last && (a1in->l_bytes > cache_budget/4 || !am->l_last)) {
+			cel = a1in->l_last;
+			ghost_add(ckey(cel));
+		} else if (am->l_last) {
+			cel = am->l_last;
+		} else {
+			break;
+		}
+		/* keep it in binary form, in case it is wanted again */
+		if (cbin(cel)) {
+			parsed_put(ckey(cel), cbin(cel), cbinlen(cel));
+			charge_cel(cel, -cbinlen(cel));
+			cbin(cel) = NULL;
+		}
+		remove_cel_from_cache(ccache(cel), cel, FALSE);
+		++cache_evictions;
+	}
+}
+/*============================================================
+ * charge_cel -- Change bytes charged for CACHEEL on a list
+ *==========================================================*/
+static void
+charge_cel (CACHEEL cel, INT delta)
+{
+	csize(cel) += delta;
+	cel_lists[clist(cel)].l_bytes += delta;
+	cacbytes(ccache(cel)) += delta;
+	cache_used += delta;
+}
+/*============================================================
+ * parsed_put -- Keep binary form of evicted record
+ *  (dropping those evicted longest ago, to stay in budget)
+ *  bin: [IN]  binary form, which is taken over
+ *==========================================================*/
+static void
+parsed_put (CNSTRING key, STRING bin, INT len)
+{
+	PARSEDREC prec;
+	if ((prec = (PARSEDREC) valueof_ptr(parsed_keys, key)))
+		parsed_drop(prec);
+	if (len > parsed_budget / 8) {
+		stdfree(bin);
+		return;
+	}
+	prec = (PARSEDREC) stdalloc(sizeof(*prec));
+	prec->p_key = strsave(key);
+	prec->p_bin = bin;
+	prec->p_len = len;
+	prec->p_next = parsed_first;
+	if (parsed_first) parsed_first->p_prev = prec;
+	if (!parsed_last) parsed_last = prec;
+	parsed_first = prec;
+	insert_table_ptr(parsed_keys, prec->p_key, prec);
+	parsed_used += len;
+	while (parsed_used > parsed_budget)
+		parsed_drop(parsed_last);
+}
+/*============================================================
+ * parsed_take -- Take binary form of record, if kept
+ * returns stdalloc'd binary form, or NULL
+ *==========================================================*/
+static STRING
+parsed_take (CNSTRING key, INT *plen)
+{
+	PARSEDREC prec;
+	STRING bin;
+	if (!parsed_keys || !(prec = (PARSEDREC) valueof_ptr(parsed_keys, key)))
+		return NULL;
+	bin = prec->p_bin;
+	*plen = prec->p_len;
+	prec->p_bin = NULL;
+	parsed_drop(prec);
+	++parsed_hits;
+	return bin;
+}
+/*============================================================
+ * parsed_drop -- Forget binary form of evicted record
+ *==========================================================*/
+static void
+parsed_drop (PARSEDREC prec)
+{
+	if (prec->p_prev) prec->p_prev->p_next = prec->p_next;
+	if (prec->p_next) prec->p_next->p_prev = prec->p_prev;
+	if (!prec->p_prev) parsed_first = prec->p_next;
+	if (!prec->p_next) parsed_last = prec->p_prev;
+	parsed_used -= prec->p_len;
+	delete_table_element(parsed_keys, prec->p_key);
+	stdfree(prec->p_key);
+	if (prec->p_bin)
+		stdfree(prec->p_bin);
+	stdfree(prec);
+}
+/*============================================================
+ * free_parsed -- Forget all evicted records
+ *==========================================================*/
+static void
+free_parsed (void)
+{
+	if (!parsed_keys) return;
+	while (parsed_first)
+		parsed_drop(parsed_first);
+	destroy_table(parsed_keys);
+	parsed_keys = NULL;
+}
+/*============================================================
+ * forget_parsed_record -- Drop binary form of record, as it
+ *  is being changed in database
+ *==========================================================*/
+void
+forget_parsed_record (CNSTRING key)
+{
+	PARSEDREC prec;
+	CACHE cache = NULL;
+	CACHEEL cel;
+	if (!key || !parsed_keys)
+		return;
+	if ((prec = (PARSEDREC) valueof_ptr(parsed_keys, key)))
+		parsed_drop(prec);
+	switch(key[0]) {
+	case 'I': cache = indicache; break;
+	case 'F': cache = famcache; break;
+	case 'S': cache = sourcache; break;
+	case 'E': cache = evencache; break;
+	case 'X': cache = othrcache; break;
+	}
+	if (cache && (cel = (CACHEEL) valueof_ptr(cacdata(cache), key))
+		&& cbin(cel)) {
+		stdfree(cbin(cel));
+		charge_cel(cel, -cbinlen(cel));
+		cbin(cel) = NULL;
+	}
 }
 /*========================================================
  * add_to_direct -- Add new CACHEEL to direct part of cache
@@ -662,14 +978,29 @@ add_to_direct (CACHE cache, CNSTRING key, INT reportmode)
 	INT len=0;
 	CACHEEL cel=0;
 	RECORD rec=0;
+	STRING bin=0;
+	INT binlen=0;
 	int i, j;
 
 	ASSERT(cache);
 	ASSERT(key);
 	rec = NULL;
-	if ((rawrec = retrieve_raw_record(key, &len))) 
+	/* rebuild record evicted lately from its binary form */
+	if ((bin = parsed_take(key, &binlen))) {
+		NODE node = binary_to_node(bin, binlen);
+		if (node)
+			rec = create_record_for_keyed_node(node, key);
+		if (!rec) {
+			stdfree(bin);
+			bin = NULL;
+		}
+	}
+	if (!rec && (rawrec = retrieve_raw_record(key, &len))) {
 		/* 2003-11-22, we should use string_to_node here */
 		rec = string_to_record(rawrec, key, len);
+		if (rec && parsed_budget)
+			bin = node_to_binary(nztop(rec), &binlen);
+	}
 	if (!rec)
 	{
 		ZSTR zstr=zs_newn(256);
@@ -702,11 +1033,18 @@ add_to_direct (CACHE cache, CNSTRING key, INT reportmode)
 	/* record was just loaded, nztop should not need to load it */
 	cel = node_to_cache(cache, nztop(rec));
 	ASSERT(!crecord(cel));
-	/* node_to_cache did a first_direct call, so record in cache */
+	/* node_to_cache put it on a list, so record in cache */
 	record_set_cel(rec, cel);
 	/* our new rec above has one reference, which is held by cel */
 	crecord(cel) = rec;
-	stdfree(rawrec);
+	/* binary form as read goes with it, till it is evicted */
+	if (bin) {
+		cbin(cel) = bin;
+		cbinlen(cel) = binlen;
+		charge_cel(cel, binlen);
+	}
+	if (rawrec)
+		stdfree(rawrec);
 	ASSERT(cel->c_magic == cel_magic);
 	return cel;
 }
@@ -725,7 +1063,12 @@ key_to_cacheel (CACHE cache, CNSTRING key, STRING tag, INT reportmode)
 	if ((cel = (CACHEEL) valueof_ptr(cacdata(cache), key))) {
 		ASSERT(cnode(cel));
 		ASSERT(cel->c_magic == cel_magic);
-		direct_to_first(cache, cel);
+		++cache_hits;
+		/* records on A1in stay in place, as 2Q would have it */
+		if (clist(cel) == CEL_AM && cel != cel_lists[CEL_AM].l_first) {
+			list_remove(cel);
+			list_push(cel, CEL_AM);
+		}
 		if (tag) {
 			ASSERT(eqstr(tag, ntag(cnode(cel))));
 			ASSERT(crecord(cel));
@@ -733,6 +1076,7 @@ key_to_cacheel (CACHE cache, CNSTRING key, STRING tag, INT reportmode)
 		}
 		return cel;
 	}
+	++cache_misses;
 	cel = add_to_direct(cache, key, reportmode);
 	if (cel && tag) {
 		ASSERT(eqstr(tag, ntag(cnode(cel))));
@@ -845,6 +1189,7 @@ lock_cache (CACHEEL cel)
 	ASSERT(cnode(cel)); /* must be in direct */
 	++cclock(cel);
 	ASSERT(cclock(cel)>0);
+	relist_cel(cel);
 }
 /*======================================
  * lockrpt_cache -- Lock CACHEEL into direct cache (for report program)
@@ -858,6 +1203,7 @@ lockrpt_cache (CACHEEL cel)
 	/* put report lock on, so we can free orphaned report locks */
 	++ccrptlock(cel);
 	ASSERT(cclock(cel)>0);
+	relist_cel(cel);
 }
 /*======================================
  * cel_rptlocks -- return report lock count for specified cache element
@@ -879,6 +1225,7 @@ lock_record_in_cache (RECORD rec)
 	cel = nzcel(rec);
 	++cclock(cel);
 	ASSERT(cclock(cel) > 0);
+	relist_cel(cel);
 }
 /*==========================================
  * unlock_cache -- Unlock CACHEEL from direct cache
@@ -889,6 +1236,7 @@ unlock_cache (CACHEEL cel)
 	ASSERT(cclock(cel) > 0);
 	ASSERT(cnode(cel));
 	--cclock(cel);
+	relist_cel(cel);
 }
 /*==========================================
  * unlockrpt_cache -- Unlock CACHEEL from direct cache (report program call)
@@ -901,6 +1249,7 @@ unlockrpt_cache (CACHEEL cel)
 	ASSERT(cnode(cel));
 	--cclock(cel);
 	--ccrptlock(cel);
+	relist_cel(cel);
 }
 /*======================================
  * unlock_record_from_cache -- Remove lock on record
@@ -914,6 +1263,7 @@ unlock_record_from_cache (RECORD rec)
 	ASSERT(cel);
 	ASSERT(cclock(cel) > 0);
 	--cclock(cel);
+	relist_cel(cel);
 }
 /*=========================================
  * cache_get_lock_counts -- Fill in lock counts
@@ -924,8 +1274,8 @@ static void
 cache_get_lock_counts (CACHE ca, INT * locks)
 {
 	CACHEEL cel;
-	for (cel = cacfirstdir(ca); cel; cel = cnext(cel)) {
-		if (cclock(cel) && locks) ++(*locks);
+	for (cel = cel_lists[CEL_LOCKED].l_first; cel; cel = cnext(cel)) {
+		if (ccache(cel) == ca && locks) ++(*locks);
 	}
 }
 /*=========================================
@@ -939,11 +1289,41 @@ get_cache_stats (CACHE ca)
 	INT lo=0;
 	cache_get_lock_counts(ca, &lo);
 	zs_appf(zstr
-		, "d:" FMT_INT "/" FMT_INT " (l:" FMT_INT ")"
-		, cacsizedir(ca), cacmaxdir(ca), lo
+		, "d:" FMT_INT "/" FMT_INT "K (l:" FMT_INT ")"
+		, caccount(ca), (cacbytes(ca) + 1023) / 1024, lo
 		);
 	return zstr;
 }
+/*=========================================
+ * get_record_cache_stats -- Report on record cache
+ *  size:      [OUT] bytes allowed
+ *  used:      [OUT] bytes in use
+ *  hits:      [OUT] lookups found in cache
+ *  misses:    [OUT] lookups read from database
+ *  evictions: [OUT] records dropped to make room
+ *=======================================*/
+void
+get_record_cache_stats (INT *size, INT *used, INT *hits, INT *misses, INT *evictions)
+{
+	*size = cache_budget;
+	*used = cache_used;
+	*hits = cache_hits;
+	*misses = cache_misses;
+	*evictions = cache_evictions;
+}
+/*=========================================
+ * get_parsed_cache_stats -- Report on evicted records kept
+ *  size:      [OUT] bytes allowed
+ *  used:      [OUT] bytes in use
+ *  hits:      [OUT] records rebuilt from binary form
+ *=======================================*/
+void
+get_parsed_cache_stats (INT *size, INT *used, INT *hits)
+{
+	*size = parsed_budget;
+	*used = parsed_used;
+	*hits = parsed_hits;
+}
 /*=========================================
  * get_cache_stats_indi -- Return indi cache stats
  *=======================================*/
@@ -1026,13 +1406,15 @@ othr_to_cache (NODE node)
  *  and delegates the work
  *  node tree must be valid, and of the correct type
  *  (INDI node trees may only be added to INDI cache, etc)
- *  This puts node into cache (first_direct)
+ *  This puts node into cache (on A1in, or on Am if it was
+ *  evicted from A1in lately)
  *======================================*/
 static CACHEEL
 node_to_cache (CACHE cache, NODE top)
 {
 	STRING key=0;
 	CACHEEL cel=0;
+	INT size;
 	ASSERT(cache);
 	ASSERT(top);
 	ASSERT(!nparent(top));	/* should be a root */
@@ -1049,38 +1431,55 @@ node_to_cache (CACHE cache, NODE top)
 	/* ASSERT that record is not in cache */
 	/* We're not supposed to be called if record in cache */
 	ASSERT(!valueof_ptr(cacdata(cache), key));
-	cel = get_free_cacheel(cache);
-	put_node_in_cache(cache, cel, top, key);
+	size = sizeof(*cel) + strlen(key) + 1 + node_tree_size(top);
+	make_room(size);
+	cel = get_free_cacheel();
+	put_node_in_cache(cache, cel, top, key, size
+		, ghost_take(key) ? CEL_AM : CEL_A1IN);
 	return cel;
 }
+/*=======================================================
+ * node_tree_size -- Bytes held by node tree
+ *  (tags are shared, so not counted)
+ *=====================================================*/
+static INT
+node_tree_size (NODE node)
+{
+	INT size = 0;
+	while (node) {
+		size += sizeof(*node);
+		if (nxref(node)) size += strlen(nxref(node)) + 1;
+		if (nval(node)) size += strlen(nval(node)) + 1;
+		if (nchild(node)) size += node_tree_size(nchild(node));
+		node = nsibling(node);
+	}
+	return size;
+}
 /*=======================================================
  * get_free_cacheel -- Remove and return entry from free list
+ *  (allocating another block of entries if it is empty)
  *=====================================================*/
 static CACHEEL
-get_free_cacheel (CACHE cache)
+get_free_cacheel (void)
 {
-	CACHEEL cel=0, celnext=0;
+	CACHEEL cel=0;
 
-	/* If free list is empty, move least recently used entry to free list */
-	if (!cacfree(cache)) {
-		/* find least recently used by unlocked entry */
-		for (cel = caclastdir(cache); cel && cclock(cel); cel = cprev(cel)) {
-		}
-		if (!cel) {
-			crashlog(_("Cache [%s] overflowed its max size (" FMT_INT ")"), cacname(cache), cacmaxdir(cache));
-			ASSERT(0);
+	if (!cel_free) {
+		CELCHUNKP chunk = (CELCHUNKP) stdalloc(sizeof(*chunk));
+		INT i;
+		chunk->next = cel_chunks;
+		cel_chunks = chunk;
+		for (i=0; i<CELCHUNK; ++i) {
+			cel = &chunk->cels[i];
+			init_cel(cel);
+			cnext(cel) = cel_free;
+			cel_free = cel;
 		}
-		remove_from_cache(cache, ckey(cel));
 	}
 
-	cel = cacfree(cache);
-	ASSERT(cel);
-
 	/* remove entry from free list */
-	celnext = cnext(cel);
-	cacfree(cache) = celnext;
-	if (celnext)
-		cprev(celnext) = 0;
+	cel = cel_free;
+	cel_free = cnext(cel);
 	/* reinitialize entry */
 	init_cel(cel);
 
@@ -1114,20 +1513,27 @@ set_all_nodetree_to_cel (NODE node, CACHEEL cel)
 }
 /*=======================================================
  * put_node_in_cache -- Low-level work of loading node into cacheel supplied
+ *  size:  [IN]  bytes to charge for it
+ *  which: [IN]  list to put it on (CEL_A1IN or CEL_AM)
  *=====================================================*/
 static void
-put_node_in_cache (CACHE cache, CACHEEL cel, NODE node, STRING key)
+put_node_in_cache (CACHE cache, CACHEEL cel, NODE node, STRING key, INT size, INT which)
 {
 	BOOLEAN travdone = FALSE;
 	ASSERT(cache);
 	ASSERT(node);
-	ASSERT(cacsizedir(cache) < cacmaxdir(cache));
 	init_cel(cel);
 	insert_table_ptr(cacdata(cache), key, cel);
 	cnode(cel) = node;
 	ckey(cel) = strsave(key);
 	cclock(cel) = FALSE;
-	first_direct(cache, cel);
+	ccache(cel) = cache;
+	csize(cel) = size;
+	chome(cel) = which;
+	list_push(cel, which);
+	caccount(cache)++;
+	cacbytes(cache) += size;
+	cache_used += size;
 	/* Now set all nodes in tree to point to cache record */
 	while (!travdone) {
 		node->n_cel = cel;
@@ -1190,17 +1596,17 @@ remove_from_cache (CACHE cache, CNSTRING key)
 	if (!key || *key == 0 || !cache)
 		return;
 	/* If it has a key, it is in the cache */
-	cel = valueof_ptr(cacdata(cache), key);
+	if (!(cel = valueof_ptr(cacdata(cache), key)))
+		return;
 	remove_cel_from_cache(cache, cel, delcache);
 }
 /*=============================================
- * remove_from_cache -- Move cache entry to free list
+ * remove_cel_from_cache -- Move cache entry to free list
  *  Requires non-null input
  *===========================================*/
 static void
 remove_cel_from_cache (CACHE cache, CACHEEL cel, BOOLEAN delcache)
 {
-	CACHEEL celnext=0;
 	STRING key = ckey(cel);
 
 	/* caller ensured cache && key are non-null */
@@ -1227,7 +1633,14 @@ remove_cel_from_cache (CACHE cache, CACHEEL cel, BOOLEAN delcache)
 	}
 	ASSERT(!cclock(cel)); 
 	ASSERT(cnode(cel));
-	remove_direct(cache, cel);
+	if (cbin(cel)) {
+		stdfree(cbin(cel));
+		cbin(cel) = NULL;
+	}
+	list_remove(cel);
+	caccount(cache)--;
+	cacbytes(cache) -= csize(cel);
+	cache_used -= csize(cel);
 
 	/* Clear all node tree info */
 	if (1) {
@@ -1238,11 +1651,7 @@ remove_cel_from_cache (CACHE cache, CACHEEL cel, BOOLEAN delcache)
 		free_nodes(node);
 	}
 
-	celnext = cacfree(cache);
-	cnext(cel) = celnext;
-	if (celnext)
-		cprev(celnext) = cel;
-	cprev(cel) = 0;
+	cnext(cel) = cel_free;
 	ckey(cel) = 0;
 	if (crecord(cel)) {
 		/* cel holds the original reference to the record */
@@ -1251,7 +1660,7 @@ remove_cel_from_cache (CACHE cache, CACHEEL cel, BOOLEAN delcache)
 		release_record(rec);
 		crecord(cel) = 0;
 	}
-	cacfree(cache) = cel;
+	cel_free = cel;
 	delete_table_element(cacdata(cache), key);
 	stdfree(key); /* alloc'd when assigned to ckey(cel) */
 }
@@ -1525,14 +1934,16 @@ static int
 free_all_rprtlocks_in_cache (CACHE cache)
 {
 	INT ct=0;
-	CACHEEL cel=0;
+	CACHEEL cel=0, next=0;
 
-	for (cel = caclastdir(cache); cel; cel = cprev(cel)) {
-		if (ccrptlock(cel)) {
+	for (cel = cel_lists[CEL_LOCKED].l_first; cel; cel = next) {
+		next = cnext(cel);
+		if (ccache(cel) == cache && ccrptlock(cel)) {
 			INT delta = ccrptlock(cel);
 			ccrptlock(cel) = 0;
 			ASSERT(cclock(cel) >= delta);
 			cclock(cel) -= delta;
+			relist_cel(cel);
 			++ct;
 		}
 	}
@@ -0,0 +1,443 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * kinship.c -- Index of family links between records
+ *  For each person (by key number) this keeps the families
+ *  in which the person is a child (FAMC) & a spouse (FAMS),
+ *  & for each family its spouses (HUSB & WIFE) & children
+ *  (CHIL), so that closures such as all the ancestors or
+ *  all the descendants of people are walks over numbers,
+ *  with no records loaded as nodes.
+ *  The links of a record are read from its raw text the
+ *  first time they are wanted, & kept in step as records
+ *  are stored (see store_record), until the database is
+ *  closed.
+ *  Links follow the node macros: FORFAMCS, FORFAMS &
+ *  FORCHILDRENx take the first run of their tag, and
+ *  FORFAMSPOUSES every HUSB & WIFE, so walks find people
+ *  in the same order as walks over nodes do.
+ *===========================================================*/
+
+#include "llstdlib.h"
+#include "gedcom.h"
+#include "gedcomi.h"
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* links of one record */
+typedef struct tag_kinrec {
+	INT32 * links;  /* FAMC then FAMS (person), HUSB/WIFE then CHIL (family) */
+	INT32 nfirst;   /* how many of first kind */
+	INT32 nlinks;   /* how many in all */
+	INT32 mark;     /* last walk to reach this record */
+	char state;     /* KIN_UNREAD, KIN_ABSENT or KIN_PRESENT */
+} *KINREC;
+#define KIN_UNREAD  0
+#define KIN_ABSENT  1
+#define KIN_PRESENT 2
+
+/* links of all records of one type, in chunks (so never moved) */
+typedef struct tag_kinset {
+	KINREC * chunks;
+	INT32 nchunks;
+	char ntype;
+	CNSTRING tag;   /* level 0 tag of its records */
+} *KINSET;
+#define KINCHUNK ((INT32)1024) /* records per chunk */
+
+/* growing list of numbers */
+typedef struct tag_kinlist {
+	INT32 * nums;
+	INT32 n;
+	INT32 max;
+} *KINLIST;
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static KINREC kin_get(KINSET set, INT32 keynum);
+static CNSTRING kin_line(CNSTRING p, CNSTRING end, INT *plev
+	, CNSTRING *ptag, INT *ptaglen, CNSTRING *pval, INT *pvallen);
+static INT32 kin_keynum(CNSTRING val, INT len, char ntype);
+static void kin_parse(KINSET set, KINREC rec, CNSTRING raw, INT len);
+static void kin_push(KINLIST list, INT32 num);
+static void kin_scan(CNSTRING raw, INT len, CNSTRING tag1, CNSTRING tag2
+	, BOOLEAN run, char ntype, KINLIST list);
+static BOOLEAN tag_is(CNSTRING tag, INT taglen, CNSTRING name);
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+static struct tag_kinset kin_indis = { 0, 0, 'I', "INDI" };
+static struct tag_kinset kin_fams = { 0, 0, 'F', "FAM" };
+static INT32 kin_walk = 0; /* number of latest walk, for marks */
+
+/*********************************************
+ * local & exported function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * kin_get -- Get links of record, reading them if need be
+ *  returns NULL for bad key number
+ *============================================*/
+static KINREC
+kin_get (KINSET set, INT32 keynum)
+{
+	INT32 c = keynum/KINCHUNK;
+	KINREC rec;
+	if (keynum <= 0)
+		return NULL;
+	if (c >= set->nchunks) {
+		INT32 m = set->nchunks ? set->nchunks * 2 : 16;
+		KINREC * chunks;
+		if (m <= c)
+			m = c + 1;
+		chunks = (KINREC *) stdalloc(m*sizeof(KINREC));
+		memset(chunks, 0, m*sizeof(KINREC));
+		if (set->nchunks) {
+			memcpy(chunks, set->chunks, set->nchunks*sizeof(KINREC));
+			stdfree(set->chunks);
+		}
+		set->chunks = chunks;
+		set->nchunks = m;
+	}
+	if (!set->chunks[c]) {
+		set->chunks[c] = (KINREC) stdalloc(KINCHUNK*sizeof(struct tag_kinrec));
+		memset(set->chunks[c], 0, KINCHUNK*sizeof(struct tag_kinrec));
+	}
+	rec = set->chunks[c] + keynum % KINCHUNK;
+	if (rec->state == KIN_UNREAD) {
+		char key[12]; /* type & up to 10 digits */
+		STRING raw;
+		INT len = 0;
+		snprintf(key, sizeof(key), "%c" FMT_INT32, set->ntype, keynum);
+		raw = retrieve_raw_record(key, &len);
+		kin_parse(set, rec, raw, raw ? len : 0);
+		if (raw)
+			stdfree(raw);
+	}
+	return rec;
+}
+/*==============================================
+ * kin_line -- Split one line of raw record
+ *  (as buffer_to_line does, but without changing it)
+ *  returns start of next line, or NULL if no line is left
+ *============================================*/
+static CNSTRING
+kin_line (CNSTRING p, CNSTRING end, INT *plev
+	, CNSTRING *ptag, INT *ptaglen, CNSTRING *pval, INT *pvallen)
+{
+	CNSTRING eol;
+	if (p >= end)
+		return NULL;
+	for (eol = p; eol < end && *eol != '\n'; eol++)
+		;
+	*plev = -1;
+	*ptaglen = *pvallen = 0;
+	*ptag = *pval = eol;
+	while (p < eol && iswhite((uchar)*p)) p++;
+	if (p < eol && chartype((uchar)*p) == DIGIT) {
+		INT lev = 0;
+		while (p < eol && chartype((uchar)*p) == DIGIT)
+			lev = lev*10 + (uchar)*p++ - (uchar)'0';
+		while (p < eol && iswhite((uchar)*p)) p++;
+		if (p < eol && *p == '@') {
+			/* skip cross reference */
+			while (p < eol && !iswhite((uchar)*p)) p++;
+			while (p < eol && iswhite((uchar)*p)) p++;
+		}
+		*plev = lev;
+		*ptag = p;
+		while (p < eol && !iswhite((uchar)*p)) p++;
+		*ptaglen = p - *ptag;
+		while (p < eol && iswhite((uchar)*p)) p++;
+		*pval = p;
+		for (p = eol; p > *pval && iswhite((uchar)p[-1]); p--)
+			;
+		*pvallen = p - *pval;
+	}
+	return eol < end ? eol + 1 : end;
+}
+/*==============================================
+ * kin_keynum -- Get key number from link value (eg, @I12@)
+ *  returns 0 if not a key of type ntype
+ *============================================*/
+static INT32
+kin_keynum (CNSTRING val, INT len, char ntype)
+{
+	INT32 keynum = 0;
+	INT i;
+	/* digits, with no leading zero, as keys are made */
+	if (len < 4 || len > 10 || val[0] != '@' || val[len-1] != '@'
+		|| val[1] != ntype || val[2] == '0')
+		return 0;
+	for (i = 2; i < len-1; i++) {
+		if (chartype((uchar)val[i]) != DIGIT)
+			return 0;
+		keynum = keynum*10 + (val[i] - '0');
+	}
+	return keynum;
+}
+/*==============================================
+ * kin_parse -- Take links of record from its raw text
+ *  raw:  [IN]  text of record (NULL if none)
+ *============================================*/
+static void
+kin_parse (KINSET set, KINREC rec, CNSTRING raw, INT len)
+{
+	struct tag_kinlist list;
+	CNSTRING tag, val;
+	INT lev, taglen, vallen;
+
+	if (rec->links)
+		stdfree(rec->links);
+	rec->links = 0;
+	rec->nfirst = rec->nlinks = 0;
+	rec->state = KIN_ABSENT;
+	/* deleted records are "DELE\n", so have no level 0 line */
+	if (!raw || !kin_line(raw, raw+len, &lev, &tag, &taglen, &val, &vallen)
+		|| lev != 0 || !tag_is(tag, taglen, set->tag))
+		return;
+	rec->state = KIN_PRESENT;
+	list.nums = 0;
+	list.n = list.max = 0;
+	if (set->ntype == 'I') {
+		kin_scan(raw, len, "FAMC", NULL, TRUE, 'F', &list);
+		rec->nfirst = list.n;
+		kin_scan(raw, len, "FAMS", NULL, TRUE, 'F', &list);
+	} else {
+		kin_scan(raw, len, "HUSB", "WIFE", FALSE, 'I', &list);
+		rec->nfirst = list.n;
+		kin_scan(raw, len, "CHIL", NULL, TRUE, 'I', &list);
+	}
+	rec->nlinks = list.n;
+	rec->links = list.nums;
+}
+/*==============================================
+ * kin_push -- Add number to end of list
+ *============================================*/
+static void
+kin_push (KINLIST list, INT32 num)
+{
+	if (list->n == list->max) {
+		INT32 * nums;
+		list->max = list->max ? list->max * 2 : 8;
+		nums = (INT32 *) stdalloc(list->max*sizeof(INT32));
+		if (list->n) {
+			memcpy(nums, list->nums, list->n*sizeof(INT32));
+			stdfree(list->nums);
+		}
+		list->nums = nums;
+	}
+	list->nums[list->n++] = num;
+}
+/*==============================================
+ * kin_scan -- Add key numbers of level 1 lines with tag
+ *  tag1 or tag2 (if not NULL) to list
+ *  run:  [IN]  only first run of such lines ?
+ *============================================*/
+static void
+kin_scan (CNSTRING raw, INT len, CNSTRING tag1, CNSTRING tag2
+	, BOOLEAN run, char ntype, KINLIST list)
+{
+	CNSTRING p = raw, end = raw + len, tag, val;
+	INT lev, taglen, vallen;
+	BOOLEAN inrun = FALSE;
+	INT32 keynum;
+
+	while ((p = kin_line(p, end, &lev, &tag, &taglen, &val, &vallen))) {
+		if (lev != 1)
+			continue;
+		if (!tag_is(tag, taglen, tag1) && !(tag2 && tag_is(tag, taglen, tag2))) {
+			if (inrun && run)
+				break;
+			continue;
+		}
+		inrun = TRUE;
+		if ((keynum = kin_keynum(val, vallen, ntype)))
+			kin_push(list, keynum);
+	}
+}
+/*==============================================
+ * tag_is -- Is tag (not terminated) the one named ?
+ *============================================*/
+static BOOLEAN
+tag_is (CNSTRING tag, INT taglen, CNSTRING name)
+{
+	return (BOOLEAN)((INT)strlen(name) == taglen && !strncmp(tag, name, taglen));
+}
+/*==============================================
+ * kin_note_record -- Keep links in step with record stored
+ *  key:  [IN]  key of record (eg, "I12")
+ *  rec:  [IN]  its new text ("DELE\n" if deleted)
+ *============================================*/
+void
+kin_note_record (CNSTRING key, CNSTRING rec, INT len)
+{
+	KINSET set;
+	KINREC krec;
+	INT32 keynum, c;
+	if (!key || (key[0] != 'I' && key[0] != 'F'))
+		return;
+	set = (key[0] == 'I') ? &kin_indis : &kin_fams;
+	keynum = (INT32)atoi(key+1);
+	c = keynum/KINCHUNK;
+	/* links not yet read will be read when wanted */
+	if (keynum <= 0 || c >= set->nchunks || !set->chunks[c])
+		return;
+	krec = set->chunks[c] + keynum % KINCHUNK;
+	if (krec->state != KIN_UNREAD)
+		kin_parse(set, krec, rec, len);
+}
+/*==============================================
+ * kin_free -- Forget all links (as database is closed)
+ *============================================*/
+void
+kin_free (void)
+{
+	KINSET sets[2];
+	INT32 c, i;
+	INT s;
+	sets[0] = &kin_indis;
+	sets[1] = &kin_fams;
+	for (s = 0; s < 2; s++) {
+		KINSET set = sets[s];
+		for (c = 0; c < set->nchunks; c++) {
+			if (!set->chunks[c])
+				continue;
+			for (i = 0; i < KINCHUNK; i++) {
+				if (set->chunks[c][i].links)
+					stdfree(set->chunks[c][i].links);
+			}
+			stdfree(set->chunks[c]);
+		}
+		if (set->chunks)
+			stdfree(set->chunks);
+		set->chunks = 0;
+		set->nchunks = 0;
+	}
+}
+/*==============================================
+ * kin_ancestors -- Walk to all ancestors of people
+ *  starts:  [IN]  key numbers of people to start from
+ *  fnc:     [IN]  called for each ancestor found, with
+ *                 its key number & generation (1=parent),
+ *                 in the order of a walk by generations
+ * People are found once each, but starting people are not
+ *  left out (as one may be an ancestor of another).
+ *============================================*/
+void
+kin_ancestors (INT32 * starts, INT nstarts, KIN_FOUND_FNC fnc, VPTR param)
+{
+	struct tag_kinlist queue, gens;
+	INT32 head, i, j, gen;
+	KINREC indi, fam, spouse;
+
+	queue.nums = gens.nums = 0;
+	queue.n = queue.max = gens.n = gens.max = 0;
+	++kin_walk;
+	for (i = 0; i < nstarts; i++) {
+		kin_push(&queue, starts[i]);
+		kin_push(&gens, 0);
+	}
+	for (head = 0; head < queue.n; head++) {
+		gen = gens.nums[head] + 1;
+		indi = kin_get(&kin_indis, queue.nums[head]);
+		if (!indi || indi->state != KIN_PRESENT)
+			continue;
+		for (i = 0; i < indi->nfirst; i++) {
+			fam = kin_get(&kin_fams, indi->links[i]);
+			if (fam->state != KIN_PRESENT)
+				continue;
+			for (j = 0; j < fam->nfirst; j++) {
+				spouse = kin_get(&kin_indis, fam->links[j]);
+				if (spouse->state != KIN_PRESENT || spouse->mark == kin_walk)
+					continue;
+				spouse->mark = kin_walk;
+				(*fnc)(fam->links[j], gen, param);
+				kin_push(&queue, fam->links[j]);
+				kin_push(&gens, gen);
+			}
+		}
+	}
+	if (queue.nums) {
+		stdfree(queue.nums);
+		stdfree(gens.nums);
+	}
+}
+/*==============================================
+ * kin_descendants -- Walk to all descendants of people
+ *  starts:  [IN]  key numbers of people to start from
+ *  fnc:     [IN]  called for each descendant found, with
+ *                 its key number & generation (1=child),
+ *                 in the order of a walk by generations
+ * People & families are gone through once each, but
+ *  starting people are not left out (see kin_ancestors).
+ *============================================*/
+void
+kin_descendants (INT32 * starts, INT nstarts, KIN_FOUND_FNC fnc, VPTR param)
+{
+	struct tag_kinlist queue, gens;
+	INT32 head, i, j, gen;
+	KINREC indi, fam, child;
+
+	queue.nums = gens.nums = 0;
+	queue.n = queue.max = gens.n = gens.max = 0;
+	++kin_walk;
+	for (i = 0; i < nstarts; i++) {
+		kin_push(&queue, starts[i]);
+		kin_push(&gens, 0);
+	}
+	for (head = 0; head < queue.n; head++) {
+		gen = gens.nums[head] + 1;
+		indi = kin_get(&kin_indis, queue.nums[head]);
+		if (!indi || indi->state != KIN_PRESENT)
+			continue;
+		for (i = indi->nfirst; i < indi->nlinks; i++) {
+			fam = kin_get(&kin_fams, indi->links[i]);
+			if (fam->state != KIN_PRESENT || fam->mark == kin_walk)
+				continue;
+			fam->mark = kin_walk;
+			for (j = fam->nfirst; j < fam->nlinks; j++) {
+				child = kin_get(&kin_indis, fam->links[j]);
+				if (child->state != KIN_PRESENT || child->mark == kin_walk)
+					continue;
+				child->mark = kin_walk;
+				(*fnc)(fam->links[j], gen, param);
+				kin_push(&queue, fam->links[j]);
+				kin_push(&gens, gen);
+			}
+		}
+	}
+	if (queue.nums) {
+		stdfree(queue.nums);
+		stdfree(gens.nums);
+	}
+}
@@ -17,6 +17,7 @@
 #include "btree.h"
 #include "vtable.h"
 #include "dbcontext.h"
+#include "lloptions.h"
 
 
 /*********************************************
@@ -66,10 +67,28 @@ lldb_alloc (void)
 void
 lldb_set_btree (LLDATABASE lldb, void *btree)
 {
+	INT ncache;
 	ASSERT(lldb);
 	ASSERT(!lldb->btree);
 	lldb->btree = btree;
 	BTR = btree;
+	/* IndexCacheSize (in headers) wins over IndexCacheMB */
+	ncache = getlloptint("IndexCacheSize", 0);
+	if (ncache <= 0)
+		ncache = getlloptint("IndexCacheMB", 0) * (1048576 / BUFLEN);
+	if (ncache > 0)
+		bt_set_index_cache_size(BTR, ncache);
+	/* % dead space allowed in block files before compacting */
+	bt_set_compact_threshold(BTR, getlloptint("CompactThreshold", bcompact(BTR)));
+	/* journalling of writes (on by default for writable databases) */
+	if (!getlloptint("Journal", 1))
+		bt_set_journal(BTR, FALSE);
+	/* compression of records written (if set, else as database was) */
+	if (bwrite(BTR) && getlloptint("CompressRecords", -1) >= 0)
+		bt_set_compress(BTR, getlloptint("CompressRecords", 0) != 0);
+	/* splitting of long name records (once allowed, stays so) */
+	if (bwrite(BTR) && getlloptint("SplitNameRecords", 0) > 0)
+		bt_set_split_names(BTR);
 }
 /*========================================
  * lldb_close -- Close any database contained. 
@@ -93,6 +112,8 @@ void lldb_close (LLDATABASE *plldb)
 		placabbvs = NULL;
 	}
 	free_caches();
+	kin_free();
+	gram_free();
 	check_node_leaks();
 	check_record_leaks();
 	closexref();
@@ -0,0 +1,562 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * namegram.c -- Index of name pieces by trigrams
+ *  Each name of the name records is kept here squeezed to
+ *  its upper-case pieces (see squeeze in names.c), & each
+ *  piece, taken with a blank on either side, is indexed under
+ *  every 3 characters in a row in it (eg, " SM", "SMI", "MIT",
+ *  "ITH", "TH "), & under its blank & first letter (" S").
+ *  Words to find are then matched as prefixes of pieces, as
+ *  parts anywhere in pieces, or as pieces with a typing
+ *  mistake or two, by checking only the names which hold
+ *  enough of the trigrams of the words (a mistake can spoil
+ *  at most 3 trigrams).
+ *  The index is built from the name records the first time it
+ *  is wanted, & kept in step by add_name & remove_name, until
+ *  the database is closed.
+ *===========================================================*/
+
+#include "llstdlib.h"
+#include "hashtab.h"
+#include "gedcom.h"
+#include "gedcomi.h"
+
+/*********************************************
+ * local enums & defines
+ *********************************************/
+
+#define GRAM_MAXWORDS 16    /* words of search used (rest ignored) */
+#define GRAM_MAXGRAMS (MAXGEDNAMELEN+2) /* trigrams of a word */
+
+/* ways a word may match a piece */
+#define GW_PREFIX 0  /* word  : piece begins with word */
+#define GW_INSIDE 1  /* *word : piece holds word anywhere */
+#define GW_NEAR   2  /* word~ : piece is word, give or take edits */
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* one name indexed */
+typedef struct tag_gramname {
+	INT32 keynum;   /* of person */
+	STRING pieces;  /* squeezed name, or NULL once removed */
+} *GRAMNAME;
+
+/* names (by number) holding one trigram, in ascending order */
+typedef struct tag_gramlist {
+	INT32 * ids;
+	INT32 n;
+	INT32 max;
+} *GRAMLIST;
+
+/* one word to find */
+typedef struct tag_gramword {
+	char text[MAXGEDNAMELEN+2];
+	INT len;
+	INT kind;       /* GW_PREFIX, GW_INSIDE or GW_NEAR */
+	INT edits;      /* allowed, for GW_NEAR */
+	INT ngrams;
+	INT need;       /* trigrams a name must hold (<= 0 for any) */
+	char grams[GRAM_MAXGRAMS][4];
+} *GRAMWORD;
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static void free_gramlist(HVALUE val);
+static void gram_add(CNSTRING gram, INT32 id);
+static BOOLEAN gram_build_cb(CNSTRING key, CNSTRING name, BOOLEAN newset, void *param);
+static INT32 gram_find(CNSTRING name, CNSTRING key, STRING pairkey, INT size);
+static void gram_index(CNSTRING name, CNSTRING key);
+static BOOLEAN gram_near(CNSTRING word, INT wlen, CNSTRING piece, INT edits);
+static BOOLEAN gram_parse(CNSTRING str, GRAMWORD word);
+static BOOLEAN gram_piece_match(GRAMWORD word, CNSTRING pieces);
+static void gram_word_grams(GRAMWORD word);
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+static BOOLEAN gram_built = FALSE;
+static GRAMNAME gram_names = 0;   /* by number */
+static INT32 gram_nnames = 0;
+static INT32 gram_maxnames = 0;
+static INT32 gram_nremoved = 0;
+static HASHTAB gram_lists = 0;    /* GRAMLIST of each trigram */
+static HASHTAB gram_pairs = 0;    /* number of each key & name */
+static INT32 * gram_counts = 0;   /* trigrams of word held, by number */
+static INT32 * gram_passes = 0;   /* words passed, by number */
+static INT32 gram_ncounts = 0;
+
+/*********************************************
+ * local & exported function definitions
+ * body of module
+ *********************************************/
+
+/*==============================================
+ * gram_add -- Add name number to list of trigram
+ *============================================*/
+static void
+gram_add (CNSTRING gram, INT32 id)
+{
+	GRAMLIST list = (GRAMLIST) find_hashtab(gram_lists, gram, NULL);
+	if (!list) {
+		list = (GRAMLIST) stdalloc(sizeof(*list));
+		memset(list, 0, sizeof(*list));
+		insert_hashtab(gram_lists, gram, list);
+	}
+	/* a piece may repeat a trigram, or the name a piece */
+	if (list->n && list->ids[list->n-1] == id)
+		return;
+	if (list->n == list->max) {
+		INT32 * ids;
+		list->max = list->max ? list->max * 2 : 4;
+		ids = (INT32 *) stdalloc(list->max*sizeof(INT32));
+		if (list->n) {
+			memcpy(ids, list->ids, list->n*sizeof(INT32));
+			stdfree(list->ids);
+		}
+		list->ids = ids;
+	}
+	list->ids[list->n++] = id;
+}
+/*==============================================
+ * free_gramlist -- Free list of one trigram
+ *============================================*/
+static void
+free_gramlist (HVALUE val)
+{
+	GRAMLIST list = (GRAMLIST) val;
+	if (list->ids)
+		stdfree(list->ids);
+	stdfree(list);
+}
+/*==============================================
+ * gram_find -- Find number of name of person
+ *  pairkey:  [OUT] key of both in gram_pairs
+ * returns -1 if not indexed (or too long to be)
+ *============================================*/
+static INT32
+gram_find (CNSTRING name, CNSTRING key, STRING pairkey, INT size)
+{
+	BOOLEAN present = FALSE;
+	HVALUE val;
+	/* keys hold no tabs, so pairs cannot be confused */
+	if (snprintf(pairkey, size, "%s\t%s", key, name) >= size)
+		return -1;
+	val = find_hashtab(gram_pairs, pairkey, &present);
+	return present ? (INT32)(INT)val : -1;
+}
+/*==============================================
+ * gram_index -- Add name of person to index
+ *============================================*/
+static void
+gram_index (CNSTRING name, CNSTRING key)
+{
+	char pairkey[MAXKEYWIDTH+MAXGEDNAMELEN+4];
+	char sqz[MAXGEDNAMELEN+2], gram[4];
+	STRING p;
+	INT32 id;
+	INT size, i, len;
+
+	if (!name || !key || key[0] != 'I' || strlen(key) > MAXKEYWIDTH
+		|| strlen(name) > MAXGEDNAMELEN)
+		return;
+	if (gram_find(name, key, pairkey, sizeof(pairkey)) >= 0)
+		return;
+	squeeze(name, sqz);
+	if (!sqz[0])
+		return;
+	for (p = sqz; *p; p += strlen(p) + 1)
+		;
+	size = p - sqz + 1;
+
+	if (gram_nnames == gram_maxnames) {
+		GRAMNAME names;
+		gram_maxnames = gram_maxnames ? gram_maxnames * 2 : 1024;
+		names = (GRAMNAME) stdalloc(gram_maxnames*sizeof(struct tag_gramname));
+		if (gram_nnames) {
+			memcpy(names, gram_names, gram_nnames*sizeof(struct tag_gramname));
+			stdfree(gram_names);
+		}
+		gram_names = names;
+	}
+	id = gram_nnames++;
+	gram_names[id].keynum = (INT32)atoi(key+1);
+	gram_names[id].pieces = (STRING) stdalloc(size);
+	memcpy(gram_names[id].pieces, sqz, size);
+	insert_hashtab(gram_pairs, pairkey, (HVALUE)(INT)id);
+
+	/* trigrams of each piece between blanks, & its first letter */
+	gram[3] = 0;
+	for (p = sqz; *p; p += len + 1) {
+		len = strlen(p);
+		gram[0] = ' ';
+		gram[1] = p[0];
+		gram[2] = 0;
+		gram_add(gram, id);
+		for (i = -1; i + 1 < len; i++) {
+			gram[0] = (i < 0 ? ' ' : p[i]);
+			gram[1] = p[i+1];
+			gram[2] = (i + 2 < len ? p[i+2] : ' ');
+			gram_add(gram, id);
+		}
+	}
+}
+/*==============================================
+ * gram_build_cb -- Add name from name records to index
+ *============================================*/
+static BOOLEAN
+gram_build_cb (CNSTRING key, CNSTRING name, BOOLEAN newset, void *param)
+{
+	newset=newset; /* unused */
+	param=param; /* unused */
+	gram_index(name, key);
+	return TRUE;
+}
+/*==============================================
+ * gram_add_name -- Keep index in step with name added
+ *  (called by add_name)
+ *============================================*/
+void
+gram_add_name (CNSTRING name, CNSTRING key)
+{
+	if (gram_built)
+		gram_index(name, key);
+}
+/*==============================================
+ * gram_remove_name -- Keep index in step with name removed
+ *  (called by remove_name)
+ *============================================*/
+void
+gram_remove_name (CNSTRING name, CNSTRING key)
+{
+	char pairkey[MAXKEYWIDTH+MAXGEDNAMELEN+4];
+	INT32 id;
+	if (!gram_built || !name || !key)
+		return;
+	if ((id = gram_find(name, key, pairkey, sizeof(pairkey))) < 0)
+		return;
+	remove_hashtab(gram_pairs, pairkey);
+	stdfree(gram_names[id].pieces);
+	gram_names[id].pieces = NULL;
+	/* lists still hold its number; start over, if most are so */
+	if (++gram_nremoved > 1024 && gram_nremoved > gram_nnames/2)
+		gram_free();
+}
+/*==============================================
+ * gram_free -- Free index (built again when next wanted)
+ *============================================*/
+void
+gram_free (void)
+{
+	INT32 i;
+	for (i = 0; i < gram_nnames; i++) {
+		if (gram_names[i].pieces)
+			stdfree(gram_names[i].pieces);
+	}
+	if (gram_names)
+		stdfree(gram_names);
+	gram_names = 0;
+	gram_nnames = gram_maxnames = gram_nremoved = 0;
+	if (gram_lists)
+		destroy_hashtab(gram_lists, free_gramlist);
+	if (gram_pairs)
+		destroy_hashtab(gram_pairs, NULL);
+	gram_lists = gram_pairs = 0;
+	if (gram_counts) {
+		stdfree(gram_counts);
+		stdfree(gram_passes);
+	}
+	gram_counts = gram_passes = 0;
+	gram_ncounts = 0;
+	gram_built = FALSE;
+}
+/*==============================================
+ * gram_parse -- Parse one word of search
+ *  str:  [IN]  word, as typed
+ * returns FALSE if it holds no letters
+ *============================================*/
+static BOOLEAN
+gram_parse (CNSTRING str, GRAMWORD word)
+{
+	char raw[MAXGEDNAMELEN+2];
+	INT len = strlen(str);
+	word->kind = GW_PREFIX;
+	if (*str == '*') {
+		word->kind = GW_INSIDE;
+		++str;
+		--len;
+	}
+	while (len && str[len-1] == '*')
+		--len;
+	if (word->kind == GW_PREFIX && len && str[len-1] == '~') {
+		word->kind = GW_NEAR;
+		--len;
+	}
+	if (len <= 0 || len > MAXGEDNAMELEN)
+		return FALSE;
+	memcpy(raw, str, len);
+	raw[len] = 0;
+	/* no blanks or slashes here, so one piece at most */
+	squeeze(raw, word->text);
+	if (!word->text[0])
+		return FALSE;
+	word->len = strlen(word->text);
+	word->edits = (word->len < 7 ? 1 : 2);
+	gram_word_grams(word);
+	return TRUE;
+}
+/*==============================================
+ * gram_word_grams -- List trigrams names must hold for word
+ *============================================*/
+static void
+gram_word_grams (GRAMWORD word)
+{
+	char padded[MAXGEDNAMELEN+4];
+	INT plen = 0, i, j;
+	if (word->kind == GW_INSIDE && word->len < 3) {
+		/* no trigram need be in name, so every name is checked */
+		word->ngrams = word->need = 0;
+		return;
+	}
+	if (word->kind != GW_INSIDE)
+		padded[plen++] = ' ';
+	memcpy(padded + plen, word->text, word->len);
+	plen += word->len;
+	if (word->kind == GW_NEAR)
+		padded[plen++] = ' ';
+	word->ngrams = 0;
+	if (plen == 2) {
+		/* blank & first letter */
+		padded[2] = 0;
+		strcpy(word->grams[word->ngrams++], padded);
+	}
+	for (i = 0; i + 3 <= plen; i++) {
+		char * gram = word->grams[word->ngrams];
+		memcpy(gram, padded + i, 3);
+		gram[3] = 0;
+		for (j = 0; j < word->ngrams; j++) {
+			if (eqstr(word->grams[j], gram))
+				break;
+		}
+		if (j == word->ngrams)
+			++word->ngrams;
+	}
+	word->need = word->ngrams;
+	if (word->kind == GW_NEAR)
+		word->need -= 3 * word->edits;
+}
+/*==============================================
+ * gram_near -- Is piece within edits of word ?
+ *============================================*/
+static BOOLEAN
+gram_near (CNSTRING word, INT wlen, CNSTRING piece, INT edits)
+{
+	INT prev[MAXGEDNAMELEN+2], cur[MAXGEDNAMELEN+2];
+	INT plen = strlen(piece), i, j;
+	if (plen > wlen + edits || wlen > plen + edits)
+		return FALSE;
+	for (j = 0; j <= plen; j++)
+		prev[j] = j;
+	for (i = 1; i <= wlen; i++) {
+		INT least;
+		cur[0] = least = i;
+		for (j = 1; j <= plen; j++) {
+			INT d = prev[j-1] + (word[i-1] != piece[j-1]);
+			if (prev[j] + 1 < d) d = prev[j] + 1;
+			if (cur[j-1] + 1 < d) d = cur[j-1] + 1;
+			cur[j] = d;
+			if (d < least) least = d;
+		}
+		if (least > edits)
+			return FALSE;
+		memcpy(prev, cur, (plen+1)*sizeof(INT));
+	}
+	return prev[plen] <= edits;
+}
+/*==============================================
+ * gram_piece_match -- Does any piece of name match word ?
+ *============================================*/
+static BOOLEAN
+gram_piece_match (GRAMWORD word, CNSTRING pieces)
+{
+	CNSTRING p;
+	for (p = pieces; *p; p += strlen(p) + 1) {
+		switch (word->kind) {
+		case GW_PREFIX:
+			if (!strncmp(p, word->text, word->len))
+				return TRUE;
+			break;
+		case GW_INSIDE:
+			if (strstr(p, word->text))
+				return TRUE;
+			break;
+		default:
+			if (gram_near(word->text, word->len, p, word->edits))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+/*====================================================
+ * find_indis_by_words -- Find all persons with a name
+ *  matching every word of search
+ *  words:  [IN]  words, separated by blanks or slashes;
+ *                 word   matches pieces beginning with word
+ *                 *word  matches pieces holding word anywhere
+ *                 word~  matches pieces one letter off word
+ *                        (two, for words of 7 or more)
+ *                letters are matched as in names, regardless
+ *                of case, & other characters ignored
+ * returns list of strings of keys found (in no order)
+ *==================================================*/
+LIST
+find_indis_by_words (CNSTRING words)
+{
+	GRAMWORD found[GRAM_MAXWORDS];
+	char str[MAXGEDNAMELEN+2];
+	LIST list = create_list2(LISTDOFREE);
+	INT nwords = 0, npassed = 0, i, w;
+	INT32 id, * cands = 0, ncands = 0, * passed1 = 0, npassed1 = 0;
+	CNSTRING p = words;
+
+	/* take words apart */
+	while (p && *p && nwords < GRAM_MAXWORDS) {
+		INT len = 0;
+		while (*p && (iswhite((uchar)*p) || *p == NAMESEP))
+			++p;
+		while (p[len] && !iswhite((uchar)p[len]) && p[len] != NAMESEP)
+			++len;
+		if (!len)
+			break;
+		if (len <= MAXGEDNAMELEN) {
+			memcpy(str, p, len);
+			str[len] = 0;
+			found[nwords] = (GRAMWORD) stdalloc(sizeof(struct tag_gramword));
+			if (gram_parse(str, found[nwords]))
+				++nwords;
+			else
+				stdfree(found[nwords]);
+		}
+		p += len;
+	}
+	if (!nwords)
+		return list;
+
+	if (!gram_built) {
+		gram_lists = create_hashtab();
+		gram_pairs = create_hashtab();
+		gram_built = TRUE;
+		traverse_names(gram_build_cb, NULL);
+	}
+	if (gram_ncounts < gram_nnames) {
+		if (gram_counts) {
+			stdfree(gram_counts);
+			stdfree(gram_passes);
+		}
+		gram_ncounts = gram_nnames;
+		gram_counts = (INT32 *) stdalloc(gram_ncounts*sizeof(INT32));
+		gram_passes = (INT32 *) stdalloc(gram_ncounts*sizeof(INT32));
+		memset(gram_counts, 0, gram_ncounts*sizeof(INT32));
+		memset(gram_passes, 0, gram_ncounts*sizeof(INT32));
+	}
+
+	/* names holding enough trigrams of every word (counting
+	for each word only names which passed the words before) */
+	for (w = 0; w < nwords; w++) {
+		GRAMWORD word = found[w];
+		INT32 * touched, ntouched = 0, total = 0, n;
+		GRAMLIST glists[GRAM_MAXGRAMS];
+		if (word->need <= 0)
+			continue;
+		for (i = 0; i < word->ngrams; i++) {
+			glists[i] = (GRAMLIST) find_hashtab(gram_lists, word->grams[i], NULL);
+			if (glists[i])
+				total += glists[i]->n;
+		}
+		touched = (INT32 *) stdalloc((total+1)*sizeof(INT32));
+		for (i = 0; i < word->ngrams; i++) {
+			for (n = 0; glists[i] && n < glists[i]->n; n++) {
+				id = glists[i]->ids[n];
+				if (gram_passes[id] != npassed)
+					continue;
+				if (!gram_counts[id]++)
+					touched[ntouched++] = id;
+			}
+		}
+		ncands = 0;
+		for (n = 0; n < ntouched; n++) {
+			id = touched[n];
+			if (gram_counts[id] >= word->need) {
+				++gram_passes[id];
+				touched[ncands++] = id;
+			}
+			gram_counts[id] = 0;
+		}
+		/* first list is kept, to clear passes after */
+		if (cands && cands != passed1)
+			stdfree(cands);
+		cands = touched;
+		if (!passed1) {
+			passed1 = touched;
+			npassed1 = ncands;
+		}
+		++npassed;
+		if (!ncands)
+			break;
+	}
+
+	/* check each such name (or each name, if no word has trigrams) */
+	for (i = 0; i < (npassed ? ncands : gram_nnames); i++) {
+		GRAMNAME gname;
+		id = (npassed ? cands[i] : (INT32)i);
+		gname = gram_names + id;
+		if (!gname->pieces)
+			continue;
+		for (w = 0; w < nwords; w++) {
+			if (!gram_piece_match(found[w], gname->pieces))
+				break;
+		}
+		if (w == nwords) {
+			snprintf(str, sizeof(str), "I" FMT_INT32, gname->keynum);
+			enqueue_list(list, strsave(str));
+		}
+	}
+
+	if (passed1) {
+		for (i = 0; i < npassed1; i++)
+			gram_passes[passed1[i]] = 0;
+		if (cands != passed1)
+			stdfree(cands);
+		stdfree(passed1);
+	}
+	for (w = 0; w < nwords; w++)
+		stdfree(found[w]);
+	return list;
+}
@@ -46,6 +46,25 @@
 extern BOOLEAN opt_finnish;
 extern BTREE BTR;
 
+/*********************************************
+ * local enums & defines
+ *********************************************/
+
+#define NR_SPLIT    (-1)     /* count of record holding directory of parts */
+#define NR_PARTMAX  512      /* names a record holds before it is split */
+#define NR_MAXPARTS (36*36)  /* part numbers, as 2 chars of key */
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* directory of name record split in parts */
+typedef struct tag_namedir {
+	INT32 nparts;
+	RKEY *pkeys;  /* key of each part */
+	RKEY *lows;   /* lowest INDI key in each part (all for first) */
+} *NAMEDIR;
+
 /*********************************************
  * local function prototypes
  *********************************************/
@@ -54,22 +73,31 @@ static void add_namekey(const RKEY * rkeyname, CNSTRING name, const RKEY * rkeyi
 static void cmpsqueeze(CNSTRING, STRING);
 static BOOLEAN dupcheck(TABLE tab, CNSTRING str);
 static BOOLEAN exactmatch(CNSTRING, CNSTRING);
+static INT findpart(NAMEDIR dir, const RKEY * rkeyid);
 static void find_indis_worker(CNSTRING name, uchar finitial, CNSTRING sdex, TABLE donetab, LIST list);
 static void flush_name_cache(void);
+static void freenamedir(NAMEDIR * pdir);
 static INT getfinitial(CNSTRING);
+static NAMEDIR getnamedir(CNSTRING rec, INT len);
 static void getnamerec(const RKEY * rkey);
 static CNSTRING getsurname_impl(CNSTRING name);
+static STRING joinparts(NAMEDIR dir, INT * plen);
 static STRING name_surfirst(STRING);
 static void name_to_parts(CNSTRING, STRING*);
 /* static void name2rkey(CNSTRING, RKEY *); */
 static CNSTRING nextpiece(CNSTRING);
+static int nrkeycmp(const void * el1, const void * el2);
+static void part2rkey(const RKEY * rkeyname, INT part, RKEY * rkey);
 static STRING parts_to_name(STRING*);
 static BOOLEAN piecematch(STRING, STRING);
+static void putnamedir(const RKEY * rkey, NAMEDIR dir);
+static void putnamerec(const RKEY * rkey, const INT * idx, INT n);
+static NAMEDIR readnamerec(const RKEY * rkey);
 static void remove_namekey(const RKEY * rkeyname, CNSTRING name, const RKEY * rkeyid);
 /* static void rkey_cpy(const RKEY * src, RKEY * dest);*/
 BOOLEAN rkey_eq(const RKEY * rkey1, const RKEY * rkey2);
 static void soundex2rkey(char finitial, CNSTRING sdex, RKEY * rkey);
-static void squeeze(CNSTRING, STRING);
+static BOOLEAN splitnamerec(const RKEY * rkeyname, NAMEDIR dir, INT ipart);
 static STRING upsurname(STRING);
 
 /*********************************************
@@ -108,6 +136,21 @@ static STRING upsurname(STRING);
  * When a name record is used to match a search name, the internal
  *   structures are modified to remove all entries that don't match
  *   the name; in addition, other global data structures are used
+ *-------------------------------------------------------------------
+ * split records -- If the keyfile allows it (KF2_VER_NAMES), a name
+ *   record growing past NR_PARTMAX names is split in two parts, &
+ *   any part growing that long is split again; each part is a name
+ *   record as above, stored under the key of the whole record, but
+ *   with its first two chars (blank for the whole record) numbering
+ *   the part; the whole record then holds a directory of its parts,
+ *   in order of the INDI keys they hold (those of a person are kept
+ *   in one part), so adding or removing a name rewrites only the
+ *   part holding that person's names
+ *-------------------------------------------------------------------
+ *        1 INT32  NR_SPLIT - instead of number of names
+ *        1 INT32  nparts   - number of parts
+ *   nparts RKEY   pkeys    - RKEYs of the parts
+ *   nparts RKEY   lows     - lowest INDI RKEY in each part
  *=================================================================*/
 
 /* Current name record - raw */
@@ -203,12 +246,14 @@ parsenamerec (const RKEY * rkey, CNSTRING p)
 		NRnames[i] = p + NRoffs[i];
 }
 /*====================================================
- * getnamerec -- Read name record and store in file buffers
+ * readnamerec -- Read name record and store in file buffers
+ *  unless it is split in parts
+ * returns directory of parts of split record, else NULL
  *==================================================*/
-static void
-getnamerec (const RKEY * rkey)
+static NAMEDIR
+readnamerec (const RKEY * rkey)
 {
-	STRING p;
+	NAMEDIR dir=0;
 /* TODO: enable this cache (but must add code to flush it
 across database reloads
 
@@ -222,18 +267,345 @@ across database reloads
 	strfree(&NRrec);
 
 	/* get record by key */
-	p = NRrec = bt_getrecord(BTR, rkey, &NRsize);
+	NRrec = bt_getrecord(BTR, rkey, &NRsize);
+	if (NRrec && (dir = getnamedir(NRrec, NRsize)))
+		strfree(&NRrec);
 	if (!NRrec) {
 		NRcount = 0;
 		if (NRmax == 0) {
 			NRmax = 10;
 			allocnamerec();
 		}
-		return;
+		return dir;
 	}
 
 	/* parse name record */
-	parsenamerec(rkey, p);
+	parsenamerec(rkey, NRrec);
+	return NULL;
+}
+/*====================================================
+ * getnamerec -- Read name record and store in file buffers
+ *  (all its parts, if it is split)
+ *==================================================*/
+static void
+getnamerec (const RKEY * rkey)
+{
+	NAMEDIR dir = readnamerec(rkey);
+	if (!dir)
+		return;
+	NRrec = joinparts(dir, &NRsize);
+	parsenamerec(rkey, NRrec);
+	freenamedir(&dir);
+}
+/*====================================================
+ * putnamerec -- Write name record from file buffers
+ *  rkey: [IN]  key of record
+ *  idx:  [IN]  which names to write (NULL for first n)
+ *  n:    [IN]  number of names to write
+ *==================================================*/
+static void
+putnamerec (const RKEY * rkey, const INT * idx, INT n)
+{
+	INT i, j, len;
+	INT32 count = n, off = 0;
+	STRING p, rec;
+
+	/* allocate new record */
+	len = sizeof(count);
+	for (i = 0; i < n; i++) {
+		j = idx ? idx[i] : i;
+		len += sizeof(RKEY) + sizeof(off) + strlen(NRnames[j]) + 1;
+	}
+	p = rec = (STRING) stdalloc(len);
+
+	/* copy record count */
+	memcpy(p, &count, sizeof(count));
+	p += sizeof(count);
+
+	/* copy keys */
+	for (i = 0; i < n; i++) {
+		j = idx ? idx[i] : i;
+		memcpy(p, &NRkeys[j], sizeof(NRkeys[j]));
+		p += sizeof(NRkeys[j]);
+	}
+
+	/* recompute offsets */
+	ASSERT(sizeof(off) == sizeof(*NRoffs));
+	for (i = 0; i < n; i++) {
+		j = idx ? idx[i] : i;
+		memcpy(p, &off, sizeof(off));
+		p += sizeof(off);
+		off += strlen(NRnames[j]) + 1;
+	}
+
+	/* copy names */
+	for (i = 0; i < n; i++) {
+		INT namelen;
+		j = idx ? idx[i] : i;
+		namelen = strlen(NRnames[j]) + 1;
+		memcpy(p, NRnames[j], namelen);
+		p += namelen;
+	}
+
+	/* update record in btree, free record storage */
+	bt_addrecord(BTR, *rkey, rec, len);
+	stdfree(rec);
+}
+/*====================================================
+ * getnamedir -- Parse directory of parts of split name record
+ * returns NULL if record is not split
+ *==================================================*/
+static NAMEDIR
+getnamedir (CNSTRING rec, INT len)
+{
+	NAMEDIR dir=0;
+	INT32 count;
+	INT size;
+
+	if (len < (INT)(2*sizeof(count)))
+		return NULL;
+	memcpy(&count, rec, sizeof(count));
+	if (count != NR_SPLIT)
+		return NULL;
+	rec += sizeof(count);
+	dir = (NAMEDIR) stdalloc(sizeof(*dir));
+	memcpy(&dir->nparts, rec, sizeof(dir->nparts));
+	rec += sizeof(dir->nparts);
+	ASSERT(dir->nparts > 0 && dir->nparts <= NR_MAXPARTS);
+	ASSERT(len == (INT)(2*sizeof(count) + 2*dir->nparts*sizeof(RKEY)));
+
+	/* room for one more, as a part may split */
+	size = (dir->nparts + 1) * sizeof(RKEY);
+	dir->pkeys = (RKEY *) stdalloc(size);
+	dir->lows = (RKEY *) stdalloc(size);
+	memcpy(dir->pkeys, rec, dir->nparts * sizeof(RKEY));
+	rec += dir->nparts * sizeof(RKEY);
+	memcpy(dir->lows, rec, dir->nparts * sizeof(RKEY));
+	return dir;
+}
+/*====================================================
+ * putnamedir -- Write directory of parts of split name record
+ *==================================================*/
+static void
+putnamedir (const RKEY * rkey, NAMEDIR dir)
+{
+	INT32 count = NR_SPLIT;
+	INT len = 2*sizeof(count) + 2*dir->nparts*sizeof(RKEY);
+	STRING p, rec;
+
+	p = rec = (STRING) stdalloc(len);
+	memcpy(p, &count, sizeof(count));
+	p += sizeof(count);
+	memcpy(p, &dir->nparts, sizeof(dir->nparts));
+	p += sizeof(dir->nparts);
+	memcpy(p, dir->pkeys, dir->nparts * sizeof(RKEY));
+	p += dir->nparts * sizeof(RKEY);
+	memcpy(p, dir->lows, dir->nparts * sizeof(RKEY));
+	bt_addrecord(BTR, *rkey, rec, len);
+	stdfree(rec);
+}
+/*====================================================
+ * freenamedir -- Free directory of parts of split name record
+ *==================================================*/
+static void
+freenamedir (NAMEDIR * pdir)
+{
+	NAMEDIR dir = *pdir;
+	if (!dir) return;
+	stdfree(dir->pkeys);
+	stdfree(dir->lows);
+	stdfree(dir);
+	*pdir = 0;
+}
+/*====================================================
+ * findpart -- Find part of split name record for person
+ *  (last part whose lowest key is not above person's)
+ *==================================================*/
+static INT
+findpart (NAMEDIR dir, const RKEY * rkeyid)
+{
+	INT lo = 1, hi = dir->nparts - 1, part = 0;
+	while (lo <= hi) {
+		INT mid = (lo + hi) / 2;
+		if (cmpkeys(&dir->lows[mid], rkeyid) <= 0) {
+			part = mid;
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return part;
+}
+/*====================================================
+ * joinparts -- Join parts of split name record into one
+ *  name record (as held before it was split)
+ *  dir:  [IN]  directory of parts
+ *  plen: [OUT] length of joined record
+ *==================================================*/
+static STRING
+joinparts (NAMEDIR dir, INT * plen)
+{
+	STRING *recs = (STRING *) stdalloc(dir->nparts * sizeof(STRING));
+	INT *lens = (INT *) stdalloc(dir->nparts * sizeof(INT));
+	INT32 *counts = (INT32 *) stdalloc(dir->nparts * sizeof(INT32));
+	INT32 total = 0, off, base = 0;
+	INT i, j, head, size = sizeof(total);
+	STRING p, q, rec;
+
+	/* read parts */
+	for (i = 0; i < dir->nparts; i++) {
+		recs[i] = bt_getrecord(BTR, &dir->pkeys[i], &lens[i]);
+		if (recs[i] && lens[i] >= (INT)sizeof(counts[i])) {
+			memcpy(&counts[i], recs[i], sizeof(counts[i]));
+			total += counts[i];
+			size += lens[i] - sizeof(counts[i]);
+		}
+	}
+	p = rec = (STRING) stdalloc(size);
+
+	/* copy record count */
+	memcpy(p, &total, sizeof(total));
+	p += sizeof(total);
+
+	/* copy keys */
+	for (i = 0; i < dir->nparts; i++) {
+		if (!counts[i]) continue;
+		memcpy(p, recs[i] + sizeof(counts[i]), counts[i] * sizeof(RKEY));
+		p += counts[i] * sizeof(RKEY);
+	}
+
+	/* copy offsets, moved past names of parts before */
+	for (i = 0; i < dir->nparts; i++) {
+		if (!counts[i]) continue;
+		head = sizeof(counts[i]) + counts[i] * (sizeof(RKEY) + sizeof(off));
+		q = recs[i] + sizeof(counts[i]) + counts[i] * sizeof(RKEY);
+		for (j = 0; j < counts[i]; j++) {
+			memcpy(&off, q, sizeof(off));
+			q += sizeof(off);
+			off += base;
+			memcpy(p, &off, sizeof(off));
+			p += sizeof(off);
+		}
+		base += lens[i] - head;
+	}
+
+	/* copy names */
+	for (i = 0; i < dir->nparts; i++) {
+		if (!counts[i]) continue;
+		head = sizeof(counts[i]) + counts[i] * (sizeof(RKEY) + sizeof(off));
+		memcpy(p, recs[i] + head, lens[i] - head);
+		p += lens[i] - head;
+	}
+	ASSERT(p == rec + size);
+
+	for (i = 0; i < dir->nparts; i++) {
+		if (recs[i])
+			stdfree(recs[i]);
+	}
+	stdfree(recs);
+	stdfree(lens);
+	stdfree(counts);
+	*plen = size;
+	return rec;
+}
+/*====================================================
+ * part2rkey -- Key of part of split name record
+ *  (its part number takes the place of the 2 leading blanks;
+ *  digits & lowercase letters never begin a record key, so
+ *  traversals cannot take the part for a person, say)
+ *==================================================*/
+static void
+part2rkey (const RKEY * rkeyname, INT part, RKEY * rkey)
+{
+	static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+	ASSERT(part >= 0 && part < NR_MAXPARTS);
+	*rkey = *rkeyname;
+	rkey->r_rkey[0] = digits[part / 36];
+	rkey->r_rkey[1] = digits[part % 36];
+}
+/*====================================================
+ * nrkeycmp -- Compare names in file buffers by INDI key
+ *  (for qsort of their indices; ties kept in order)
+ *==================================================*/
+static int
+nrkeycmp (const void * el1, const void * el2)
+{
+	INT i1 = *(const INT *)el1, i2 = *(const INT *)el2;
+	INT rel = cmpkeys(&NRkeys[i1], &NRkeys[i2]);
+	if (rel)
+		return rel;
+	return (i1 > i2) - (i1 < i2);
+}
+/*====================================================
+ * splitnamerec -- Write name record in file buffers
+ *  as two parts of split record
+ *  rkeyname: [IN]  key of whole name record
+ *  dir:      [I/O] its directory (NULL if not yet split)
+ *  ipart:    [IN]  part in file buffers (if split)
+ * returns FALSE if it cannot be split (so is not written)
+ *==================================================*/
+static BOOLEAN
+splitnamerec (const RKEY * rkeyname, NAMEDIR dir, INT ipart)
+{
+	INT *idx=0;
+	INT i, cut;
+	struct tag_namedir newdir;
+
+	if (dir && dir->nparts >= NR_MAXPARTS)
+		return FALSE;
+
+	/* order names by person, & cut in middle, but not
+	between names of one person */
+	idx = (INT *) stdalloc(NRcount * sizeof(INT));
+	for (i = 0; i < NRcount; i++)
+		idx[i] = i;
+	qsort(idx, NRcount, sizeof(INT), nrkeycmp);
+	for (cut = NRcount/2; cut < NRcount; cut++) {
+		if (cmpkeys(&NRkeys[idx[cut-1]], &NRkeys[idx[cut]]))
+			break;
+	}
+	if (cut == NRcount) {
+		for (cut = NRcount/2; cut > 0; cut--) {
+			if (cmpkeys(&NRkeys[idx[cut-1]], &NRkeys[idx[cut]]))
+				break;
+		}
+	}
+	if (cut == 0) {
+		/* all names of one person */
+		stdfree(idx);
+		return FALSE;
+	}
+
+	if (!dir) {
+		/* first split, so parts 0 & 1 */
+		RKEY pkeys[2], lows[2];
+		dir = &newdir;
+		dir->nparts = 2;
+		dir->pkeys = pkeys;
+		dir->lows = lows;
+		part2rkey(rkeyname, 0, &pkeys[0]);
+		part2rkey(rkeyname, 1, &pkeys[1]);
+		lows[0] = NRkeys[idx[0]];
+		lows[1] = NRkeys[idx[cut]];
+		putnamerec(&pkeys[0], idx, cut);
+		putnamerec(&pkeys[1], idx + cut, NRcount - cut);
+		putnamedir(rkeyname, dir);
+	} else {
+		/* new part goes after this one (& parts never go away,
+		so their number is the next free one) */
+		for (i = dir->nparts; i > ipart + 1; i--) {
+			dir->pkeys[i] = dir->pkeys[i-1];
+			dir->lows[i] = dir->lows[i-1];
+		}
+		part2rkey(rkeyname, dir->nparts, &dir->pkeys[ipart+1]);
+		dir->lows[ipart+1] = NRkeys[idx[cut]];
+		dir->nparts++;
+		putnamerec(&dir->pkeys[ipart], idx, cut);
+		putnamerec(&dir->pkeys[ipart+1], idx + cut, NRcount - cut);
+		putnamedir(rkeyname, dir);
+	}
+	stdfree(idx);
+	return TRUE;
 }
 /*============================================
  * name2rkey - Convert name to name record key
@@ -434,6 +806,7 @@ add_name (CNSTRING name, CNSTRING key)
 		add_namekey(&rkeyname, name, &rkeyid);
 	}
 	destroy_table(donetab);
+	gram_add_name(name, key);
 
 	strfree(&surname);
 }
@@ -446,18 +819,23 @@ add_name (CNSTRING name, CNSTRING key)
 static void
 add_namekey (const RKEY * rkeyname, CNSTRING name, const RKEY * rkeyid)
 {
-	INT i, len, recsize;
-	INT32 off;
-	STRING p, rec;
-
-	/* load up local name record buffers */
-	getnamerec(rkeyname);
+	INT i, ipart=0;
+	NAMEDIR dir=0;
+
+	/* load up local name record buffers (just the part
+	for this person, if name record is split) */
+	if ((dir = readnamerec(rkeyname))) {
+		ipart = findpart(dir, rkeyid);
+		readnamerec(&dir->pkeys[ipart]);
+	}
 
 	/* check if name already present in name record */
 	for (i = 0; i < NRcount; i++) {
 		if (rkey_eq(rkeyid, &NRkeys[i]) &&
-		    eqstr(name, NRnames[i]))
+		    eqstr(name, NRnames[i])) {
+			freenamedir(&dir);
 			return;
+		}
 	}
 
 	/* update directory */
@@ -467,43 +845,11 @@ add_namekey (const RKEY * rkeyname, CNSTRING name, const RKEY * rkeyid)
 	/* increase record count */
 	NRcount++;
 
-	/* allocate new record */
-	recsize = sizeof(RKEY) + sizeof(INT32) + strlen(name) + 10;
-	p = rec = (STRING) stdalloc(NRsize + recsize);
-	len = off = 0;
-
-	/* copy record count */
-	memcpy(p, &NRcount, sizeof(NRcount));
-	p += sizeof(NRcount);
-	len += sizeof(NRcount);
-
-	/* copy keys */
-	for (i = 0; i < NRcount; i++) {
-		memcpy(p, &NRkeys[i], sizeof(NRkeys[i]));
-		p += sizeof(NRkeys[i]);
-		len += sizeof(NRkeys[i]);
-	}
-
-	/* recompute offsets */
-	ASSERT(sizeof(off) == sizeof(*NRoffs));
-	for (i = 0; i < NRcount; i++) {
-		memcpy(p, &off, sizeof(off));
-		p += sizeof(off);
-		len += sizeof(off);
-		off += strlen(NRnames[i]) + 1;
-	}
-
-	/* copy names */
-	for (i = 0; i < NRcount; i++) {
-		INT namelen = strlen(NRnames[i]) + 1;
-		memcpy(p, NRnames[i], namelen);
-		p += namelen;
-		len += namelen;
-	}
-
-	/* update record in btree, free record storage */
-	bt_addrecord(BTR, NRkey, rec, len);
-	stdfree(rec);
+	/* update record in btree (split, if too long & allowed) */
+	if (NRcount <= NR_PARTMAX || !bkf2names(BTR)
+		|| !splitnamerec(rkeyname, dir, ipart))
+		putnamerec(&NRkey, NULL, NRcount);
+	freenamedir(&dir);
 
 	/* flush cache as name record has changed */
 	flush_name_cache();
@@ -537,6 +883,7 @@ remove_name (STRING name, CNSTRING key)
 		remove_namekey(&rkeyname, name, &rkeyid);
 	}
 	destroy_table(donetab);
+	gram_remove_name(name, key);
 
 	strfree(&surname);
 }
@@ -549,13 +896,16 @@ remove_name (STRING name, CNSTRING key)
 static void
 remove_namekey (const RKEY * rkeyname, CNSTRING name, const RKEY * rkeyid)
 {
-	INT i, len;
-	INT32 off;
-	STRING p, rec;
+	INT i;
+	NAMEDIR dir=0;
 	BOOLEAN found = FALSE;
 
-	/* load up local name record buffers */
-	getnamerec(rkeyname);
+	/* load up local name record buffers (just the part
+	for this person, if name record is split) */
+	if ((dir = readnamerec(rkeyname))) {
+		readnamerec(&dir->pkeys[findpart(dir, rkeyid)]);
+		freenamedir(&dir);
+	}
 
 	/* check if name already present in name record */
 	for (i = 0; i < NRcount; i++) {
@@ -576,43 +926,8 @@ remove_namekey (const RKEY * rkeyname, CNSTRING name, const RKEY * rkeyid)
 	/* decrease record count */
 	NRcount--;
 
-	/* allocate new record */
-	p = rec = (STRING) stdalloc(NRsize);
-	len = off = 0;
-
-	/* copy record count */
-	memcpy(p, &NRcount, sizeof(NRcount));
-	p += sizeof(NRcount);
-	len += sizeof(NRcount);
-
-	/* copy keys */
-	for (i = 0; i < NRcount; i++) {
-		memcpy(p, &NRkeys[i], sizeof(NRkeys[i]));
-		p += sizeof(NRkeys[i]);
-		len += sizeof(NRkeys[i]);
-	}
-
-	/* recompute offsets */
-	ASSERT(sizeof(off) == sizeof(*NRoffs));
-	off = 0;
-	for (i = 0; i < NRcount; i++) {
-		memcpy(p, &off, sizeof(off));
-		p += sizeof(off);
-		len += sizeof(off);
-		off += strlen(NRnames[i]) + 1;
-	}
-
-	/* copy names */
-	for (i = 0; i < NRcount; i++) {
-		INT namelen = strlen(NRnames[i]) + 1;
-		memcpy(p, NRnames[i], namelen);
-		p += namelen;
-		len += namelen;
-	}
-
-	/* update record in btree, free record storage */
-	bt_addrecord(BTR, NRkey, rec, len);
-	stdfree(rec);
+	/* update record in btree (an emptied part stays, empty) */
+	putnamerec(&NRkey, NULL, NRcount);
 
 	/* flush cache as name record has changed */
 	flush_name_cache();
@@ -678,7 +993,7 @@ piecematch (STRING part, STRING comp)
  *  in:   [in] string of words
  *  out:  [out] superstring of words
  *=============================================================*/
-static void
+void
 squeeze (CNSTRING in, STRING out)
 {
 	/* TODO: fix for Unicode (switch to string based casing) */
@@ -1217,41 +1532,109 @@ name_to_list (CNSTRING name, INT *plen, INT *psind)
 }
 /*====================================================
  * traverse_names -- traverse names in db
- *  delegates to traverse_db_rec_rkeys
- *   passing callback function: traverse_name_callback
- *   and using local data in a TRAV_NAME_PARAM
+ *  steps through name records with a cursor
+ *   calling func for each name in each record
  *   (newset is true every time it is a callback for a new name)
  *==================================================*/
-typedef struct
-{
-	TRAV_NAMES_FUNC func;
-	void * param;
-} TRAV_NAME_PARAM;
-/* see above */
-static BOOLEAN
-traverse_name_callback (RKEY rkey, STRING data, INT len, void *param)
+void
+traverse_names (TRAV_NAMES_FUNC func, void *param)
 {
-	TRAV_NAME_PARAM *tparam = (TRAV_NAME_PARAM *)param;
-	INT i;
-	len=len; /* unused */
-
-	parsenamerec(&rkey, data);
-
-	for (i=0; i<NRcount; i++)
-	{
-		if (!tparam->func(rkey2str(NRkeys[i]), NRnames[i], !i, tparam->param))
-			return FALSE;
+	RKEY lo = name_lo(), hi = name_hi(), rkey;
+	BTCURSOR cursor = bt_cursor_open(BTR, FALSE);
+	RAWRECORD data;
+	NAMEDIR dir=0;
+	INT i, len;
+	BOOLEAN more = TRUE;
+
+	/* (parts of split records, whose keys do not start
+	with blanks, are outside this range) */
+	bt_cursor_seek(cursor, &lo);
+	while (more && bt_cursor_next(cursor, &rkey, &data, &len)) {
+		if (cmpkeys(&rkey, &hi) > 0) {
+			if (data) stdfree(data);
+			break;
+		}
+		if (!data || !cmpkeys(&rkey, &lo))
+			continue;
+		if ((dir = getnamedir(data, len))) {
+			stdfree(data);
+			data = joinparts(dir, &len);
+			freenamedir(&dir);
+		}
+		parsenamerec(&rkey, data);
+		for (i=0; more && i<NRcount; i++)
+			more = (*func)(rkey2str(NRkeys[i]), NRnames[i], !i, param);
+		stdfree(data);
 	}
-	return TRUE;
+	bt_cursor_close(cursor);
 }
-/* see above */
-void
-traverse_names (TRAV_NAMES_FUNC func, void *param)
+/*====================================================
+ * rebuild_names -- Rebuild name records from names of all
+ *  persons (splitting long records, if keyfile allows it)
+ * returns number of names indexed
+ *==================================================*/
+INT
+rebuild_names (void)
 {
-	TRAV_NAME_PARAM tparam;
-	tparam.param = param;
-	tparam.func = func;
-	traverse_db_rec_rkeys(BTR, name_lo(), name_hi(), &traverse_name_callback, &tparam);
+	RKEY lo = name_lo(), hi = name_hi(), rkey;
+	BTCURSOR cursor = bt_cursor_open(BTR, FALSE);
+	RAWRECORD data;
+	NAMEDIR dir=0;
+	RKEY *rkeys=0;
+	INT i, j, len, nkeys = 0, maxkeys = 0, count = 0;
+	INT32 zero = 0;
+
+	/* note keys of all name records & parts */
+	bt_cursor_seek(cursor, &lo);
+	while (bt_cursor_next(cursor, &rkey, &data, &len)) {
+		if (cmpkeys(&rkey, &hi) > 0) {
+			if (data) stdfree(data);
+			break;
+		}
+		if (!data || !cmpkeys(&rkey, &lo))
+			continue;
+		dir = getnamedir(data, len);
+		if (nkeys + 1 + (dir ? dir->nparts : 0) > maxkeys) {
+			RKEY *old = rkeys;
+			maxkeys = 2*maxkeys + 64 + (dir ? dir->nparts : 0);
+			rkeys = (RKEY *) stdalloc(maxkeys * sizeof(RKEY));
+			if (old) {
+				memcpy(rkeys, old, nkeys * sizeof(RKEY));
+				stdfree(old);
+			}
+		}
+		rkeys[nkeys++] = rkey;
+		for (j = 0; dir && j < dir->nparts; j++)
+			rkeys[nkeys++] = dir->pkeys[j];
+		freenamedir(&dir);
+		stdfree(data);
+	}
+	bt_cursor_close(cursor);
+
+	/* empty them (records are never taken out of btree) */
+	for (i = 0; i < nkeys; i++)
+		bt_addrecord(BTR, rkeys[i], (RAWRECORD)&zero, sizeof(zero));
+	if (rkeys)
+		stdfree(rkeys);
+	flush_name_cache();
+	gram_free();
+
+	/* & index names of each person anew */
+	for (i = xref_firsti(); i; i = xref_nexti(i)) {
+		char key[MAXKEYWIDTH+1];
+		RECORD rec;
+		NODE node;
+		snprintf(key, sizeof(key), "I" FMT_INT, i);
+		if (!(rec = qkey_to_irecord(key)))
+			continue;
+		for (node = nchild(nztop(rec)); node; node = nsibling(node)) {
+			if (eqstr(ntag(node), "NAME") && nval(node)) {
+				add_name(nval(node), key);
+				++count;
+			}
+		}
+	}
+	return count;
 }
 /*====================================================
  * flush_name_cache -- Clear any cached name records
@@ -56,11 +56,16 @@ enum { NEW_RECORD, EXISTING_LACKING_WH_RECORD };
  *********************************************/
 
 static NODE alloc_node(void);
+static INT binary_len(NODE node, INT levl);
+static STRING binary_put(STRING p, NODE node, INT levl);
 static STRING fixup(STRING str);
 static STRING fixtag (STRING tag);
 static RECORD indi_to_prev_sib_impl(NODE indi);
 static void node_destructor(VTABLE *obj);
 static INT node_strlen(INT levl, NODE node);
+static STRING put_binnum(STRING p, INT n);
+static STRING take_binstr(CNSTRING *pp, CNSTRING end, BOOLEAN *ok);
+static BOOLEAN take_binnum(CNSTRING *pp, CNSTRING end, INT *pn);
 
 /*********************************************
  * unused local function prototypes
@@ -260,6 +265,190 @@ free_nodes (NODE node)
 		node = sib;
 	}
 }
+/*=====================================
+ * Binary form of node tree
+ *  Each node in turn (parents before children, older siblings
+ *  before younger), as its level, its tag (as pointer into
+ *  tagtable), & its xref & value (each as length + 1, 0 for
+ *  none, & the bytes without the 0). Numbers are stored 7 bits
+ *  per byte, low bits first, high bit set if more follow.
+ *  As tags are pointers, the form is only good while tagtable
+ *  lasts, & never leaves memory.
+ *===================================*/
+/*=====================================
+ * put_binnum -- Store number in binary form
+ *===================================*/
+static STRING
+put_binnum (STRING p, INT n)
+{
+	while (n >= 0x80) {
+		*p++ = (char)((n & 0x7f) | 0x80);
+		n >>= 7;
+	}
+	*p++ = (char)n;
+	return p;
+}
+/*=====================================
+ * take_binnum -- Read number of binary form
+ * returns FALSE if form runs out
+ *===================================*/
+static BOOLEAN
+take_binnum (CNSTRING *pp, CNSTRING end, INT *pn)
+{
+	CNSTRING p = *pp;
+	INT n = 0, shift = 0;
+	unsigned char c;
+	do {
+		if (p >= end || shift > 28)
+			return FALSE;
+		c = (unsigned char)*p++;
+		n |= (INT)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	*pp = p;
+	*pn = n;
+	return TRUE;
+}
+/*=====================================
+ * take_binstr -- Read xref or value of binary form
+ * returns stdalloc'd string, or NULL if none
+ *  (or if form runs out, when *ok is set FALSE)
+ *===================================*/
+static STRING
+take_binstr (CNSTRING *pp, CNSTRING end, BOOLEAN *ok)
+{
+	STRING str;
+	INT n;
+	if (!take_binnum(pp, end, &n) || n - 1 > end - *pp) {
+		*ok = FALSE;
+		return NULL;
+	}
+	if (!n--)
+		return NULL;
+	str = (STRING) stdalloc(n + 1);
+	memcpy(str, *pp, n);
+	str[n] = 0;
+	*pp += n;
+	return str;
+}
+/*=====================================
+ * binary_len -- Length of binary form of nodes
+ *  node: [IN]  first of siblings
+ *  levl: [IN]  their level
+ *===================================*/
+static INT
+binary_len (NODE node, INT levl)
+{
+	INT len = 0;
+	for ( ; node; node = nsibling(node)) {
+		/* allow 5 bytes for each number */
+		len += 5 + sizeof(STRING) + 5 + 5;
+		if (nxref(node)) len += strlen(nxref(node));
+		if (nval(node)) len += strlen(nval(node));
+		len += binary_len(nchild(node), levl + 1);
+	}
+	return len;
+}
+/*=====================================
+ * binary_put -- Write binary form of nodes
+ *  node: [IN]  first of siblings
+ *  levl: [IN]  their level
+ * returns end of what was written
+ *===================================*/
+static STRING
+binary_put (STRING p, NODE node, INT levl)
+{
+	INT n;
+	for ( ; node; node = nsibling(node)) {
+		p = put_binnum(p, levl);
+		memcpy(p, &ntag(node), sizeof(STRING));
+		p += sizeof(STRING);
+		n = nxref(node) ? (INT)strlen(nxref(node)) : -1;
+		p = put_binnum(p, n + 1);
+		if (n > 0) {
+			memcpy(p, nxref(node), n);
+			p += n;
+		}
+		n = nval(node) ? (INT)strlen(nval(node)) : -1;
+		p = put_binnum(p, n + 1);
+		if (n > 0) {
+			memcpy(p, nval(node), n);
+			p += n;
+		}
+		p = binary_put(p, nchild(node), levl + 1);
+	}
+	return p;
+}
+/*=====================================
+ * node_to_binary -- Convert tree to binary form
+ *  (tree must have tags from tagtable, as made by create_node)
+ *  root: [IN]  root of tree (its siblings are not included)
+ *  plen: [OUT] length of binary form
+ * returns stdalloc'd binary form
+ *===================================*/
+STRING
+node_to_binary (NODE root, INT *plen)
+{
+	NODE sib = nsibling(root);
+	STRING buf, end;
+	nsibling(root) = NULL;
+	buf = (STRING) stdalloc(binary_len(root, 0));
+	end = binary_put(buf, root, 0);
+	nsibling(root) = sib;
+	*plen = end - buf;
+	return buf;
+}
+/*=====================================
+ * binary_to_node -- Rebuild tree from binary form
+ *  made by node_to_binary (no parsing of text, nor
+ *  lookup of tags)
+ *  buf: [IN]  binary form
+ *  len: [IN]  its length
+ * returns root of new tree, or NULL if form is bad
+ *===================================*/
+NODE
+binary_to_node (CNSTRING buf, INT len)
+{
+	CNSTRING p = buf, end = buf + len;
+	NODE root = NULL, curnode = NULL, node;
+	INT lev, curlev = 0;
+	BOOLEAN ok = TRUE;
+
+	while (ok && p < end) {
+		if (!take_binnum(&p, end, &lev) || lev > curlev + 1
+			|| (!root && lev != 0) || (root && lev == 0)
+			|| end - p < (INT)sizeof(STRING)) {
+			ok = FALSE;
+			break;
+		}
+		node = alloc_node();
+		memset(node, 0, sizeof(*node));
+		memcpy(&ntag(node), p, sizeof(STRING));
+		p += sizeof(STRING);
+		if (!root) {
+			root = node;
+		} else if (lev == curlev + 1) {
+			nparent(node) = curnode;
+			nchild(curnode) = node;
+		} else {
+			while (lev < curlev) {
+				curnode = nparent(curnode);
+				curlev--;
+			}
+			nparent(node) = nparent(curnode);
+			nsibling(curnode) = node;
+		}
+		curnode = node;
+		curlev = lev;
+		nxref(node) = take_binstr(&p, end, &ok);
+		nval(node) = take_binstr(&p, end, &ok);
+	}
+	if (!ok) {
+		free_nodes(root);
+		return NULL;
+	}
+	return root;
+}
 /*==============================================================
  * tree_strlen -- Compute string length of tree -- don't count 0
  *============================================================*/
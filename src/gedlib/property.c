@@ -6,11 +6,14 @@
 #include "llstdlib.h"
 #include "gedcom.h"
 #include "lloptions.h"
+#include "btree.h"
 
 #if HAVE_PWD_H
 #include <pwd.h>
 #endif
 
+extern BTREE BTR;
+
 /*=====================================================
  * get_user_fullname -- Extract current users full name
  *  returns static buffer (actually system buffer)
@@ -60,6 +63,66 @@ get_user_email (void)
   return retval;
 }
 
+/*=======================================================================
+ * get_db_stat -- Look up database cache counter by property name
+ *  returns static buffer, or NULL if not a db counter
+ *=====================================================================*/
+static STRING
+get_db_stat (STRING opt)
+{
+  static char buffer[32];
+  BTCACHESTATS stats;
+  INT hits=0, misses=0, commits=0, syncs=0, val;
+  INT rsize=0, rused=0, rhits=0, rmisses=0, revictions=0;
+  INT psize=0, pused=0, phits=0;
+
+  if (!BTR || strncmp(opt, "db.", 3))
+    return NULL;
+  bt_get_index_cache_stats(BTR, &stats);
+  bt_get_fdpool_stats(BTR, &hits, &misses);
+  bt_get_journal_stats(BTR, &commits, &syncs);
+  get_record_cache_stats(&rsize, &rused, &rhits, &rmisses, &revictions);
+  get_parsed_cache_stats(&psize, &pused, &phits);
+  if (eqstr(opt, "db.indexcache.size"))
+    val = stats.capacity;
+  else if (eqstr(opt, "db.indexcache.used"))
+    val = stats.count;
+  else if (eqstr(opt, "db.indexcache.hits"))
+    val = stats.hits;
+  else if (eqstr(opt, "db.indexcache.misses"))
+    val = stats.misses;
+  else if (eqstr(opt, "db.indexcache.evictions"))
+    val = stats.evictions;
+  else if (eqstr(opt, "db.filepool.hits"))
+    val = hits;
+  else if (eqstr(opt, "db.filepool.misses"))
+    val = misses;
+  else if (eqstr(opt, "db.journal.commits"))
+    val = commits;
+  else if (eqstr(opt, "db.journal.syncs"))
+    val = syncs;
+  else if (eqstr(opt, "db.recordcache.size"))
+    val = rsize;
+  else if (eqstr(opt, "db.recordcache.used"))
+    val = rused;
+  else if (eqstr(opt, "db.recordcache.hits"))
+    val = rhits;
+  else if (eqstr(opt, "db.recordcache.misses"))
+    val = rmisses;
+  else if (eqstr(opt, "db.recordcache.evictions"))
+    val = revictions;
+  else if (eqstr(opt, "db.parsedcache.size"))
+    val = psize;
+  else if (eqstr(opt, "db.parsedcache.used"))
+    val = pused;
+  else if (eqstr(opt, "db.parsedcache.hits"))
+    val = phits;
+  else
+    return NULL;
+  snprintf(buffer, sizeof(buffer), FMT_INT, val);
+  return (STRING) buffer;
+}
+
 /*===============================================================
  * get_property -- 
  * Try getlloptstr_rpt, which tries user options table & config file
@@ -81,6 +144,9 @@ get_property (STRING opt)
 
       if (eqstr(opt, "user.email"))
         val = get_user_email();
+
+      if (!val)
+        val = get_db_stat(opt);
     }
   return val;
 }
@@ -787,38 +787,30 @@ index_by_refn (NODE node,
 }
 /*====================================================
  * traverse_refns -- traverse refns in db
- *  delegates to traverse_db_rec_rkeys
- *   passing callback function: traverse_refn_callback
- *   and using local data in a TRAV_REFN_PARAM
+ *  steps through refn records with a cursor
+ *   calling func for each refn in each record
  *==================================================*/
-typedef struct
-{
-	TRAV_REFNS_FUNC func;
-	void * param;
-} TRAV_REFN_PARAM;
-/* see above */
-static BOOLEAN
-traverse_refn_callback ( TRAV_RECORD_FUNC_BYKEY_ARGS(rkey, data, len, param) )
-{
-	TRAV_REFN_PARAM *tparam = (TRAV_REFN_PARAM *)param;
-	INT i;
-	len=len; /* unused */
-
-	parserefnrec(rkey, data);
-
-	for (i=0; i<RRcount; i++)
-	{
-		if (!tparam->func(rkey2str(RRkeys[i]), RRrefns[i], !i, tparam->param))
-			return FALSE;
-	}
-	return TRUE;
-}
-/* see above */
 void
 traverse_refns (TRAV_REFNS_FUNC func, void *param)
 {
-	TRAV_REFN_PARAM tparam;
-	tparam.param = param;
-	tparam.func = func;
-	traverse_db_rec_rkeys(BTR, refn_lo(), refn_hi(), &traverse_refn_callback, &tparam);
+	RKEY lo = refn_lo(), hi = refn_hi(), rkey;
+	BTCURSOR cursor = bt_cursor_open(BTR, FALSE);
+	RAWRECORD data;
+	INT i, len;
+	BOOLEAN more = TRUE;
+
+	bt_cursor_seek(cursor, &lo);
+	while (more && bt_cursor_next(cursor, &rkey, &data, &len)) {
+		if (cmpkeys(&rkey, &hi) > 0) {
+			if (data) stdfree(data);
+			break;
+		}
+		if (!data || !cmpkeys(&rkey, &lo))
+			continue;
+		parserefnrec(rkey, data);
+		for (i=0; more && i<RRcount; i++)
+			more = (*func)(rkey2str(RRkeys[i]), RRrefns[i], !i, param);
+		stdfree(data);
+	}
+	bt_cursor_close(cursor);
 }
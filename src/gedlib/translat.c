@@ -141,6 +141,7 @@ static CNSTRING conversions_keys[] = {
 /* currently loaded legacy (embedded) translation tables */
 static struct legacytt_s legacytts[NUM_TT_MAPS]; /* initialized once by transl_init() */
 static BOOLEAN inited=FALSE;
+static ZSTR f_zbuf=0; /* reused by translate_string */
 
 
 /*********************************************
@@ -195,14 +196,19 @@ translate_string_to_zstring (XLAT xlat, CNSTRING in)
 void
 translate_string (XLAT ttm, CNSTRING in, STRING out, INT maxlen)
 {
-	ZSTR zstr=0;
 	if (!in || !in[0]) {
 		out[0] = 0;
 		return;
 	}
-	zstr = translate_string_to_zstring(ttm, in);
-	llstrsets(out, maxlen, uu8, zs_str(zstr));
-	zs_free(&zstr);
+	if (transl_is_xlat_identity(ttm)) {
+		llstrsets(out, maxlen, uu8, in);
+		return;
+	}
+	if (!f_zbuf)
+		f_zbuf = zs_new();
+	zs_sets(f_zbuf, in);
+	transl_xlat(ttm, f_zbuf);
+	llstrsets(out, maxlen, uu8, zs_str(f_zbuf));
 }
 /*==========================================================
  * translate_write -- Translate and output lines in a buffer
@@ -211,8 +217,8 @@ translate_string (XLAT ttm, CNSTRING in, STRING out, INT maxlen)
  *  lenp: [in,out] #characters left in buffer (set to 0 if a full write)
  *  ofp:  [in] output file
  *  last: [in] flag to write final line if no trailing \n
- * Loops thru & prints out lines until end of string
- *  (or until last line if not terminated with \n)
+ * All complete lines are translated together in one pass
+ *  (and the last line too, if caller asks for it)
  * *lenp will be set to zero unless there is a final line
  * not terminated by \n and caller didn't ask to write it anyway
  * NB: If no translation table, entire string is always written
@@ -220,11 +226,9 @@ translate_string (XLAT ttm, CNSTRING in, STRING out, INT maxlen)
 BOOLEAN
 translate_write(XLAT ttm, STRING in, INT *lenp, FILE *ofp, BOOLEAN last)
 {
-	char intmp[MAXLINELEN+2]="";
-	char out[MAXLINELEN+2]="";
-	char *tp=0;
-	STRING bp = in;
-	int i=0,j=0;
+	ZSTR zstr=0;
+	INT len = *lenp, done = *lenp;
+	size_t outlen;
 
 	if(ttm == NULL) {
 	    ASSERT(fwrite(in, *lenp, 1, ofp) == 1);
@@ -232,45 +236,34 @@ translate_write(XLAT ttm, STRING in, INT *lenp, FILE *ofp, BOOLEAN last)
 	    return TRUE;
 	}
 
-	/* loop through lines one by one */
-	for(i = 0; i < *lenp; ) {
-		/* copy in to intmp, up to first \n or our buffer size-1 */
-		tp = intmp;
-		for(j = 0; (j <= MAXLINELEN) && (i < *lenp) && (*bp != '\n'); j++) {
-			i++;
-			*tp++ = *bp++;
-		}
-		*tp = '\0';
-		if(i < *lenp) {
-			/* partial, either a single line or a single buffer full */
-			if(*bp == '\n') {
-				/* single line, include the \n */
-				/* it is important that we limited size earlier so we
-				have room here to add one more character */
-				*tp++ = *bp++;
-				*tp = '\0';
-				i++;
-			}
-		}
-		else if(!last) {
-			/* the last line is not complete, return it in buffer  */
-			strcpy(in, intmp);
-			*lenp = strlen(in);
-			return(TRUE);
-		}
-		/* translate & write out current line */
-		/* TODO (2002-11-28): modify to use dynamic string */
-		translate_string(ttm, intmp, out, MAXLINELEN+2);
-		if (ofp && strlen(out)) {
-			int outbytes = fwrite(out, 1, strlen(out), ofp);
+	/* hold back any final line not terminated by \n */
+	if (!last) {
+		while (done > 0 && in[done-1] != '\n')
+			--done;
+	}
+
+	/* translate & write out all lines at once */
+	if (done > 0) {
+		zstr = zs_newsubs(in, done);
+		transl_xlat(ttm, zstr);
+		outlen = strlen(zs_str(zstr));
+		if (ofp && outlen) {
+			int outbytes = fwrite(zs_str(zstr), 1, outlen, ofp);
 			if (!outbytes || ferror(ofp)) {
 				crashlog("outbytes=%d, errno=%d, outstr=%s"
-					, outbytes, errno, out);
+					, outbytes, errno, zs_str(zstr));
 				FATAL();
 			}
 		}
+		zs_free(&zstr);
+	}
+
+	if (done > 0 && done < len) {
+		/* the last line is not complete, return it in buffer  */
+		memmove(in, in+done, len-done);
+		in[len-done] = 0;
 	}
-	*lenp = 0;
+	*lenp = len-done;
 	return(TRUE);
 }
 /*==========================================================
@@ -561,6 +554,19 @@ void
 transl_free_predefined_xlats (void)
 {
 	clear_predefined_list();
+	zs_free(&f_zbuf);
+}
+/*==========================================================
+ * transl_is_xlat_identity -- Would transl_xlat leave text as is ?
+ *  (no conversion, nor legacy table)
+ *========================================================*/
+BOOLEAN
+transl_is_xlat_identity (XLAT xlat)
+{
+	INT index = xl_get_uparam(xlat)-1;
+	if (index>=0 && legacytts[index].tt)
+		return FALSE;
+	return xl_is_xlat_identity(xlat);
 }
 /*==========================================================
  * transl_is_xlat_valid -- Does it do the job ?
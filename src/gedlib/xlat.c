@@ -37,6 +37,7 @@ struct tag_xlat {
 	BOOLEAN adhoc;
 	BOOLEAN valid;
 	INT uparam; /* opaque number used by client */
+	ZSTR zscratch; /* reused output buffer for iconv steps */
 };
 /* dynamically loadable translation table, entry in dyntt list */
 struct tag_dyntt {
@@ -53,6 +54,7 @@ typedef struct tag_dyntt *DYNTT;
 typedef struct xlat_step_s {
 	STRING iconv_src;
 	STRING iconv_dest;
+	ICVT icvt; /* open for the life of the step */
 	DYNTT dyntt;
 } *XLSTEP;
 
@@ -64,7 +66,7 @@ typedef struct xlat_step_s {
 /* alphabetical */
 static void add_dyntt_step(XLAT xlat, DYNTT dyntt);
 static INT check_tt_name(CNSTRING filename);
-static XLSTEP create_iconv_step(CNSTRING src, CNSTRING dest);
+static XLSTEP create_iconv_step(CNSTRING src, CNSTRING dest, ICVT icvt);
 static XLSTEP create_dyntt_step(DYNTT dyntt);
 static XLAT create_null_xlat(BOOLEAN adhoc);
 static XLAT create_xlat(CNSTRING src, CNSTRING dest, BOOLEAN adhoc);
@@ -150,25 +152,29 @@ free_xlat (XLAT xlat)
 		xstep = (XLSTEP)el;
 		strfree(&xstep->iconv_src);
 		strfree(&xstep->iconv_dest);
+		icvt_close(&xstep->icvt);
 		xstep->dyntt = 0; /* f_dyntts owns dyntt memory */
 	ENDLIST
 	destroy_list(xlat->steps);
 	strfree(&xlat->src);
 	strfree(&xlat->dest);
+	zs_free(&xlat->zscratch);
 	stdfree(xlat);
 }
 /*==========================================================
  * create_iconv_step -- Create an iconv step of a translation chain
+ *  icvt: [IN]  open conversion (step takes ownership)
  * Created: 2002/11/27 (Perry Rapp)
  *========================================================*/
 static XLSTEP
-create_iconv_step (CNSTRING src, CNSTRING dest)
+create_iconv_step (CNSTRING src, CNSTRING dest, ICVT icvt)
 {
 	XLSTEP xstep;
 	xstep = (XLSTEP) stdalloc(sizeof(*xstep));
 	memset(xstep, 0, sizeof(*xstep));
 	xstep->iconv_dest = strsave(dest);
 	xstep->iconv_src = strsave(src);
+	xstep->icvt = icvt;
 	return xstep;
 }
 /*==========================================================
@@ -213,6 +219,7 @@ xl_get_xlat (CNSTRING src, CNSTRING dest, BOOLEAN adhoc)
 	ZSTR zsrc_u=ll_toupperz(src,0),zdest_u=ll_toupperz(dest,0);
 	LIST srcsubs=0, destsubs=0;
 	STRING subcoding=0;
+	ICVT icvt=0;
 	
 	if (!src || !src[0] || !dest || !dest[0]) {
 		xlat = create_null_xlat(adhoc);
@@ -261,8 +268,8 @@ xl_get_xlat (CNSTRING src, CNSTRING dest, BOOLEAN adhoc)
 	/* do main codeset conversion, prefering iconv if available */
 	if (eqstr(zs_str(zsrc), zs_str(zdest))) {
 		/* main conversion is identity */
-	} else if (iconv_can_trans(zs_str(zsrc), zs_str(zdest))) {
-		XLSTEP xstep = create_iconv_step(zs_str(zsrc), zs_str(zdest));
+	} else if ((icvt = icvt_open(zs_str(zsrc), zs_str(zdest))) != 0) {
+		XLSTEP xstep = create_iconv_step(zs_str(zsrc), zs_str(zdest), icvt);
 		enqueue_list(xlat->steps, xstep);
 	} else {
 		STRING src = zs_str(zsrc), dest = zs_str(zdest);
@@ -391,6 +398,7 @@ load_dyntt_if_needed (DYNTT dyntt)
 }
 /*==========================================================
  * xl_do_xlat -- Perform a translation on a string
+ *  (string may hold many lines, eg a whole record)
  * Created: 2002/11/25 (Perry Rapp)
  *========================================================*/
 BOOLEAN
@@ -404,12 +412,13 @@ xl_do_xlat (XLAT xlat, ZSTR zstr)
 		xstep = (XLSTEP)el;
 		if (xstep->iconv_src) {
 			/* an iconv step */
-			ZSTR ztemp=zs_new();
-			if (iconv_trans(xstep->iconv_src, xstep->iconv_dest, zs_str(zstr), ztemp, '?')) {
+			if (!xlat->zscratch)
+				xlat->zscratch = zs_new();
+			if (icvt_trans(xstep->icvt, zs_str(zstr), xlat->zscratch, '?')) {
 				cvtd=TRUE;
-				zs_move(zstr, &ztemp);
+				/* result to caller, old buffer kept for next step */
+				zs_swap(zstr, xlat->zscratch);
 			} else {
-				zs_free(&ztemp);
 				/* iconv failed, anything to do ? */
 			}
 		} else if (xstep->dyntt) {
@@ -721,6 +730,14 @@ xl_is_xlat_valid (XLAT xlat)
 {
 	return xlat->valid;
 }
+/*==========================================================
+ * xl_is_xlat_identity -- Does translation leave text as is ?
+ *========================================================*/
+BOOLEAN
+xl_is_xlat_identity (XLAT xlat)
+{
+	return !xlat->valid || !xlat->steps || is_empty_list(xlat->steps);
+}
 /*==========================================================
  * xl_release_xlat -- Client finished with this
  * Created: 2002/12/15 (Perry Rapp)
@@ -49,6 +49,10 @@ extern BTREE BTR;
  *   rest are keys of deleted records
  * n==1 means there are no deleted INDI keys
  * n==2 means there is one deleted INDI key (ixrefs[1])
+ * The writer keeps the same words in record VXREF of the database,
+ *   written along with the file. The file is changed in place, so a
+ *   reader (which goes on reading the version of the database it
+ *   opened, see btree/snapshot.c) takes the record of its version.
  *=================================================================*/
 /*
  In memory, data is kept in a DELETESET
@@ -64,6 +68,13 @@ extern BTREE BTR;
   recs[1] = 5 (I5 was deleted, so it is available)
   max = allocation unit (still 64)
   ctype as above (eg, 'I' for the INDI set)
+ Alongside, the live keys (1 up to recs[0]-1, less those deleted) are
+ kept as a bitmap, so that walking through the records, or finding
+ the nth of them, does not search recs for each key number.
+ The bitmap is in chunks of XCHUNK keys; chunks with no live keys
+ are null, & those with all keys live share xfull, so a database
+ with few deletions takes little more than a pointer per chunk.
+ Each chunk's count of live keys is kept too, for rank & select.
 */
 
 /*********************************************
@@ -72,6 +83,11 @@ extern BTREE BTR;
 
 typedef enum { DUPSOK, NODUPS } DUPS;
 
+typedef unsigned long XWORD; /* word of live key bitmap */
+#define XWORDBITS ((INT32)(8*sizeof(XWORD)))
+#define XCHUNK ((INT32)4096) /* keys per chunk of bitmap */
+#define XCHUNKWORDS (XCHUNK/XWORDBITS)
+
  /*==================================== 
  * deleteset -- set of deleted records
  *  NB: storage order is IFESX
@@ -83,6 +99,11 @@ struct deleteset_s
 	INT32 * recs;
 	INT32 max;
 	char ctype;
+	XWORD ** live; /* chunks of bitmap of live keys */
+	INT32 * nlive; /* live keys in each chunk */
+	INT32 * before; /* live keys in chunks before each */
+	INT32 nchunks;
+	BOOLEAN ranked; /* is before up to date ? */
 };
 typedef struct deleteset_s *DELETESET;
 
@@ -103,13 +124,27 @@ static void freexref(DELETESET set);
 static DELETESET get_deleteset_from_type(char ctype);
 static STRING getxref(DELETESET set);
 static void growxrefs(DELETESET set);
+static void live_build(DELETESET set);
+static XWORD * live_chunk(DELETESET set, INT32 c);
+static void live_free(DELETESET set);
+static INT32 live_next(DELETESET set, INT32 keynum);
+static INT32 live_nth(DELETESET set, INT32 n);
+static INT32 live_prev(DELETESET set, INT32 keynum);
+static void live_set(DELETESET set, INT32 keynum, BOOLEAN on);
+static BOOLEAN live_test(DELETESET set, INT32 keynum);
+static INT word_high(XWORD w);
+static INT word_low(XWORD w);
+static INT word_ones(XWORD w);
 static STRING newxref(STRING xrefp, BOOLEAN flag, DELETESET set);
 static INT num_set(DELETESET set);
 static BOOLEAN parse_key(CNSTRING key, char * ktype, INT32 * kval);
-static void readrecs(DELETESET set);
+static BOOLEAN parse_xrefs(CNSTRING image, INT len);
+static void readrecs(DELETESET set, const INT32 * words, INT * used);
 static BOOLEAN readxrefs(void);
+static STRING xref_image(INT * plen);
 static BOOLEAN xref_isvalid_impl(DELETESET set, INT32 keynum);
 static INT xref_last(DELETESET set);
+static BOOLEAN xrefs_initial(void);
 
 /*********************************************
  * local variables
@@ -121,9 +156,12 @@ static struct deleteset_s irecs, frecs, srecs, erecs, xrecs;
 static FILE *xreffp=0;	/* open xref file pointer */
 static BOOLEAN xrefReadonly = FALSE;
 static INT xrefsize=0; /* xref file size */
+#define XREF_RECKEY "VXREF"
 
 static INT32 maxkeynum=-1; /* cache value of largest key extant (-1 means not sure) */
 
+static XWORD xfull[XCHUNK/(8*sizeof(XWORD))]; /* shared chunk of all live keys */
+
 /*********************************************
  * local & exported function definitions
  * body of module
@@ -139,6 +177,11 @@ initdset (DELETESET set, char ctype)
 	set->max = 0;
 	set->n = 1;
 	set->recs = 0;
+	set->live = 0;
+	set->nlive = 0;
+	set->before = 0;
+	set->nchunks = 0;
+	set->ranked = FALSE;
 }
 /*=================================== 
  * initdsets -- Initialize delete sets
@@ -184,7 +227,8 @@ openxref (BOOLEAN readonly)
 	initdsets();
 	ASSERT(!xreffp);
 	snprintf(scratch, sizeof(scratch), "%s/xrefs", BTR->b_basedir);
-	xrefReadonly = readonly;
+	/* file is the writer's to change */
+	xrefReadonly = readonly || !bwrite(BTR);
 	fmode = xrefReadonly ? LLREADBINARY : LLREADBINARYUPDATE;
 	if (!(xreffp = fopen(scratch, fmode))) {
 		return FALSE;
@@ -192,8 +236,6 @@ openxref (BOOLEAN readonly)
 
 	success = readxrefs();
 
-	xrefsize = ftell(xreffp);
-
 	return success;
 }
 /*==============================
@@ -237,6 +279,7 @@ getxrefnum (DELETESET set)
 		/* remove just-used entry from list */
 		--(set->n);
 	}
+	live_set(set, keynum, TRUE);
 	ASSERT(writexrefs());
 	maxkeynum=-1;
 	return keynum;
@@ -317,17 +360,76 @@ sortxrefs (void)
 }
 /*=============================
  * readxrefs -- Read xrefs file
- *  storage order: IFESX
+ *  or, if not the writer, xrefs record of the version
+ *  being read (if the database has one)
+ *  The writer brings the record up to date, if it is not.
  *===========================*/
 static BOOLEAN
 readxrefs (void)
 {
+	STRING image, recimage;
+	INT len, reclen;
+	long size;
+	BOOLEAN ok;
+
 	ASSERT(xreffp);
-	ASSERT(fread(&irecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fread(&frecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fread(&erecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fread(&srecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fread(&xrecs.n, sizeof(INT32), 1, xreffp) == 1);
+	recimage = retrieve_raw_record(XREF_RECKEY, &reclen);
+	if (recimage && !bwrite(BTR)) {
+		ok = parse_xrefs(recimage, reclen);
+		stdfree(recimage);
+		return ok;
+	}
+	ASSERT(fseek(xreffp, 0, SEEK_END) == 0);
+	ASSERT((size = ftell(xreffp)) >= 0);
+	rewind(xreffp);
+	image = (STRING) stdalloc(size + 1);
+	ASSERT(fread(image, size, 1, xreffp) == 1);
+	ok = parse_xrefs(image, size);
+	stdfree(image);
+	if (recimage)
+		stdfree(recimage);
+	if (!bwrite(BTR))
+		return ok;
+	/* a database no key was ever taken from needs no record yet */
+	image = xref_image(&len);
+	recimage = retrieve_raw_record(XREF_RECKEY, &reclen);
+	if (recimage ? (reclen != len || memcmp(image, recimage, len)) : !xrefs_initial())
+		bt_addrecord(BTR, str2rkey(XREF_RECKEY), image, len);
+	stdfree(image);
+	if (recimage)
+		stdfree(recimage);
+	return ok;
+}
+/*=============================
+ * xrefs_initial -- Are xrefs as initxref made them ?
+ *===========================*/
+static BOOLEAN
+xrefs_initial (void)
+{
+	return irecs.n == 1 && irecs.recs[0] == 1
+		&& frecs.n == 1 && frecs.recs[0] == 1
+		&& erecs.n == 1 && erecs.recs[0] == 1
+		&& srecs.n == 1 && srecs.recs[0] == 1
+		&& xrecs.n == 1 && xrecs.recs[0] == 1;
+}
+/*=============================
+ * parse_xrefs -- Set delete sets from words of xrefs
+ *  (trailing bytes after them are ignored)
+ *  storage order: IFESX
+ *===========================*/
+static BOOLEAN
+parse_xrefs (CNSTRING image, INT len)
+{
+	INT32 words[5];
+	INT used = 5;
+
+	ASSERT(len >= (INT)sizeof(words));
+	memcpy(words, image, sizeof(words));
+	irecs.n = words[0];
+	frecs.n = words[1];
+	erecs.n = words[2];
+	srecs.n = words[3];
+	xrecs.n = words[4];
 	ASSERT(irecs.n > 0);
 	ASSERT(frecs.n > 0);
 	ASSERT(erecs.n > 0);
@@ -338,43 +440,79 @@ readxrefs (void)
 	if (srecs.n > srecs.max) growxrefs(&srecs);
 	if (erecs.n > erecs.max) growxrefs(&erecs);
 	if (xrecs.n > xrecs.max) growxrefs(&xrecs);
-	readrecs(&irecs);
-	readrecs(&frecs);
-	readrecs(&erecs);
-	readrecs(&srecs);
-	readrecs(&xrecs);
+	ASSERT((INT)sizeof(INT32) * ((INT)5 + irecs.n + frecs.n + erecs.n + srecs.n + xrecs.n) <= len);
+	readrecs(&irecs, (const INT32 *)image, &used);
+	readrecs(&frecs, (const INT32 *)image, &used);
+	readrecs(&erecs, (const INT32 *)image, &used);
+	readrecs(&srecs, (const INT32 *)image, &used);
+	readrecs(&xrecs, (const INT32 *)image, &used);
+	xrefsize = used * sizeof(INT32);
 	sortxrefs();
+	live_build(&irecs);
+	live_build(&frecs);
+	live_build(&srecs);
+	live_build(&erecs);
+	live_build(&xrecs);
 	return TRUE;
 }
 /*=========================================
  * readrecs -- Read in one array of records
+ *  words: [IN]     words of xrefs
+ *  used:  [IN/OUT] words already read
  *=======================================*/
 static void
-readrecs (DELETESET set)
+readrecs (DELETESET set, const INT32 * words, INT * used)
 {
-	ASSERT((INT32)fread(set->recs, sizeof(INT32), set->n, xreffp) == set->n);
+	memcpy(set->recs, words + *used, set->n * sizeof(INT32));
+	*used += set->n;
 }
 /*================================
- * writexrefs -- Write xrefs file.
+ * xref_image -- Words of xrefs, as in file
  *  storage order: IFESX
+ * returns image (caller frees)
+ *==============================*/
+static STRING
+xref_image (INT * plen)
+{
+	DELETESET sets[5];
+	INT32 * words;
+	INT i, used = 5;
+
+	sets[0] = &irecs;
+	sets[1] = &frecs;
+	sets[2] = &erecs;
+	sets[3] = &srecs;
+	sets[4] = &xrecs;
+	*plen = 5;
+	for (i = 0; i < 5; i++)
+		*plen += sets[i]->n;
+	*plen *= sizeof(INT32);
+	words = (INT32 *) stdalloc(*plen);
+	for (i = 0; i < 5; i++) {
+		words[i] = sets[i]->n;
+		memcpy(words + used, sets[i]->recs, sets[i]->n * sizeof(INT32));
+		used += sets[i]->n;
+	}
+	return (STRING)words;
+}
+/*================================
+ * writexrefs -- Write xrefs file.
+ *  & xrefs record, so that it is published with the
+ *  records whose keys it hands out or frees
  *==============================*/
 BOOLEAN
 writexrefs (void)
 {
+	STRING image;
+	INT len;
 	ASSERT(!xrefReadonly);
 	ASSERT(xreffp);
+	image = xref_image(&len);
 	rewind(xreffp);
-	ASSERT(fwrite(&irecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fwrite(&frecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fwrite(&erecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fwrite(&srecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT(fwrite(&xrecs.n, sizeof(INT32), 1, xreffp) == 1);
-	ASSERT((INT32)fwrite(irecs.recs, sizeof(INT32), irecs.n, xreffp) == irecs.n);
-	ASSERT((INT32)fwrite(frecs.recs, sizeof(INT32), frecs.n, xreffp) == frecs.n);
-	ASSERT((INT32)fwrite(erecs.recs, sizeof(INT32), erecs.n, xreffp) == erecs.n);
-	ASSERT((INT32)fwrite(srecs.recs, sizeof(INT32), srecs.n, xreffp) == srecs.n);
-	ASSERT((INT32)fwrite(xrecs.recs, sizeof(INT32), xrecs.n, xreffp) == xrecs.n);
+	ASSERT(fwrite(image, len, 1, xreffp) == 1);
 	fflush(xreffp);
+	bt_addrecord(BTR, str2rkey(XREF_RECKEY), image, len);
+	stdfree(image);
 	return TRUE;
 }
 /*================================
@@ -468,6 +606,7 @@ add_xref_to_set_impl (INT32 keynum, DELETESET set, DUPS dups)
 		add this to the list
 		*/
 		--set->recs[0];
+		live_set(set, keynum, FALSE);
 		ASSERT(writexrefs());
 		return TRUE;
 	}
@@ -491,6 +630,7 @@ add_xref_to_set_impl (INT32 keynum, DELETESET set, DUPS dups)
 		(set->recs)[i+1] = (set->recs)[i];
 	(set->recs)[lo] = keynum;
 	(set->n)++;
+	live_set(set, keynum, FALSE);
 	ASSERT(writexrefs());
 	maxkeynum=-1;
 	return TRUE;
@@ -611,12 +751,13 @@ delete_xref_if_present (CNSTRING key)
 	if (!(lo < set->n && (set->recs)[lo] == keynum))
 		return FALSE;
 	/* removing xrefs[lo] -- move lo+ down */
-	for (i=lo; i+1<set->n-1; ++i)
+	for (i=lo; i+1<set->n; ++i)
 		(set->recs)[i] = (set->recs)[i+1];
 	/* zero out the entry slipping off the top of the list */
 	if (set->n > 1)
 		set->recs[set->n - 1] = 0;
 	--(set->n);
+	live_set(set, keynum, TRUE);
 	ASSERT(writexrefs());
 	maxkeynum=-1;
 	return TRUE;
@@ -674,6 +815,7 @@ static void
 freexref (DELETESET set)
 {
 	ASSERT(set);
+	live_free(set);
 	if (set->recs) {
 		stdfree(set->recs);
 		set->recs = 0;
@@ -751,8 +893,10 @@ newxref (STRING xrefp, BOOLEAN flag, DELETESET set)
 			set->n = 1;	/* forget about deleted entries */
 		if(keynum >= set->recs[0])
 			set->recs[0] = keynum+1;	/* next available */
-		if(changed)
+		if(changed) {
+			live_build(set);
 			ASSERT(writexrefs());
+		}
 		snprintf(scratch, sizeof(scratch), "@%s@", xrefp);
 		return(scratch);
 	}
@@ -796,39 +940,17 @@ newxxref (STRING xrefp, BOOLEAN flag)
 static BOOLEAN
 xref_isvalid_impl (DELETESET set, INT32 keynum)
 {
-	INT32 lo,hi,md;
-	if (set->n == set->recs[0]) return FALSE; /* no valids */
-	if (set->n == 1) return TRUE; /* all valid */
-	/* binary search deleteds */
-	lo=1;
-	hi=(set->n)-1;
-	while (lo<=hi) {
-		md = (lo + hi)/2;
-		if (keynum>(set->recs)[md])
-			hi=--md;
-		else if (keynum<(set->recs)[md])
-			lo=++md;
-		else
-			return FALSE;
-	}
-	return TRUE;
+	return live_test(set, keynum);
 }
 /*=========================================================
  * xref_next_impl -- Return next valid of some type after i
  *  returns 0 if none found
  *  generic for all 5 types
- *  this could be more efficient (after first one work
- *  thru tree)
  *=======================================================*/
 static INT32
 xref_next_impl (DELETESET set, INT32 i)
 {
-	if (set->n == set->recs[0]) return 0; /* no valids */
-	while (++i < set->recs[0])
-	{
-		if (xref_isvalid_impl(set, i)) return (INT)i;
-	}
-	return 0;
+	return live_next(set, i);
 }
 /*==========================================================
  * xref_prev_impl -- Return prev valid of some type before i
@@ -838,12 +960,7 @@ xref_next_impl (DELETESET set, INT32 i)
 static INT32
 xref_prev_impl (DELETESET set, INT32 i)
 {
-	if (set->n == set->recs[0]) return 0; /* no valids */
-	while (--i)
-	{
-		if (xref_isvalid_impl(set, i)) return i;
-	}
-	return 0;
+	return live_prev(set, i);
 }
 /*===============================================
  * xref_next? -- Return next valid indi/? after i
@@ -911,6 +1028,16 @@ INT xref_lastf (void) { return xref_last(&frecs); }
 INT xref_lasts (void) { return xref_last(&srecs); }
 INT xref_laste (void) { return xref_last(&erecs); }
 INT xref_lastx (void) { return xref_last(&xrecs); }
+/*=======================================
+ * xref_nth -- Return nth (from 1) valid key of type
+ *  (eg, to pick records at random)
+ *  returns 0 if there are fewer than n
+ *=====================================*/
+INT
+xref_nth (char ntype, INT n)
+{
+	return (INT)live_nth(get_deleteset_from_type(ntype), (INT32)n);
+}
 /*=======================================
  * xrefs_get_counts_from_unopened_db --
  *  read record counts out of file on disk
@@ -965,3 +1092,280 @@ xrefs_get_counts_from_unopened_db (CNSTRING path, INT *nindis, INT *nfams
 	fclose(fp);
 	return TRUE;
 }
+/*=======================================
+ * live_build -- Make bitmap of live keys from recs
+ *=====================================*/
+static void
+live_build (DELETESET set)
+{
+	INT32 c, i, lo, hi;
+	XWORD * w;
+
+	live_free(set);
+	if (!xfull[0])
+		memset(xfull, 0xff, sizeof(xfull));
+	set->nchunks = set->recs[0]/XCHUNK + 1;
+	set->live = (XWORD **) stdalloc(set->nchunks*sizeof(XWORD *));
+	set->nlive = (INT32 *) stdalloc(set->nchunks*sizeof(INT32));
+	set->before = (INT32 *) stdalloc(set->nchunks*sizeof(INT32));
+	/* keys 1 up to recs[0]-1 are live, but for those deleted */
+	for (c = 0; c < set->nchunks; c++) {
+		lo = c ? c*XCHUNK : 1;
+		hi = (c+1)*XCHUNK;
+		if (hi > set->recs[0])
+			hi = set->recs[0];
+		if (hi - lo == XCHUNK) {
+			set->live[c] = xfull;
+		} else if (hi > lo) {
+			w = live_chunk(set, c);
+			for (i = lo; i < hi; i++)
+				w[(i % XCHUNK)/XWORDBITS] |= (XWORD)1 << (i % XWORDBITS);
+		}
+		set->nlive[c] = (hi > lo) ? hi - lo : 0;
+	}
+	for (i = 1; i < set->n; i++)
+		live_set(set, set->recs[i], FALSE);
+	set->ranked = FALSE;
+}
+/*=======================================
+ * live_chunk -- Get chunk c of bitmap to change
+ *  (making room for it, or own copy of shared one)
+ *=====================================*/
+static XWORD *
+live_chunk (DELETESET set, INT32 c)
+{
+	XWORD * w;
+	if (c >= set->nchunks) {
+		INT32 m = set->nchunks * 2;
+		XWORD ** live;
+		INT32 * nlive;
+		if (m <= c)
+			m = c + 1;
+		live = (XWORD **) stdalloc(m*sizeof(XWORD *));
+		nlive = (INT32 *) stdalloc(m*sizeof(INT32));
+		if (set->nchunks) {
+			memcpy(live, set->live, set->nchunks*sizeof(XWORD *));
+			memcpy(nlive, set->nlive, set->nchunks*sizeof(INT32));
+			stdfree(set->live);
+			stdfree(set->nlive);
+			stdfree(set->before);
+		}
+		set->live = live;
+		set->nlive = nlive;
+		set->before = (INT32 *) stdalloc(m*sizeof(INT32));
+		set->nchunks = m;
+		set->ranked = FALSE;
+	}
+	w = set->live[c];
+	if (w && w != xfull)
+		return w;
+	set->live[c] = (XWORD *) stdalloc(sizeof(xfull));
+	if (w)
+		memcpy(set->live[c], xfull, sizeof(xfull));
+	else
+		memset(set->live[c], 0, sizeof(xfull));
+	return set->live[c];
+}
+/*=======================================
+ * live_free -- Free bitmap of live keys
+ *=====================================*/
+static void
+live_free (DELETESET set)
+{
+	INT32 c;
+	for (c = 0; c < set->nchunks; c++) {
+		if (set->live[c] && set->live[c] != xfull)
+			stdfree(set->live[c]);
+	}
+	if (set->nchunks) {
+		stdfree(set->live);
+		stdfree(set->nlive);
+		stdfree(set->before);
+	}
+	set->live = 0;
+	set->nlive = 0;
+	set->before = 0;
+	set->nchunks = 0;
+	set->ranked = FALSE;
+}
+/*=======================================
+ * live_set -- Mark key live (or not) in bitmap
+ *=====================================*/
+static void
+live_set (DELETESET set, INT32 keynum, BOOLEAN on)
+{
+	INT32 c = keynum/XCHUNK;
+	XWORD bit = (XWORD)1 << (keynum % XWORDBITS);
+	XWORD * w;
+	if (keynum <= 0 || live_test(set, keynum) == on)
+		return;
+	w = live_chunk(set, c) + (keynum % XCHUNK)/XWORDBITS;
+	if (on) {
+		*w |= bit;
+		++set->nlive[c];
+	} else {
+		*w &= ~bit;
+		--set->nlive[c];
+	}
+	/* share again chunks with all or no keys live */
+	if (!set->nlive[c] || set->nlive[c] == XCHUNK) {
+		stdfree(set->live[c]);
+		set->live[c] = set->nlive[c] ? xfull : 0;
+	}
+	set->ranked = FALSE;
+}
+/*=======================================
+ * live_test -- Is key live ?
+ *=====================================*/
+static BOOLEAN
+live_test (DELETESET set, INT32 keynum)
+{
+	INT32 c = keynum/XCHUNK;
+	XWORD * w;
+	if (keynum <= 0 || c >= set->nchunks || !(w = set->live[c]))
+		return FALSE;
+	return (BOOLEAN)((w[(keynum % XCHUNK)/XWORDBITS] >> (keynum % XWORDBITS)) & 1);
+}
+/*=======================================
+ * live_next -- Return first live key after keynum
+ *  returns 0 if none
+ *=====================================*/
+static INT32
+live_next (DELETESET set, INT32 keynum)
+{
+	INT32 k = keynum < 0 ? 1 : keynum + 1;
+	INT32 c, i;
+	XWORD * w, word;
+	for (c = k/XCHUNK; c < set->nchunks; c++, k = c*XCHUNK) {
+		if (!(w = set->live[c]))
+			continue;
+		i = (k % XCHUNK)/XWORDBITS;
+		/* drop keys before k from first word */
+		word = w[i] & (~(XWORD)0 << (k % XWORDBITS));
+		while (!word && ++i < XCHUNKWORDS)
+			word = w[i];
+		if (word)
+			return c*XCHUNK + i*XWORDBITS + word_low(word);
+	}
+	return 0;
+}
+/*=======================================
+ * live_prev -- Return last live key before keynum
+ *  returns 0 if none
+ *=====================================*/
+static INT32
+live_prev (DELETESET set, INT32 keynum)
+{
+	INT32 k = keynum - 1;
+	INT32 c, i;
+	XWORD * w, word;
+	if (k <= 0)
+		return 0;
+	c = k/XCHUNK;
+	if (c >= set->nchunks) {
+		c = set->nchunks - 1;
+		k = set->nchunks*XCHUNK - 1;
+	}
+	for ( ; c >= 0; c--, k = (c+1)*XCHUNK - 1) {
+		if (!(w = set->live[c]))
+			continue;
+		i = (k % XCHUNK)/XWORDBITS;
+		/* drop keys after k from first word */
+		word = w[i] & (~(XWORD)0 >> (XWORDBITS - 1 - k % XWORDBITS));
+		while (!word && --i >= 0)
+			word = w[i];
+		if (word)
+			return c*XCHUNK + i*XWORDBITS + word_high(word);
+	}
+	return 0;
+}
+/*=======================================
+ * live_nth -- Return nth (from 1) live key
+ *  returns 0 if fewer than n live
+ *=====================================*/
+static INT32
+live_nth (DELETESET set, INT32 n)
+{
+	INT32 lo, hi, c, i, ones;
+	XWORD * w, word;
+	if (n < 1 || !set->nchunks)
+		return 0;
+	if (!set->ranked) {
+		INT32 total = 0;
+		for (c = 0; c < set->nchunks; c++) {
+			set->before[c] = total;
+			total += set->nlive[c];
+		}
+		set->ranked = TRUE;
+	}
+	hi = set->nchunks - 1;
+	if (set->before[hi] + set->nlive[hi] < n)
+		return 0;
+	/* find last chunk with fewer than n live keys before it */
+	lo = 0;
+	while (lo < hi) {
+		c = (lo + hi + 1)/2;
+		if (set->before[c] < n)
+			lo = c;
+		else
+			hi = c - 1;
+	}
+	c = lo;
+	n -= set->before[c];
+	w = set->live[c];
+	for (i = 0; n > (ones = word_ones(w[i])); i++)
+		n -= ones;
+	/* drop n-1 lowest live keys of word */
+	for (word = w[i]; --n; )
+		word &= word - 1;
+	return c*XCHUNK + i*XWORDBITS + word_low(word);
+}
+/*=======================================
+ * word_high -- Highest bit set in (nonzero) word
+ *=====================================*/
+static INT
+word_high (XWORD w)
+{
+#if defined __GNUC__
+	return XWORDBITS - 1 - __builtin_clzl(w);
+#else
+	INT i = -1;
+	while (w) {
+		w >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+/*=======================================
+ * word_low -- Lowest bit set in (nonzero) word
+ *=====================================*/
+static INT
+word_low (XWORD w)
+{
+#if defined __GNUC__
+	return __builtin_ctzl(w);
+#else
+	INT i = 0;
+	while (!(w & 1)) {
+		w >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+/*=======================================
+ * word_ones -- Number of bits set in word
+ *=====================================*/
+static INT
+word_ones (XWORD w)
+{
+#if defined __GNUC__
+	return __builtin_popcountl(w);
+#else
+	INT n = 0;
+	for ( ; w; w &= w - 1)
+		++n;
+	return n;
+#endif
+}
@@ -71,7 +71,8 @@ typedef char *RAWRECORD;
 typedef struct {
 	FKEY k_mkey;  /* current master key*/
 	FKEY k_fkey;  /* current file key*/
-	/* ostat: -2=immutable, -1=writer, 0=closed, 1+=reader count */
+	/* ostat: -2=immutable, -1=writer (or writer crashed), 0=closed */
+	/* (readers & live writer are tracked by locks, see btree/lock.c) */
 	INT32 k_ostat;
 } KEYFILE1;
 
@@ -94,6 +95,22 @@ typedef struct {
 #define KF2_NAME "LifeLines Keyfile"
 #define KF2_MAGIC 0x12345678
 #define KF2_VER 1
+/* version 2 allows block files of compressed records (see btree/compress.c);
+older programs refuse it, rather than misread them */
+#define KF2_VER_ZIP 2
+/* 4 added to either version allows name records split into parts
+(see gedlib/names.c), which older programs would misread too */
+#define KF2_VER_NAMES 4
+
+/*
+KEYFILE3 occurs directly after KEYFILE2, and holds the number of the
+version of the tree published by the writer (see btree/snapshot.c).
+It is silently added, like KEYFILE2; a keyfile without it is at
+version 0.
+*/
+typedef struct {
+	INT32 k_version; /* incremented each time a new master is published */
+} KEYFILE3;
 
 /*==============================================
  * INDEX -- Data structure for BTREE index files
@@ -139,20 +156,38 @@ typedef struct {
 	FKEY    b_nkey;      /* next index key */
 	FILE   *b_kfp;       /* keyfile file pointer */
 	KEYFILE1 b_kfile;    /* keyfile contents */
-	INT     b_ncache;    /* number of indices in cache */
-	INDEX  *b_cache;     /* index cache */
+	struct tag_btcache *b_cache; /* index cache */
 	BOOLEAN b_write;     /* database writeable? */
 	BOOLEAN b_immut;     /* database immutable? */
+	struct tag_btfdpool *b_fdpool; /* open block file descriptors */
+	INT     b_compact;   /* % dead space allowed in block files */
+	struct tag_btbulk *b_bulk; /* records buffered for bulk load */
+	struct tag_btjournal *b_journal; /* write-ahead journal */
+	KEYFILE3 b_kfile3;   /* keyfile version (of tree being read) */
+	int     b_lockfd;    /* lock file descriptor, or -1 */
+	struct tag_btsnap *b_snap; /* versions & freed files (writer only) */
+	INT32   b_kf2ver;    /* KEYFILE2 version (see KF2_VER_ZIP, KF2_VER_NAMES) */
+	BOOLEAN b_zip;       /* compress records of blocks written */
 } *BTREE, BTREESTRUCT;
 #define bbasedir(b) ((b)->b_basedir)
 #define bmaster(b)  ((b)->b_master)
 /* #define bnkey(b)    ((b)->b_nkey) */ /* UNUSED */
 #define bkfp(b)     ((b)->b_kfp)
 #define bkfile(b)   ((b)->b_kfile)
-#define bncache(b)  ((b)->b_ncache)
 #define bcache(b)   ((b)->b_cache)
 #define bwrite(b)   ((b)->b_write)
 #define bimmut(b)   ((b)->b_immut)
+#define bfdpool(b)  ((b)->b_fdpool)
+#define bcompact(b) ((b)->b_compact)
+#define bbulk(b)    ((b)->b_bulk)
+#define bjournal(b) ((b)->b_journal)
+#define bversion(b) ((b)->b_kfile3.k_version)
+#define blockfd(b)  ((b)->b_lockfd)
+#define bsnap(b)    ((b)->b_snap)
+#define bkf2ver(b)  ((b)->b_kf2ver)
+#define bkf2zip(b)   ((bkf2ver(b) & ~KF2_VER_NAMES) == KF2_VER_ZIP)
+#define bkf2names(b) ((bkf2ver(b) & KF2_VER_NAMES) != 0)
+#define bzip(b)     ((b)->b_zip)
 
 /*======================================================
  * BLOCK -- Data structure for BTREE record file headers
@@ -177,7 +212,7 @@ typedef struct {
 	FKEY   ix_self;             /*fkey of this block*/
 	INT16  ix_type;             /*block/file type*/
 #if __WORDSIZE != 16
-	INT16  ix_pad1;
+	INT16  ix_format;           /*BTFMTZIP if records compressed*/
 #endif
 	FKEY   ix_parent;           /*parent file's fkey*/
 	INT16  ix_nkeys;            /*num of keys in block*/
@@ -201,6 +236,29 @@ typedef struct {
 #define fkeys(p,i) ((p)->ix_fkeys[i])
 #define offs(p,i)  ((p)->ix_offs[i])
 #define lens(p,i)  ((p)->ix_lens[i])
+#if __WORDSIZE != 16
+#define blockformat(p)       ((p)->ix_format)
+#define setblockformat(p,f)  ((p)->ix_format = (f))
+#else
+/* no room in header, so records are never compressed */
+#define blockformat(p)       0
+#define setblockformat(p,f)  ((void)0)
+#endif
+/* value only trusted in a keyfile version which allows it, as the
+field was padding (& may be garbage) in blocks written before
+(bt_set_compress clears it in old blocks when it upgrades the keyfile) */
+#define blockzipped(b,p) (bkf2zip(b) && blockformat(p) == BTFMTZIP)
+
+/*============================================
+ * BTCACHESTATS -- Counters reported by index cache
+ *==========================================*/
+typedef struct {
+	INT capacity;   /* max INDEX/BLOCK headers cached */
+	INT count;      /* headers currently cached */
+	INT hits;       /* lookups found in cache */
+	INT misses;     /* lookups read from disk */
+	INT evictions;  /* headers dropped to make room */
+} BTCACHESTATS;
 
 /*============================================
  * Traversal function pointer typedefs
@@ -211,10 +269,32 @@ typedef BOOLEAN(*TRAV_BLOCK_FUNC)(BTREE, BLOCK, void*);
 typedef BOOLEAN(*TRAV_RECORD_FUNC_BYKEY)(RKEY, STRING, INT, void*);
 #define TRAV_RECORD_FUNC_BYKEY_ARGS(a,b,c,d) RKEY a, STRING b, INT c, void* d
 
+/*============================================
+ * BTCURSOR -- Position in key order of BTREE
+ *  records (see cursor.c)
+ *==========================================*/
+typedef struct tag_btcursor *BTCURSOR;
+
 /*====================================
  * BTREE library function declarations 
  *==================================*/
 
+/* bulk.c */
+BOOLEAN bt_bulk_begin(BTREE btree);
+BOOLEAN bt_bulk_end(BTREE btree);
+
+/* cursor.c */
+void bt_cursor_close(BTCURSOR cursor);
+BOOLEAN bt_cursor_next(BTCURSOR cursor, RKEY * prkey, RAWRECORD * prec, INT * plen);
+BTCURSOR bt_cursor_open(BTREE btree, BOOLEAN keysonly);
+BOOLEAN bt_cursor_prev(BTCURSOR cursor, RKEY * prkey, RAWRECORD * prec, INT * plen);
+void bt_cursor_seek(BTCURSOR cursor, const RKEY * rkey);
+void bt_cursor_seek_end(BTCURSOR cursor);
+
+/* fdpool.c */
+void bt_get_fdpool_stats(BTREE btree, INT * hits, INT * misses);
+void fdpool_invalidate(BTREE btree, FKEY fkey);
+
 /* file.c */
 BOOLEAN addfile(BTREE, RKEY, STRING file);
 BOOLEAN addtextfile(BTREE, RKEY, CNSTRING file, TRANSLFNC);
@@ -225,20 +305,40 @@ RECORD_STATUS write_record_to_textfile(BTREE btree, RKEY rkey, STRING file, TRAN
 BOOLEAN closebtree(BTREE);
 void describe_dberror(INT dberr, STRING buffer, INT buflen);
 BTREE bt_openbtree(STRING dir, BOOLEAN cflag, INT writ, BOOLEAN immut, INT *lldberr);
+BOOLEAN bt_set_compress(BTREE btree, BOOLEAN on);
+BOOLEAN bt_set_split_names(BTREE btree);
 BOOLEAN validate_keyfile2(KEYFILE2 * kfile2, INT *lldberr);
 
 /* index.c */
+void bt_get_index_cache_stats(BTREE btree, BTCACHESTATS * stats);
+void bt_set_index_cache_size(BTREE btree, INT n);
 void get_index_file(STRING path, INT len, BTREE btr, FKEY ikey);
 INDEX readindex(BTREE btr, FKEY ikey, BOOLEAN robust);
 
+/* journal.c */
+void bt_get_journal_stats(BTREE btree, INT * commits, INT * syncs);
+void bt_set_journal(BTREE btree, BOOLEAN on);
+
+/* lock.c */
+BOOLEAN bt_database_in_use(CNSTRING dir, INT *lldberr);
+
 /* names.c */
 
 /* btrec.c */
 BOOLEAN bt_addrecord(BTREE, RKEY, RAWRECORD, INT);
+INT bt_check_block_records(BTREE, BLOCK);
+INT bt_compact(BTREE, INT pct);
+void bt_compact_block(BTREE, BLOCK);
 RAWRECORD bt_getrecord(BTREE, const RKEY *, INT*);
+CNSTRING bt_getrecord_view(BTREE, const RKEY *, INT*);
 BOOLEAN isrecord(BTREE, RKEY);
+void bt_set_compact_threshold(BTREE, INT pct);
 INT cmpkeys(const RKEY * rk1, const RKEY * rk2);
 
+/* snapshot.c */
+BOOLEAN bt_begin_group(BTREE btree);
+BOOLEAN bt_commit_group(BTREE btree);
+
 /* traverse.c */
 BOOLEAN traverse_index_blocks(BTREE, INDEX, void *, TRAV_INDEX_FUNC ifunc, TRAV_BLOCK_FUNC dfunc);
 void traverse_db_rec_rkeys(BTREE, RKEY lo, RKEY hi, TRAV_RECORD_FUNC_BYKEY func, void *param);
@@ -282,6 +382,8 @@ STRING getlldberrstr (BTERR err);
 #define BTINDEXTYPE 1
 #define BTBLOCKTYPE 2
 
+#define BTFMTZIP 0x5a31 /* block records compressed (see btree/compress.c) */
+
 #define BTFLGCRT (1<<0)
 
 #endif
@@ -229,6 +229,7 @@ void addxref(CNSTRING key);
 void addxxref(INT key);
 BOOLEAN add_refn(CNSTRING refn, CNSTRING key);
 BOOLEAN are_locales_supported(void);
+NODE binary_to_node(CNSTRING buf, INT len);
 void change_node_tag(NODE node, STRING newtag);
 RECORD choose_child(RECORD irec, RECORD frec, STRING msg0, STRING msgn, ASK1Q ask1);
 void choose_and_remove_family(void);
@@ -276,6 +277,7 @@ NODE file_to_node(STRING, XLAT, STRING*, BOOLEAN*);
 INT file_to_line(FILE*, XLAT, INT*, STRING*, STRING*, STRING*, STRING*);
 NODE find_node(NODE, STRING, STRING, NODE*);
 NODE find_tag(NODE, CNSTRING);
+void forget_parsed_record(CNSTRING key);
 void free_node(NODE);
 void free_nodes(NODE);
 void free_temp_node_tree(NODE);
@@ -289,7 +291,9 @@ INT get_hexidecimal(STRING);
 STRING get_lifelines_version(INT maxlen);
 STRING get_original_locale_collate(void);
 STRING get_original_locale_msgs(void);
+void get_parsed_cache_stats(INT *size, INT *used, INT *hits);
 STRING get_property(STRING opt);
+void get_record_cache_stats(INT *size, INT *used, INT *hits, INT *misses, INT *evictions);
 void get_refns(STRING, INT*, STRING**, INT);
 STRING getexref(void);
 STRING getfxref(void);
@@ -386,6 +390,7 @@ void nkey_load_key(NKEY * nkey);
 BOOLEAN nkey_to_node(NKEY * nkey, NODE * node);
 BOOLEAN nkey_to_record(NKEY * nkey, RECORD * prec);
 NKEY nkey_zero(void);
+STRING node_to_binary(NODE root, INT *plen);
 void node_to_dbase(NODE, STRING);
 BOOLEAN node_to_file(INT, NODE, STRING, BOOLEAN, TRANTABLE);
 INT node_to_keynum(char ntype, NODE nod);
@@ -533,6 +538,9 @@ void set_gettext_codeset(CNSTRING domain, CNSTRING codeset);
 /* misc.c */
 INT xrefval(char ntype, STRING str);
 
+/* namegram.c */
+LIST find_indis_by_words(CNSTRING words);
+
 /* names.c */
 void add_name(CNSTRING name, CNSTRING key);
 LIST find_indis_by_name(CNSTRING name);
@@ -543,6 +551,7 @@ STRING manip_name(STRING name, SURCAPTYPE captype, SURORDER surorder, INT len);
 LIST name_to_list(CNSTRING name, INT *plen, INT *psind);
 STRING name_string(STRING);
 int namecmp(STRING, STRING);
+INT rebuild_names(void);
 void remove_name(STRING name, CNSTRING key);
 void traverse_names(TRAV_NAMES_FUNC func, void *param);
 STRING trim_name(STRING, INT);
@@ -613,6 +622,7 @@ INT xref_nextf(INT);
 INT xref_nexti(INT);
 INT xref_nexts(INT);
 INT xref_nextx(INT);
+INT xref_nth(char ntype, INT n);
 INT xref_prev(char ntype, INT i);
 INT xref_preve(INT);
 INT xref_prevf(INT);
@@ -13,8 +13,13 @@
 #ifndef ICVT_H_INCLUDED
 #define ICVT_H_INCLUDED 1
 
+typedef struct tag_icvt * ICVT;
+
 BOOLEAN iconv_trans(CNSTRING src, CNSTRING dest, CNSTRING sin, ZSTR zout, char illegal);
 BOOLEAN iconv_can_trans(CNSTRING src, CNSTRING dest);
+void icvt_close(ICVT * picvt);
+ICVT icvt_open(CNSTRING src, CNSTRING dest);
+BOOLEAN icvt_trans(ICVT icvt, CNSTRING sin, ZSTR zout, char illegal);
 void init_win32_iconv_shim(CNSTRING dllpath);
 
 #endif /* ICVT_H_INCLUDED */
@@ -96,6 +96,7 @@ struct tag_indiseq {
 	INT is_valtype;    /* int, string, pointer */
 	STRING is_locale;  /* used by namesort */
 	INDISEQ_VALUE_FNCTABLE is_valfnctbl;
+	struct tag_seqkeys * is_keys; /* counts of keys, for membership tests */
 };
 #ifndef INDISEQ_type_defined
 typedef struct tag_indiseq *INDISEQ;
@@ -111,6 +112,7 @@ typedef struct tag_indiseq *INDISEQ;
 #define IValtype(s)  ((s)->is_valtype)
 #define ILocale(s)   ((s)->is_locale)
 #define IValfnctbl(s) ((s)->is_valfnctbl)
+#define IKeys(s)     ((s)->is_keys)
 
 #define KEYSORT       (1<<0)
 #define NAMESORT      (1<<1)
@@ -200,6 +202,7 @@ void unique_indiseq(INDISEQ);
 INDISEQ union_indiseq(INDISEQ one, INDISEQ two);
 void update_browse_list(STRING, INDISEQ);
 void valuesort_indiseq(INDISEQ, BOOLEAN*);
+INDISEQ words_to_indiseq(STRING words);
 void write_family(STRING, TABLE);
 void write_nonlink_indi(NODE);
 
@@ -41,5 +41,6 @@ void shutdown_interpreter(void);
 ZSTR get_report_error_msg (STRING msg);
 
 extern BOOLEAN prog_trace;
+extern BOOLEAN prog_bytecode;
 
 #endif /* _INTERP_H */
@@ -60,6 +60,7 @@ typedef struct tag_pvalue *PVALUE;
 struct tag_pvalue {
         struct tag_vtable * vtable;
         unsigned char type;     /* type of value */
+        unsigned char imm;      /* immediate, held by caller (see evaluate_imm) */
 	PVALUE_DATA value;
 };
 
@@ -107,9 +108,11 @@ void eq_pvalues(PVALUE, PVALUE, BOOLEAN*eflg, ZSTR * zerr);
 
 /* PVALUE Functions */
 void bad_type_error(CNSTRING op, ZSTR *zerr, PVALUE val1, PVALUE val2);
+PVALUE box_pvalue(PVALUE val);
 void clear_pvalue(PVALUE val);
 void coerce_pvalue(INT, PVALUE, BOOLEAN*);
 PVALUE copy_pvalue(PVALUE);
+void count_saved_pvalues(INT n);
 PVALUE create_new_pvalue_list(void);
 PVALUE create_new_pvalue_table(void);
 PVALUE create_pvalue(INT type, PVALUE_DATA pvd);
@@ -148,6 +151,7 @@ BOOLEAN is_pvalue(PVALUE);
 BOOLEAN is_record_pvalue(PVALUE);
 BOOLEAN is_numeric_zero(PVALUE);
 void pvalues_begin(void);
+INT pvalues_saved(void);
 void pvalues_end(void);
 
 BOOLEAN pvalue_to_bool(PVALUE);
@@ -171,9 +175,11 @@ void show_pvalue(PVALUE);
 INT which_pvalue_type(PVALUE);
 
 PVALUE alloc_pvalue_memory(void);
+STRING alloc_pvalue_string(CNSTRING str);
 void check_pvalue_validity(PVALUE val);
 PVALUE create_new_pvalue(void);
 void free_pvalue_memory(PVALUE val);
+void free_pvalue_string(STRING str);
 void set_pvalue_node(PVALUE val, NODE node);
 INT pvalues_collate(PVALUE val1, PVALUE val2);
 void init_pvalue_vtable(PVALUE val);
@@ -82,6 +82,7 @@ ZSTR transl_get_predefined_name(INT trnum);
 ZSTR transl_get_description(XLAT xlat);
 XLAT transl_get_xlat(CNSTRING src, CNSTRING dest);
 XLAT transl_get_xlat_to_int(CNSTRING codeset);
+BOOLEAN transl_is_xlat_identity(XLAT xlat);
 BOOLEAN transl_is_xlat_valid(XLAT xlat);
 TRANTABLE transl_get_legacy_tt(INT trnum);
 void transl_load_all_tts(void);
@@ -24,6 +24,7 @@ TRANTABLE xl_get_legacy_tt(XLAT xlat);
 XLAT xl_get_null_xlat(void);
 INT xl_get_uparam(XLAT);
 XLAT xl_get_xlat(CNSTRING src, CNSTRING dest, BOOLEAN adhoc);
+BOOLEAN xl_is_xlat_identity(XLAT xlat);
 BOOLEAN xl_is_xlat_valid(XLAT xlat);
 void xl_load_all_dyntts(CNSTRING ttpath);
 void xl_parse_codeset(CNSTRING codeset, ZSTR zcsname, LIST * subcodes);
@@ -24,6 +24,7 @@ ZSTR zs_newvf(const char * fmt, va_list args);
 ZSTR zs_newsubs(const char * str, unsigned int len);
 void zs_free(ZSTR * pzstr);
 void zs_move(ZSTR zstr, ZSTR * pzsrc);
+void zs_swap(ZSTR zstr1, ZSTR zstr2);
 char * zs_str(ZCSTR);
 unsigned int zs_len(ZCSTR zstr);
 unsigned int zs_allocsize(ZCSTR zstr);
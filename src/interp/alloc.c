@@ -243,6 +243,9 @@ create_pnode (PACTX pactx, INT type)
 	irptinfo(node) = get_rptinfo(pactx->fullpath);
 	node->i_word1 = node->i_word2 = node->i_word3 = NULL;
 	node->i_word4 = node->i_word5 = NULL;
+	node->i_scope = NULL;
+	node->i_slot[0] = node->i_slot[1] = node->i_slot[2] = node->i_slot[3] = -1;
+	node->i_code = NULL;
 	return node;
 }
 /*========================================
@@ -252,6 +255,15 @@ create_pnode (PACTX pactx, INT type)
 static void
 clear_pnode (PNODE node)
 {
+	if (itype(node) == IPDEFN || itype(node) == IFDEFN) {
+		/* scope belongs to proc or func */
+		free_scope(node->i_scope);
+		node->i_scope = NULL;
+	}
+	if (node->i_code) {
+		free_bytecode(node->i_code);
+		node->i_code = NULL;
+	}
 	switch (itype(node)) {
 	case IICONS: clear_icons_node(node); return;
 	case IFCONS: clear_fcons_node(node); return;
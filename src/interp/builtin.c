@@ -104,7 +104,7 @@ llrpt_getint (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		*eflg = TRUE;
 		return NULL;
 	}
-	assign_iden(stab, iident_name(argvar), create_pvalue_from_int(num));
+	assign_iden(stab, argvar, create_pvalue_from_int(num));
 	delete_pvalue(val);
 	return NULL;
 }
@@ -139,7 +139,7 @@ llrpt_getstr (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		buffer[0]=0;
 	}
 	ansval = create_pvalue_from_string(buffer);
-	assign_iden(stab, iident_name(argvar), ansval);
+	assign_iden(stab, argvar, ansval);
 	delete_pvalue(val);
 	return NULL;
 }
@@ -170,11 +170,10 @@ llrpt_getindi (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	}
 	if (!msg)
 		msg = _("Identify person for program:");
-	assign_iden(stab, iident_name(argvar), create_pvalue_from_indi(NULL));
+	assign_iden(stab, argvar, create_pvalue_from_indi(NULL));
 	key = rptui_ask_for_indi_key(msg, DOASK1);
 	if (key) {
-		assign_iden(stab, iident_name(argvar)
-			, create_pvalue_from_indi_key(key));
+		assign_iden(stab, argvar, create_pvalue_from_indi_key(key));
 	}
 	delete_pvalue_ptr(&val);
 	return NULL;
@@ -193,10 +192,10 @@ llrpt_getfam (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		*eflg = TRUE;
 		return NULL;
 	}
-	assign_iden(stab, iident_name(argvar), NULL);
+	assign_iden(stab, argvar, NULL);
 	fam = nztop(rptui_ask_for_fam(_("Enter a spouse from family."),
 	    _("Enter a sibling from family.")));
-	assign_iden(stab, iident_name(argvar), create_pvalue_from_fam(fam));
+	assign_iden(stab, argvar, create_pvalue_from_fam(fam));
 	return NULL;
 }
 /*=================================================+
@@ -233,7 +232,7 @@ llrpt_getindiset (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	if (seq)
 		namesort_indiseq(seq); /* in case uilocale != rptlocale */
 	delete_pvalue_ptr(&val);
-	assign_iden(stab, iident_name(argvar), create_pvalue_from_seq(seq));
+	assign_iden(stab, argvar, create_pvalue_from_seq(seq));
 	return NULL;
 }
 /*==================================+
@@ -678,7 +677,7 @@ llrpt_set (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		}
 		return NULL;
 	}
-	assign_iden(stab, iident_name(argvar), val);
+	assign_iden(stab, argvar, val);
 	return NULL;
 }
 /*===========================================+
@@ -715,7 +714,7 @@ llrpt_setdate (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	chil = create_temp_node(NULL, "DATE", str, prnt);
 	nchild(prnt) = chil;
 	/* Assign new EVEN node to new pvalue, and assign that to specified identifier */
-	assign_iden(stab, iident_name(argvar), create_pvalue_from_node(prnt));
+	assign_iden(stab, argvar, create_pvalue_from_node(prnt));
 	return NULL;
 }
 /*=========================================+
@@ -1323,13 +1322,14 @@ PVALUE
 llrpt_eq (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2=0, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2=0, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "eq", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "eq", "2");
 		return NULL;
@@ -1340,7 +1340,7 @@ llrpt_eq (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*=============================+
  * llrpt_ne -- Not equal operation
@@ -1350,13 +1350,14 @@ PVALUE
 llrpt_ne (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "ne", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "ne", "2");
 		return NULL;
@@ -1367,7 +1368,7 @@ llrpt_ne (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*===============================+
  * llrpt_le -- Less or equal operation
@@ -1377,13 +1378,14 @@ PVALUE
 llrpt_le (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "le", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "le", "2");
 		return NULL;
@@ -1394,7 +1396,7 @@ llrpt_le (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*==================================+
  * llrpt_ge -- Greater or equal operation
@@ -1404,13 +1406,14 @@ PVALUE
 llrpt_ge (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "ge", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "le", "2");
 		return NULL;
@@ -1421,7 +1424,7 @@ llrpt_ge (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*============================+
  * llrpt_lt -- Less than operation
@@ -1431,13 +1434,14 @@ PVALUE
 llrpt_lt (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "lt", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "lt", "2");
 		return NULL;
@@ -1448,7 +1452,7 @@ llrpt_lt (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*==============================+
  * llrpt_gt -- Greater than operation
@@ -1458,13 +1462,14 @@ PVALUE
 llrpt_gt (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "gt", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "gt", "2");
 		return NULL;
@@ -1475,7 +1480,7 @@ llrpt_gt (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*=================================+
  * llrpt_and -- And operation
@@ -1551,7 +1556,8 @@ PVALUE
 llrpt_add (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	INT argix=1; /* count arguments for error message */
 	if (*eflg) {
@@ -1560,7 +1566,7 @@ llrpt_add (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	}
 	while ((argvar = inext(argvar))) {
 		++argix;
-		val2 = evaluate(argvar, stab, eflg);
+		val2 = evaluate_imm(argvar, stab, &imm2, eflg);
 		if (*eflg) {
 			char numstr[33];
 			snprintf(numstr, sizeof(numstr), FMT_INT, argix);
@@ -1574,7 +1580,7 @@ llrpt_add (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 			return NULL;
 		}
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*=============================+
  * llrpt_sub -- Subtract operation
@@ -1584,13 +1590,14 @@ PVALUE
 llrpt_sub (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "sub", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "sub", 2);
 		return NULL;
@@ -1601,7 +1608,7 @@ llrpt_sub (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*================================+
  * llrpt_mul -- Multiply operation
@@ -1611,7 +1618,8 @@ PVALUE
 llrpt_mul (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	INT iarg=1;
 	if (*eflg) {
@@ -1620,7 +1628,7 @@ llrpt_mul (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	}
 	while ((argvar = inext(argvar))) {
 		++iarg;
-		val2 = evaluate(argvar, stab, eflg);
+		val2 = evaluate_imm(argvar, stab, &imm2, eflg);
 		if (*eflg) {
 			char numstr[33];
 			snprintf(numstr, sizeof(numstr), FMT_INT, iarg);
@@ -1634,7 +1642,7 @@ llrpt_mul (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 			return NULL;
 		}
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*=============================+
  * llrpt_div -- Divide operation
@@ -1644,13 +1652,14 @@ PVALUE
 llrpt_div (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "div", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "div", 2);
 		return NULL;
@@ -1661,7 +1670,7 @@ llrpt_div (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*=============================+
  * llrpt_mod -- Modulus operation
@@ -1671,13 +1680,14 @@ PVALUE
 llrpt_mod (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "mod", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "mod", 2);
 		return NULL;
@@ -1688,7 +1698,7 @@ llrpt_mod (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*=================================+
  * llrpt_exp -- Exponentiation operation
@@ -1698,13 +1708,14 @@ PVALUE
 llrpt_exp (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val2, val1 = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm1, imm2;
+	PVALUE val2, val1 = evaluate_imm(argvar, stab, &imm1, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val1, badargx, "sub", "1");
 		return NULL;
 	}
-	val2 = evaluate(argvar=inext(argvar), stab, eflg);
+	val2 = evaluate_imm(argvar=inext(argvar), stab, &imm2, eflg);
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val2, badargx, "sub", 2);
 		return NULL;
@@ -1715,7 +1726,7 @@ llrpt_exp (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val1;
+	return box_pvalue(val1);
 }
 /*===========================+
  * llrpt_neg -- Negation operation
@@ -1725,7 +1736,8 @@ PVALUE
 llrpt_neg (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	PNODE argvar = builtin_args(node);
-	PVALUE val = evaluate(argvar, stab, eflg);
+	struct tag_pvalue imm;
+	PVALUE val = evaluate_imm(argvar, stab, &imm, eflg);
 	ZSTR zerr=0;
 	if (*eflg) {
 		prog_var_error(node, stab, argvar, val, badarg1, "neg");
@@ -1738,7 +1750,7 @@ llrpt_neg (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	return val;
+	return box_pvalue(val);
 }
 /*===========================+
  * llrpt_incr -- Increment variable
@@ -1750,21 +1762,30 @@ llrpt_incr (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	PNODE argvar = builtin_args(node);
 	PNODE argvar2=0;
 	PVALUE val=0;
+	struct tag_pvalue imm2;
+	BOOLEAN inplace = FALSE;
 	ZSTR zerr=0;
 	if (!iistype(argvar, IIDENT)) {
 		*eflg = TRUE;
 		prog_error(node, "%s", "arg to incr must be a variable");
 		return NULL;
 	}
-	val = evaluate(argvar, stab, eflg);
-	if (*eflg || !val) {
-		*eflg = TRUE;
-		prog_var_error(node, stab, argvar, val, badarg1, "incr");
-		return NULL;
+	val = iden_value(stab, argvar);
+	if (!prog_trace && val && (ptype(val) == PINT || ptype(val) == PFLOAT)) {
+		/* number is changed where it is, not copied */
+		inplace = TRUE;
+		count_saved_pvalues(1);
+	} else {
+		val = evaluate(argvar, stab, eflg);
+		if (*eflg || !val) {
+			*eflg = TRUE;
+			prog_var_error(node, stab, argvar, val, badarg1, "incr");
+			return NULL;
+		}
 	}
 
 	if ((argvar2 = inext(argvar))) {
-		PVALUE val2 = evaluate(argvar2, stab, eflg);
+		PVALUE val2 = evaluate_imm(argvar2, stab, &imm2, eflg);
 		if (*eflg) {
 			prog_var_error(node, stab, argvar2, val2, badargx, "incr", "2");
 			return NULL;
@@ -1778,7 +1799,8 @@ llrpt_incr (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	assign_iden(stab, iident_name(argvar), val);
+	if (!inplace)
+		assign_iden(stab, argvar, val);
 	return NULL;
 }
 /*============================+
@@ -1791,20 +1813,29 @@ llrpt_decr (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	PNODE argvar = builtin_args(node);
 	PNODE argvar2=0;
 	PVALUE val=0;
+	struct tag_pvalue imm2;
+	BOOLEAN inplace = FALSE;
 	ZSTR zerr=0;
 	if (!iistype(argvar, IIDENT)) {
 		*eflg = TRUE;
 		prog_error(node, "%s", "arg to decr must be a variable");
 		return NULL;
 	}
-	val = evaluate(argvar, stab, eflg);
-	if (*eflg || !val) {
-		*eflg = TRUE;
-		prog_var_error(node, stab, argvar, val, badarg1, "decr");
-		return NULL;
+	val = iden_value(stab, argvar);
+	if (!prog_trace && val && (ptype(val) == PINT || ptype(val) == PFLOAT)) {
+		/* number is changed where it is, not copied */
+		inplace = TRUE;
+		count_saved_pvalues(1);
+	} else {
+		val = evaluate(argvar, stab, eflg);
+		if (*eflg || !val) {
+			*eflg = TRUE;
+			prog_var_error(node, stab, argvar, val, badarg1, "decr");
+			return NULL;
+		}
 	}
 	if ((argvar2 = inext(argvar))) {
-		PVALUE val2 = evaluate(argvar2, stab, eflg);
+		PVALUE val2 = evaluate_imm(argvar2, stab, &imm2, eflg);
 		if (*eflg) {
 			prog_var_error(node, stab, argvar2, val2, badargx, "decr", "2");
 			return NULL;
@@ -1818,7 +1849,8 @@ llrpt_decr (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		zs_free(&zerr);
 		return NULL;
 	}
-	assign_iden(stab, iident_name(argvar), val);
+	if (!inplace)
+		assign_iden(stab, argvar, val);
 	return NULL;
 }
 /*======================================+
@@ -2425,7 +2457,7 @@ llrpt_table (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	}
 	newval = create_new_pvalue_table();
 
-	assign_iden(stab, iident_name(argvar), newval);
+	assign_iden(stab, argvar, newval);
 	return NULL;
 }
 /*=========================================+
@@ -2870,9 +2902,9 @@ llrpt_extractdate (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	mo = date_get_month(gdv);
 	yr = date_get_year(gdv);
 	yr = normalize_year(yr);
-	assign_iden(stab, iident_name(dvar), create_pvalue_from_int(da));
-	assign_iden(stab, iident_name(mvar), create_pvalue_from_int(mo));
-	assign_iden(stab, iident_name(yvar), create_pvalue_from_int(yr));
+	assign_iden(stab, dvar, create_pvalue_from_int(da));
+	assign_iden(stab, mvar, create_pvalue_from_int(mo));
+	assign_iden(stab, yvar, create_pvalue_from_int(yr));
 	free_gdateval(gdv);
 	*eflg = FALSE;
 	return NULL;
@@ -2940,11 +2972,11 @@ llrpt_extractdatestr (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	yr = normalize_year(yr);
 	yrstr = date_get_year_string(gdv);
 	if (!yrstr) yrstr="";
-	assign_iden(stab, iident_name(modvar), create_pvalue_from_int(mod));
-	assign_iden(stab, iident_name(dvar), create_pvalue_from_int(da));
-	assign_iden(stab, iident_name(mvar), create_pvalue_from_int(mo));
-	assign_iden(stab, iident_name(yvar), create_pvalue_from_int(yr));
-	assign_iden(stab, iident_name(ystvar), create_pvalue_from_string(yrstr));
+	assign_iden(stab, modvar, create_pvalue_from_int(mod));
+	assign_iden(stab, dvar, create_pvalue_from_int(da));
+	assign_iden(stab, mvar, create_pvalue_from_int(mo));
+	assign_iden(stab, yvar, create_pvalue_from_int(yr));
+	assign_iden(stab, ystvar, create_pvalue_from_string(yrstr));
 	free_gdateval(gdv);
 	return NULL;
 }
@@ -80,7 +80,7 @@ llrpt_list (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 
 	newval = create_new_pvalue_list();
 
-	assign_iden(stab, iident_name(argvar), newval);
+	assign_iden(stab, argvar, newval);
 	return NULL;
 }
 /*=======================================+
@@ -0,0 +1,1009 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=============================================================
+ * compile.c -- Compile report programs to code for a stack
+ *  machine, & run it (instead of interpret(), if prog_bytecode)
+ *  Each list of statements (body of proc, func, loop, or if)
+ *  is compiled the first time it is run.
+ *  Integers & booleans are kept on the stack as they are, not
+ *  in PVALUEs, so arithmetic, comparisons, set, incr & decr
+ *  of them allocate nothing; other values are PVALUEs.
+ *  Variables stay in the symbol tables (see symtab.c), so that
+ *  whatever is not compiled -- loops over records, calls of
+ *  procs, funcs & other builtins -- is run just as interpret()
+ *  runs it, by the tree walker & the builtins table.
+ *===========================================================*/
+
+#include "llstdlib.h"
+#include "table.h"
+#include "translat.h"
+#include "gedcom.h"
+#include "cache.h"
+#include "interpi.h"
+#include "liflines.h"
+#include "feedback.h"
+#include "lloptions.h"
+#include "zstr.h"
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* value on stack of machine */
+typedef struct tag_vmval {
+	INT type; /* PINT, PBOOL, PNULL (held here), or VBOXED */
+	union {
+		INT ival;
+		BOOLEAN bval;
+		PVALUE pval; /* VBOXED (0 if no value) */
+	} v;
+} VMVAL;
+#define VBOXED 0
+
+/* instruction */
+typedef struct tag_vmins {
+	INT op;     /* VO_* */
+	PNODE node; /* node compiled (for errors) */
+	INT arg;    /* constant, jump target, or VA_* */
+} VMINS;
+
+/* messages to give if error occurs within code of argument */
+typedef struct tag_vmcatch {
+	INT start;  /* first instruction of argument */
+	INT end;    /* after last */
+	INT kind;   /* VC_* */
+	PNODE node; /* builtin call, condition, or return */
+	PNODE arg;  /* argument */
+	CNSTRING name;
+	INT argix;
+} VMCATCH;
+
+struct tag_vmcode {
+	VMINS *ins;
+	INT nins;
+	INT maxins;
+	VMCATCH *catches; /* inner before outer */
+	INT ncatch;
+	INT maxcatch;
+	INT maxdepth;     /* most values on stack */
+};
+
+/* state of compiler */
+typedef struct tag_vmcomp {
+	VMCODE code;
+	INT depth;   /* values on stack here */
+	BOOLEAN inloop; /* in compiled while ? */
+	INT top;     /* start of while */
+	INT breaks;  /* chain of jumps out of while */
+} VMCOMP;
+
+/* instructions (& effect on depth of stack) */
+enum {
+	VO_STMT      /*  0 interp_statement(node) */
+	, VO_PUSHI   /* +1 integer arg */
+	, VO_PUSHK   /* +1 copy of constant node */
+	, VO_PUSHN   /* +1 no value */
+	, VO_LOAD    /* +1 value of variable node */
+	, VO_STORE   /* -1 into variable, first arg of builtin node */
+	, VO_BCALL   /* +1 builtin node, as evaluate_func() */
+	, VO_UCALL   /* +1 func node, as evaluate_ufunc() */
+	, VO_EVAL    /* +1 node, as evaluate() */
+	, VO_ARITH   /* -1 arithmetic VA_* of top two */
+	, VO_CMP     /* -1 comparison VA_* of top two */
+	, VO_NEG     /*  0 */
+	, VO_STEP    /*  0 add arg (+1 or -1) */
+	, VO_BOOL    /*  0 to boolean */
+	, VO_NOT     /*  0 */
+	, VO_COND    /*  0 condition node (with variable) to boolean */
+	, VO_JMP     /*  0 to arg */
+	, VO_JFALSE  /* -1 to arg if false */
+	, VO_JFALSEK /*  0 to arg if false (keeping it) */
+	, VO_JTRUEK  /*  0 to arg if true (keeping it) */
+	, VO_POP     /* -1 */
+	, VO_OUT     /* -1 output if string (statement of call) */
+	, VO_RET     /*  0 return arg (INTOKAY, etc) */
+	, VO_RETV    /* -1 return value */
+};
+static INT vo_depth[] = { 0, 1, 1, 1, 1, -1, 1, 1, 1, -1, -1, 0, 0, 0, 0, 0
+	, 0, -1, 0, 0, -1, -1, 0, -1 };
+
+/* operations of VO_ARITH & VO_CMP */
+enum { VA_ADD, VA_SUB, VA_MUL, VA_DIV, VA_MOD
+	, VA_EQ, VA_NE, VA_LT, VA_LE, VA_GT, VA_GE };
+
+/* kinds of catch */
+enum {
+	VC_ARGX      /* arg of builtin had error */
+	, VC_ARG1    /* only arg of builtin had error */
+	, VC_BOOX    /* arg of and/or not boolean */
+	, VC_NOT     /* arg of not not boolean */
+	, VC_COND    /* error in condition of if/while */
+	, VC_RETURN  /* error in return value (returns none) */
+};
+
+/* builtins compiled */
+static struct {
+	PFUNC func;
+	INT op;   /* VO_ARITH, VO_CMP, etc */
+	INT arg;
+	CNSTRING name;
+} vmbuiltins[] = {
+	{ llrpt_add, VO_ARITH, VA_ADD, "add" }
+	, { llrpt_sub, VO_ARITH, VA_SUB, "sub" }
+	, { llrpt_mul, VO_ARITH, VA_MUL, "mul" }
+	, { llrpt_div, VO_ARITH, VA_DIV, "div" }
+	, { llrpt_mod, VO_ARITH, VA_MOD, "mod" }
+	, { llrpt_eq, VO_CMP, VA_EQ, "eq" }
+	, { llrpt_ne, VO_CMP, VA_NE, "ne" }
+	, { llrpt_lt, VO_CMP, VA_LT, "lt" }
+	, { llrpt_le, VO_CMP, VA_LE, "le" }
+	, { llrpt_gt, VO_CMP, VA_GT, "gt" }
+	, { llrpt_ge, VO_CMP, VA_GE, "ge" }
+	, { llrpt_neg, VO_NEG, 0, "neg" }
+	, { llrpt_not, VO_NOT, 0, "not" }
+	, { llrpt_and, VO_JFALSEK, 0, "and" }
+	, { llrpt_or, VO_JTRUEK, 0, "or" }
+	, { llrpt_set, VO_STORE, 0, "set" }
+	, { llrpt_incr, VO_STEP, 1, "incr" }
+	, { llrpt_decr, VO_STEP, -1, "decr" }
+};
+
+#define VMSTACK 32 /* stack of machine held locally */
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static void add_catch(VMCOMP *cc, INT start, INT kind, PNODE node, PNODE arg, CNSTRING name, INT argix);
+static BOOLEAN compile_assign(VMCOMP *cc, PNODE node);
+static void compile_builtin(VMCOMP *cc, PNODE node);
+static BOOLEAN compile_cond(VMCOMP *cc, PNODE node);
+static void compile_expr(VMCOMP *cc, PNODE node);
+static void compile_list(VMCOMP *cc, PNODE node);
+static void compile_stmt(VMCOMP *cc, PNODE node);
+static INT emit(VMCOMP *cc, INT op, PNODE node, INT arg);
+static INT find_vmbuiltin(PNODE node);
+static void patch_chain(VMCOMP *cc, INT chain, INT target);
+static void push_pvalue(VMVAL *val, PVALUE pval);
+static void report_catch(VMCATCH *vc, SYMTAB stab);
+static INTERPTYPE run_code(VMCODE code, SYMTAB stab, PVALUE *pval);
+static BOOLEAN slow_arith(VMINS *ins, VMVAL *a, VMVAL *b);
+static BOOLEAN slow_unary(VMINS *ins, VMVAL *a);
+static void store_value(SYMTAB stab, PNODE var, VMVAL *val);
+static PVALUE take_pvalue(VMVAL *val);
+static BOOLEAN to_bool(VMVAL *val);
+
+/*********************************************
+ * local & exported variables
+ *********************************************/
+
+BOOLEAN prog_bytecode = FALSE; /* compile reports (llexec -B) */
+extern BOOLEAN explicitvars;
+extern PNODE Pnode;
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*======================================================
+ * run_bytecode -- Run statement list, compiling it
+ *  the first time
+ *  node:  [I/O] first statement of list
+ *  stab:  [I/O] current symbol table
+ *  pval:  [OUT] return value, if any
+ *====================================================*/
+INTERPTYPE
+run_bytecode (PNODE node, SYMTAB stab, PVALUE *pval)
+{
+	VMCOMP comp;
+	*pval = NULL;
+	if (!node)
+		return INTOKAY;
+	if (!node->i_code) {
+		memset(&comp, 0, sizeof(comp));
+		comp.code = (VMCODE)stdalloc(sizeof(*comp.code));
+		memset(comp.code, 0, sizeof(*comp.code));
+		compile_list(&comp, node);
+		emit(&comp, VO_RET, node, INTOKAY);
+		node->i_code = comp.code;
+	}
+	return run_code(node->i_code, stab, pval);
+}
+/*======================================================
+ * free_bytecode -- Free code compiled for statement list
+ *====================================================*/
+void
+free_bytecode (VMCODE code)
+{
+	if (!code) return;
+	if (code->ins)
+		stdfree(code->ins);
+	if (code->catches)
+		stdfree(code->catches);
+	stdfree(code);
+}
+/*======================================================
+ * emit -- Append instruction
+ * returns its index
+ *====================================================*/
+static INT
+emit (VMCOMP *cc, INT op, PNODE node, INT arg)
+{
+	VMCODE code = cc->code;
+	VMINS *ins;
+	if (code->nins == code->maxins) {
+		VMINS *newins;
+		code->maxins = code->maxins ? 2*code->maxins : 32;
+		newins = (VMINS *)stdalloc(code->maxins * sizeof(VMINS));
+		if (code->nins) {
+			memcpy(newins, code->ins, code->nins * sizeof(VMINS));
+			stdfree(code->ins);
+		}
+		code->ins = newins;
+	}
+	ins = &code->ins[code->nins];
+	ins->op = op;
+	ins->node = node;
+	ins->arg = arg;
+	cc->depth += vo_depth[op];
+	if (cc->depth > code->maxdepth)
+		code->maxdepth = cc->depth;
+	return code->nins++;
+}
+/*======================================================
+ * add_catch -- Note messages for error in code from start
+ *  to here
+ *====================================================*/
+static void
+add_catch (VMCOMP *cc, INT start, INT kind, PNODE node, PNODE arg
+	, CNSTRING name, INT argix)
+{
+	VMCODE code = cc->code;
+	VMCATCH *vc;
+	if (code->ncatch == code->maxcatch) {
+		VMCATCH *newcatches;
+		code->maxcatch = code->maxcatch ? 2*code->maxcatch : 8;
+		newcatches = (VMCATCH *)stdalloc(code->maxcatch * sizeof(VMCATCH));
+		if (code->ncatch) {
+			memcpy(newcatches, code->catches, code->ncatch * sizeof(VMCATCH));
+			stdfree(code->catches);
+		}
+		code->catches = newcatches;
+	}
+	vc = &code->catches[code->ncatch++];
+	vc->start = start;
+	vc->end = code->nins;
+	vc->kind = kind;
+	vc->node = node;
+	vc->arg = arg;
+	vc->name = name;
+	vc->argix = argix;
+}
+/*======================================================
+ * patch_chain -- Point chain of jumps at target
+ *  (each jump's arg is the previous, until -1)
+ *====================================================*/
+static void
+patch_chain (VMCOMP *cc, INT chain, INT target)
+{
+	while (chain >= 0) {
+		INT prev = cc->code->ins[chain].arg;
+		cc->code->ins[chain].arg = target;
+		chain = prev;
+	}
+}
+/*======================================================
+ * compile_list -- Compile list of statements
+ *====================================================*/
+static void
+compile_list (VMCOMP *cc, PNODE node)
+{
+	for ( ; node; node = inext(node))
+		compile_stmt(cc, node);
+}
+/*======================================================
+ * compile_stmt -- Compile statement
+ *  (as call to interp_statement, if not compiled)
+ *====================================================*/
+static void
+compile_stmt (VMCOMP *cc, PNODE node)
+{
+	INT start, jump, jump2;
+	BOOLEAN inloop;
+	INT top, breaks;
+
+	switch (itype(node)) {
+	case IIF:
+		if (!compile_cond(cc, node->vars.iif.icond))
+			break;
+		jump = emit(cc, VO_JFALSE, node, -1);
+		compile_list(cc, node->vars.iif.ithen);
+		if (node->vars.iif.ielse) {
+			jump2 = emit(cc, VO_JMP, node, -1);
+			patch_chain(cc, jump, cc->code->nins);
+			compile_list(cc, node->vars.iif.ielse);
+			patch_chain(cc, jump2, cc->code->nins);
+		} else {
+			patch_chain(cc, jump, cc->code->nins);
+		}
+		return;
+	case IWHILE:
+		start = cc->code->nins;
+		if (!compile_cond(cc, node->vars.iwhile.icond))
+			break;
+		jump = emit(cc, VO_JFALSE, node, -1);
+		inloop = cc->inloop;
+		top = cc->top;
+		breaks = cc->breaks;
+		cc->inloop = TRUE;
+		cc->top = start;
+		cc->breaks = -1;
+		compile_list(cc, node->vars.iwhile.ibody);
+		emit(cc, VO_JMP, node, start);
+		patch_chain(cc, jump, cc->code->nins);
+		patch_chain(cc, cc->breaks, cc->code->nins);
+		cc->inloop = inloop;
+		cc->top = top;
+		cc->breaks = breaks;
+		return;
+	case IBREAK:
+		if (cc->inloop)
+			cc->breaks = emit(cc, VO_JMP, node, cc->breaks);
+		else
+			emit(cc, VO_RET, node, INTBREAK);
+		return;
+	case ICONTINUE:
+		if (cc->inloop)
+			emit(cc, VO_JMP, node, cc->top);
+		else
+			emit(cc, VO_RET, node, INTCONTINUE);
+		return;
+	case IRETURN:
+		if (!iargs(node)) {
+			emit(cc, VO_RET, node, INTRETURN);
+			return;
+		}
+		start = cc->code->nins;
+		compile_expr(cc, (PNODE)iargs(node));
+		add_catch(cc, start, VC_RETURN, node, NULL, NULL, 0);
+		emit(cc, VO_RETV, node, 0);
+		return;
+	case IBCALL:
+		if (compile_assign(cc, node))
+			return;
+		/* fall through */
+	case IFCALL:
+		compile_expr(cc, node);
+		emit(cc, VO_OUT, node, 0);
+		return;
+	}
+	emit(cc, VO_STMT, node, 0);
+}
+/*======================================================
+ * compile_cond -- Compile condition of if or while
+ *  to boolean (setting its variable, if it has one)
+ * returns FALSE (& compiles nothing) if not compilable
+ *====================================================*/
+static BOOLEAN
+compile_cond (VMCOMP *cc, PNODE node)
+{
+	INT start = cc->code->nins;
+	PNODE expr = inext(node) ? inext(node) : node;
+	if (expr != node && !iistype(node, IIDENT))
+		return FALSE; /* leave error to interpret() */
+	compile_expr(cc, expr);
+	emit(cc, VO_COND, node, 0);
+	add_catch(cc, start, VC_COND, node, NULL, NULL, 0);
+	return TRUE;
+}
+/*======================================================
+ * compile_assign -- Compile set, incr or decr statement
+ * returns FALSE if not one of them
+ *====================================================*/
+static BOOLEAN
+compile_assign (VMCOMP *cc, PNODE node)
+{
+	INT i = find_vmbuiltin(node), start;
+	PNODE var = builtin_args(node), arg2 = var ? inext(var) : NULL;
+	if (i < 0 || !var || !iistype(var, IIDENT))
+		return FALSE;
+	switch (vmbuiltins[i].op) {
+	case VO_STORE:
+		start = cc->code->nins;
+		compile_expr(cc, arg2);
+		add_catch(cc, start, VC_ARGX, node, arg2, vmbuiltins[i].name, 2);
+		break;
+	case VO_STEP:
+		start = cc->code->nins;
+		emit(cc, VO_LOAD, var, 0);
+		add_catch(cc, start, VC_ARG1, node, var, vmbuiltins[i].name, 1);
+		if (arg2) {
+			start = cc->code->nins;
+			compile_expr(cc, arg2);
+			add_catch(cc, start, VC_ARGX, node, arg2, vmbuiltins[i].name, 2);
+			emit(cc, VO_ARITH, node, vmbuiltins[i].arg > 0 ? VA_ADD : VA_SUB);
+		} else {
+			emit(cc, VO_STEP, node, vmbuiltins[i].arg);
+		}
+		break;
+	default:
+		return FALSE;
+	}
+	emit(cc, VO_STORE, node, 0);
+	return TRUE;
+}
+/*======================================================
+ * compile_expr -- Compile expression, to leave its value
+ *  on stack
+ *====================================================*/
+static void
+compile_expr (VMCOMP *cc, PNODE node)
+{
+	switch (itype(node)) {
+	case IICONS:
+		emit(cc, VO_PUSHI, node, pvalue_to_int(node->vars.iicons.value));
+		return;
+	case ISCONS:
+	case IFCONS:
+		emit(cc, VO_PUSHK, node, 0);
+		return;
+	case IIDENT:
+		emit(cc, VO_LOAD, node, 0);
+		return;
+	case IBCALL:
+		compile_builtin(cc, node);
+		return;
+	case IFCALL:
+		emit(cc, VO_UCALL, node, 0);
+		return;
+	}
+	emit(cc, VO_EVAL, node, 0);
+}
+/*======================================================
+ * find_vmbuiltin -- Is builtin call one compiled ?
+ * returns its index in vmbuiltins, or -1
+ *====================================================*/
+static INT
+find_vmbuiltin (PNODE node)
+{
+	INT i;
+	for (i = 0; i < ARRSIZE(vmbuiltins); i++) {
+		if (ifunc(node) == vmbuiltins[i].func)
+			return i;
+	}
+	return -1;
+}
+/*======================================================
+ * compile_builtin -- Compile call of builtin
+ *  (as call through builtins table, if not compiled)
+ *====================================================*/
+static void
+compile_builtin (VMCOMP *cc, PNODE node)
+{
+	INT i = find_vmbuiltin(node), argix, start, chain = -1;
+	PNODE arg = builtin_args(node);
+	CNSTRING name;
+
+	if (i < 0 || !arg) {
+		emit(cc, VO_BCALL, node, 0);
+		return;
+	}
+	name = vmbuiltins[i].name;
+	switch (vmbuiltins[i].op) {
+	case VO_ARITH:
+	case VO_CMP:
+		for (argix = 1; arg; arg = inext(arg), ++argix) {
+			start = cc->code->nins;
+			compile_expr(cc, arg);
+			add_catch(cc, start, VC_ARGX, node, arg, name, argix);
+			if (argix > 1)
+				emit(cc, vmbuiltins[i].op, node, vmbuiltins[i].arg);
+		}
+		return;
+	case VO_NEG:
+		start = cc->code->nins;
+		compile_expr(cc, arg);
+		add_catch(cc, start, VC_ARG1, node, arg, name, 1);
+		emit(cc, VO_NEG, node, 0);
+		return;
+	case VO_NOT:
+		start = cc->code->nins;
+		compile_expr(cc, arg);
+		emit(cc, VO_BOOL, node, 0);
+		add_catch(cc, start, VC_NOT, node, arg, name, 1);
+		emit(cc, VO_NOT, node, 0);
+		return;
+	case VO_JFALSEK:
+	case VO_JTRUEK:
+		/* and & or stop at first arg to decide */
+		for (argix = 1; arg; arg = inext(arg), ++argix) {
+			start = cc->code->nins;
+			compile_expr(cc, arg);
+			emit(cc, VO_BOOL, node, 0);
+			add_catch(cc, start, VC_BOOX, node, arg, name, argix);
+			if (inext(arg)) {
+				chain = emit(cc, vmbuiltins[i].op, node, chain);
+				emit(cc, VO_POP, node, 0);
+			}
+		}
+		patch_chain(cc, chain, cc->code->nins);
+		return;
+	}
+	/* set, incr, decr (value is none) */
+	if (compile_assign(cc, node)) {
+		emit(cc, VO_PUSHN, node, 0);
+		return;
+	}
+	emit(cc, VO_BCALL, node, 0);
+}
+/*======================================================
+ * push_pvalue -- Put value on stack
+ *  (integer or boolean as is, freeing its PVALUE)
+ *====================================================*/
+static void
+push_pvalue (VMVAL *val, PVALUE pval)
+{
+	if (pval && ptype(pval) == PINT) {
+		val->type = PINT;
+		val->v.ival = pvalue_to_int(pval);
+		delete_pvalue(pval);
+	} else if (pval && ptype(pval) == PBOOL) {
+		val->type = PBOOL;
+		val->v.bval = pvalue_to_bool(pval);
+		delete_pvalue(pval);
+	} else {
+		val->type = VBOXED;
+		val->v.pval = pval;
+	}
+}
+/*======================================================
+ * take_pvalue -- Take value off stack as PVALUE
+ * returns 0 if no value
+ *====================================================*/
+static PVALUE
+take_pvalue (VMVAL *val)
+{
+	PVALUE pval = 0;
+	switch (val->type) {
+	case PINT: pval = create_pvalue_from_int(val->v.ival); break;
+	case PBOOL: pval = create_pvalue_from_bool(val->v.bval); break;
+	case PNULL: pval = create_pvalue_any(); break;
+	default: pval = val->v.pval; break;
+	}
+	val->type = VBOXED;
+	val->v.pval = 0;
+	return pval;
+}
+/*======================================================
+ * to_bool -- Convert value on stack to boolean
+ *  (as eval_and_coerce(PBOOL) would)
+ * returns FALSE if no value
+ *====================================================*/
+static BOOLEAN
+to_bool (VMVAL *val)
+{
+	BOOLEAN eflg = FALSE, rc;
+	PVALUE pval;
+	switch (val->type) {
+	case PBOOL: return TRUE;
+	case PINT: rc = (val->v.ival != 0); break;
+	case PNULL: rc = FALSE; break;
+	default:
+		if (!(pval = take_pvalue(val)))
+			return FALSE;
+		coerce_pvalue(PBOOL, pval, &eflg);
+		rc = pvalue_to_bool(pval);
+		delete_pvalue(pval);
+		if (eflg)
+			return FALSE;
+		break;
+	}
+	val->type = PBOOL;
+	val->v.bval = rc;
+	return TRUE;
+}
+/*======================================================
+ * store_value -- Assign value on stack to variable
+ *  (as assign_iden does, but reusing variable's PVALUE
+ *  for an integer or boolean)
+ *====================================================*/
+static void
+store_value (SYMTAB stab, PNODE var, VMVAL *val)
+{
+	PVALUE *pval = symtab_slot(stab, var, ISLOT_VAR, FALSE);
+	if (!pval || !*pval) {
+		PVALUE *gval = symtab_slot(globtab, var, ISLOT_GLOBAL, FALSE);
+		if (gval && *gval)
+			pval = gval;
+		else
+			pval = symtab_slot(stab, var, ISLOT_VAR, TRUE);
+	}
+	if (*pval && val->type == PINT) {
+		set_pvalue_int(*pval, val->v.ival);
+		return;
+	}
+	if (*pval && val->type == PBOOL) {
+		set_pvalue_bool(*pval, val->v.bval);
+		return;
+	}
+	if (*pval)
+		delete_pvalue(*pval);
+	*pval = take_pvalue(val);
+}
+/*======================================================
+ * slow_arith -- Arithmetic or comparison of PVALUEs
+ *  a:  [I/O] first operand, & result
+ *  b:  [IN]  second operand (freed)
+ * returns FALSE (having given message) if error
+ *====================================================*/
+static BOOLEAN
+slow_arith (VMINS *ins, VMVAL *a, VMVAL *b)
+{
+	PVALUE val1 = take_pvalue(a), val2 = take_pvalue(b);
+	BOOLEAN eflg = FALSE;
+	ZSTR zerr=0;
+	if (!val1) val1 = create_pvalue_any();
+	if (!val2) val2 = create_pvalue_any();
+	switch (ins->arg) {
+	case VA_ADD: add_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_SUB: sub_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_MUL: mul_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_DIV: div_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_MOD: mod_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_EQ: eq_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_NE: ne_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_LT: lt_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_LE: le_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_GT: gt_pvalues(val1, val2, &eflg, &zerr); break;
+	case VA_GE: ge_pvalues(val1, val2, &eflg, &zerr); break;
+	}
+	if (eflg) {
+		/* operands are not freed on error */
+		prog_error(ins->node, "%s", zerr ? zs_str(zerr) : "");
+		zs_free(&zerr);
+		delete_pvalue(val1);
+		delete_pvalue(val2);
+		return FALSE;
+	}
+	push_pvalue(a, val1);
+	return TRUE;
+}
+/*======================================================
+ * slow_unary -- Negate, increment or decrement PVALUE
+ *  a:  [I/O] operand, & result
+ * returns FALSE (having given message) if error
+ *====================================================*/
+static BOOLEAN
+slow_unary (VMINS *ins, VMVAL *a)
+{
+	PVALUE val = take_pvalue(a);
+	BOOLEAN eflg = FALSE;
+	ZSTR zerr=0;
+	if (!val) val = create_pvalue_any();
+	if (ins->op == VO_NEG)
+		neg_pvalue(val, &eflg, &zerr);
+	else if (ins->arg > 0)
+		incr_pvalue(val, &eflg, &zerr);
+	else
+		decr_pvalue(val, &eflg, &zerr);
+	if (eflg) {
+		prog_error(ins->node, "%s", zerr ? zs_str(zerr) : "");
+		zs_free(&zerr);
+		delete_pvalue(val);
+		return FALSE;
+	}
+	push_pvalue(a, val);
+	return TRUE;
+}
+/*======================================================
+ * report_catch -- Give message of catch for error
+ *  (those builtins give, for error in their args)
+ *====================================================*/
+static void
+report_catch (VMCATCH *vc, SYMTAB stab)
+{
+	char numstr[33];
+	switch (vc->kind) {
+	case VC_ARGX:
+		snprintf(numstr, sizeof(numstr), FMT_INT, vc->argix);
+		prog_var_error(vc->node, stab, vc->arg, NULL, badargx
+			, vc->name, numstr);
+		break;
+	case VC_ARG1:
+		prog_var_error(vc->node, stab, vc->arg, NULL, badarg1
+			, vc->name);
+		break;
+	case VC_BOOX:
+		snprintf(numstr, sizeof(numstr), FMT_INT, vc->argix);
+		prog_var_error(vc->node, stab, vc->arg, NULL, nonboox
+			, vc->name, numstr);
+		break;
+	case VC_NOT:
+		prog_error(vc->node, "%s", "the arg to not is not boolean");
+		break;
+	case VC_COND:
+		prog_error(vc->node, "error in conditional expression");
+		break;
+	}
+}
+/*======================================================
+ * run_code -- Run compiled statement list
+ *====================================================*/
+static INTERPTYPE
+run_code (VMCODE code, SYMTAB stab, PVALUE *pval)
+{
+	VMVAL local[VMSTACK], *stack = local, *sp, *a, *b;
+	VMINS *ins = code->ins;
+	PVALUE val, *slot;
+	INTERPTYPE irc = INTERROR;
+	BOOLEAN eflg = FALSE, reported = FALSE;
+	STRING str;
+	INT i;
+
+	if (code->maxdepth > VMSTACK)
+		stack = (VMVAL *)stdalloc(code->maxdepth * sizeof(VMVAL));
+	sp = stack;
+
+	for ( ; ; ++ins) {
+		switch (ins->op) {
+		case VO_STMT:
+			irc = interp_statement(ins->node, stab, pval);
+			if (irc == INTOKAY)
+				break;
+			if (irc == INTERROR) {
+				reported = TRUE;
+				goto vm_fail;
+			}
+			goto vm_leave;
+		case VO_PUSHI:
+			sp->type = PINT;
+			sp->v.ival = ins->arg;
+			++sp;
+			break;
+		case VO_PUSHK:
+			sp->type = VBOXED;
+			sp->v.pval = copy_pvalue(iistype(ins->node, ISCONS)
+				? ins->node->vars.iscons.value
+				: ins->node->vars.ifcons.value);
+			++sp;
+			break;
+		case VO_PUSHN:
+			sp->type = VBOXED;
+			sp->v.pval = 0;
+			++sp;
+			break;
+		case VO_LOAD:
+			slot = symtab_slot(stab, ins->node, ISLOT_VAR, FALSE);
+			if (!slot || !*slot)
+				slot = symtab_slot(globtab, ins->node, ISLOT_GLOBAL, FALSE);
+			if (!slot || !*slot) {
+				/* undeclared identifier */
+				if (explicitvars) {
+					prog_error(ins->node, "Undeclared identifier: %s"
+						, iident_name(ins->node));
+					goto vm_fail;
+				}
+				sp->type = PNULL;
+				sp->v.ival = 0;
+			} else if (ptype(*slot) == PINT) {
+				sp->type = PINT;
+				sp->v.ival = pvalue_to_int(*slot);
+			} else if (ptype(*slot) == PBOOL) {
+				sp->type = PBOOL;
+				sp->v.bval = pvalue_to_bool(*slot);
+			} else {
+				sp->type = VBOXED;
+				sp->v.pval = copy_pvalue(*slot);
+			}
+			++sp;
+			break;
+		case VO_STORE:
+			a = --sp;
+			if (a->type == VBOXED && !a->v.pval) {
+				PNODE var = builtin_args(ins->node);
+				prog_var_error(ins->node, stab, inext(var), NULL
+					, _("set(%s, <Null>) is invalid"), iident_name(var));
+				goto vm_fail;
+			}
+			store_value(stab, builtin_args(ins->node), a);
+			break;
+		case VO_BCALL:
+			Pnode = ins->node;
+			eflg = FALSE;
+			val = (*(PFUNC)ifunc(ins->node))(ins->node, stab, &eflg);
+			if (eflg)
+				goto vm_fail;
+			push_pvalue(sp++, val);
+			break;
+		case VO_UCALL:
+			Pnode = ins->node;
+			val = evaluate_ufunc(ins->node, stab, &eflg);
+			if (eflg)
+				goto vm_fail;
+			push_pvalue(sp++, val);
+			break;
+		case VO_EVAL:
+			val = evaluate(ins->node, stab, &eflg);
+			if (eflg)
+				goto vm_fail;
+			push_pvalue(sp++, val);
+			break;
+		case VO_ARITH:
+			b = --sp;
+			a = sp - 1;
+			if (a->type == PINT && b->type == PINT) {
+				switch (ins->arg) {
+				case VA_ADD: a->v.ival += b->v.ival; continue;
+				case VA_SUB: a->v.ival -= b->v.ival; continue;
+				case VA_MUL: a->v.ival *= b->v.ival; continue;
+				case VA_DIV:
+					if (!b->v.ival) break; /* for message */
+					a->v.ival /= b->v.ival;
+					continue;
+				case VA_MOD:
+					if (!b->v.ival) break;
+					a->v.ival %= b->v.ival;
+					continue;
+				}
+			}
+			if (!slow_arith(ins, a, b))
+				goto vm_fail;
+			break;
+		case VO_CMP:
+			b = --sp;
+			a = sp - 1;
+			if (a->type == PINT && b->type == PINT) {
+				INT i1 = a->v.ival, i2 = b->v.ival;
+				a->type = PBOOL;
+				switch (ins->arg) {
+				case VA_EQ: a->v.bval = (i1 == i2); break;
+				case VA_NE: a->v.bval = (i1 != i2); break;
+				case VA_LT: a->v.bval = (i1 < i2); break;
+				case VA_LE: a->v.bval = (i1 <= i2); break;
+				case VA_GT: a->v.bval = (i1 > i2); break;
+				case VA_GE: a->v.bval = (i1 >= i2); break;
+				}
+				break;
+			}
+			if (!slow_arith(ins, a, b))
+				goto vm_fail;
+			break;
+		case VO_NEG:
+			a = sp - 1;
+			if (a->type == PINT) {
+				a->v.ival = -a->v.ival;
+				break;
+			}
+			if (!slow_unary(ins, a))
+				goto vm_fail;
+			break;
+		case VO_STEP:
+			a = sp - 1;
+			if (a->type == PINT) {
+				a->v.ival += ins->arg;
+				break;
+			}
+			if (!slow_unary(ins, a))
+				goto vm_fail;
+			break;
+		case VO_BOOL:
+			if (!to_bool(sp - 1))
+				goto vm_fail;
+			break;
+		case VO_NOT:
+			sp[-1].v.bval = !sp[-1].v.bval;
+			break;
+		case VO_COND:
+			a = sp - 1;
+			if (a->type == VBOXED && !a->v.pval)
+				goto vm_fail;
+			if (inext(ins->node)) {
+				/* if (VAR, EXPR) sets VAR to value */
+				VMVAL copy = *a;
+				if (a->type == VBOXED)
+					copy.v.pval = copy_pvalue(a->v.pval);
+				store_value(stab, ins->node, &copy);
+			}
+			if (!to_bool(a))
+				goto vm_fail;
+			break;
+		case VO_JMP:
+			ins = code->ins + ins->arg - 1;
+			break;
+		case VO_JFALSE:
+			if (!(--sp)->v.bval)
+				ins = code->ins + ins->arg - 1;
+			break;
+		case VO_JFALSEK:
+			if (!sp[-1].v.bval)
+				ins = code->ins + ins->arg - 1;
+			break;
+		case VO_JTRUEK:
+			if (sp[-1].v.bval)
+				ins = code->ins + ins->arg - 1;
+			break;
+		case VO_POP:
+			if ((--sp)->type == VBOXED && sp->v.pval)
+				delete_pvalue(sp->v.pval);
+			break;
+		case VO_OUT:
+			a = --sp;
+			if (a->type != VBOXED || !a->v.pval)
+				break;
+			eflg = FALSE;
+			if (ptype(a->v.pval) == PSTRING
+				&& (str = pvalue_to_string(a->v.pval))) {
+				poutput(str, &eflg);
+			}
+			delete_pvalue(a->v.pval);
+			if (eflg)
+				goto vm_fail;
+			break;
+		case VO_RET:
+			irc = ins->arg;
+			goto vm_leave;
+		case VO_RETV:
+			*pval = take_pvalue(--sp);
+			irc = INTRETURN;
+			goto vm_leave;
+		}
+	}
+
+vm_fail:
+	while (sp > stack) {
+		if ((--sp)->type == VBOXED && sp->v.pval)
+			delete_pvalue(sp->v.pval);
+	}
+	irc = INTERROR;
+	if (reported)
+		goto vm_leave;
+	/* messages of builtins whose args include failed instruction */
+	for (i = 0; i < code->ncatch; i++) {
+		VMCATCH *vc = &code->catches[i];
+		INT at = ins - code->ins;
+		if (at < vc->start || at >= vc->end)
+			continue;
+		if (vc->kind == VC_RETURN) {
+			/* as interpret(), return no value */
+			if (getlloptint("FullReportCallStack", 0) > 0)
+				prog_error(vc->node, "in return statement");
+			*pval = NULL;
+			irc = INTRETURN;
+			goto vm_leave;
+		}
+		report_catch(vc, stab);
+	}
+	if (getlloptint("FullReportCallStack", 0) > 0) {
+		llwprintf("e" FMT_INT ": ", iline(ins->node)+1);
+		debug_show_one_pnode(ins->node);
+		llwprintf("\n");
+	}
+
+vm_leave:
+	if (stack != local)
+		stdfree(stack);
+	return irc;
+}
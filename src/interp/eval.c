@@ -143,6 +143,48 @@ evaluate_iden (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	*eflg = FALSE;
 	return valueof_iden(node, stab, iden, eflg);
 }
+/*=======================================+
+ * evaluate_imm -- Evaluate, holding number in caller's value
+ *  A constant, or a variable holding an INT, FLOAT or BOOL,
+ *  is copied into imm, instead of into a new pvalue.
+ *  imm:   [OUT] immediate value (caller's local)
+ * returns imm or new pvalue (either may be given to delete_pvalue,
+ *  but imm must go through box_pvalue to be kept)
+ *======================================*/
+PVALUE
+evaluate_imm (PNODE node, SYMTAB stab, PVALUE imm, BOOLEAN *eflg)
+{
+	PVALUE val=0;
+	if (prog_trace)
+		return evaluate(node, stab, eflg);
+	if (iistype(node, IICONS))
+		val = node->vars.iicons.value;
+	else if (iistype(node, IFCONS))
+		val = node->vars.ifcons.value;
+	else if (iistype(node, IIDENT))
+		val = iden_value(stab, node);
+	if (!val || (ptype(val) != PINT && ptype(val) != PFLOAT
+		&& ptype(val) != PBOOL))
+		return evaluate(node, stab, eflg);
+	*eflg = FALSE;
+	*imm = *val;
+	imm->imm = TRUE;
+	count_saved_pvalues(1);
+	return imm;
+}
+/*=======================================+
+ * iden_value -- Value identifier holds (not a copy)
+ *  (local, else global, as valueof_iden)
+ * returns NULL if none
+ *======================================*/
+PVALUE
+iden_value (SYMTAB stab, PNODE var)
+{
+	PVALUE *pval = symtab_slot(stab, var, ISLOT_VAR, FALSE);
+	if (pval && *pval) return *pval;
+	pval = symtab_slot(globtab, var, ISLOT_GLOBAL, FALSE);
+	return pval ? *pval : NULL;
+}
 /*=======================================+
  * valueof_iden - Find value of identifier
  * makes & returns copy
@@ -150,8 +192,7 @@ evaluate_iden (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 PVALUE
 valueof_iden (PNODE node, SYMTAB stab, CNSTRING iden, BOOLEAN *eflg)
 {
-	BOOLEAN there;
-	PVALUE val;
+	PVALUE *pval;
 
 #ifdef DEBUG
 	llwprintf("valueof_iden: iden, stab, globtab: %s, %d, %d\n",
@@ -159,10 +200,10 @@ valueof_iden (PNODE node, SYMTAB stab, CNSTRING iden, BOOLEAN *eflg)
 #endif
 
 	*eflg = FALSE;
-	val = symtab_valueofbool(stab, iden, &there);
-	if (there) return copy_pvalue(val);
-	val = symtab_valueofbool(globtab, iden, &there);
-	if (there) return copy_pvalue(val);
+	pval = symtab_slot(stab, node, ISLOT_VAR, FALSE);
+	if (pval && *pval) return copy_pvalue(*pval);
+	pval = symtab_slot(globtab, node, ISLOT_GLOBAL, FALSE);
+	if (pval && *pval) return copy_pvalue(*pval);
 	/* undeclared identifier */
 	if (explicitvars) {
 		*eflg = TRUE;
@@ -199,7 +240,7 @@ evaluate_cond (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	show_pvalue(val);
 	wprintf("\n");
 #endif
-	if (var) assign_iden(stab, iident_name(node), copy_pvalue(val));
+	if (var) assign_iden(stab, node, copy_pvalue(val));
 	coerce_pvalue(PBOOL, val, eflg);
 	rc = pvalue_to_bool(val);
 	delete_pvalue(val);
@@ -247,7 +288,7 @@ evaluate_ufunc (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		goto ufunc_leave;
 	}
 
-	newstab = create_symtab_proc(procname, stab);
+	newstab = create_symtab_proc(func, stab);
 	argvar = ifcall_args(node); /* instance values */
 	parm = ifdefn_args(func);
 	while (argvar && parm) {
@@ -258,7 +299,7 @@ evaluate_ufunc (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 				prog_error(node, "In user function %s()", procname);
 			return INTERROR;
 		}
-		insert_symtab(newstab, iident_name(parm), value);
+		insert_symtab_slot(newstab, parm, ISLOT_VAR, value);
 		argvar = inext(argvar);
 		parm = inext(parm);
 	}
@@ -319,15 +360,23 @@ num_params (PNODE node)
 }
 /*============================================
  * assign_iden -- Assign ident value in symtab
+ *  (in globals, if a global & not a local)
+ *  var:   [IN]  identifier pnode
  *==========================================*/
 void
-assign_iden (SYMTAB stab, CNSTRING id, PVALUE value)
+assign_iden (SYMTAB stab, PNODE var, PVALUE value)
 {
-	SYMTAB tab = stab;
-	if (!in_symtab(stab, id) && in_symtab(globtab, id))
-		tab = globtab;
-	insert_symtab(tab, id, value);
-	return;
+	PVALUE *pval = symtab_slot(stab, var, ISLOT_VAR, FALSE);
+	if (!pval || !*pval) {
+		PVALUE *gval = symtab_slot(globtab, var, ISLOT_GLOBAL, FALSE);
+		if (gval && *gval)
+			pval = gval;
+		else
+			pval = symtab_slot(stab, var, ISLOT_VAR, TRUE);
+	}
+	if (*pval)
+		delete_pvalue(*pval);
+	*pval = value;
 }
 /*=================================================
  * eval_and_coerce -- Generic evaluator and coercer
@@ -144,6 +144,7 @@ BUILTINS builtins[] = {
 	{"gettoday",        0,    0,    llrpt_gettoday},
 	{"givens",          1,    1,    llrpt_givens},
 	{"gt",              2,    2,    llrpt_gt},
+	{"heapsaved",       0,    0,    llrpt_heapsaved},
 	{"heapused",        0,    0,    llrpt_heapused},
 	{"husband",         1,    1,    llrpt_husband},
 	{"incr",            1,    2,    llrpt_incr},
@@ -223,6 +224,7 @@ BUILTINS builtins[] = {
 	{"rsort",           1,    2,    llrpt_rsort},
 	{"save",            1,    1,    llrpt_save},
 	{"savenode",        1,    1,    llrpt_savenode},
+	{"searchindiset",   2,    2,    llrpt_searchindiset},
 	{"set",             2,    2,    llrpt_set},
 	{"setdate",         2,    2,    llrpt_setdate},
 	{"setel",           3,    3,    llrpt_setel},
@@ -24,6 +24,7 @@
 /* added 05 Jan 2000 by Paul B. McBride (pmcbride@tiac.net) */
 /*===========================================================
  * heapused.c -- report how much heap space is in use (WIN32 - ONLY!)
+ *  & how many value allocations were avoided (everywhere)
  *===========================================================*/
 
 #ifdef HAVE_CONFIG_H
@@ -105,3 +106,16 @@ llrpt_heapused (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	return NULL;
 #endif
 }
+/*===============================================+
+ * llrpt_heapsaved -- Return how many value allocations
+ *  immediate values have avoided
+ * usage: heapsaved() -> INT
+ *==============================================*/
+PVALUE
+llrpt_heapsaved (PNODE node, SYMTAB stab, BOOLEAN *eflg)
+{
+	node=node; /* unused */
+	stab=stab; /* unused */
+	*eflg = FALSE;
+	return create_pvalue_from_int(pvalues_saved());
+}
@@ -35,6 +35,7 @@
 #include "table.h"
 #include "translat.h"
 #include "gedcom.h"
+#include "btree.h"
 #include "cache.h"
 #include "interpi.h"
 #include "indiseq.h"
@@ -78,6 +79,7 @@ BOOLEAN rpt_cancelled = FALSE;
  * external/imported variables
  *********************************************/
 
+extern BTREE BTR;
 extern INT progerror;
 extern BOOLEAN progrunning, progparsing;
 extern STRING qSwhatrpt;
@@ -99,6 +101,7 @@ static void parse_file(PACTX pactx, STRING fname, STRING fullpath);
 static void print_report_duration(INT duration, INT uiduration);
 static void progmessage(MSG_LEVEL level, STRING);
 static void remove_tables(PACTX pactx);
+static void resolve_all_slots(TABLE tab);
 static void wipe_pactx(PACTX pactx);
 
 /*********************************************
@@ -219,6 +222,7 @@ interp_program_list (STRING proc, INT nargs, VPTR *args, LIST lifiles
 	PACTX pactx = &pact;
 	STRING rootfilepath=0;
 	INT ranit=0;
+	BOOLEAN group=FALSE;
 
 	init_pactx(pactx);
 
@@ -313,6 +317,11 @@ interp_program_list (STRING proc, INT nargs, VPTR *args, LIST lifiles
 		goto interp_program_exit;
 	}
 
+   /* Bind variables to slots, now that all globals are known */
+
+	resolve_all_slots(gproctab);
+	resolve_all_slots(gfunctab);
+
    /* Find top procedure */
 
 	if (!(first = (PNODE) valueof_ptr(get_rptinfo(rootfilepath)->proctab, proc))) {
@@ -337,9 +346,9 @@ interp_program_list (STRING proc, INT nargs, VPTR *args, LIST lifiles
 			proc, num_params(parm), nargs);
 		goto interp_program_exit;
 	}
-	stab = create_symtab_proc(proc, NULL);
+	stab = create_symtab_proc(first, NULL);
 	for (i = 0; i < nargs; i++) {
-		insert_symtab(stab, iident_name(parm), args[0]);
+		insert_symtab_slot(stab, parm, ISLOT_VAR, args[0]);
 		parm = inext(parm);
 	}
 
@@ -349,7 +358,11 @@ interp_program_list (STRING proc, INT nargs, VPTR *args, LIST lifiles
 	progrunning = TRUE;
 	progerror = 0;
 	progmessage(MSG_STATUS, _("Program is running..."));
+	/* records the report writes are committed together at its end */
+	group = bt_begin_group(BTR);
 	ranit = interpret_prog((PNODE) ibody(first), stab);
+	if (group)
+		bt_commit_group(BTR);
 
    /* Clean up and return */
 
@@ -413,6 +426,23 @@ interpret_prog (PNODE begin, SYMTAB stab)
 		return FALSE;
 	}
 }
+/*===============================================
+ * resolve_all_slots -- Give slots to variables of
+ *  all procs (or funcs) of table (of lists of them)
+ *=============================================*/
+static void
+resolve_all_slots (TABLE tab)
+{
+	TABLE_ITER tabit = begin_table_iter(tab);
+	CNSTRING name=0;
+	VPTR ptr=0;
+	while (next_table_ptr(tabit, &name, &ptr)) {
+		FORLIST((LIST)ptr, el)
+			resolve_slots((PNODE)el);
+		ENDLIST
+	}
+	end_table_iter(&tabit);
+}
 /*===============================================
  * init_pactx -- initialize global parsing context
  *=============================================*/
@@ -583,317 +613,334 @@ interp_main (LIST lifiles, STRING ofile, BOOLEAN picklist, BOOLEAN timing)
 INTERPTYPE
 interpret (PNODE node, SYMTAB stab, PVALUE *pval)
 {
-	STRING str;
-	BOOLEAN eflg = FALSE;
 	INTERPTYPE irc;
-	PVALUE val;
 
 	*pval = NULL;
 
+	if (prog_bytecode && !prog_trace)
+		return run_bytecode(node, stab, pval);
 	while (node) {
-		Pnode = node;
-		if (prog_trace) {
-			trace_out("d" FMT_INT ": ", iline(node)+1);
-			trace_pnode(node);
-			trace_endl();
-		}
-		switch (itype(node)) {
-		case IICONS:
-			prog_error(node, _("integer constant not allowed here.  Use d(constant) instead.\n"));
+		if ((irc = interp_statement(node, stab, pval)) != INTOKAY)
+			return irc;
+		node = inext(node);
+	}
+	return TRUE;
+}
+/*======================================
+ * interp_statement -- Interpret one statement
+ * PNODE node:   statement to interpret
+ * TABLE stab:   current symbol table
+ * PVALUE *pval: possible return value
+ *====================================*/
+INTERPTYPE
+interp_statement (PNODE node, SYMTAB stab, PVALUE *pval)
+{
+	STRING str;
+	BOOLEAN eflg = FALSE;
+	INTERPTYPE irc;
+	PVALUE val;
+
+	Pnode = node;
+	if (prog_trace) {
+		trace_out("d" FMT_INT ": ", iline(node)+1);
+		trace_pnode(node);
+		trace_endl();
+	}
+	switch (itype(node)) {
+	case IICONS:
+		prog_error(node, _("integer constant not allowed here.  Use d(constant) instead.\n"));
+		goto interp_fail;
+	case IFCONS:
+		prog_error(node, _("floating-point constant not allowed here.  Use f(constant) instead.\n"));
+		goto interp_fail;
+	case ISCONS:
+		poutput(pvalue_to_string(node->vars.iscons.value), &eflg);
+		if (eflg)
 			goto interp_fail;
-		case IFCONS:
-			prog_error(node, _("floating-point constant not allowed here.  Use f(constant) instead.\n"));
+		break;
+	case IIDENT:
+		val = eval_and_coerce(PSTRING, node, stab, &eflg);
+		if (eflg) {
+			prog_error(node, _("identifier: %s should be a string\n"),
+			    iident_name(node));
 			goto interp_fail;
-		case ISCONS:
-			poutput(pvalue_to_string(node->vars.iscons.value), &eflg);
-			if (eflg)
-				goto interp_fail;
-			break;
-		case IIDENT:
-			val = eval_and_coerce(PSTRING, node, stab, &eflg);
+		}
+		str = pvalue_to_string(val);
+		if (str) {
+			poutput(str, &eflg);
 			if (eflg) {
-				prog_error(node, _("identifier: %s should be a string\n"),
-				    iident_name(node));
 				goto interp_fail;
 			}
+		}
+		delete_pvalue(val);
+		break;
+	case IBCALL:
+		val = evaluate_func(node, stab, &eflg);
+		if (eflg) {
+			goto interp_fail;
+		}
+		if (!val) break;
+		if (which_pvalue_type(val) == PSTRING) {
 			str = pvalue_to_string(val);
 			if (str) {
 				poutput(str, &eflg);
-				if (eflg) {
+				if (eflg)
 					goto interp_fail;
-				}
-			}
-			delete_pvalue(val);
-			break;
-		case IBCALL:
-			val = evaluate_func(node, stab, &eflg);
-			if (eflg) {
-				goto interp_fail;
-			}
-			if (!val) break;
-			if (which_pvalue_type(val) == PSTRING) {
-				str = pvalue_to_string(val);
-				if (str) {
-					poutput(str, &eflg);
-					if (eflg)
-						goto interp_fail;
-				}
-			}
-			delete_pvalue(val);
-			break;
-		case IFCALL:
-			val = evaluate_ufunc(node, stab, &eflg);
-			if (eflg) {
-				goto interp_fail;
-			}
-			if (!val) break;
-			if (which_pvalue_type(val) == PSTRING) {
-				str = pvalue_to_string(val);
-				if (str) {
-					poutput(str, &eflg);
-					if (eflg)
-						goto interp_fail;
-				}
-			}
-			delete_pvalue(val);
-			break;
-		case IPDEFN:
-			FATAL();
-		case ICHILDREN:
-			switch (irc = interp_children(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
 			}
-			break;
-		case IFAMILYSPOUSES:
-			switch (irc = interp_familyspouses(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
+		}
+		delete_pvalue(val);
+		break;
+	case IFCALL:
+		val = evaluate_ufunc(node, stab, &eflg);
+		if (eflg) {
+			goto interp_fail;
+		}
+		if (!val) break;
+		if (which_pvalue_type(val) == PSTRING) {
+			str = pvalue_to_string(val);
+			if (str) {
+				poutput(str, &eflg);
+				if (eflg)
+					goto interp_fail;
 			}
+		}
+		delete_pvalue(val);
+		break;
+	case IPDEFN:
+		FATAL();
+	case ICHILDREN:
+		switch (irc = interp_children(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case ISPOUSES:
-			switch (irc = interp_spouses(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IFAMILYSPOUSES:
+		switch (irc = interp_familyspouses(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IFAMILIES:
-			switch (irc = interp_families(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case ISPOUSES:
+		switch (irc = interp_spouses(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IFATHS:
-			switch (irc = interp_fathers(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IFAMILIES:
+		switch (irc = interp_families(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IMOTHS:
-			switch (irc = interp_mothers(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IFATHS:
+		switch (irc = interp_fathers(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IFAMCS:
-			switch (irc = interp_parents(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IMOTHS:
+		switch (irc = interp_mothers(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case ISET:
-			switch (irc = interp_indisetloop(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IFAMCS:
+		switch (irc = interp_parents(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IINDI:
-			switch (irc = interp_forindi(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case ISET:
+		switch (irc = interp_indisetloop(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IFAM:
-			switch (irc = interp_forfam(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IINDI:
+		switch (irc = interp_forindi(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case ISOUR:
-			switch (irc = interp_forsour(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IFAM:
+		switch (irc = interp_forfam(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IEVEN:
-			switch (irc = interp_foreven(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case ISOUR:
+		switch (irc = interp_forsour(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IOTHR:
-			switch (irc = interp_forothr(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IEVEN:
+		switch (irc = interp_foreven(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case ILIST:
-			switch (irc = interp_forlist(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IOTHR:
+		switch (irc = interp_forothr(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case INOTES:
-			switch (irc = interp_fornotes(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case ILIST:
+		switch (irc = interp_forlist(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case INODES:
-			switch (irc = interp_fornodes(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case INOTES:
+		switch (irc = interp_fornotes(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case ITRAV:
-			switch (irc = interp_traverse(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case INODES:
+		switch (irc = interp_fornodes(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IIF:
-			switch (irc = interp_if(node, stab, pval)) {
-			case INTOKAY:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case ITRAV:
+		switch (irc = interp_traverse(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IWHILE:
-			switch (irc = interp_while(node, stab, pval)) {
-			case INTOKAY:
-			case INTBREAK:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IIF:
+		switch (irc = interp_if(node, stab, pval)) {
+		case INTOKAY:
 			break;
-		case IPCALL:
-			switch (irc = interp_call(node, stab, pval)) {
-			case INTOKAY:
-				break;
-			case INTERROR:
-				goto interp_fail;
-			default:
-				return irc;
-			}
+		case INTERROR:
+			goto interp_fail;
+		default:
+			return irc;
+		}
+		break;
+	case IWHILE:
+		switch (irc = interp_while(node, stab, pval)) {
+		case INTOKAY:
+		case INTBREAK:
 			break;
-		case IBREAK:
-			return INTBREAK;
-		case ICONTINUE:
-			return INTCONTINUE;
-		case IRETURN:
-			if (iargs(node))
-				*pval = evaluate(iargs(node), stab, &eflg);
-			if (eflg && getlloptint("FullReportCallStack", 0) > 0)
-				prog_error(node, "in return statement");
-			return INTRETURN;
+		case INTERROR:
+			goto interp_fail;
 		default:
-			prog_error(node, _("Unexpected node type (%d)"), itype(node));
+			return irc;
+		}
+		break;
+	case IPCALL:
+		switch (irc = interp_call(node, stab, pval)) {
+		case INTOKAY:
+			break;
+		case INTERROR:
 			goto interp_fail;
+		default:
+			return irc;
 		}
-		node = inext(node);
+		break;
+	case IBREAK:
+		return INTBREAK;
+	case ICONTINUE:
+		return INTCONTINUE;
+	case IRETURN:
+		if (iargs(node))
+			*pval = evaluate(iargs(node), stab, &eflg);
+		if (eflg && getlloptint("FullReportCallStack", 0) > 0)
+			prog_error(node, "in return statement");
+		return INTRETURN;
+	default:
+		prog_error(node, _("Unexpected node type (%d)"), itype(node));
+		goto interp_fail;
 	}
-	return TRUE;
+	return INTOKAY;
 
 interp_fail:
 	if (getlloptint("FullReportCallStack", 0) > 0) {
@@ -928,8 +975,8 @@ interp_children (PNODE node, SYMTAB stab, PVALUE *pval)
 	lock_cache(fcel);
 	FORCHILDRENx(fam, chil, nchil)
 		val = create_pvalue_from_indi(chil);
-		insert_symtab(stab, ichild(node), val);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(nchil));
+		insert_symtab_slot(stab, node, ISLOT_VAR, val);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(nchil));
 		/* val should be real person, because it came from FORCHILDREN */
 		cel = pvalue_to_cel(val);
 		lock_cache(cel);
@@ -946,8 +993,8 @@ aloop:	;
 	ENDCHILDRENx
 	irc = INTOKAY;
 aleave:
-	delete_symtab_element(stab, ichild(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(fcel);
 	return irc;
 }
@@ -976,8 +1023,8 @@ interp_familyspouses (PNODE node, SYMTAB stab, PVALUE *pval)
 	lock_cache(fcel);
 	FORFAMSPOUSES(fam, spouse, nspouse)
 		val = create_pvalue_from_indi(spouse);
-		insert_symtab(stab, ichild(node), val);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(nspouse));
+		insert_symtab_slot(stab, node, ISLOT_VAR, val);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(nspouse));
 		/* val should be real person, because it came from FORFAMSPOUSES */
 		cel = pvalue_to_cel(val);
 		lock_cache(cel);
@@ -994,8 +1041,8 @@ aloop:	;
 	ENDFAMSPOUSES
 	irc = INTOKAY;
 aleave:
-	delete_symtab_element(stab, ichild(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(fcel);
 	return irc;
 }
@@ -1024,11 +1071,11 @@ interp_spouses (PNODE node, SYMTAB stab, PVALUE *pval)
 	lock_cache(icel);
 	FORSPOUSES(indi, spouse, fam, nspouses)
 		sval = create_pvalue_from_indi(spouse);
-		insert_symtab(stab, ispouse(node), sval);
+		insert_symtab_slot(stab, node, ISLOT_VAR, sval);
 		fval = create_pvalue_from_fam(fam);
-		insert_symtab(stab, ifamily(node), fval);
+		insert_symtab_slot(stab, node, ISLOT_VAR2, fval);
 		nval = create_pvalue_from_int(nspouses);
-		insert_symtab(stab, inum(node), nval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, nval);
 		/* sval should be real person, because it came from FORSPOUSES */
 		scel = pvalue_to_cel(sval);
 		/* fval should be real person, because it came from FORSPOUSES */
@@ -1049,9 +1096,9 @@ bloop:	;
 	ENDSPOUSES
 	irc = INTOKAY;
 bleave:
-	delete_symtab_element(stab, ispouse(node));
-	delete_symtab_element(stab, ifamily(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_VAR2);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(icel);
 	return irc;
 }
@@ -1083,11 +1130,11 @@ interp_families (PNODE node, SYMTAB stab, PVALUE *pval)
 	lock_cache(icel);
 	FORFAMSS(indi, fam, spouse, nfams)
 		fval = create_pvalue_from_fam(fam);
-		insert_symtab(stab, ifamily(node), fval);
+		insert_symtab_slot(stab, node, ISLOT_VAR2, fval);
 		sval = create_pvalue_from_indi(spouse);
-		insert_symtab(stab, ispouse(node), sval);
+		insert_symtab_slot(stab, node, ISLOT_VAR, sval);
 		nval = create_pvalue_from_int(nfams);
-		insert_symtab(stab, inum(node), nval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, nval);
 		/* fval should be real person, because it came from FORFAMSS */
 		fcel = pvalue_to_cel(fval);
 		/* sval may not be a person -- so scel may be NULL */
@@ -1108,9 +1155,9 @@ cloop:	;
 	ENDFAMSS
 	irc = INTOKAY;
 cleave:
-	delete_symtab_element(stab, ifamily(node));
-	delete_symtab_element(stab, ispouse(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR2);
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(icel);
 	return irc;
 }
@@ -1140,16 +1187,16 @@ interp_fathers (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 	if (!indi) return TRUE;
 	lock_cache(icel);
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	FORFAMCS(indi, fam, husb, wife, nfams)
 		sval = create_pvalue_from_indi(husb);
 		scel = pvalue_to_cel(sval);
 		if (!scel) goto dloop;
 		fval = create_pvalue_from_fam(fam);
 		fcel = pvalue_to_cel(fval);
-		insert_symtab(stab, ifamily(node), fval);
-		insert_symtab(stab, iiparent(node), create_pvalue_from_cel(PINDI, scel));
-		insert_symtab(stab, inum(node), create_pvalue_from_int(ncount++));
+		insert_symtab_slot(stab, node, ISLOT_VAR2, fval);
+		insert_symtab_slot(stab, node, ISLOT_VAR, create_pvalue_from_cel(PINDI, scel));
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(ncount++));
 		lock_cache(fcel);
 		lock_cache(scel);
 		irc = interpret((PNODE) ibody(node), stab, pval);
@@ -1167,9 +1214,9 @@ dloop:	;
 	ENDFAMCS
 	irc = INTOKAY;
 dleave:
-	delete_symtab_element(stab, ifamily(node));
-	delete_symtab_element(stab, iiparent(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR2);
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(icel);
 	return irc;
 }
@@ -1199,16 +1246,16 @@ interp_mothers (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 	if (!indi) return TRUE;
 	lock_cache(icel);
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	FORFAMCS(indi, fam, husb, wife, nfams)
 		sval = create_pvalue_from_indi(wife);
 		scel = pvalue_to_cel(sval);
 		if (!scel) goto eloop;
 		fval = create_pvalue_from_fam(fam);
 		fcel = pvalue_to_cel(fval);
-		insert_symtab(stab, ifamily(node), fval);
-		insert_symtab(stab, iiparent(node), create_pvalue_from_cel(PINDI, scel));
-		insert_symtab(stab, inum(node), create_pvalue_from_int(ncount++));
+		insert_symtab_slot(stab, node, ISLOT_VAR2, fval);
+		insert_symtab_slot(stab, node, ISLOT_VAR, create_pvalue_from_cel(PINDI, scel));
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(ncount++));
 		lock_cache(fcel);
 		lock_cache(scel);
 		irc = interpret((PNODE) ibody(node), stab, pval);
@@ -1225,9 +1272,9 @@ eloop:	;
 	ENDFAMCS
 	irc = INTOKAY;
 eleave:
-	delete_symtab_element(stab, ifamily(node));
-	delete_symtab_element(stab, iiparent(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR2);
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(icel);
 	return irc;
 }
@@ -1258,8 +1305,8 @@ interp_parents (PNODE node, SYMTAB stab, PVALUE *pval)
 	lock_cache(icel);
 	FORFAMCS(indi, fam, husb, wife, nfams)
 		fval = create_pvalue_from_fam(fam);
-		insert_symtab(stab, ifamily(node), fval);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(nfams));
+		insert_symtab_slot(stab, node, ISLOT_VAR2, fval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(nfams));
 		fcel = pvalue_to_cel(fval);
 		lock_cache(fcel);
 		irc = interpret((PNODE) ibody(node), stab, pval);
@@ -1275,8 +1322,8 @@ floop:	;
 	ENDFAMCS
 	irc = INTOKAY;
 fleave:
-	delete_symtab_element(stab, ifamily(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR2);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	unlock_cache(icel);
 	return INTOKAY;
 }
@@ -1298,7 +1345,7 @@ interp_fornotes (PNODE node, SYMTAB stab, PVALUE *pval)
 	delete_pvalue(val);
 	if (!root) return INTOKAY;
 	FORTAGVALUES(root, "NOTE", sub, vstring)
-		insert_symtab(stab, ielement(node), create_pvalue_from_string(vstring));
+		insert_symtab_slot(stab, node, ISLOT_VAR, create_pvalue_from_string(vstring));
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		switch (irc) {
 		case INTCONTINUE:
@@ -1311,7 +1358,7 @@ gloop:      ;
 	ENDTAGVALUES
 	irc = INTOKAY;
 gleave:
-	delete_symtab_element(stab, ielement(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
 	return irc;
 }
 /*==========================================+
@@ -1336,7 +1383,7 @@ interp_fornodes (PNODE node, SYMTAB stab, PVALUE *pval)
 	if (!root) return INTOKAY;
 	sub = nchild(root);
 	while (sub) {
-		insert_symtab(stab, ielement(node), create_pvalue_from_node(sub));
+		insert_symtab_slot(stab, node, ISLOT_VAR, create_pvalue_from_node(sub));
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		switch (irc) {
 		case INTCONTINUE:
@@ -1350,7 +1397,7 @@ hloop: ;
 	}
 	irc = INTOKAY;
 hleave:
-	delete_symtab_element(stab, ielement(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
 	return irc;
 }
 /*========================================+
@@ -1368,7 +1415,7 @@ interp_forindi (PNODE node, SYMTAB stab, PVALUE *pval)
 	PVALUE ival=NULL;
 	INT count = 0;
 	INT icount = 0;
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	while (TRUE) {
 		count = xref_nexti(count);
 		if (!count) {
@@ -1384,8 +1431,8 @@ interp_forindi (PNODE node, SYMTAB stab, PVALUE *pval)
 		icount++;
 		lock_cache(icel); /* keep current indi in cache during loop body */
 		/* set loop variables */
-		insert_symtab(stab, ielement(node), ival);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(icount));
+		insert_symtab_slot(stab, node, ISLOT_VAR, ival);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(icount));
 		/* execute loop body */
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		unlock_cache(icel);
@@ -1398,8 +1445,8 @@ interp_forindi (PNODE node, SYMTAB stab, PVALUE *pval)
 		}
 	}
 ileave:
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	return irc;
 }
 /*========================================+
@@ -1417,7 +1464,7 @@ interp_forsour (PNODE node, SYMTAB stab, PVALUE *pval)
 	PVALUE sval=NULL;
 	INT count = 0;
 	INT scount = 0;
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	while (TRUE) {
 		count = xref_nexts(count);
 		if (!count) {
@@ -1433,8 +1480,8 @@ interp_forsour (PNODE node, SYMTAB stab, PVALUE *pval)
 		scount++;
 		lock_cache(scel); /* keep current source in cache during loop body */
 		/* set loop variables */
-		insert_symtab(stab, ielement(node), sval);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(scount));
+		insert_symtab_slot(stab, node, ISLOT_VAR, sval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(scount));
 		/* execute loop body */
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		unlock_cache(scel);
@@ -1448,8 +1495,8 @@ interp_forsour (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 sourleave:
 	/* remove loop variables from symbol table */
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	return irc;
 }
 /*========================================+
@@ -1464,7 +1511,7 @@ interp_foreven (PNODE node, SYMTAB stab, PVALUE *pval)
 	PVALUE eval=NULL;
 	INT count = 0;
 	INT ecount = 0;
-	insert_symtab(stab, inum(node), create_pvalue_from_int(count));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(count));
 	while (TRUE) {
 		count = xref_nexte(count);
 		if (!count) {
@@ -1480,8 +1527,8 @@ interp_foreven (PNODE node, SYMTAB stab, PVALUE *pval)
 		ecount++;
 		lock_cache(ecel); /* keep current event in cache during loop body */
 		/* set loop variables */
-		insert_symtab(stab, ielement(node), eval);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(ecount));
+		insert_symtab_slot(stab, node, ISLOT_VAR, eval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(ecount));
 		/* execute loop body */
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		unlock_cache(ecel);
@@ -1495,8 +1542,8 @@ interp_foreven (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 evenleave:
 	/* remove loop variables from symbol table */
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	return irc;
 }
 /*========================================+
@@ -1511,7 +1558,7 @@ interp_forothr (PNODE node, SYMTAB stab, PVALUE *pval)
 	PVALUE xval;
 	INT count = 0;
 	INT xcount = 0;
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	while (TRUE) {
 		count = xref_nextx(count);
 		if (!count) {
@@ -1527,8 +1574,8 @@ interp_forothr (PNODE node, SYMTAB stab, PVALUE *pval)
 		xcount++;
 		lock_cache(xcel); /* keep current source in cache during loop body */
 		/* set loop variables */
-		insert_symtab(stab, ielement(node), xval);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(xcount));
+		insert_symtab_slot(stab, node, ISLOT_VAR, xval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(xcount));
 		/* execute loop body */
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		unlock_cache(xcel);
@@ -1541,8 +1588,8 @@ interp_forothr (PNODE node, SYMTAB stab, PVALUE *pval)
 		}
 	}
 othrleave:
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	return irc;
 }
 /*======================================+
@@ -1557,7 +1604,7 @@ interp_forfam (PNODE node, SYMTAB stab, PVALUE *pval)
 	PVALUE fval=NULL;
 	INT count = 0;
 	INT fcount = 0;
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	while (TRUE) {
 		count = xref_nextf(count);
 		if (!count) {
@@ -1572,8 +1619,8 @@ interp_forfam (PNODE node, SYMTAB stab, PVALUE *pval)
 		}
 		fcount++;
 		lock_cache(fcel);
-		insert_symtab(stab, ielement(node), fval);
-		insert_symtab(stab, inum(node), create_pvalue_from_int(fcount));
+		insert_symtab_slot(stab, node, ISLOT_VAR, fval);
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(fcount));
 		irc = interpret((PNODE) ibody(node), stab, pval);
 		unlock_cache(fcel);
 		switch (irc) {
@@ -1585,8 +1632,8 @@ interp_forfam (PNODE node, SYMTAB stab, PVALUE *pval)
 		}
 	}
 mleave:
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	return irc;
 }
 /*============================================+
@@ -1613,20 +1660,20 @@ interp_indisetloop (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 	/* can't delete val until we're done with seq */
 	/* initialize counter */
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	FORINDISEQ(seq, el, ncount)
 		/* put current indi in symbol table */
 		indival = create_pvalue_from_indi_key(element_skey(el));
-		insert_symtab(stab, ielement(node), indival);
+		insert_symtab_slot(stab, node, ISLOT_VAR, indival);
 		/* put current indi's value in symbol table */
 		loopval = element_pval(el);
 		if (loopval)
 			loopval = copy_pvalue(loopval);
 		else
 			loopval = create_pvalue_any();
-		insert_symtab(stab, ivalvar(node), loopval);
+		insert_symtab_slot(stab, node, ISLOT_VAR2, loopval);
 		/* put counter in symbol table */
-		insert_symtab(stab, inum(node), create_pvalue_from_int(ncount + 1));
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(ncount + 1));
 		switch (irc = interpret((PNODE) ibody(node), stab, pval)) {
 		case INTCONTINUE:
 		case INTOKAY:
@@ -1639,9 +1686,9 @@ hloop:	;
 	irc = INTOKAY;
 hleave:
 	delete_pvalue(val); /* delete temp evaluated val - may destruct seq */
-	delete_symtab_element(stab, ielement(node)); /* remove indi */
-	delete_symtab_element(stab, ivalvar(node)); /* remove indi's value */
-	delete_symtab_element(stab, inum(node)); /* remove counter */
+	delete_symtab_slot(stab, node, ISLOT_VAR); /* remove indi */
+	delete_symtab_slot(stab, node, ISLOT_VAR2); /* remove indi's value */
+	delete_symtab_slot(stab, node, ISLOT_NUM); /* remove counter */
 	return irc;
 }
 /*=====================================+
@@ -1668,12 +1715,12 @@ interp_forlist (PNODE node, SYMTAB stab, PVALUE *pval)
 		prog_error(node, "1st arg to forlist is in error");
 		return INTERROR;
 	}
-	insert_symtab(stab, inum(node), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(0));
 	FORLIST(list, el)
 		/* insert/update current element in symbol table */
-		insert_symtab(stab, ielement(node), copy_pvalue(el));
+		insert_symtab_slot(stab, node, ISLOT_VAR, copy_pvalue(el));
 		/* insert/update counter in symbol table */
-		insert_symtab(stab, inum(node), create_pvalue_from_int(ncount++));
+		insert_symtab_slot(stab, node, ISLOT_NUM, create_pvalue_from_int(ncount++));
 		switch (irc = interpret((PNODE) ibody(node), stab, pval)) {
 		case INTCONTINUE:
 		case INTOKAY:
@@ -1688,8 +1735,8 @@ iloop:	;
 ileave:
 	delete_pvalue(val); /* delete temp evaluated val - may destruct list */
 	/* remove element & counter from symbol table */
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, inum(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_NUM);
 	return irc;
 }
 /*===================================+
@@ -1779,7 +1826,7 @@ interp_call (PNODE node, SYMTAB stab, PVALUE *pval)
 		goto call_leave;
 	}
 	ASSERT(itype(proc) == IPDEFN);
-	newstab = create_symtab_proc(procname, stab);
+	newstab = create_symtab_proc(proc, stab);
 	arg = node->vars.ipcall.fargs; /* call instance */
 	parm = (PNODE) iargs(proc); /* declaration */
 	while (arg && parm) {
@@ -1789,7 +1836,7 @@ interp_call (PNODE node, SYMTAB stab, PVALUE *pval)
 			irc = INTERROR;
 			goto call_leave;
 		}
-		insert_symtab(newstab, iident_name(parm), value);
+		insert_symtab_slot(newstab, parm, ISLOT_VAR, value);
 		arg = inext(arg);
 		parm = inext(parm);
 	}
@@ -1845,8 +1892,8 @@ interp_traverse (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 	stack[++lev] = snode = root;
 	while (TRUE) {
-		insert_symtab(stab, ielement(node), create_pvalue_from_node(snode));
-		insert_symtab(stab, ilev(node), create_pvalue_from_int(lev));
+		insert_symtab_slot(stab, node, ISLOT_VAR, create_pvalue_from_node(snode));
+		insert_symtab_slot(stab, node, ISLOT_VAR2, create_pvalue_from_int(lev));
 		switch (irc = interpret((PNODE) ibody(node), stab, pval)) {
 		case INTCONTINUE:
 		case INTOKAY:
@@ -1872,8 +1919,8 @@ interp_traverse (PNODE node, SYMTAB stab, PVALUE *pval)
 	}
 	irc = INTOKAY;
 traverse_leave:
-	delete_symtab_element(stab, ielement(node));
-	delete_symtab_element(stab, ilev(node));
+	delete_symtab_slot(stab, node, ISLOT_VAR);
+	delete_symtab_slot(stab, node, ISLOT_VAR2);
 	delete_pvalue(val);
 	val=NULL;
 	return irc;
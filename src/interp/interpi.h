@@ -74,21 +74,34 @@ typedef struct tag_rptinfo *RPTINFO;
 /************************************************************************/
 
 
-/* symbol table data is just table data */
+/* names of variables of a proc or func, each given a slot number */
+typedef struct tag_scope *SCOPE;
+
+/* symbol table is a frame of slots, one per variable of its scope */
 typedef struct tag_symtab *SYMTAB;
 struct tag_symtab {
-	TABLE tab;
+	SCOPE scope;       /* names of slots (shared by calls of same proc) */
+	BOOLEAN ownscope;  /* scope belongs to this table ? */
+	PVALUE *slots;     /* value of each variable (0 if not set) */
+	INT nslots;
 	SYMTAB parent;
 	char title[128];
 };
 
+typedef struct tag_pnode *PNODE;
+
 SYMTAB create_symtab_global(void);
-SYMTAB create_symtab_proc(CNSTRING procname, SYMTAB parstab);
-void delete_symtab_element(SYMTAB stab, STRING iden);
+SYMTAB create_symtab_proc(PNODE defn, SYMTAB parstab);
+void delete_symtab_slot(SYMTAB stab, PNODE node, INT which);
 BOOLEAN in_symtab(SYMTAB stab, CNSTRING key);
 void insert_symtab(SYMTAB stab, CNSTRING iden, PVALUE val);
+void insert_symtab_slot(SYMTAB stab, PNODE node, INT which, PVALUE val);
+void free_scope(SCOPE scope);
 void remove_symtab(SYMTAB stab);
+void resolve_slots(PNODE defn);
 void symbol_tables_end(void);
+INT symtab_count(SYMTAB stab);
+PVALUE * symtab_slot(SYMTAB stab, PNODE node, INT which, BOOLEAN create);
 PVALUE symtab_valueofbool(SYMTAB stab, CNSTRING key, BOOLEAN *there);
 
 
@@ -102,8 +115,6 @@ void end_symtab_iter(SYMTAB_ITER * psymtabit);
 /* Interpreter Structures and Functions                                 */
 /************************************************************************/
 
-typedef struct tag_pnode *PNODE;
-
 typedef struct tag_ipcall_data {
 	CNSTRING fname;
 	PNODE fargs;
@@ -111,6 +122,9 @@ typedef struct tag_ipcall_data {
 
 typedef PVALUE (*PFUNC)(PNODE, SYMTAB, BOOLEAN *);
 
+/* code compiled for statement list (see compile.c) */
+typedef struct tag_vmcode *VMCODE;
+
 struct tag_pnode {
 	char     i_type;       /* type of node */
 	PNODE    i_prnt;       /* parent of this node */
@@ -124,6 +138,9 @@ struct tag_pnode {
 	VPTR     i_word4;
 	VPTR     i_word5;
 	PFUNC    i_func;
+	SCOPE    i_scope;      /* scope of enclosing proc or func (own, for these) */
+	INT      i_slot[4];    /* frame slots of variables of node (see ISLOT_*) */
+	VMCODE   i_code;       /* code of list this node begins, once compiled */
 	union {
 		struct {
 			PVALUE value;
@@ -232,6 +249,12 @@ PNODE ifcall_args(PNODE node);
 #define ibody(i)     ((i)->i_word5)     /* body of proc, func, loops */
 #define inum(i)      ((i)->i_word4)     /* counter used by many loops */
 
+/* variables of a node, by index into i_slot */
+#define ISLOT_VAR    0   /* identifier, or ichild/ispouse/iiparent/ielement */
+#define ISLOT_VAR2   1   /* ifamily/ivalvar/ilev */
+#define ISLOT_NUM    2   /* inum */
+#define ISLOT_GLOBAL 3   /* identifier, in global table (-1 if not global) */
+
 #define pitype(i)	ptype(ivalue(i))
 #define pivalue(i)	pvalue(ivalue(i))
 
@@ -255,6 +278,9 @@ void finishinterp(void);
 void finishrassa(void);
 
 INTERPTYPE interpret(PNODE, SYMTAB, PVALUE*);
+INTERPTYPE interp_statement(PNODE, SYMTAB, PVALUE*);
+INTERPTYPE run_bytecode(PNODE, SYMTAB, PVALUE*);
+void free_bytecode(VMCODE code);
 INTERPTYPE interp_children(PNODE, SYMTAB, PVALUE*);
 INTERPTYPE interp_spouses(PNODE, SYMTAB, PVALUE*);
 INTERPTYPE interp_families(PNODE, SYMTAB, PVALUE*);
@@ -372,6 +398,7 @@ PVALUE llrpt_gettext(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_gettoday(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_givens(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_gt(PNODE, SYMTAB, BOOLEAN *);
+PVALUE llrpt_heapsaved(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_heapused(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_husband(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_incr(PNODE, SYMTAB, BOOLEAN *);
@@ -453,6 +480,7 @@ PVALUE llrpt_row(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_rsort(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_save(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_savenode(PNODE, SYMTAB, BOOLEAN *);
+PVALUE llrpt_searchindiset(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_set(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_setdate(PNODE, SYMTAB, BOOLEAN *);
 PVALUE llrpt_setel(PNODE, SYMTAB, BOOLEAN *);
@@ -546,7 +574,7 @@ extern STRING badarg1, badargs, badargx;
 void dolock_node_in_cache(NODE, BOOLEAN lock);
 
 /* Prototypes */
-void assign_iden(SYMTAB stab, CNSTRING id, PVALUE value);
+void assign_iden(SYMTAB stab, PNODE var, PVALUE value);
 PNODE break_node(PACTX pactx);
 PNODE children_node(PACTX pactx, PNODE, STRING, STRING, PNODE);
 void clear_rptinfos(void);
@@ -563,6 +591,7 @@ PVALUE evaluate(PNODE, SYMTAB, BOOLEAN*);
 BOOLEAN evaluate_cond(PNODE, SYMTAB, BOOLEAN*);
 PVALUE evaluate_func(PNODE, SYMTAB, BOOLEAN*);
 PVALUE evaluate_iden(PNODE, SYMTAB, BOOLEAN*);
+PVALUE evaluate_imm(PNODE, SYMTAB, PVALUE imm, BOOLEAN*);
 PVALUE evaluate_ufunc(PNODE, SYMTAB, BOOLEAN*);
 PVALUE eval_and_coerce(INT, PNODE, SYMTAB, BOOLEAN*);
 NODE eval_indi(PNODE, SYMTAB, BOOLEAN*, CACHEEL*);
@@ -589,6 +618,7 @@ PNODE func_node(PACTX pactx, STRING, PNODE);
 CNSTRING get_internal_string_node_value(PNODE node);
 PNODE get_proc_node(CNSTRING procname, TABLE loctab, TABLE gtab, INT * count);
 RPTINFO get_rptinfo(CNSTRING fullpath);
+PVALUE iden_value(SYMTAB stab, PNODE var);
 PNODE if_node(PACTX pactx, PNODE, PNODE, PNODE);
 BOOLEAN iistype(PNODE, INT);
 void init_debugger(void);
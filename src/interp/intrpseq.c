@@ -82,7 +82,7 @@ llrpt_indiset (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 	newseq = create_indiseq_pval();
 	set_indiseq_value_funcs(newseq, &pvseq_fnctbl);
 	newval = create_pvalue_from_seq(newseq);
-	assign_iden(stab, iident_name(arg1), newval);
+	assign_iden(stab, arg1, newval);
 	/* gave val1 to stab, so don't clear it */
 	return NULL;
 }
@@ -135,8 +135,8 @@ llrpt_extractnames (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		len = 0;
 		sind = 0;
 	}
-	insert_symtab(stab, iident_name(lvar), create_pvalue_from_int(len));
-	insert_symtab(stab, iident_name(svar), create_pvalue_from_int(sind));
+	insert_symtab_slot(stab, lvar, ISLOT_VAR, create_pvalue_from_int(len));
+	insert_symtab_slot(stab, svar, ISLOT_VAR, create_pvalue_from_int(sind));
 	return NULL;
 }
 /*==============================================================+
@@ -178,7 +178,7 @@ llrpt_extractplaces (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		prog_var_error(node, stab, lvar, NULL, nonvarx, "extractplaces", "3");
 		return NULL;
 	}
-	insert_symtab(stab, iident_name(lvar), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, lvar, ISLOT_VAR, create_pvalue_from_int(0));
 	*eflg = FALSE;
 	if (!line) return NULL;
 	if (strcmp("PLAC", ntag(line)) && !(line = PLAC(line))) return NULL;
@@ -189,7 +189,7 @@ llrpt_extractplaces (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		str2 = (STRING)el; /* place_to_list made list of strings */
 		push_list(list, create_pvalue_from_string(str2));
 	ENDLIST
-	insert_symtab(stab, iident_name(lvar), create_pvalue_from_int(len));
+	insert_symtab_slot(stab, lvar, ISLOT_VAR, create_pvalue_from_int(len));
 	return NULL;
 }
 /*==========================================================+
@@ -240,12 +240,12 @@ llrpt_extracttokens (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		delete_pvalue_ptr(&val2);
 		return NULL;
 	}
-	insert_symtab(stab, iident_name(lvar), create_pvalue_from_int(0));
+	insert_symtab_slot(stab, lvar, ISLOT_VAR, create_pvalue_from_int(0));
 	temp = value_to_list(str, &len, dlm);
 	FORLIST(temp, el)
 		push_list(list, create_pvalue_from_string((STRING)el));
 	ENDLIST
-	insert_symtab(stab, iident_name(lvar), create_pvalue_from_int(len));
+	insert_symtab_slot(stab, lvar, ISLOT_VAR, create_pvalue_from_int(len));
 	delete_pvalue_ptr(&val1);
 	delete_pvalue_ptr(&val2);
 	return NULL;
@@ -1157,10 +1157,42 @@ llrpt_genindiset (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		return NULL;
 	}
 	seqval = create_pvalue_from_seq(NULL);
-	assign_iden(stab, iident_name(argvar), seqval);
+	assign_iden(stab, argvar, seqval);
 	if (!name || *name == 0) return NULL;
 	seqval = create_pvalue_from_seq(str_to_indiseq(name, 'I'));
-	assign_iden(stab, iident_name(argvar), seqval);
+	assign_iden(stab, argvar, seqval);
+	return NULL;
+}
+/*=============================================================+
+ * llrpt_searchindiset -- Generate set of persons whose names
+ *  match words of search (see find_indis_by_words)
+ * usage: searchindiset(STRING, SET) -> VOID
+ *============================================================*/
+PVALUE
+llrpt_searchindiset (PNODE node, SYMTAB stab, BOOLEAN *eflg)
+{
+	PNODE argvar = builtin_args(node);
+	STRING words=0;
+	PVALUE seqval=0;
+	PVALUE val1 = eval_and_coerce(PSTRING, argvar, stab, eflg);
+	if (*eflg) {
+		prog_var_error(node, stab, argvar, val1, nonstrx, "searchindiset" , "1");
+		delete_pvalue_ptr(&val1);
+		return NULL;
+	}
+	words = pvalue_to_string(val1);
+	if(words) words = strsave(words);
+	delete_pvalue_ptr(&val1);
+	argvar = inext(argvar);
+	if (!iistype(argvar, IIDENT)) {
+		*eflg = TRUE;
+		prog_var_error(node, stab, argvar, NULL, nonvarx, "searchindiset", "2");
+		strfree(&words);
+		return NULL;
+	}
+	seqval = create_pvalue_from_seq(words_to_indiseq(words));
+	assign_iden(stab, argvar, seqval);
+	strfree(&words);
 	return NULL;
 }
 /*================================================+
@@ -1316,7 +1348,7 @@ llrpt_dms2deg (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		prog_var_error(node, stab, argvar, NULL, nonvarx, "dms2deg", "4");
 		return NULL;
 	}
-	insert_symtab(stab, iident_name(argvar), create_pvalue_from_float(decdeg));
+	insert_symtab_slot(stab, argvar, ISLOT_VAR, create_pvalue_from_float(decdeg));
 	return NULL;
 }
 /*========================================
@@ -1373,9 +1405,9 @@ llrpt_deg2dms (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 
 	if (neg == 1) { deg *= -1; }
 
-	insert_symtab(stab, iident_name(retvar1), create_pvalue_from_int(deg));
-	insert_symtab(stab, iident_name(retvar2), create_pvalue_from_int(min));
-	insert_symtab(stab, iident_name(retvar3), create_pvalue_from_int(sec));
+	insert_symtab_slot(stab, retvar1, ISLOT_VAR, create_pvalue_from_int(deg));
+	insert_symtab_slot(stab, retvar2, ISLOT_VAR, create_pvalue_from_int(min));
+	insert_symtab_slot(stab, retvar3, ISLOT_VAR, create_pvalue_from_int(sec));
 	return NULL;
 }
 /*========================================
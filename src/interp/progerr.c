@@ -148,13 +148,13 @@ prog_var_error_zstr (PNODE node, SYMTAB stab, PNODE arg, PVALUE val, ZSTR zstr)
 		ZSTR zstr=zs_new();
 		INT n=0;
 		/* 0: display local variable(s) */
-		n = (curstab->tab ? get_table_count(curstab->tab) : 0);
+		n = symtab_count(curstab);
 		zs_setf(zstr, _pl("Display local (" FMT_INT" var)",
 				  "Display locals (" FMT_INT " vars)", n), n);
 		zs_appf(zstr, " [%s]", curstab->title);
 		choices[0] = strsave(zs_str(zstr));
 		/* 1: display global variables */
-		n = (globtab->tab ? get_table_count(globtab->tab) : 0);
+		n = symtab_count(globtab);
 		zs_setf(zstr, _pl("Display global (" FMT_INT " var)",
 				  "Display globals (" FMT_INT " vars)", n), n);
 		choices[1] = strsave(zs_str(zstr));
@@ -272,7 +272,7 @@ static void
 disp_symtab (STRING title, SYMTAB stab)
 {
 	SYMTAB_ITER symtabit=0;
-	INT nels = (stab->tab ? get_table_count(stab->tab) : 0);
+	INT nels = symtab_count(stab);
 	struct dbgsymtab_s sdata;
 	if (!nels) return;
 	init_dbgsymtab_arrays(&sdata, nels);
@@ -7,6 +7,12 @@
 /*=============================================================
  * pvalalloc.c -- Allocation of pvalues (intrepreter values)
  * Copyright(c) 1991-95 by T.T. Wetmore IV; all rights reserved
+ *  All pvalues of a run of report programs, and the strings
+ *  they hold, come from an arena of blocks kept for the run,
+ *  & freed all at once when it ends (pvalues_end).
+ *  Strings are carved from chunks in a few size classes,
+ *  each class with its own free list; longer ones are
+ *  allocated alone, but kept on a list of the arena.
  *===========================================================*/
 
 #include "llstdlib.h"
@@ -25,6 +31,11 @@
  */
 /* #define NOBLOCKALLOCATOR 1 */
 
+/* define following to check pvalues as they are freed & used,
+   & to report leaked pvalues (by type) to ReportLeakLog
+ */
+/* #define DEBUG_PVALUES 1 */
+
 /*********************************************
  * local types
  *********************************************/
@@ -33,17 +44,47 @@
 struct tag_pv_block
 {
 	struct tag_pv_block * next;
-	struct tag_pvalue values[100]; /* arbitrary size may be adjusted */
+	struct tag_pvalue values[250]; /* arbitrary size may be adjusted */
 };
 typedef struct tag_pv_block *PV_BLOCK;
 #define BLOCK_VALUES (sizeof(((PV_BLOCK)0)->values)/sizeof(((PV_BLOCK)0)->values[0]))
 
+/* chunk of string cells of one size class */
+struct tag_pv_chunk
+{
+	struct tag_pv_chunk * next;
+	double cells[512]; /* (double for alignment) */
+};
+typedef struct tag_pv_chunk *PV_CHUNK;
+#define CHUNK_BYTES (sizeof(((PV_CHUNK)0)->cells))
+
+/* string too long for any class, allocated alone */
+struct tag_pv_bigstr
+{
+	struct tag_pv_bigstr * prev;
+	struct tag_pv_bigstr * next;
+};
+typedef struct tag_pv_bigstr *PV_BIGSTR;
+
+/*
+ Each string is preceded by one byte, giving its class
+ (or NSTRCLASS, if allocated alone); a free cell holds
+ the next free cell of its class instead.
+*/
+#define NSTRCLASS 5
+static const INT strclass_size[NSTRCLASS] = { 16, 32, 64, 128, 256 };
+
 /*********************************************
  * local function prototypes
  *********************************************/
 
 static void free_all_pvalues(void);
+#ifdef DEBUG_PVALUES
 static BOOLEAN is_pvalue_or_freed(PVALUE pval);
+#endif
+#ifndef NOBLOCKALLOCATOR
+static void release_leaked_pvalues(void);
+#endif
 
 /*********************************************
  * local variables
@@ -53,19 +94,16 @@ static BOOLEAN is_pvalue_or_freed(PVALUE pval);
 static PVALUE free_list = 0;
 static INT live_pvalues = 0;
 static PV_BLOCK block_list = 0;
+static char * free_cells[NSTRCLASS];
+static PV_CHUNK chunk_list = 0;
+static PV_BIGSTR bigstr_list = 0;
 #endif
+static INT saved_pvalues = 0; /* allocations avoided by immediate values */
 static BOOLEAN reports_time = FALSE;
 static BOOLEAN cleaning_time = FALSE;
 #ifdef DEBUG_REPORT_MEMORY_DETAIL
 static BOOLEAN alloclog_save = FALSE;
 #endif
-#ifndef NOBLOCKALLOCATOR
-#ifdef DEBUG_PVALUES
-static INT debugging_pvalues = TRUE;
-#else
-static INT debugging_pvalues = FALSE;
-#endif
-#endif
 
 /*********************************************
  * local function definitions
@@ -80,7 +118,7 @@ static INT debugging_pvalues = FALSE;
  * corruption bug.
  * Created: 2001/03, Perry Rapp
  *======================================*/
-#ifndef NOBLOCKALLOCATOR
+#if !defined(NOBLOCKALLOCATOR) && defined(DEBUG_PVALUES)
 static void
 debug_check (void)
 {
@@ -134,19 +172,19 @@ alloc_pvalue_memory (void)
 			val1->type = PFREED;
 			val1->value.pxd = free_list;
 			free_list = val1;
-			if (debugging_pvalues)
-				debug_check();
 		}
 	}
 	/* pull pvalue off of free list */
 	val = free_list;
 	free_list = free_list->value.pxd;
-	if (debugging_pvalues)
-		debug_check();
+#ifdef DEBUG_PVALUES
+	debug_check();
+#endif
 	live_pvalues++;
 #endif
 	/* set type to uninitialized - caller ought to set type */
 	ptype(val) = PNULL;
+	val->imm = FALSE;
 	val->value.pxd = 0;
 	return val;
 }
@@ -176,12 +214,86 @@ free_pvalue_memory (PVALUE val)
 	val->type = PFREED;
 	val->value.pxd = free_list;
 	free_list = val;
-	if (debugging_pvalues)
-		debug_check();
+#ifdef DEBUG_PVALUES
+	debug_check();
+#endif
 	live_pvalues--;
 	ASSERT(live_pvalues>=0);
 #endif
 }
+/*========================================
+ * alloc_pvalue_string -- Copy string for pvalue
+ *  (see comments at top of file)
+ *======================================*/
+STRING
+alloc_pvalue_string (CNSTRING str)
+{
+#ifdef NOBLOCKALLOCATOR
+	return strsave(str);
+#else
+	INT len = strlen(str) + 1, cls;
+	char * cell;
+	ASSERT(reports_time);
+	for (cls = 0; cls < NSTRCLASS; cls++) {
+		if (len < strclass_size[cls])
+			break;
+	}
+	if (cls == NSTRCLASS) {
+		PV_BIGSTR big = stdalloc(sizeof(*big) + 1 + len);
+		big->prev = 0;
+		big->next = bigstr_list;
+		if (bigstr_list)
+			bigstr_list->prev = big;
+		bigstr_list = big;
+		cell = (char *)(big + 1);
+	} else {
+		if (!free_cells[cls]) {
+			/* carve new chunk into cells of this class */
+			PV_CHUNK chunk = stdalloc(sizeof(*chunk));
+			INT size = strclass_size[cls], off;
+			chunk->next = chunk_list;
+			chunk_list = chunk;
+			for (off = CHUNK_BYTES - size; off >= 0; off -= size) {
+				cell = (char *)chunk->cells + off;
+				*(char **)cell = free_cells[cls];
+				free_cells[cls] = cell;
+			}
+		}
+		cell = free_cells[cls];
+		free_cells[cls] = *(char **)cell;
+	}
+	cell[0] = (char)cls;
+	memcpy(cell + 1, str, len);
+	return cell + 1;
+#endif
+}
+/*========================================
+ * free_pvalue_string -- Free string of pvalue
+ *======================================*/
+void
+free_pvalue_string (STRING str)
+{
+#ifdef NOBLOCKALLOCATOR
+	stdfree(str);
+#else
+	char * cell = str - 1;
+	INT cls = cell[0];
+	if (cls == NSTRCLASS) {
+		PV_BIGSTR big = (PV_BIGSTR)cell - 1;
+		if (big->prev)
+			big->prev->next = big->next;
+		else
+			bigstr_list = big->next;
+		if (big->next)
+			big->next->prev = big->prev;
+		stdfree(big);
+		return;
+	}
+	ASSERT(cls >= 0 && cls < NSTRCLASS);
+	*(char **)cell = free_cells[cls];
+	free_cells[cls] = cell;
+#endif
+}
 /*======================================
  * pvalues_begin -- Start of programs
  * Created: 2001/01/20, Perry Rapp
@@ -191,6 +303,7 @@ pvalues_begin (void)
 {
 	ASSERT(!reports_time);
 	reports_time = TRUE;
+	saved_pvalues = 0;
 #ifdef DEBUG_REPORT_MEMORY_DETAIL
 	alloclog_save = alloclog;
 	alloclog = TRUE;
@@ -224,19 +337,41 @@ pvalues_end (void)
 #endif
 }
 /*======================================
- * free_all_pvalues -- Free every pvalue
- * Created: 2001/01/20, Perry Rapp
+ * count_saved_pvalues -- Note allocations avoided
+ *  (or, if n < 0, made after all) by immediate values
  *====================================*/
+void
+count_saved_pvalues (INT n)
+{
+	saved_pvalues += n;
+}
+/*======================================
+ * pvalues_saved -- How many allocations immediate
+ *  values have avoided in this run of programs
+ *====================================*/
+INT
+pvalues_saved (void)
+{
+	return saved_pvalues;
+}
+/*======================================
+ * release_leaked_pvalues -- Release what leaked pvalues hold
+ *  outside the arena (records, nodes, lists, tables, sets)
+ *  Scans the blocks only if any pvalues were leaked.
+ *====================================*/
+#ifndef NOBLOCKALLOCATOR
 static void
-free_all_pvalues (void)
+release_leaked_pvalues (void)
 {
-#ifdef NOBLOCKALLOCATOR
-#else
 	PV_BLOCK block;
+#ifdef DEBUG_PVALUES
 	INT found_leaks=0;
 	INT orig_leaks = live_pvalues;
 	TABLE leaktab = create_table_int(); /* count of leaks by type */
+#endif
 
+	if (!live_pvalues)
+		return;
 	/* Notes
 	live_pvalues is the count of leaked pvalues
 	We have to go through all blocks and free all pvalues
@@ -244,6 +379,7 @@ free_all_pvalues (void)
 	cross-link between blocks (ie, a list on one block could
 	contain pointers to pvalues on other blocks)
 	*/
+#ifdef DEBUG_PVALUES
 	/* First check out all leaked pvalues for consistency
 	 * in numbers - this has to be done first, since when we
 	 * delete a set,list, etc. other pvalues get deleted as well */
@@ -258,30 +394,23 @@ free_all_pvalues (void)
 			}
 		}
 	}
+	ASSERT(orig_leaks == found_leaks);
+#endif
 	for (block = block_list; block; block = block->next) {
-		if (live_pvalues) {
-			INT i;
-			for (i=0; i<(INT)BLOCK_VALUES; i++) {
-				PVALUE val1=&block->values[i];
-				if (val1->type != PFREED) {
-					/* leaked */
-					ZSTR zstr = describe_pvalue(val1);
-					/* zstr is just for debugging, we don't record it */
-					delete_pvalue(val1);
-					zs_free(&zstr);
-				}
+		INT i;
+		for (i=0; i<(INT)BLOCK_VALUES; i++) {
+			PVALUE val1=&block->values[i];
+			switch (val1->type) {
+			/* nothing outside arena to release */
+			case PFREED: case PNULL: case PINT: case PFLOAT:
+			case PBOOL: case PSTRING:
+				break;
+			default:
+				delete_pvalue(val1);
 			}
 		}
 	}
-	ASSERT(orig_leaks == found_leaks);
-	ASSERT(live_pvalues == 0);
-	/* finally, free the blocks */
-	while ((block = block_list)) {
-		PV_BLOCK next = block->next;
-		stdfree(block);
-		block_list = next;
-	}
-	free_list = 0;
+#ifdef DEBUG_PVALUES
 	if (found_leaks) {
 		STRING report_leak_path = getlloptstr("ReportLeakLog", NULL);
 		FILE * fp=0;
@@ -309,17 +438,56 @@ free_all_pvalues (void)
 	destroy_table(leaktab);
 #endif
 }
+#endif
+/*======================================
+ * free_all_pvalues -- Free every pvalue
+ *  (& string of one) in arena, all at once
+ * Created: 2001/01/20, Perry Rapp
+ *====================================*/
+static void
+free_all_pvalues (void)
+{
+#ifdef NOBLOCKALLOCATOR
+#else
+	INT i;
+	release_leaked_pvalues();
+	while (block_list) {
+		PV_BLOCK next = block_list->next;
+		stdfree(block_list);
+		block_list = next;
+	}
+	while (chunk_list) {
+		PV_CHUNK next = chunk_list->next;
+		stdfree(chunk_list);
+		chunk_list = next;
+	}
+	while (bigstr_list) {
+		PV_BIGSTR next = bigstr_list->next;
+		stdfree(bigstr_list);
+		bigstr_list = next;
+	}
+	for (i = 0; i < NSTRCLASS; i++)
+		free_cells[i] = 0;
+	free_list = 0;
+	live_pvalues = 0;
+#endif
+}
 /*======================================
  * check_pvalue_validity -- ASSERT that pvalue is valid
+ *  (only if DEBUG_PVALUES)
  *====================================*/
 void
 check_pvalue_validity (PVALUE val)
 {
+#ifdef DEBUG_PVALUES
 	if (cleaning_time) {
 		ASSERT(is_pvalue_or_freed(val));
 	} else {
 		ASSERT(is_pvalue(val));
 	}
+#else
+	val = val; /* unused */
+#endif
 }
 /*===========================================================
  * is_pvalue -- Checks that PVALUE is a valid type
@@ -334,6 +502,7 @@ is_pvalue (PVALUE pval)
  * is_pvalue_or_freed -- Checks that PVALUE is a valid type
  *  or freed
  *=========================================================*/
+#ifdef DEBUG_PVALUES
 static BOOLEAN
 is_pvalue_or_freed (PVALUE pval)
 {
@@ -341,6 +510,7 @@ is_pvalue_or_freed (PVALUE pval)
 	if (ptype(pval) == PFREED) return TRUE;
 	return (ptype(pval) <= PMAXLIVE);
 }
+#endif
 /*========================================
  * create_new_pvalue -- Create new program value
  *======================================*/
@@ -127,13 +127,13 @@ set_pvalue (PVALUE val, INT type, PVALUE_DATA pvd)
 		val->value.bxd = pvd.bxd;
 	} else if (type == PSTRING) {
 		STRING str = pvd.sxd;
-		/* strings are always copied, no self-assignment issue */
+		/* strings are always copied, before clearing in case
+		 of self-assignment */
+		if (str)
+			str = alloc_pvalue_string(str);
 		clear_pvalue(val);
 		val->type = PSTRING;
-		if (str)
-			val->value.sxd = strsave(str);
-		else
-			val->value.sxd = 0;
+		val->value.sxd = str;
 	} else if (type == PGNODE) {
 		NODE node = pvd.nxd;
 		if (val->type == PGNODE && val->value.nxd == node)
@@ -271,7 +271,7 @@ release_pvalue_contents (PVALUE val)
 		{
 			STRING str = pvalue_to_string(val);
 			if (str) {
-				stdfree(str);
+				free_pvalue_string(str);
 			}
 		}
 		return;
@@ -370,13 +370,16 @@ remove_node_and_delete_pvalue (PVALUE * pval)
 }
 /*========================================
  * delete_pvalue -- Delete a program value
+ *  (immediate values belong to caller, so are left alone)
  * see create_pvalue - Perry Rapp, 2001/01/19
  *======================================*/
 void
 delete_pvalue (PVALUE val)
 {
-	if (!val) return;
-	clear_pvalue(val);
+	if (!val || val->imm) return;
+	/* leaked values being cleaned up may be freed already */
+	if (ptype(val) != PFREED)
+		clear_pvalue(val);
 	free_pvalue_memory(val);
 }
 /*========================================
@@ -391,6 +394,18 @@ delete_pvalue_ptr (PVALUE * valp)
 		*valp = 0;
 	}
 }
+/*====================================
+ * box_pvalue -- Return value as a pvalue of its own
+ *  (copying it, if it is an immediate value)
+ *==================================*/
+PVALUE
+box_pvalue (PVALUE val)
+{
+	if (!val || !val->imm)
+		return val;
+	count_saved_pvalues(-1);
+	return create_pvalue(ptype(val), pvalvv(val));
+}
 /*====================================
  * copy_pvalue -- Create a new pvalue & copy into it
  *  handles NULL
@@ -25,6 +25,9 @@
 /*=============================================================
  * rassa.c -- Handle program report output to the output file
  * Copyright(c) 1991-95 by T.T. Wetmore IV; all rights reserved
+ *  Line mode output is gathered in a large buffer, which is
+ *  written (with writev where available) together with any
+ *  string too long to be worth copying into it.
  * pre-SourceForge version information:
  *   2.3.4 - 24 Jun 93    2.3.5 - 01 Sep 93
  *   3.0.0 - 17 Dec 93    3.0.2 - 15 Dec 94
@@ -45,6 +48,12 @@
 
 #include "interpi.h"
 
+#if defined(HAVE_WRITEV) && defined(HAVE_SYS_UIO_H)
+#include <errno.h>
+#include <sys/uio.h>
+#define RASSA_USE_WRITEV 1
+#endif
+
 
 /*********************************************
  * external/imported variables
@@ -60,15 +69,17 @@ extern INT rpt_cancelled;
 #define MAXPAGESIZE 65536
 #define MAXROWS 512
 #define MAXCOLS 512
+#define OUTBUFSIZE 65536
 
 /*********************************************
  * local function prototypes
  *********************************************/
 
 /* alphabetical */
-static void adjust_cols(STRING);
+static void adjust_cols(CNSTRING str, INT len);
 static BOOLEAN request_file(BOOLEAN *eflg);
 static BOOLEAN set_output_file(STRING outfilename, BOOLEAN append);
+static void write_output(CNSTRING str, INT len);
 
 /*********************************************
  * local variables
@@ -79,9 +90,8 @@ static INT curcol = 1, currow = 1;
 static INT outputmode = BUFFERED;
 
 static STRING pagebuffer = NULL;
-static char linebuffer[1024];
-static INT linebuflen = 0;
-static STRING bufptr = (STRING)linebuffer;
+static char outbuf[OUTBUFSIZE];
+static INT outbuflen = 0;
 
 static STRING outfilename;
 
@@ -97,8 +107,7 @@ void
 initrassa (void)
 {
 	outputmode = BUFFERED;
-	linebuflen = 0;
-	bufptr = (STRING)linebuffer;
+	outbuflen = 0;
 	curcol = 1;
 }
 /*======================================+
@@ -107,10 +116,8 @@ initrassa (void)
 void
 finishrassa (void)
 {
-	if (outputmode == BUFFERED && linebuflen > 0 && Poutfp) {
-		fwrite(linebuffer, linebuflen, 1, Poutfp);
-		linebuflen = 0;
-		bufptr = (STRING)linebuffer;
+	if (outputmode == BUFFERED && outbuflen > 0 && Poutfp) {
+		write_output(NULL, 0);
 		curcol = 1;
 	}
 }
@@ -151,6 +158,7 @@ llrpt_pagemode (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 		return NULL;
 	}
 	*eflg = FALSE;
+	write_output(NULL, 0); /* line mode output so far */
 	outputmode = PAGEMODE;
 	__rows = rows;
 	__cols = cols;
@@ -168,9 +176,8 @@ llrpt_linemode (PNODE node, SYMTAB stab, BOOLEAN *eflg)
 {
 	node=node; /* unused */
 	stab=stab; /* unused */
+	write_output(NULL, 0);
 	outputmode = BUFFERED;
-	linebuflen = 0;
-	bufptr = (STRING)linebuffer;
 	curcol = 1;
 	*eflg = FALSE;
 	return NULL;
@@ -472,9 +479,11 @@ poutput (STRING str, BOOLEAN *eflg)
 	ZSTR zstr = 0;
 	INT c, len;
 	XLAT ttmr = transl_get_predefined_xlat(MINRP);
-	if (!str || (len = strlen(str)) <= 0) return;
-	zstr = translate_string_to_zstring(ttmr, str);
-	str = zs_str(zstr);
+	if (!str || !str[0]) return;
+	if (!transl_is_xlat_identity(ttmr)) {
+		zstr = translate_string_to_zstring(ttmr, str);
+		str = zs_str(zstr);
+	}
 	if ((len = strlen(str)) <= 0)
 		goto exit_poutput;
 	if (!Poutfp) {
@@ -484,31 +493,22 @@ poutput (STRING str, BOOLEAN *eflg)
 	}
 	switch (outputmode) {
 	case UNBUFFERED:
-		fwrite(str, len, 1, Poutfp);
-		adjust_cols(str);
+		write_output(str, len);
+		adjust_cols(str, len);
 		goto exit_poutput;
 	case BUFFERED:
-		if (len >= 1024) {
-			fwrite(linebuffer, linebuflen, 1, Poutfp);
-			fwrite(str, len, 1, Poutfp);
-			linebuflen = 0;
-			bufptr = (STRING)linebuffer;
-			adjust_cols(str);
-			goto exit_poutput;
-		}
-		if (len + linebuflen >= 1024) {
-			fwrite(linebuffer, linebuflen, 1, Poutfp);
-			linebuflen = 0;
-			bufptr = (STRING)linebuffer;
-		}
-		linebuflen += len;
-		while ((c = *bufptr++ = *str++)) {
-			if (c == '\n')
-				curcol = 1;
-			else
-				curcol++;
+		if (len > OUTBUFSIZE - outbuflen) {
+			if (len >= OUTBUFSIZE/4) {
+				/* long, so written along with buffer, not copied */
+				write_output(str, len);
+				adjust_cols(str, len);
+				goto exit_poutput;
+			}
+			write_output(NULL, 0);
 		}
-		--bufptr;
+		memcpy(outbuf + outbuflen, str, len);
+		outbuflen += len;
+		adjust_cols(str, len);
 		goto exit_poutput;
 	case PAGEMODE:
 		p = pagebuffer + (currow - 1)*__cols + curcol - 1;
@@ -532,15 +532,70 @@ exit_poutput:
 }
 /*==================================================+
  * adjust_cols -- Adjust column after printing string
+ *  (from its last line only)
  *=================================================*/
 static void
-adjust_cols (STRING str)
+adjust_cols (CNSTRING str, INT len)
 {
-	INT c;
-	while ((c = *str++)) {
-		if (c == '\n')
-			curcol = 1;
-		else
-			curcol++;
+	CNSTRING p = str + len;
+	while (p > str && p[-1] != '\n')
+		--p;
+	if (p > str)
+		curcol = 1 + (str + len - p);
+	else
+		curcol += len;
+}
+/*==================================================+
+ * write_output -- Write out buffered output, then str
+ *  str:  [IN]  string to follow buffer (may be NULL)
+ *  len:  [IN]  its length
+ *=================================================*/
+static void
+write_output (CNSTRING str, INT len)
+{
+#ifdef RASSA_USE_WRITEV
+	struct iovec iov[2], *piov = iov;
+	int niov = 0;
+	ssize_t rc;
+#endif
+	if (!Poutfp || (!outbuflen && !len)) {
+		outbuflen = 0;
+		return;
+	}
+#ifdef RASSA_USE_WRITEV
+	/* anything written through stdio (eg, prefix) goes first */
+	fflush(Poutfp);
+	if (outbuflen) {
+		iov[niov].iov_base = outbuf;
+		iov[niov++].iov_len = outbuflen;
+	}
+	if (len) {
+		iov[niov].iov_base = (void *)str;
+		iov[niov++].iov_len = len;
 	}
+	while (niov > 0) {
+		rc = writev(fileno(Poutfp), piov, niov);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		/* skip past what was written, in case not all */
+		while (niov > 0 && (size_t)rc >= piov->iov_len) {
+			rc -= piov->iov_len;
+			++piov;
+			--niov;
+		}
+		if (niov > 0) {
+			piov->iov_base = (char *)piov->iov_base + rc;
+			piov->iov_len -= rc;
+		}
+	}
+#else
+	if (outbuflen)
+		fwrite(outbuf, outbuflen, 1, Poutfp);
+	if (len)
+		fwrite(str, len, 1, Poutfp);
+#endif
+	outbuflen = 0;
 }
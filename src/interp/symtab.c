@@ -25,6 +25,13 @@
  * symtab.c -- Symbol tables (lexical scopes)
  * Copyright(c) 1991-95 by T.T. Wetmore IV; all rights reserved
  * Created: 2002.02.17 by Perry Rapp, out of pvalue.c
+ *  Once a report is parsed, each variable named in a proc or
+ *  func is given a slot number in the SCOPE of that proc or
+ *  func, & the slot is stored in the pnodes naming it (along
+ *  with its slot among the globals, if it is one).
+ *  Each call of the proc or func has a symbol table which is
+ *  an array of values by slot, so that reaching a variable
+ *  from its pnode takes no lookup by name.
  *===========================================================*/
 
 #include "llstdlib.h"
@@ -42,10 +49,18 @@
  * local types
  *********************************************/
 
+struct tag_scope {
+	TABLE slotnums; /* slot number of each name */
+	STRING *names;  /* name of each slot */
+	INT count;
+	INT max;
+};
+
 struct tag_symtab_iter {
 	struct tag_vtable *vtable; /* generic object */
 	INT refcnt; /* ref-countable object */
-	TABLE_ITER tabit; /* iterator over our table of symbols */
+	SYMTAB stab; /* symbol table being iterated */
+	INT next; /* next slot to look at */
 };
 /* typedef struct tag_symtab_iter *SYMTAB_ITER; */ /* in interpi.h */
 
@@ -54,10 +69,15 @@ struct tag_symtab_iter {
  *********************************************/
 
 /* alphabetical */
-static SYMTAB create_symtab(CNSTRING title, SYMTAB parstab);
+static SCOPE create_scope(void);
+static SYMTAB create_symtab(CNSTRING title, SCOPE scope, SYMTAB parstab);
 static void free_symtable_iter(SYMTAB_ITER symtabit);
+static void grow_symtab(SYMTAB stab);
 static void record_dead_symtab(SYMTAB symtab);
 static void record_live_symtab(SYMTAB symtab);
+static void resolve_pnodes(SCOPE scope, PNODE node);
+static INT scope_slot(SCOPE scope, CNSTRING name, BOOLEAN add);
+static CNSTRING slot_name(PNODE node, INT which);
 static void symtabit_destructor(VTABLE *obj);
 
 /*********************************************
@@ -91,17 +111,104 @@ LIST live_symtabs=0; /* list of symbol tables, to check for leaks */
 void
 insert_symtab (SYMTAB stab, CNSTRING iden, PVALUE val)
 {
-	insert_table_ptr(stab->tab, iden, val);
+	INT slot = scope_slot(stab->scope, iden, TRUE);
+	if (slot >= stab->nslots)
+		grow_symtab(stab);
+	if (stab->slots[slot])
+		delete_pvalue(stab->slots[slot]);
+	stab->slots[slot] = val;
 }
 /*======================================================
- * delete_symtab_element -- Delete a value from a symbol table
- *  stab: [I/O] symbol table
- *  iden: [IN]  variable in symbol table
+ * insert_symtab_slot -- Update symbol table with PVALUE
+ *  stab:  [I/O] symbol table
+ *  node:  [IN]  pnode naming variable
+ *  which: [IN]  which variable of pnode (ISLOT_VAR, etc)
+ *  val:   [IN]  already created PVALUE
+ *====================================================*/
+void
+insert_symtab_slot (SYMTAB stab, PNODE node, INT which, PVALUE val)
+{
+	PVALUE *pval = symtab_slot(stab, node, which, TRUE);
+	if (*pval)
+		delete_pvalue(*pval);
+	*pval = val;
+}
+/*======================================================
+ * delete_symtab_slot -- Delete a value from a symbol table
+ *  stab:  [I/O] symbol table
+ *  node:  [IN]  pnode naming variable
+ *  which: [IN]  which variable of pnode (ISLOT_VAR, etc)
  *====================================================*/
 void
-delete_symtab_element (SYMTAB stab, STRING iden)
+delete_symtab_slot (SYMTAB stab, PNODE node, INT which)
+{
+	PVALUE *pval = symtab_slot(stab, node, which, FALSE);
+	if (pval && *pval) {
+		delete_pvalue(*pval);
+		*pval = 0;
+	}
+}
+/*======================================================
+ * symtab_slot -- Find slot of variable in symbol table
+ *  stab:   [IN]  symbol table
+ *  node:   [IN]  pnode naming variable
+ *  which:  [IN]  which variable of pnode (ISLOT_VAR, etc)
+ *  create: [IN]  make slot if variable has none ?
+ * returns slot (holding 0 if variable is not set), or 0
+ *  if no slot & not create
+ *====================================================*/
+PVALUE *
+symtab_slot (SYMTAB stab, PNODE node, INT which, BOOLEAN create)
+{
+	INT slot;
+	if (node->i_scope && (which == ISLOT_GLOBAL
+		? stab == globtab : node->i_scope == stab->scope)) {
+		/* resolved to this table, so no lookup by name */
+		slot = node->i_slot[which];
+	} else {
+		slot = scope_slot(stab->scope, slot_name(node, which), create);
+	}
+	if (slot < 0)
+		return 0;
+	if (slot >= stab->nslots) {
+		if (!create)
+			return 0;
+		grow_symtab(stab);
+	}
+	return &stab->slots[slot];
+}
+/*======================================================
+ * slot_name -- Name of variable of pnode
+ *  which: [IN]  which variable of pnode (ISLOT_VAR, etc)
+ *====================================================*/
+static CNSTRING
+slot_name (PNODE node, INT which)
 {
-	delete_table_element(stab->tab, iden);
+	if (itype(node) == IIDENT)
+		return iident_name(node);
+	switch (which) {
+	case ISLOT_VAR: return (CNSTRING)node->i_word2;
+	case ISLOT_VAR2: return (CNSTRING)node->i_word3;
+	case ISLOT_NUM: return (CNSTRING)node->i_word4;
+	}
+	ASSERT(0);
+	return 0;
+}
+/*======================================================
+ * grow_symtab -- Make room for every slot of scope
+ *====================================================*/
+static void
+grow_symtab (SYMTAB stab)
+{
+	INT n = stab->scope->max;
+	PVALUE *slots = (PVALUE *)stdalloc(n * sizeof(PVALUE));
+	memset(slots, 0, n * sizeof(PVALUE));
+	if (stab->slots) {
+		memcpy(slots, stab->slots, stab->nslots * sizeof(PVALUE));
+		stdfree(stab->slots);
+	}
+	stab->slots = slots;
+	stab->nslots = n;
 }
 /*========================================
  * remove_symtab -- Remove symbol table 
@@ -110,24 +217,34 @@ delete_symtab_element (SYMTAB stab, STRING iden)
 void
 remove_symtab (SYMTAB stab)
 {
+	INT i;
 	ASSERT(stab);
 
 	record_dead_symtab(stab);
 
-	destroy_table(stab->tab);
+	for (i = 0; i < stab->nslots; i++) {
+		if (stab->slots[i])
+			delete_pvalue(stab->slots[i]);
+	}
+	if (stab->slots)
+		stdfree(stab->slots);
+	if (stab->ownscope)
+		free_scope(stab->scope);
 
 	stdfree(stab);
 }
 /*======================================================
  * create_symtab_proc -- Create a symbol table for a procedure
+ *  defn:    [IN]  proc or func being called
+ *  parstab: [IN]  symbol table of caller
  *  returns allocated SYMTAB
  *====================================================*/
 SYMTAB
-create_symtab_proc (CNSTRING procname, SYMTAB parstab)
+create_symtab_proc (PNODE defn, SYMTAB parstab)
 {
 	char title[128];
-	llstrncpyf(title, sizeof(title), uu8, "proc: %s", procname);
-	return create_symtab(title, parstab);
+	llstrncpyf(title, sizeof(title), uu8, "proc: %s", (STRING)iname(defn));
+	return create_symtab(title, defn->i_scope, parstab);
 }
 /*======================================================
  * create_symtab_global -- Create a global symbol table
@@ -136,22 +253,29 @@ create_symtab_proc (CNSTRING procname, SYMTAB parstab)
 SYMTAB
 create_symtab_global (void)
 {
-	return create_symtab("global", NULL);
+	return create_symtab("global", NULL, NULL);
 }
 /*======================================================
  * create_symtab -- Create a symbol table
  *  @title:    [IN]  title (procedure or func name)
+ *  @scope:    [IN]  names of slots (0 to give table its own)
  *  @parstab:  [IN]  (dynamic) parent symbol table
  *                    only for debugging, not for scope
  *  returns allocated SYMTAB
  *====================================================*/
 static SYMTAB
-create_symtab (CNSTRING title, SYMTAB parstab)
+create_symtab (CNSTRING title, SCOPE scope, SYMTAB parstab)
 {
 	SYMTAB symtab = (SYMTAB)stdalloc(sizeof(*symtab));
 	memset(symtab, 0, sizeof(*symtab));
 
-	symtab->tab = create_table_custom_vptr(delete_vptr_pvalue);
+	if (!scope) {
+		scope = create_scope();
+		symtab->ownscope = TRUE;
+	}
+	symtab->scope = scope;
+	if (scope->count)
+		grow_symtab(symtab);
 	symtab->parent = parstab;
 	llstrncpyf(symtab->title, sizeof(symtab->title), uu8, "%s", title);
 
@@ -206,7 +330,9 @@ symbol_tables_end (void)
 BOOLEAN
 in_symtab (SYMTAB stab, CNSTRING key)
 {
-	return in_table(stab->tab, key);
+	BOOLEAN there;
+	symtab_valueofbool(stab, key, &there);
+	return there;
 }
 /*======================================================
  * symtab_valueofbool -- Convert pvalue to boolean if present
@@ -218,7 +344,23 @@ in_symtab (SYMTAB stab, CNSTRING key)
 PVALUE
 symtab_valueofbool (SYMTAB stab, CNSTRING key, BOOLEAN *there)
 {
-	return (PVALUE)valueofbool_ptr(stab->tab, key, there);
+	INT slot = scope_slot(stab->scope, key, FALSE);
+	PVALUE val = (slot >= 0 && slot < stab->nslots) ? stab->slots[slot] : 0;
+	*there = (val != 0);
+	return val;
+}
+/*======================================================
+ * symtab_count -- Number of variables set in symbol table
+ *====================================================*/
+INT
+symtab_count (SYMTAB stab)
+{
+	INT i, n = 0;
+	for (i = 0; i < stab->nslots; i++) {
+		if (stab->slots[i])
+			++n;
+	}
+	return n;
 }
 /*======================================================
  * begin_symtab_iter -- Begin iterating a symbol table
@@ -232,7 +374,7 @@ begin_symtab_iter (SYMTAB stab)
 	memset(symtabit, 0, sizeof(*symtabit));
 	symtabit->vtable = &vtable_for_symtabit;
 	++symtabit->refcnt;
-	symtabit->tabit = begin_table_iter(stab->tab);
+	symtabit->stab = stab;
 	return symtabit;
 }
 /*======================================================
@@ -244,13 +386,18 @@ begin_symtab_iter (SYMTAB stab)
 BOOLEAN
 next_symtab_entry (SYMTAB_ITER symtabit, CNSTRING *pkey, PVALUE *ppval)
 {
-	VPTR vptr=0;
+	SYMTAB stab = symtabit->stab;
 	*pkey=0;
 	*ppval=0;
-	if (!next_table_ptr(symtabit->tabit, pkey, &vptr))
-		return FALSE;
-	*ppval = vptr;
-	return TRUE;
+	while (symtabit->next < stab->nslots) {
+		INT slot = symtabit->next++;
+		if (stab->slots[slot]) {
+			*pkey = stab->scope->names[slot];
+			*ppval = stab->slots[slot];
+			return TRUE;
+		}
+	}
+	return FALSE;
 }
 /*=================================================
  * end_symtab_iter -- Release reference to symbol table iterator object
@@ -260,7 +407,6 @@ end_symtab_iter (SYMTAB_ITER * psymtabit)
 {
 	ASSERT(psymtabit);
 	ASSERT(*psymtabit);
-	end_table_iter(&(*psymtabit)->tabit);
 	--(*psymtabit)->refcnt;
 	if (!(*psymtabit)->refcnt) {
 		free_symtable_iter(*psymtabit);
@@ -289,3 +435,122 @@ symtabit_destructor (VTABLE *obj)
 	ASSERT((*obj) == &vtable_for_symtabit);
 	free_symtable_iter(symtabit);
 }
+/*======================================================
+ * create_scope -- Create empty scope
+ *====================================================*/
+static SCOPE
+create_scope (void)
+{
+	SCOPE scope = (SCOPE)stdalloc(sizeof(*scope));
+	memset(scope, 0, sizeof(*scope));
+	scope->slotnums = create_table_int();
+	return scope;
+}
+/*======================================================
+ * free_scope -- Free scope & its names
+ *====================================================*/
+void
+free_scope (SCOPE scope)
+{
+	INT i;
+	if (!scope) return;
+	destroy_table(scope->slotnums);
+	for (i = 0; i < scope->count; i++)
+		stdfree(scope->names[i]);
+	if (scope->names)
+		stdfree(scope->names);
+	stdfree(scope);
+}
+/*======================================================
+ * scope_slot -- Find slot number of name
+ *  add: [IN]  give name a slot if it has none ?
+ * returns -1 if name has no slot (& not add)
+ *====================================================*/
+static INT
+scope_slot (SCOPE scope, CNSTRING name, BOOLEAN add)
+{
+	BOOLEAN there;
+	INT slot = valueofbool_int(scope->slotnums, name, &there);
+	if (there)
+		return slot;
+	if (!add)
+		return -1;
+	if (scope->count == scope->max) {
+		STRING *names;
+		scope->max = scope->max ? 2*scope->max : 8;
+		names = (STRING *)stdalloc(scope->max * sizeof(STRING));
+		if (scope->count) {
+			memcpy(names, scope->names, scope->count * sizeof(STRING));
+			stdfree(scope->names);
+		}
+		scope->names = names;
+	}
+	slot = scope->count++;
+	scope->names[slot] = strsave(name);
+	insert_table_int(scope->slotnums, name, slot);
+	return slot;
+}
+/*======================================================
+ * resolve_slots -- Give slots to variables of proc or func
+ *  & store them in its pnodes (after parsing, once all
+ *  globals are declared)
+ *  defn: [I/O] proc or func definition
+ *====================================================*/
+void
+resolve_slots (PNODE defn)
+{
+	if (defn->i_scope)
+		return; /* already done */
+	defn->i_scope = create_scope();
+	resolve_pnodes(defn->i_scope, (PNODE)iargs(defn));
+	resolve_pnodes(defn->i_scope, (PNODE)ibody(defn));
+}
+/*======================================================
+ * resolve_pnodes -- Give slots to variables of pnodes
+ *  scope: [I/O] scope of enclosing proc or func
+ *  node:  [I/O] first of list of pnodes
+ *====================================================*/
+static void
+resolve_pnodes (SCOPE scope, PNODE node)
+{
+	INT which;
+	for ( ; node; node = inext(node)) {
+		node->i_scope = scope;
+		switch (itype(node)) {
+		case IIDENT:
+			node->i_slot[ISLOT_VAR] = scope_slot(scope, iident_name(node), TRUE);
+			node->i_slot[ISLOT_GLOBAL] = scope_slot(globtab->scope
+				, iident_name(node), FALSE);
+			break;
+		case IIF:
+			resolve_pnodes(scope, node->vars.iif.icond);
+			resolve_pnodes(scope, node->vars.iif.ithen);
+			resolve_pnodes(scope, node->vars.iif.ielse);
+			break;
+		case IWHILE:
+			resolve_pnodes(scope, node->vars.iwhile.icond);
+			resolve_pnodes(scope, node->vars.iwhile.ibody);
+			break;
+		case IPCALL:
+			resolve_pnodes(scope, node->vars.ipcall.fargs);
+			break;
+		case IRETURN:
+		case IFCALL:
+		case IBCALL:
+			resolve_pnodes(scope, (PNODE)iargs(node));
+			break;
+		case ITRAV: case INODES: case IFAMILIES: case ISPOUSES:
+		case ICHILDREN: case IINDI: case IFAM: case ISOUR: case IEVEN:
+		case IOTHR: case ILIST: case ISET: case IFATHS: case IMOTHS:
+		case IFAMCS: case INOTES: case IFAMILYSPOUSES:
+			/* loop variables are named in the loop node itself */
+			resolve_pnodes(scope, (PNODE)iloopexp(node));
+			for (which = ISLOT_VAR; which <= ISLOT_NUM; which++) {
+				CNSTRING name = slot_name(node, which);
+				node->i_slot[which] = name ? scope_slot(scope, name, TRUE) : -1;
+			}
+			resolve_pnodes(scope, (PNODE)ibody(node));
+			break;
+		}
+	}
+}
@@ -63,8 +63,8 @@ struct tag_trav_parm {
  *********************************************/
 
 /* alphabetical */
-static BOOLEAN archive(BTREE btree, BLOCK block, void * param);
-static void copy_and_translate(FILE *fo, INT len, struct tag_trav_parm * travparm, char ctype, XLAT xlat);
+static void archive(struct tag_trav_parm * travparm);
+static void copy_and_translate(STRING rec, INT len, struct tag_trav_parm * travparm, char ctype, XLAT xlat);
 
 /*********************************************
  * local variables
@@ -129,64 +129,47 @@ archive_in_file (struct tag_export_feedback * efeed, FILE *fp)
 	memset(&travparm, 0, sizeof(travparm));
 	travparm.efeed = efeed;
 	travparm.fp = fp;
-	traverse_index_blocks(BTR, bmaster(BTR), &travparm, NULL, archive);
+	archive(&travparm);
 	fprintf(fp, "0 TRLR\n");
 	return TRUE;
 }
 /*========================================================
- * archive -- Traverse function called on each btree block
+ * archive -- Write out each record of database
+ *  (pulled in key order through btree cursor, which also
+ *  expands compressed records)
  *======================================================*/
-static BOOLEAN
-archive (BTREE btree, BLOCK block, void * param)
+static void
+archive (struct tag_trav_parm * travparm)
 {
-	INT i, n, l;
-	char scratch[100];
-	FILE *fo=0;
-	struct tag_trav_parm * travparm = (struct tag_trav_parm *)param;
-
-	snprintf(scratch, sizeof(scratch), "%s/%s", bbasedir(btree), fkey2path(ixself(block)));
-	fo = fopen(scratch, LLREADBINARY);
-	ASSERT(fo);
-	n = nkeys(block);
-	for (i = 0; i < n; i++) {
-		STRING key = rkey2str(rkeys(block, i));
-		if (*key != 'I' && *key != 'F' && *key != 'E' &&
-		    *key != 'S' && *key != 'X')
-			continue;
-		if (fseek(fo, (long)(offs(block, i) + BUFLEN), 0))
-			FATAL();
-		if ((l = lens(block, i)) > 6)	/* filter deleted records */
-			copy_and_translate(fo, l, travparm, *key, xlat_gedout);
+	BTCURSOR cursor = bt_cursor_open(BTR, FALSE);
+	RKEY rkey;
+	RAWRECORD rec;
+	INT len;
+
+	while (bt_cursor_next(cursor, &rkey, &rec, &len)) {
+		STRING key = rkey2str(rkey);
+		if ((*key == 'I' || *key == 'F' || *key == 'E' ||
+		    *key == 'S' || *key == 'X')
+			&& len > 6)	/* filter deleted records */
+			copy_and_translate(rec, len, travparm, *key, xlat_gedout);
+		if (rec)
+			stdfree(rec);
 	}
-	fclose(fo);
-	return TRUE;
+	bt_cursor_close(cursor);
 }
 /*===================================================
  * copy_and_translate -- Copy record with translation
  *=================================================*/
 static void
-copy_and_translate (FILE *fo, INT len, struct tag_trav_parm * travparm, char ctype, XLAT xlat)
+copy_and_translate (STRING rec, INT len, struct tag_trav_parm * travparm, char ctype, XLAT xlat)
 {
-	char in[BUFLEN]="";
-	char *inp=0;
-	INT remlen=0, num=0;
+	INT num=0;
 	FILE * fn = travparm->fp;
 	struct tag_export_feedback * efeed = travparm->efeed;
-	
-	inp = in;		/* location for next read */
-	remlen = BUFLEN;	/* max for next read */
-	while (len > 0) {
-		BOOLEAN last=FALSE, ok=FALSE;
-		if(len < remlen) remlen = len;
-		ASSERT(fread(inp, remlen, 1, fo) == 1);
-		len -= remlen;
-		remlen = (inp + remlen) - in;	/* amount in current buffer */
-		last = (len <= 0);
-		ok = translate_write(xlat, in, &remlen, fn, last);
-		ASSERT(ok);
-		inp = in + remlen;		/* position for next read */
-		remlen = BUFLEN - remlen;	/* max for next read */
-	}
+	BOOLEAN ok=FALSE;
+
+	ok = translate_write(xlat, rec, &len, fn, TRUE);
+	ASSERT(ok);
 	num = 0;
 	switch (ctype) {
 	case 'I': num = ++nindi; break;
@@ -31,6 +31,7 @@
  *========================================================*/
 
 #include "llstdlib.h"
+#include "btree.h"
 #include "table.h"
 #include "translat.h"
 #include "gedcom.h"
@@ -63,6 +64,7 @@ extern INT gd_smax;	/* maximum source key number */
 extern INT gd_emax;	/* maximum event key number */
 extern INT gd_xmax;	/* maximum other key number */
 
+extern BTREE BTR;
 extern STRING qSgdnadd, qSdboldk, qSdbnewk;
 extern STRING qScfoldk, qSunsupuniv, qSproceed;
 
@@ -144,6 +146,7 @@ do_import (IMPORT_FEEDBACK ifeed, FILE *fp)
 	TABLE metadatatab = create_table_str();
 	STRING gdcodeset=0;
 	INT warnings=0;
+	BOOLEAN empty=FALSE, bulk=FALSE, group=FALSE;
 
 	/* start by assuming default */
 	strupdate(&gdcodeset, gedcom_codeset_in);
@@ -247,11 +250,12 @@ retry_input_codeset:
 		}
 	}
 	
-	if((num_indis() > 0)
-		|| (num_fams() > 0)
-		|| (num_sours() > 0)
-		|| (num_evens() > 0)
-		|| (num_othrs() > 0)) gd_reuse = FALSE;
+	empty = !(num_indis() > 0
+		|| num_fams() > 0
+		|| num_sours() > 0
+		|| num_evens() > 0
+		|| num_othrs() > 0);
+	if(!empty) gd_reuse = FALSE;
 	else if((gd_reuse = check_stdkeys())) {
 		totused = gd_itot + gd_ftot + gd_stot + gd_etot + gd_xtot;
 		totkeys = gd_imax + gd_fmax + gd_smax + gd_emax + gd_xmax;
@@ -294,6 +298,12 @@ TODO: why were these here ?
 
 
 /* Add records to database */
+	/* into an empty database, buffer them & build btree in one pass */
+	/* else commit them to the journal together */
+	if (empty)
+		bulk = bt_bulk_begin(BTR);
+	if (!bulk)
+		group = bt_begin_group(BTR);
 	node = convert_first_fp_to_node(fp, FALSE, ttm, &msg, &emp);
 	while (node) {
 		if (!(conv = node_to_node(node, &type))) {
@@ -327,6 +337,10 @@ TODO: why were these here ?
 		addmissingkeys(SOUR_REC);
 		addmissingkeys(OTHR_REC);
 	}
+	if (bulk)
+		bt_bulk_end(BTR);
+	if (group)
+		bt_commit_group(BTR);
 	succeeded = TRUE;
 
 end_import:
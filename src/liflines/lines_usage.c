@@ -37,6 +37,9 @@ print_lines_usage (CNSTRING exename)
 	printf(_("Usage: %s [OPTIONS] [database]"), exename);
 	printf("\n\n");
 	printf(_("Options:"));
+	printf("\n\t-B\n\t\t");
+	printf(_("compile report programs to bytecode (instead of interpreting\n"
+		"\t\tthem as parsed)"));
 	printf("\n\t");
 	printf(_("-C[FILE]"));
 	printf("\n\t\t");
@@ -50,10 +53,10 @@ print_lines_usage (CNSTRING exename)
 	printf("\n\t-a\n\t\t");
 	printf(_("log dynamic memory operation (for debugging)"));
 	printf("\n\t");
-	printf(_("-c[TYPE][DIRECT,INDIRECT]"));
+	printf(_("-c[TYPE][COUNT]"));
 	printf("\n\t\t");
-	printf(_("supply cache values (eg, -ci400,4000f400,4000 sets direct indi\n"
-		"\t\t& fam caches to 400, and indirect indi & fam caches to 4000)"));
+	printf(_("supply record counts (eg, -ci400f400 for indis & fams); the record\n"
+		"\t\tcache keeps at least their total, whatever RecordCacheMB says"));
 	printf("\n\t-d\n\t\t");
 	printf(_("debug mode (disable signal trapping)"));
 	printf("\n\t-f\n\t\t");
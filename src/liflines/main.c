@@ -178,7 +178,7 @@ main (int argc, char **argv)
 
 	/* Parse Command-Line Arguments */
 	opterr = 0;	/* turn off getopt's error message */
-	while ((c = getopt(argc, argv, "adkrwil:fntc:Fu:x:o:zC:I:vh?")) != -1) {
+	while ((c = getopt(argc, argv, "adkrwil:fntBc:Fu:x:o:zC:I:vh?")) != -1) {
 		switch (c) {
 		case 'c':	/* adjust cache sizes */
 			while(optarg && *optarg) {
@@ -259,6 +259,9 @@ main (int argc, char **argv)
 		case 't': /* show lots of trace statements for debugging */
 			prog_trace = TRUE;
 			break;
+		case 'B': /* compile report programs */
+			prog_bytecode = TRUE;
+			break;
 		case 'u': /* specify screen dimensions */
 			sscanf(optarg, SCN_INT "," SCN_INT, &winx, &winy);
 			break;
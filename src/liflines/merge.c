@@ -46,6 +46,7 @@
  *********************************************/
 
 extern BOOLEAN traditional;
+extern BTREE BTR;
 extern STRING qSiredit, qScfpmrg, qSnopmrg, qSnoqmrg, qSnoxmrg, qSnofmrg;
 extern STRING qSdhusb,  qSdwife,  qScffmrg, qSfredit, qSbadata, qSronlym;
 extern STRING qSmgsfam,qSmgconf;
@@ -95,6 +96,7 @@ merge_two_indis (NODE indi1, NODE indi2, BOOLEAN conf)
 	INT sx2;
 	STRING msg, key;
  	BOOLEAN emp;
+	BOOLEAN group;
 
 /* Do start up checks */
 
@@ -223,6 +225,9 @@ merge_two_indis (NODE indi1, NODE indi2, BOOLEAN conf)
 
 /* Modify families that have persons as children */
 
+	/* all database writes of the merge are committed together */
+	group = bt_begin_group(BTR);
+
 	classify_nodes(&famc1, &famc2, &fam12);
 
 /*
@@ -419,6 +424,7 @@ merge_two_indis (NODE indi1, NODE indi2, BOOLEAN conf)
 /* sanity check lineage links */
 	check_indi_lineage_links(indi02);
 
+	if (group) bt_commit_group(BTR);
 	return node_to_record(indi02);   /* this is the updated indi2 */
 }
 /*=================================================================
@@ -444,6 +450,7 @@ merge_two_fams (NODE fam1, NODE fam2)
 	FILE *fp;
 	STRING msg;
 	BOOLEAN emp;
+	BOOLEAN group;
 
 	if (readonly) {
 		message("%s", _(qSronlym));
@@ -535,6 +542,9 @@ merge_two_fams (NODE fam1, NODE fam2)
 	}
 	split_fam(fam4, &fref4, &husb4, &wife4, &chil4, &rest4);
 
+	/* all database writes of the merge are committed together */
+	group = bt_begin_group(BTR);
+
  /* Modify links between persons and families */
 #define CHUSB 1
 #define CWIFE 2
@@ -559,7 +569,8 @@ merge_two_fams (NODE fam1, NODE fam2)
 
 /* sanity check lineage links */
 	check_fam_lineage_links(fam2);
-	
+
+	if (group) bt_commit_group(BTR);
 	return node_to_record(fam2);
 }
 /*================================================================
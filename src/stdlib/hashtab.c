@@ -26,6 +26,10 @@
  hashtab contains a simple hash table implementation
  keys are strings (hash table copies & manages memory itself for keys
  values (void * pointers, they are client's responsibility to free) 
+ Entries are kept in one array of slots (open addressing, linear
+ probing), which doubles when it gets 3/4 full. Each slot keeps the
+ hash of its key, so probes rarely compare strings, and short keys
+ are kept in the slot itself, rather than allocated.
 */
 
 #include "llstdlib.h"
@@ -35,27 +39,29 @@
  * local enums & defines
  *********************************************/
 
-#define MAXHASH_DEF 512
+#define HASH_MINSIZE 16 /* slots in new table (power of 2) */
+#define HASH_INLINE 16 /* keys shorter than this are kept in slot */
 
 /*********************************************
  * local types
  *********************************************/
 
-/* entry in hash table */
-struct tag_hashent {
-	CNSTRING magic;
-	CNSTRING ekey;
+/* slot of hash table */
+struct tag_hashslot {
+	unsigned long hval; /* hash of key */
+	STRING ekey; /* 0 if empty, removed_key if removed, else key */
 	HVALUE val;
-	struct tag_hashent *enext;
+	char kbuf[HASH_INLINE]; /* ekey points here if key is short */
 };
-typedef struct tag_hashent *HASHENT;
+typedef struct tag_hashslot *HASHSLOT;
 
 /* hash table */
 struct tag_hashtab {
 	CNSTRING magic;
-	HASHENT *entries;
+	HASHSLOT slots;
 	INT count; /* #entries */
-	INT maxhash;
+	INT nremoved; /* #slots of removed entries */
+	INT size; /* #slots (power of 2) */
 };
 /* typedef struct tag_hashtab *HASHTAB */ /* in hashtab.h */
 
@@ -63,17 +69,20 @@ struct tag_hashtab {
 struct tag_hashtab_iter {
 	CNSTRING magic;
 	HASHTAB hashtab;
-	INT index;
-	HASHENT enext;
+	INT index; /* next slot to look at, -1 when finished */
+	HASHSLOT slot; /* slot last returned */
 };
 
 /*********************************************
  * local function prototypes
  *********************************************/
 
-static HASHENT create_entry(CNSTRING key, HVALUE val);
-static HASHENT fndentry(HASHTAB tab, CNSTRING key);
-static INT hash(HASHTAB tab, CNSTRING key);
+/* alphabetical */
+static HASHSLOT fndslot(HASHTAB tab, CNSTRING key, unsigned long hval);
+static unsigned long hash(CNSTRING key);
+static void rehash(HASHTAB tab, INT size);
+static void set_key(HASHSLOT slot, CNSTRING key, unsigned long hval);
+static void unset_key(HASHSLOT slot);
 
 /*********************************************
  * local variables
@@ -81,9 +90,11 @@ static INT hash(HASHTAB tab, CNSTRING key);
 
 /* fixed magic strings to verify object identity */
 static CNSTRING hashtab_magic = "HASHTAB_MAGIC";
-static CNSTRING hashent_magic = "HASHENT_MAGIC";
 static CNSTRING hashtab_iter_magic = "HASHTAB_ITER_MAGIC";
 
+/* marks slot of removed entry, which probes must pass over */
+static char removed_key[] = "";
+
 /*********************************************
  * local & exported function definitions
  * body of module
@@ -97,8 +108,8 @@ create_hashtab (void)
 {
 	HASHTAB tab = (HASHTAB)stdalloc(sizeof(*tab));
 	tab->magic = hashtab_magic;
-	tab->maxhash = MAXHASH_DEF;
-	tab->entries = (HASHENT *)stdalloc(tab->maxhash * sizeof(HASHENT));
+	tab->size = HASH_MINSIZE;
+	tab->slots = (HASHSLOT)stdalloc(tab->size * sizeof(struct tag_hashslot));
 	return tab;
 }
 /*================================
@@ -110,22 +121,17 @@ destroy_hashtab (HASHTAB tab, DELFUNC func)
 	INT i=0;
 	if (!tab) return;
 	ASSERT(tab->magic == hashtab_magic);
-	for (i=0; i<tab->maxhash; ++i) {
-		HASHENT entry = tab->entries[i];
-		HASHENT next=0;
-		while (entry) {
-			ASSERT(entry->magic == hashent_magic);
-			next = entry->enext;
-			if (func)
-				(*func)(entry->val);
-			entry->val = 0;
-			strfree((STRING *)&entry->ekey);
-			stdfree(entry);
-			entry = next;
-		}
+	for (i=0; i<tab->size; ++i) {
+		HASHSLOT slot = &tab->slots[i];
+		if (!slot->ekey || slot->ekey == removed_key)
+			continue;
+		if (func)
+			(*func)(slot->val);
+		slot->val = 0;
+		unset_key(slot);
 	}
-	stdfree(tab->entries);
-	tab->entries = 0;
+	stdfree(tab->slots);
+	tab->slots = 0;
 	stdfree(tab);
 }
 /*======================
@@ -146,39 +152,49 @@ get_hashtab_count (HASHTAB tab)
 HVALUE
 insert_hashtab (HASHTAB tab, CNSTRING key, HVALUE val)
 {
-	HASHENT entry=0;
-	INT hval=0;
+	HASHSLOT slot=0, reuse=0;
+	unsigned long hval=0;
+	INT mask=0, i=0;
 
 	ASSERT(tab);
 	ASSERT(tab->magic == hashtab_magic);
 
-	/* find appropriate has chain */
-	hval = hash(tab, key);
-	if (!tab->entries[hval]) {
-		/* table lacks entry for this key, create it */
-		entry = create_entry(key, val);
-		tab->entries[hval] = entry;
-		++tab->count;
-		return 0; /* no old value */
-	}
-	entry = tab->entries[hval];
-	while (TRUE) {
-		ASSERT(entry->magic == hashent_magic);
-		if (eqstr(key, entry->ekey)) {
+	hval = hash(key);
+	mask = tab->size - 1;
+	for (i = (INT)(hval & mask); ; i = (i + 1) & mask) {
+		slot = &tab->slots[i];
+		if (!slot->ekey)
+			break;
+		if (slot->ekey == removed_key) {
+			if (!reuse)
+				reuse = slot;
+		} else if (slot->hval == hval && eqstr(key, slot->ekey)) {
 			/* table already has entry for this key, replace it */
-			HVALUE old = entry->val;
-			entry->val = val;
+			HVALUE old = slot->val;
+			slot->val = val;
 			return old;
 		}
-		if (!entry->enext) {
-			/* table lacks entry for this key, create it */
-			HASHENT newent = create_entry(key, val);
-			entry->enext = newent;
-			++tab->count;
-			return 0; /* no old value */
-		}
-		entry = entry->enext;
 	}
+	/* table lacks entry for this key, create it */
+	if (reuse) {
+		/* reuse slot of removed entry */
+		slot = reuse;
+		--tab->nremoved;
+	} else if ((tab->count + tab->nremoved + 1) * 4 > tab->size * 3) {
+		/* keep at most half full after rehash */
+		INT size = HASH_MINSIZE;
+		while (size < (tab->count + 1) * 2)
+			size *= 2;
+		rehash(tab, size);
+		mask = tab->size - 1;
+		for (i = (INT)(hval & mask); tab->slots[i].ekey; i = (i + 1) & mask)
+			;
+		slot = &tab->slots[i];
+	}
+	set_key(slot, key, hval);
+	slot->val = val;
+	++tab->count;
+	return 0; /* no old value */
 }
 /*======================
  * remove_hashtab -- Remove element from table
@@ -188,30 +204,20 @@ HVALUE
 remove_hashtab (HASHTAB tab, CNSTRING key)
 {
 	HVALUE val=0;
-	INT hval=0;
-	HASHENT preve=0, thise=0;
+	HASHSLOT slot=0;
 
 	ASSERT(tab);
 	ASSERT(tab->magic == hashtab_magic);
 
-	hval = hash(tab, key);
-	thise = tab->entries[hval];
-	while (thise && nestr(key, thise->ekey)) {
-		ASSERT(thise->magic == hashent_magic);
-		preve = thise;
-		thise = thise->enext;
-	}
-	if (!thise) return 0;
-	if (preve)
-		preve->enext = thise->enext;
-	else
-		tab->entries[hval] = thise->enext;
-
-	val = thise->val;
-	strfree((STRING *)&thise->ekey);
-	thise->val = 0;
-	stdfree(thise);
+	slot = fndslot(tab, key, hash(key));
+	if (!slot) return 0;
+
+	val = slot->val;
+	unset_key(slot);
+	slot->ekey = removed_key;
+	slot->val = 0;
 	--tab->count;
+	++tab->nremoved;
 	return val;
 }
 /*======================
@@ -221,17 +227,16 @@ remove_hashtab (HASHTAB tab, CNSTRING key)
 HVALUE
 find_hashtab (HASHTAB tab, CNSTRING key, BOOLEAN * present)
 {
-	HASHENT entry=0;
+	HASHSLOT slot=0;
 
 	ASSERT(tab);
 	ASSERT(tab->magic == hashtab_magic);
 
-	entry = fndentry(tab, key);
-	if (present) *present = !!entry;
-	if (!entry) return 0;
+	slot = key ? fndslot(tab, key, hash(key)) : 0;
+	if (present) *present = !!slot;
+	if (!slot) return 0;
 
-	ASSERT(entry->magic == hashent_magic);
-	return entry->val;
+	return slot->val;
 }
 /*======================
  * in_hashtab -- Find and return value
@@ -239,55 +244,91 @@ find_hashtab (HASHTAB tab, CNSTRING key, BOOLEAN * present)
 BOOLEAN
 in_hashtab (HASHTAB tab, CNSTRING key)
 {
-	HASHENT entry=0;
-
 	ASSERT(tab);
 	ASSERT(tab->magic == hashtab_magic);
 
-	entry = fndentry(tab, key);
-	return (entry != 0);
+	if (!key) return FALSE;
+	return fndslot(tab, key, hash(key)) != 0;
 }
 /*================================
- * fndentry -- Find entry in table
+ * fndslot -- Find slot of key in table
  *==============================*/
-static HASHENT
-fndentry (HASHTAB tab, CNSTRING key)
+static HASHSLOT
+fndslot (HASHTAB tab, CNSTRING key, unsigned long hval)
 {
-	HASHENT entry=0;
-	if (!tab || !key) return NULL;
-	entry = tab->entries[hash(tab, key)];
-	while (entry) {
-		if (eqstr(key, entry->ekey)) return entry;
-		entry = entry->enext;
+	INT mask = tab->size - 1;
+	INT i = (INT)(hval & mask);
+	HASHSLOT slot=0;
+	for ( ; (slot = &tab->slots[i])->ekey; i = (i + 1) & mask) {
+		if (slot->hval == hval && slot->ekey != removed_key
+			&& eqstr(key, slot->ekey))
+			return slot;
 	}
 	return NULL;
 }
 /*======================
- * hash -- Hash function
+ * hash -- Hash function (FNV-1a, 32 bits)
  *====================*/
-static INT
-hash (HASHTAB tab, CNSTRING key)
+static unsigned long
+hash (CNSTRING key)
 {
 	const unsigned char *ckey = (const unsigned char *)key;
-	INT hval = 0;
-	while (*ckey)
-		hval += *ckey++;
-	hval %= tab->maxhash;
-	ASSERT(hval>=0);
-	ASSERT(hval < tab->maxhash);
-	return hval;
+	unsigned long hval = 2166136261UL;
+	while (*ckey) {
+		hval ^= *ckey++;
+		hval = (hval * 16777619UL) & 0xffffffffUL;
+	}
+	/* fold high bits in, as only low bits pick slot */
+	return hval ^ (hval >> 16);
+}
+/*================================
+ * rehash -- Move all entries to new array of slots
+ *  (which also drops slots of removed entries)
+ *==============================*/
+static void
+rehash (HASHTAB tab, INT size)
+{
+	HASHSLOT old = tab->slots;
+	INT oldsize = tab->size, mask = size - 1, i, j;
+	tab->slots = (HASHSLOT)stdalloc(size * sizeof(struct tag_hashslot));
+	tab->size = size;
+	tab->nremoved = 0;
+	for (i = 0; i < oldsize; ++i) {
+		HASHSLOT slot = &old[i];
+		if (!slot->ekey || slot->ekey == removed_key)
+			continue;
+		for (j = (INT)(slot->hval & mask); tab->slots[j].ekey; j = (j + 1) & mask)
+			;
+		tab->slots[j] = *slot;
+		if (slot->ekey == slot->kbuf)
+			tab->slots[j].ekey = tab->slots[j].kbuf;
+	}
+	stdfree(old);
 }
 /*================================
- * create_entry -- Create and return new hash entry
+ * set_key -- Put copy of key into slot
  *==============================*/
-static HASHENT
-create_entry (CNSTRING key, HVALUE val)
+static void
+set_key (HASHSLOT slot, CNSTRING key, unsigned long hval)
 {
-	HASHENT entry = (HASHENT)stdalloc(sizeof(*entry));
-	entry->magic = hashent_magic;
-	entry->ekey = strsave(key);
-	entry->val = val;
-	return entry;
+	size_t len = strlen(key);
+	if (len < HASH_INLINE) {
+		memcpy(slot->kbuf, key, len + 1);
+		slot->ekey = slot->kbuf;
+	} else {
+		slot->ekey = strsave(key);
+	}
+	slot->hval = hval;
+}
+/*================================
+ * unset_key -- Free key of slot (if it was allocated)
+ *==============================*/
+static void
+unset_key (HASHSLOT slot)
+{
+	if (slot->ekey != slot->kbuf)
+		stdfree(slot->ekey);
+	slot->ekey = 0;
 }
 /*================================
  * begin_hashtab -- Create new iterator for hash table
@@ -302,7 +343,7 @@ begin_hashtab (HASHTAB tab)
 	tabit = (HASHTAB_ITER)stdalloc(sizeof(*tabit));
 	tabit->magic = hashtab_iter_magic;
 	tabit->hashtab = tab;
-	/* table iterator starts at index=0, enext=0 */
+	/* table iterator starts at index=0, slot=0 */
 	/* stdalloc gave us all zero memory */
 	return tabit;
 }
@@ -324,30 +365,37 @@ next_hashtab (HASHTAB_ITER tabit, CNSTRING *pkey, HVALUE *pval)
 	if (tabit->index == -1 || tab->count == 0)
 		return FALSE;
 
-	/* continue current hash chain */
-	if (tabit->enext) {
-		tabit->enext = tabit->enext->enext;
-		if (tabit->enext)
-			goto returnit;
-		++tabit->index;
-	}
-	/* find next populated hash chain */
-	for ( ; tabit->index < tab->maxhash; ++tabit->index) {
-			tabit->enext = tab->entries[tabit->index];
-			if (tabit->enext)
-				goto returnit;
+	/* find next slot in use */
+	for ( ; tabit->index < tab->size; ++tabit->index) {
+		HASHSLOT slot = &tab->slots[tabit->index];
+		if (slot->ekey && slot->ekey != removed_key) {
+			++tabit->index;
+			tabit->slot = slot;
+			*pkey = slot->ekey;
+			*pval = slot->val;
+			return TRUE;
+		}
 	}
-	/* finished (ran out of hash chains) */
+	/* finished (ran out of slots) */
 	tabit->index = -1;
-	tabit->enext = 0;
+	tabit->slot = 0;
 	return FALSE;
+}
+/*================================
+ * change_hashtab -- Change value of entry last returned by iterator
+ * return previous value
+ *==============================*/
+HVALUE
+change_hashtab (HASHTAB_ITER tabit, HVALUE newval)
+{
+	HVALUE old=0;
+	ASSERT(tabit);
+	ASSERT(tabit->magic == hashtab_iter_magic);
+	ASSERT(tabit->slot);
 
-	/* found entry */
-returnit:
-	*pkey = tabit->enext->ekey;
-	*pval = tabit->enext->val;
-	return TRUE;
-
+	old = tabit->slot->val;
+	tabit->slot->val = newval;
+	return old;
 }
 /*================================
  * end_hashtab -- Release/destroy hash table iterator
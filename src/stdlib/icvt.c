@@ -26,6 +26,21 @@
 #include "zstr.h"
 #include "icvt.h"
 
+/*********************************************
+ * local types
+ *********************************************/
+
+/* an open iconv conversion, kept to translate many strings */
+struct tag_icvt {
+#ifdef HAVE_ICONV
+	iconv_t ict;
+#endif
+	int srcwidth; /* bytes per source char if source is wide, else 0 */
+	int chwidth; /* bytes per destination char */
+	double expand; /* expected output bytes per input byte */
+	BOOLEAN srcutf8;
+};
+
 
 /*===================================================
  * iconv_can_trans -- Can iconv do this translation ?
@@ -54,53 +69,123 @@ iconv_can_trans (CNSTRING src, CNSTRING dest)
  *  sin:     [IN]  source string to be converted
  *  zout:    [I/O] converted result
  *  illegal: [IN]  character to use as placeholder for unconvertible input
+ * (callers translating many strings should keep an ICVT instead)
  *=================================================*/
 BOOLEAN
 iconv_trans (CNSTRING src, CNSTRING dest, CNSTRING sin, ZSTR zout, char illegal)
+{
+	BOOLEAN rtn;
+	ICVT icvt = icvt_open(src, dest);
+	if (!icvt)
+		return FALSE;
+	rtn = icvt_trans(icvt, sin, zout, illegal);
+	icvt_close(&icvt);
+	return rtn;
+}
+/*===================================================
+ * icvt_open -- Open a reusable iconv conversion
+ *  src:     [IN]  source codeset
+ *  dest:    [IN]  destination codeset
+ * returns NULL if iconv cannot do this translation
+ *=================================================*/
+ICVT
+icvt_open (CNSTRING src, CNSTRING dest)
 {
 #ifdef HAVE_ICONV
+	ICVT icvt;
 	iconv_t ict;
-	char * inptr;
-	char * outptr;
-	size_t inleft;
-	size_t outleft;
-	size_t cvted;
 #ifdef ICONV_SET_TRANSLITERATE
 	int transliterate=2; 
 #endif
-	double expand=1.3;
-	int chwidth=1;
-	int badchars=0; /* count # illegal placeholders inserted */
-	int inlen = sin ? strlen(sin) : 0;
 
 	ASSERT(src);
 	ASSERT(dest);
 
 	ict = iconv_open(dest, src);
+	if (ict == (iconv_t)-1)
+		return NULL;
 
-	if (ict == (iconv_t)-1) {
-		return FALSE;
-	}
+	/* testing recursive transliteration in my private iconv, Perry, 2002.07.11 */
+#ifdef ICONV_SET_TRANSLITERATE
+	iconvctl(ict, ICONV_SET_TRANSLITERATE, &transliterate);
+#endif
+
+	icvt = (ICVT)stdalloc(sizeof(*icvt));
+	memset(icvt, 0, sizeof(*icvt));
+	icvt->ict = ict;
+	icvt->expand = 1.3;
+	icvt->chwidth = 1;
 	if (!strncmp(src, "UCS-2", strlen("UCS-2"))) {
 		/* assume MS-Windows makenarrow call */
-		inlen = 2 * wcslen((const wchar_t *)sin);
+		icvt->srcwidth = 2;
 	}
 	if (!strncmp(src, "UCS-4", strlen("UCS-4"))) {
 		/* assume UNIX makenarrow call */
-		inlen = 4 * wcslen((const wchar_t *)sin);
+		icvt->srcwidth = 4;
 	}
+	icvt->srcutf8 = eqstr(src, "UTF-8");
 	if (!strncmp(dest, "UCS-2", strlen("UCS-2"))) {
-		chwidth = expand = 2;
+		icvt->chwidth = 2;
+		icvt->expand = 2;
 	}
 	if (!strncmp(dest, "UCS-4", strlen("UCS-4"))) {
-		chwidth = expand = 4;
+		icvt->chwidth = 4;
+		icvt->expand = 4;
 	}
 	if (eqstr(dest, "wchar_t")) {
-		chwidth = expand = sizeof(wchar_t);
-
+		icvt->chwidth = sizeof(wchar_t);
+		icvt->expand = sizeof(wchar_t);
 	}
 	/* TODO: What about UTF-16 or UTF-32 ? */
+	return icvt;
+#else
+	src=src; /* unused */
+	dest=dest; /* unused */
+	return NULL;
+#endif /* HAVE_ICONV */
+}
+/*===================================================
+ * icvt_close -- Release a conversion from icvt_open
+ *=================================================*/
+void
+icvt_close (ICVT * picvt)
+{
+	ICVT icvt = *picvt;
+	if (!icvt)
+		return;
+#ifdef HAVE_ICONV
+	iconv_close(icvt->ict);
+#endif
+	stdfree(icvt);
+	*picvt = 0;
+}
+/*===================================================
+ * icvt_trans -- Translate string via an open conversion
+ *  icvt:    [IN]  conversion from icvt_open
+ *  sin:     [IN]  source string to be converted
+ *  zout:    [I/O] converted result (its buffer is reused)
+ *  illegal: [IN]  character to use as placeholder for unconvertible input
+ *=================================================*/
+BOOLEAN
+icvt_trans (ICVT icvt, CNSTRING sin, ZSTR zout, char illegal)
+{
+#ifdef HAVE_ICONV
+	char * inptr;
+	char * outptr;
+	size_t inleft;
+	size_t outleft;
+	size_t cvted;
+	int chwidth = icvt->chwidth;
+	double expand = icvt->expand;
+	int badchars=0; /* count # illegal placeholders inserted */
+	int inlen = sin ? strlen(sin) : 0;
+
+	if (sin && icvt->srcwidth) {
+		inlen = icvt->srcwidth * wcslen((const wchar_t *)sin);
+	}
 
+	/* output is written from the start of zout */
+	zs_clear(zout);
 	zs_reserve(zout, (unsigned int)(inlen*expand+6));
 
 	if (!inlen) {
@@ -108,11 +193,8 @@ iconv_trans (CNSTRING src, CNSTRING dest, CNSTRING sin, ZSTR zout, char illegal)
 		goto icvt_terminate_and_exit;
 	}
 
-	/* testing recursive transliteration in my private iconv, Perry, 2002.07.11 */
-#ifdef ICONV_SET_TRANSLITERATE
-	iconvctl(ict, ICONV_SET_TRANSLITERATE, &transliterate);
-#endif
-
+	/* descriptor is reused, so start from its initial shift state */
+	iconv(icvt->ict, NULL, NULL, NULL, NULL);
 
 	inptr = (char *)sin;
 	outptr = zs_str(zout);
@@ -123,7 +205,7 @@ iconv_trans (CNSTRING src, CNSTRING dest, CNSTRING sin, ZSTR zout, char illegal)
 
 cvting:
 	/* main convert */
-	cvted = iconv (ict, &inptr, &inleft, &outptr, &outleft);
+	cvted = iconv (icvt->ict, &inptr, &inleft, &outptr, &outleft);
 
 	/* zero terminate & fix output zstring */
 	/* there may be embedded nulls, if UCS-2/4 is target! */
@@ -141,7 +223,7 @@ cvting:
 			/* unconvertible input character */
 			/* append placeholder & skip over */
 			size_t wid = 1;
-			if (eqstr(src, "UTF-8")) {
+			if (icvt->srcutf8) {
 				wid = utf8len(*inptr);
 			}
 			if (wid > inleft)
@@ -188,11 +270,9 @@ icvt_terminate_and_exit:
 	*outptr=0;
 	zs_set_len(zout, outptr-zs_str(zout));
 
-	iconv_close(ict);
 	return TRUE;
 #else
-	src=src; /* unused */
-	dest=dest; /* unused */
+	icvt=icvt; /* unused */
 	sin=sin; /* unused */
 	zout=zout; /* unused */
 	illegal=illegal; /* unused */
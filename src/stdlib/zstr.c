@@ -403,6 +403,17 @@ zs_move (ZSTR zstr, ZSTR * pzsrc)
 	free(*pzsrc);
 	*pzsrc = 0;
 }
+/* exchange contents (and buffers) of two zstrs */
+void
+zs_swap (ZSTR zstr1, ZSTR zstr2)
+{
+	struct tag_zstr ztemp;
+	DBGCHK(zstr1);
+	DBGCHK(zstr2);
+	memcpy(&ztemp, zstr1, sizeof(ztemp));
+	memcpy(zstr1, zstr2, sizeof(ztemp));
+	memcpy(zstr2, &ztemp, sizeof(ztemp));
+}
 /*========================================
  * init_zstr_vtable -- set this zstr's vtable
  *======================================*/
@@ -0,0 +1,361 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=================================================================
+ * btbench.c -- Command that times btree lookups against a
+ *              synthetic database.
+ *  The database is created & filled with generated person records
+ *  on first use, and reused by later runs (which is how a change
+ *  to the lookup code is best compared against the previous one).
+ *===============================================================*/
+
+#include <time.h>
+#include "llstdlib.h"
+/* llstdlib.h pulls in standard.h, config.h, sys_inc.h */
+#include "btree.h"
+#include "version.h"
+
+extern STRING qSgen_bugreport;
+
+/*********************************************
+ * required global variables
+ *********************************************/
+/* defined in liflines/main.c */
+STRING readpath_file = NULL;
+STRING readpath = NULL;
+int opt_finnish = 0;
+int opt_mychar = 0;
+/* defined in gedlib/codesets.c */
+BOOLEAN uu8=0;            /* flag if internal codeset is UTF-8 */
+STRING int_codeset=0;     /* internal codeset */
+
+/*********************************************
+ * local types
+ *********************************************/
+
+typedef struct tag_trav_count {
+	INT count;
+	INT bytes;
+} TRAV_COUNT;
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static BOOLEAN count_record(RKEY rkey, STRING data, INT len, void *param);
+static double elapsed(clock_t start);
+static BOOLEAN fill_database(BTREE btree, INT nrecs);
+static INT next_random(void);
+static RKEY nth_key(INT n);
+static void print_usage(void);
+static void scan_cursor(BTREE btree, BOOLEAN keysonly, TRAV_COUNT * tcount);
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+static unsigned long rand_state = 1;
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*=========================================
+ * main -- Main procedure of btbench command
+ *=======================================*/
+int
+main (int argc,
+      char **argv)
+{
+	BTREE btree;
+	char *dbname = NULL;
+	BOOLEAN created = FALSE;
+	INT lldberrnum = 0;
+	INT nrecs = 200000;
+	INT nlookups = 1000000;
+	INT ncache = 0;
+	INT nfound = 0;
+	INT i, len;
+	RKEY lo, hi;
+	TRAV_COUNT tcount;
+	clock_t start;
+	double secs;
+	int rtn = 0;
+
+#ifdef WIN32
+	_fmode = O_BINARY;	/* default to binary rather than TEXT mode */
+#endif
+
+	for (i=1; i<argc; ++i) {
+		if (!strcmp(argv[i], "--version")
+			|| !strcmp(argv[i], "-v")) {
+			print_version("btbench");
+			return 0;
+		}
+		if (!strcmp(argv[i], "--help")
+			|| !strcmp(argv[i], "-h")
+			|| !strcmp(argv[i], "-?")) {
+			print_usage();
+			return 0;
+		}
+		if (!strcmp(argv[i], "-n") && i+1<argc) {
+			nrecs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-l") && i+1<argc) {
+			nlookups = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-c") && i+1<argc) {
+			ncache = atoi(argv[++i]);
+		} else if (!dbname && argv[i][0] != '-') {
+			dbname = argv[i];
+		} else {
+			print_usage();
+			return 10;
+		}
+	}
+	if (!dbname || nrecs < 1 || nlookups < 1) {
+		printf(_("btbench requires 1 argument (database)."));
+		puts("");
+		printf(_("See `btbench --help' for more information."));
+		puts("");
+		return 10;
+	}
+
+	/* reuse database if present, else create & fill it */
+	if (!(btree = bt_openbtree(dbname, FALSE, TRUE, FALSE, &lldberrnum))) {
+		if (!(btree = bt_openbtree(dbname, TRUE, TRUE, FALSE, &lldberrnum))) {
+			printf(_("Failed to open btree: %s."), dbname);
+			puts("");
+			return 20;
+		}
+		start = clock();
+		if (!fill_database(btree, nrecs)) {
+			printf(_("Failed to fill btree: %s."), dbname);
+			puts("");
+			rtn = 30;
+			goto finish;
+		}
+		printf("filled " FMT_INT " records in %.2f sec\n", nrecs, elapsed(start));
+		created = TRUE;
+	}
+	if (!created) {
+		/* count what a previous run left, so lookups stay in range */
+		for (nrecs = 0; isrecord(btree, nth_key(nrecs+1)); ++nrecs)
+			;
+		if (!nrecs) {
+			printf(_("Database %s holds no btbench records."), dbname);
+			puts("");
+			rtn = 30;
+			goto finish;
+		}
+	}
+
+	if (ncache > 0)
+		bt_set_index_cache_size(btree, ncache);
+
+	/* keyed lookups in random order, without & with reading record */
+	start = clock();
+	for (i = 0; i < nlookups; ++i) {
+		if (isrecord(btree, nth_key(next_random() % nrecs + 1)))
+			++nfound;
+	}
+	secs = elapsed(start);
+	printf("isrecord:     " FMT_INT " lookups (" FMT_INT " found) in %.2f sec, %.0f lookups/sec\n"
+		, nlookups, nfound, secs, secs > 0 ? nlookups/secs : 0.0);
+
+	start = clock();
+	nfound = 0;
+	for (i = 0; i < nlookups; ++i) {
+		RKEY rkey = nth_key(next_random() % nrecs + 1);
+		RAWRECORD rawrec = bt_getrecord(btree, &rkey, &len);
+		if (rawrec) {
+			++nfound;
+			stdfree(rawrec);
+		}
+	}
+	secs = elapsed(start);
+	printf("bt_getrecord: " FMT_INT " lookups (" FMT_INT " found) in %.2f sec, %.0f lookups/sec\n"
+		, nlookups, nfound, secs, secs > 0 ? nlookups/secs : 0.0);
+
+	/* one full traversal, for comparison */
+	memset(&lo, 0, sizeof(lo));
+	memset(&hi, 0, sizeof(hi));
+	tcount.count = tcount.bytes = 0;
+	start = clock();
+	traverse_db_rec_rkeys(btree, lo, hi, count_record, &tcount);
+	secs = elapsed(start);
+	printf("traverse:     " FMT_INT " records (" FMT_INT " bytes) in %.2f sec\n"
+		, tcount.count, tcount.bytes, secs);
+
+	/* same scan pulled through cursors */
+	start = clock();
+	scan_cursor(btree, TRUE, &tcount);
+	secs = elapsed(start);
+	printf("cursor keys:  " FMT_INT " records (" FMT_INT " bytes) in %.2f sec\n"
+		, tcount.count, tcount.bytes, secs);
+	start = clock();
+	scan_cursor(btree, FALSE, &tcount);
+	secs = elapsed(start);
+	printf("cursor data:  " FMT_INT " records (" FMT_INT " bytes) in %.2f sec\n"
+		, tcount.count, tcount.bytes, secs);
+
+finish:
+	closebtree(btree);
+	btree = 0;
+	return rtn;
+}
+/*=========================================
+ * scan_cursor -- Count all records by stepping cursor
+ *  keysonly: [IN]  leave record data unread ?
+ *=======================================*/
+static void
+scan_cursor (BTREE btree, BOOLEAN keysonly, TRAV_COUNT * tcount)
+{
+	BTCURSOR cursor = bt_cursor_open(btree, keysonly);
+	RKEY rkey;
+	RAWRECORD rec;
+	INT len;
+	tcount->count = tcount->bytes = 0;
+	while (bt_cursor_next(cursor, &rkey, &rec, &len)) {
+		++tcount->count;
+		tcount->bytes += len;
+		if (rec)
+			stdfree(rec);
+	}
+	bt_cursor_close(cursor);
+}
+/*=========================================
+ * fill_database -- Add generated person records
+ *  loads via bulk builder, as import would
+ *=======================================*/
+static BOOLEAN
+fill_database (BTREE btree, INT nrecs)
+{
+	char rec[200];
+	INT i;
+	BOOLEAN bulk = bt_bulk_begin(btree);
+	for (i = 1; i <= nrecs; ++i) {
+		snprintf(rec, sizeof(rec)
+			, "0 @I" FMT_INT "@ INDI\n1 NAME Person " FMT_INT " /Bench/\n1 SEX %c\n"
+			, i, i, (i % 2) ? 'M' : 'F');
+		if (!bt_addrecord(btree, nth_key(i), rec, strlen(rec)))
+			return FALSE;
+	}
+	if (bulk)
+		bt_bulk_end(btree);
+	return TRUE;
+}
+/*=========================================
+ * nth_key -- Key of nth generated record
+ *=======================================*/
+static RKEY
+nth_key (INT n)
+{
+	char key[32];
+	snprintf(key, sizeof(key), "I" FMT_INT, n);
+	return str2rkey(key);
+}
+/*=========================================
+ * next_random -- Simple repeatable pseudo random number
+ *  (so that runs are comparable)
+ *=======================================*/
+static INT
+next_random (void)
+{
+	rand_state = rand_state * 1103515245UL + 12345UL;
+	return (INT)((rand_state >> 8) & 0x7fffff);
+}
+/*=========================================
+ * count_record -- Traversal callback counting records
+ *=======================================*/
+static BOOLEAN
+count_record (RKEY rkey, STRING data, INT len, void *param)
+{
+	TRAV_COUNT * tcount = (TRAV_COUNT *)param;
+	rkey = rkey; /* unused */
+	data = data; /* unused */
+	++tcount->count;
+	tcount->bytes += len;
+	return TRUE;
+}
+/*=========================================
+ * elapsed -- Processor seconds since start
+ *=======================================*/
+static double
+elapsed (clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+/*=============================
+ * __fatal -- Fatal error routine
+ *  handles null or empty details input
+ *===========================*/
+void
+__fatal (STRING file, int line, CNSTRING details)
+{
+	printf("FATAL ERROR: ");
+	if (details && details[0]) {
+		printf("%s", details);
+		printf("\nAT: ");
+	}
+	printf("%s: line %d\n", file, line);
+	exit(1);
+}
+/*===============================================
+ * print_usage -- display program help/usage
+ *  displays to stdout
+ *=============================================*/
+static void
+print_usage (void)
+{
+#ifdef WIN32
+	char * fname = _("\"\\My Documents\\LifeLines\\Databases\\bench\"");
+#else
+	char * fname = _("/tmp/bench");
+#endif
+
+	printf(_("lifelines `btbench' times btree lookups in a synthetic database.\n"));
+	printf("\n\n");
+	printf(_("Usage btbench [database] <options>"));
+	printf("\n\n");
+	printf(_("Options:"));
+	printf("\n");
+	printf(_("\t-n N\tnumber of records to create, if database is new (default 200000)"));
+	printf("\n");
+	printf(_("\t-l N\tnumber of random lookups to time (default 1000000)"));
+	printf("\n");
+	printf(_("\t-c N\tindex cache size, in entries (default as in btree)"));
+	printf("\n");
+	printf(_("\t--help\tdisplay this help and exit"));
+	printf("\n");
+	printf(_("\t--version\toutput version information and exit"));
+	printf("\n\n");
+	printf(_("Examples:"));
+	printf("\n");
+	printf(_("\tbtbench %s"), fname);
+	printf("\n");
+	printf(_("\tbtbench %s -n 500000 -l 100000 -c 4096"), fname);
+	printf("\n\t\t");
+	printf("%s", _(qSgen_bugreport));
+	printf("\n");
+}
@@ -101,6 +101,10 @@ struct work {
 	INT fix_block_splits;
 	INT check_missing_data_records; /* record in index, but no data */
 	INT fix_missing_data_records;
+	INT report_cache_stats;
+	INT compact_blocks;
+	INT compress_blocks; /* 1 to compress records, -1 to expand */
+	INT rebuild_names;
 	INT pass; /* =1 is checking, =2 is fixing */
 };
 /*=======================================
@@ -149,6 +153,7 @@ static BOOLEAN nodes_callback(TRAV_RECORDS_FUNC_ARGS(key, rec, param));
 static void printblock(BLOCK block);
 static CNSTRING printkey(CNSTRING key);
 static void print_usage(void);
+static void print_cache_stats(BTREE btr);
 static void process_fam(RECORD rec);
 static void process_indi(RECORD rec);
 static void process_record(RECORD rec);
@@ -172,7 +177,7 @@ enum {
 	, ERR_BADHUSBREF, ERR_BADWIFEREF, ERR_BADCHILDREF
 	, ERR_EXTRAHUSB, ERR_EXTRAWIFE, ERR_EXTRACHILD
 	, ERR_EMPTYFAM, ERR_SOLOFAM, ERR_BADPOINTER
-	, ERR_MISSINGREC, ERR_STALEBLOCKENTRY
+	, ERR_MISSINGREC, ERR_STALEBLOCKENTRY, ERR_BADZIPREC
 };
 
 static struct errinfo errs[] = {
@@ -203,6 +208,7 @@ static struct errinfo errs[] = {
 	, { ERR_BADPOINTER, 0, 0, N_("Bad pointer") }
 	, { ERR_MISSINGREC, 0, 0, N_("Missing data records") }
 	, { ERR_STALEBLOCKENTRY, 0, 0, N_("Stale block directory entry") }
+	, { ERR_BADZIPREC, 0, 0, N_("Unreadable compressed record") }
 };
 static struct work todo;
 static LIST tofix=0;
@@ -256,6 +262,11 @@ print_usage (void)
 	printf(_("\t-D = Fix bad delete entries\n"));
 	printf(_("\t-B = Fix block splits with stale data\n"));
 	printf(_("\t-n = Noisy (echo every record processed)\n"));
+	printf(_("\t-c = Report btree cache statistics\n"));
+	printf(_("\t-C = Compact block files holding dead space\n"));
+	printf(_("\t-z = Compress records of all block files\n"));
+	printf(_("\t-Z = Uncompress records of all block files\n"));
+	printf(_("\t-N = Rebuild name index (splitting long name records)\n"));
 	printf(_("example: dbverify -ifsex \"%s\"\n"), fname);
 	printf("%s\n", verstr);
 }
@@ -1121,7 +1132,7 @@ check_btree (BTREE btr)
 	TABLE fkeytab = create_table_int();
 
 	/* check that master index has its fkey correct */
-	INDEX index = bmaster(BTR);
+	INDEX index = bmaster(BTR), master;
 	FKEY mk1 = bkfile(btr).k_mkey;
 	if (ixself(index) != mk1) {
 		printf(_("Master fkey misaligned"));
@@ -1130,12 +1141,17 @@ check_btree (BTREE btr)
 		goto exit;
 	}
 
-	/* check index (and block) keys */
-	if (!check_index(btr, index, fkeytab, NULL, NULL)) {
+	/* check index (and block) keys, in tree as it is before
+	any fixes (which go to copies, published together at end) */
+	bt_begin_group(btr);
+	master = (INDEX) stdalloc(BUFLEN);
+	memcpy(master, index, BUFLEN);
+	if (!check_index(btr, master, fkeytab, NULL, NULL)) {
 		printf(_("Index or block keys invalid\n"));
 		ret = FALSE;
-		goto exit;
 	}
+	stdfree(master);
+	bt_commit_group(btr);
 
 exit:
 	destroy_table(fkeytab);
@@ -1197,12 +1213,19 @@ check_block (BTREE btr, BLOCK block, RKEY * lo, RKEY * hi)
 	INT i;
 	RKEY nullrkey;
 	BOOLEAN altered=FALSE;
+	INT bad;
 
 	RKEY_INIT(nullrkey);
 
 	if (!check_keys(block, lo, hi))
 		return FALSE;
 
+	/* check that compressed records can be expanded */
+	if ((bad = bt_check_block_records(btr, block)) > 0) {
+		report_error(ERR_BADZIPREC
+			, _("Found %d unreadable compressed records (%s)"), (int)bad, fkey2path(ixself(block)));
+	}
+
 	if (!todo.check_block_splits)
 		goto exit;
 
@@ -1229,46 +1252,8 @@ check_block (BTREE btr, BLOCK block, RKEY * lo, RKEY * hi)
 
 
 	/* must rewrite data block with new header */
-	if (altered) {
-		char scratch0[MAXPATHLEN], scratch1[MAXPATHLEN];
-		FILE *fo, *fn;
-
-		/* open original file */
-		snprintf(scratch0, sizeof(scratch0), "%s/%s", bbasedir(btr), fkey2path(ixself(block)));
-		if (!(fo = fopen(scratch0, LLREADBINARY LLFILERANDOM))) {
-			char msg[sizeof(scratch0)+64];
-			snprintf(msg, sizeof(msg), "Corrupt db  -- failed to open blockfile: %s", scratch0);
-			FATAL2(msg);
-		}
-	
-		/* open new file */
-		snprintf(scratch1, sizeof(scratch1), "%s/tmp1", bbasedir(btr));
-		if (!(fn = fopen(scratch1, LLWRITEBINARY LLFILETEMP LLFILERANDOM))) {
-			char msg[sizeof(scratch1)+64];
-			snprintf(msg, sizeof(msg), "Corrupt db  -- failed to open blockfile: %s", scratch1);
-			FATAL2(msg);
-		}
-
-		/* write updated header to new file */
-		ASSERT(fwrite(block, BUFLEN, 1, fn) == 1);
-
-		/* copy records from old file to new file */
-		/* NOTE: block keys are 0..n-1 */
-		for (i = 0; i < n; i++) {
-			if (fseek(fo, (long)(offs(block, i) + BUFLEN), 0))
-				FATAL();
-
-			/* NOTE: Assumes that fn is positioned properly */
-			filecopy(fo, lens(block, i), fn);
-		}
-
-		/* close files */
-		fclose(fn);
-		fclose(fo);
-
-		/* move new file over top of old file */
-		movefiles(scratch1, scratch0);
-        }
+	if (altered)
+		bt_compact_block(btr, block);
 
 exit:
 	return TRUE;
@@ -1459,6 +1444,11 @@ main (int argc, char **argv)
 		case 'e': todo.check_evens=TRUE; break;
 		case 'x': todo.check_othes=TRUE; break;
 		case 'n': noisy=TRUE; break;
+		case 'c': todo.report_cache_stats=TRUE; break;
+		case 'C': todo.compact_blocks=TRUE; break;
+		case 'z': todo.compress_blocks=1; break;
+		case 'Z': todo.compress_blocks=-1; break;
+		case 'N': todo.rebuild_names=TRUE; break;
 		case 'a': allchecks=TRUE; break;
 		case 'F': todo.fix_alter_pointers=TRUE; break;
 		case 'm': todo.check_missing_data_records=TRUE; break;
@@ -1533,11 +1523,24 @@ main (int argc, char **argv)
 		todo.fix_alter_pointers = FALSE;
 		todo.fix_ghosts = FALSE;
 		todo.fix_block_splits = FALSE;
+		todo.compact_blocks = FALSE;
+		todo.compress_blocks = 0;
+		todo.rebuild_names = FALSE;
 	}
 
 	if (todo.check_block_splits || todo.fix_block_splits)
 		check_btree(BTR);
 
+	if (todo.rebuild_names) {
+		if (bt_set_split_names(BTR)) {
+			INT n = rebuild_names();
+			printf(_("Indexed " FMT_INT " names"), n);
+			printf("\n");
+		} else {
+			printf("%s\n", _("Failed to mark database as holding split name records"));
+		}
+	}
+
 	if (todo.find_ghosts || todo.fix_ghosts)
 		check_ghosts();
 
@@ -1554,8 +1557,25 @@ main (int argc, char **argv)
 		check_missing_data_records();
 	}
 
+	if (todo.compress_blocks) {
+		/* compacting rewrites blocks not stored as now set */
+		if (bt_set_compress(BTR, todo.compress_blocks > 0))
+			todo.compact_blocks = TRUE;
+		else
+			printf("%s\n", _("Failed to mark database as compressed"));
+	}
+
+	if (todo.compact_blocks) {
+		INT n = bt_compact(BTR, 0);
+		printf(_("Compacted " FMT_INT " block files"), n);
+		printf("\n");
+	}
+
 	report_results();
 
+	if (todo.report_cache_stats)
+		print_cache_stats(BTR);
+
 done:
 	closebtree(BTR);
 
@@ -1593,6 +1613,24 @@ report_results (void)
 		printf("%s\n", _("No errors found"));
 	}
 }
+/*===============================================
+ * print_cache_stats -- Print btree cache counters
+ *=============================================*/
+static void
+print_cache_stats (BTREE btr)
+{
+	INT hits=0, misses=0;
+	BTCACHESTATS stats;
+	bt_get_fdpool_stats(btr, &hits, &misses);
+	printf(_("Block file pool: " FMT_INT " hits, " FMT_INT " misses"), hits, misses);
+	printf("\n");
+	bt_get_index_cache_stats(btr, &stats);
+	printf(_("Index cache: " FMT_INT " of " FMT_INT " entries used, ")
+		, stats.count, stats.capacity);
+	printf(_(FMT_INT " hits, " FMT_INT " misses, " FMT_INT " evictions")
+		, stats.hits, stats.misses, stats.evictions);
+	printf("\n");
+}
 /*=============================
  * fatal -- Fatal error routine
  * Created: 2001/01/01, Perry Rapp
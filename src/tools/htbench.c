@@ -0,0 +1,417 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=================================================================
+ * htbench.c -- Command that times hash table inserts & lookups
+ *  Times HASHTAB (open addressing, in stdlib/hashtab.c) against
+ *  the chained table of 512 fixed buckets it replaced, which is
+ *  kept here only for comparison.
+ *===============================================================*/
+
+#include <time.h>
+#include "llstdlib.h"
+/* llstdlib.h pulls in standard.h, config.h, sys_inc.h */
+#include "hashtab.h"
+#include "version.h"
+
+extern STRING qSgen_bugreport;
+
+/*********************************************
+ * required global variables
+ *********************************************/
+/* defined in liflines/main.c */
+STRING readpath_file = NULL;
+STRING readpath = NULL;
+int opt_finnish = 0;
+int opt_mychar = 0;
+/* defined in gedlib/codesets.c */
+BOOLEAN uu8=0;            /* flag if internal codeset is UTF-8 */
+STRING int_codeset=0;     /* internal codeset */
+
+/*********************************************
+ * local enums & defines
+ *********************************************/
+
+#define CHAIN_MAXHASH 512
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* entry of former chained table */
+typedef struct tag_chainent {
+	STRING ekey;
+	HVALUE val;
+	struct tag_chainent *enext;
+} *CHAINENT;
+
+/* former chained table */
+typedef struct tag_chaintab {
+	CHAINENT entries[CHAIN_MAXHASH];
+	INT count;
+} *CHAINTAB;
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static INT chain_hash(CNSTRING key);
+static HVALUE chain_find(CHAINTAB tab, CNSTRING key);
+static void chain_free(CHAINTAB tab);
+static HVALUE chain_insert(CHAINTAB tab, CNSTRING key, HVALUE val);
+static HVALUE chain_remove(CHAINTAB tab, CNSTRING key);
+static double elapsed(clock_t start);
+static STRING * make_keys(INT nkeys, CNSTRING fmt);
+static INT next_random(void);
+static void print_usage(void);
+static void report(CNSTRING what, INT n, INT nfound, double secs);
+static void time_chain(STRING * keys, INT nkeys, INT nlookups);
+static void time_hashtab(STRING * keys, INT nkeys, INT nlookups);
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+static unsigned long rand_state = 1;
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*=========================================
+ * main -- Main procedure of htbench command
+ *=======================================*/
+int
+main (int argc,
+      char **argv)
+{
+	INT nkeys = 100000;
+	INT nlookups = 100000;
+	STRING * keys;
+	INT i;
+
+#ifdef WIN32
+	_fmode = O_BINARY;	/* default to binary rather than TEXT mode */
+#endif
+
+	for (i=1; i<argc; ++i) {
+		if (!strcmp(argv[i], "--version")
+			|| !strcmp(argv[i], "-v")) {
+			print_version("htbench");
+			return 0;
+		}
+		if (!strcmp(argv[i], "--help")
+			|| !strcmp(argv[i], "-h")
+			|| !strcmp(argv[i], "-?")) {
+			print_usage();
+			return 0;
+		}
+		if (!strcmp(argv[i], "-n") && i+1<argc) {
+			nkeys = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-l") && i+1<argc) {
+			nlookups = atoi(argv[++i]);
+		} else {
+			print_usage();
+			return 10;
+		}
+	}
+	if (nkeys < 1 || nlookups < 1) {
+		print_usage();
+		return 10;
+	}
+
+	/* short keys (as record keys) & long keys (as names) */
+	keys = make_keys(nkeys, "I" FMT_INT);
+	printf("short keys (" FMT_INT "):\n", nkeys);
+	time_chain(keys, nkeys, nlookups);
+	time_hashtab(keys, nkeys, nlookups);
+	for (i = 0; i < 2*nkeys; ++i)
+		stdfree(keys[i]);
+	stdfree(keys);
+
+	keys = make_keys(nkeys, "Person " FMT_INT " /Benchmark/");
+	printf("long keys (" FMT_INT "):\n", nkeys);
+	time_chain(keys, nkeys, nlookups);
+	time_hashtab(keys, nkeys, nlookups);
+	for (i = 0; i < 2*nkeys; ++i)
+		stdfree(keys[i]);
+	stdfree(keys);
+	return 0;
+}
+/*=========================================
+ * make_keys -- Generate 2*nkeys distinct keys
+ *  first nkeys go into tables, rest are looked up in vain
+ *=======================================*/
+static STRING *
+make_keys (INT nkeys, CNSTRING fmt)
+{
+	STRING * keys = (STRING *)stdalloc(2 * nkeys * sizeof(STRING));
+	char key[64];
+	INT i;
+	for (i = 0; i < 2*nkeys; ++i) {
+		snprintf(key, sizeof(key), fmt, i+1);
+		keys[i] = strsave(key);
+	}
+	return keys;
+}
+/*=========================================
+ * time_hashtab -- Time inserts, lookups & removes of HASHTAB
+ *=======================================*/
+static void
+time_hashtab (STRING * keys, INT nkeys, INT nlookups)
+{
+	HASHTAB tab = create_hashtab();
+	INT i, nfound;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < nkeys; ++i)
+		insert_hashtab(tab, keys[i], keys[i]);
+	report("hashtab insert", nkeys, get_hashtab_count(tab), elapsed(start));
+
+	rand_state = 1;
+	nfound = 0;
+	start = clock();
+	for (i = 0; i < nlookups; ++i) {
+		if (find_hashtab(tab, keys[next_random() % nkeys], NULL))
+			++nfound;
+	}
+	report("hashtab found", nlookups, nfound, elapsed(start));
+
+	nfound = 0;
+	start = clock();
+	for (i = 0; i < nlookups; ++i) {
+		if (find_hashtab(tab, keys[nkeys + next_random() % nkeys], NULL))
+			++nfound;
+	}
+	report("hashtab missed", nlookups, nfound, elapsed(start));
+
+	nfound = 0;
+	start = clock();
+	for (i = 0; i < nkeys; ++i) {
+		if (remove_hashtab(tab, keys[i]))
+			++nfound;
+	}
+	report("hashtab remove", nkeys, nfound, elapsed(start));
+	destroy_hashtab(tab, NULL);
+}
+/*=========================================
+ * time_chain -- Time inserts, lookups & removes of chained table
+ *  (same steps as time_hashtab)
+ *=======================================*/
+static void
+time_chain (STRING * keys, INT nkeys, INT nlookups)
+{
+	CHAINTAB tab = (CHAINTAB)stdalloc(sizeof(*tab));
+	INT i, nfound;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < nkeys; ++i)
+		chain_insert(tab, keys[i], keys[i]);
+	report("chained insert", nkeys, tab->count, elapsed(start));
+
+	rand_state = 1;
+	nfound = 0;
+	start = clock();
+	for (i = 0; i < nlookups; ++i) {
+		if (chain_find(tab, keys[next_random() % nkeys]))
+			++nfound;
+	}
+	report("chained found", nlookups, nfound, elapsed(start));
+
+	nfound = 0;
+	start = clock();
+	for (i = 0; i < nlookups; ++i) {
+		if (chain_find(tab, keys[nkeys + next_random() % nkeys]))
+			++nfound;
+	}
+	report("chained missed", nlookups, nfound, elapsed(start));
+
+	nfound = 0;
+	start = clock();
+	for (i = 0; i < nkeys; ++i) {
+		if (chain_remove(tab, keys[i]))
+			++nfound;
+	}
+	report("chained remove", nkeys, nfound, elapsed(start));
+	chain_free(tab);
+}
+/*=========================================
+ * report -- Print time & rate of one step
+ *=======================================*/
+static void
+report (CNSTRING what, INT n, INT nfound, double secs)
+{
+	printf("  %-15s " FMT_INT " (" FMT_INT " found) in %.3f sec, %.0f per sec\n"
+		, what, n, nfound, secs, secs > 0 ? n/secs : 0.0);
+}
+/*=========================================
+ * chain_hash -- Hash of former table (sum of bytes)
+ *=======================================*/
+static INT
+chain_hash (CNSTRING key)
+{
+	const unsigned char *ckey = (const unsigned char *)key;
+	INT hval = 0;
+	while (*ckey)
+		hval += *ckey++;
+	return hval % CHAIN_MAXHASH;
+}
+/*=========================================
+ * chain_insert -- Add to chained table
+ * return previous value for this key, if any
+ *=======================================*/
+static HVALUE
+chain_insert (CHAINTAB tab, CNSTRING key, HVALUE val)
+{
+	CHAINENT *pentry = &tab->entries[chain_hash(key)];
+	for ( ; *pentry; pentry = &(*pentry)->enext) {
+		if (eqstr(key, (*pentry)->ekey)) {
+			HVALUE old = (*pentry)->val;
+			(*pentry)->val = val;
+			return old;
+		}
+	}
+	*pentry = (CHAINENT)stdalloc(sizeof(**pentry));
+	(*pentry)->ekey = strsave(key);
+	(*pentry)->val = val;
+	++tab->count;
+	return 0;
+}
+/*=========================================
+ * chain_find -- Find value in chained table
+ *=======================================*/
+static HVALUE
+chain_find (CHAINTAB tab, CNSTRING key)
+{
+	CHAINENT entry = tab->entries[chain_hash(key)];
+	for ( ; entry; entry = entry->enext) {
+		if (eqstr(key, entry->ekey))
+			return entry->val;
+	}
+	return 0;
+}
+/*=========================================
+ * chain_remove -- Remove from chained table
+ * return old value if found
+ *=======================================*/
+static HVALUE
+chain_remove (CHAINTAB tab, CNSTRING key)
+{
+	CHAINENT *pentry = &tab->entries[chain_hash(key)];
+	for ( ; *pentry; pentry = &(*pentry)->enext) {
+		if (eqstr(key, (*pentry)->ekey)) {
+			CHAINENT entry = *pentry;
+			HVALUE val = entry->val;
+			*pentry = entry->enext;
+			stdfree(entry->ekey);
+			stdfree(entry);
+			--tab->count;
+			return val;
+		}
+	}
+	return 0;
+}
+/*=========================================
+ * chain_free -- Free chained table & its entries
+ *=======================================*/
+static void
+chain_free (CHAINTAB tab)
+{
+	INT i;
+	for (i = 0; i < CHAIN_MAXHASH; ++i) {
+		CHAINENT entry = tab->entries[i], next;
+		for ( ; entry; entry = next) {
+			next = entry->enext;
+			stdfree(entry->ekey);
+			stdfree(entry);
+		}
+	}
+	stdfree(tab);
+}
+/*=========================================
+ * next_random -- Simple repeatable pseudo random number
+ *  (so that runs are comparable)
+ *=======================================*/
+static INT
+next_random (void)
+{
+	rand_state = rand_state * 1103515245UL + 12345UL;
+	return (INT)((rand_state >> 8) & 0x7fffff);
+}
+/*=========================================
+ * elapsed -- Processor seconds since start
+ *=======================================*/
+static double
+elapsed (clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+/*=============================
+ * __fatal -- Fatal error routine
+ *  handles null or empty details input
+ *===========================*/
+void
+__fatal (STRING file, int line, CNSTRING details)
+{
+	printf("FATAL ERROR: ");
+	if (details && details[0]) {
+		printf("%s", details);
+		printf("\nAT: ");
+	}
+	printf("%s: line %d\n", file, line);
+	exit(1);
+}
+/*===============================================
+ * print_usage -- display program help/usage
+ *  displays to stdout
+ *=============================================*/
+static void
+print_usage (void)
+{
+	printf(_("lifelines `htbench' times hash table inserts & lookups.\n"));
+	printf("\n\n");
+	printf(_("Usage htbench <options>"));
+	printf("\n\n");
+	printf(_("Options:"));
+	printf("\n");
+	printf(_("\t-n N\tnumber of keys to insert (default 100000)"));
+	printf("\n");
+	printf(_("\t-l N\tnumber of random lookups to time (default 100000)"));
+	printf("\n");
+	printf(_("\t--help\tdisplay this help and exit"));
+	printf("\n");
+	printf(_("\t--version\toutput version information and exit"));
+	printf("\n\n");
+	printf(_("Examples:"));
+	printf("\n");
+	printf(_("\thtbench"));
+	printf("\n");
+	printf(_("\thtbench -n 20000 -l 1000000"));
+	printf("\n\t\t");
+	printf("%s", _(qSgen_bugreport));
+	printf("\n");
+}
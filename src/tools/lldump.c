@@ -94,7 +94,7 @@ BOOLEAN tf_print_block(BTREE btree, BLOCK block, void *param);
 void print_block(BTREE btree, BLOCK block, INT32 *offset);
 BOOLEAN tf_print_index(BTREE btree, INDEX index, void *param);
 void print_index(INDEX index, INT32 *offset);
-void print_keyfile(KEYFILE1* kfile1, KEYFILE2* kfile2, INT32 size);
+void print_keyfile(KEYFILE1* kfile1, KEYFILE2* kfile2, KEYFILE3* kfile3, INT32 size);
 static void print_usage(void);
 void print_xrefs(void);
 static void vcrashlog (int newline, const char * fmt, va_list args);
@@ -216,7 +216,7 @@ print_usage (void)
 	printf(_("options:\n"));
 	printf(_("\t-a = Dump ALL records\n"));
 	printf(_("\t-b = Dump btree (INDEX)\n"));
-	printf(_("\t-k = Dump key files (KEYFILE1, KEYFILE2)\n"));
+	printf(_("\t-k = Dump key files (KEYFILE1, KEYFILE2, KEYFILE3)\n"));
 	printf(_("\t-x = Dump xref file (DELETESET)\n"));
 	printf(_("\t-r = Dump records (BLOCK)\n"));
 	printf(_("\t-s = Summarize unused INDEX and BLOCK directory entries\n"));
@@ -249,7 +249,9 @@ print_usage (void)
  *     R's value is 2 or 3 chars, including the R
  * 3c. N  6 chars long, N[A-Z$][A-Z][0-9]{3,3}
  *     Name
- * 3d. V is VUOPT (only V key I am aware of)
+ *     parts of a split Name record replace the 2 leading spaces
+ *     by the part number, [0-9a-z]{2,2}N...
+ * 3d. V is VUOPT, VPLAC or VXREF (copy of xrefs file)
  * 3e. H is HISTV or HISTC
  * messages to stdout - errors, warnings are printed and ignored
  * 
@@ -274,6 +276,10 @@ check_rkey(keytype *kt, RKEY *key,BOOLEAN in_data) {
 	char *p = kt->rkey;
 	while (*p == ' ') p++;   // p points to 1st non-space char
 	kt->rkeyfirst = p;
+	if (p == kt->rkey && (isdigit(p[0]) || islower(p[0]))
+		&& (isdigit(p[1]) || islower(p[1])) && p[2] == 'N') {
+		p += 2;          // part of split Name record, check rest as Name
+	}
 	if (strlen(kt->rkey) != 8) {
 		printf("Warning, embedded null in RKEY %s (0x",kt->rkeyfirst);
 		for (int i = 0; i <= 7; i++) {
@@ -304,7 +310,7 @@ check_rkey(keytype *kt, RKEY *key,BOOLEAN in_data) {
 //    R,N are letter followed by A-Za-z0-9
 //       well really N is [A-Z]{3}[0-9]{3}
 //    REFN Name
-//    V is VUOPT
+//    V is VUOPT, VPLAC or VXREF
 //    H is HIST[VC]
 	switch (*p) {
 	case 'E': 
@@ -350,7 +356,8 @@ check_rkey(keytype *kt, RKEY *key,BOOLEAN in_data) {
 		}
 		break;
 	case 'V': 
-		if (strcmp(p,"VUOPT") != 0) {
+		if (strcmp(p,"VUOPT") != 0 && strcmp(p,"VPLAC") != 0
+			&& strcmp(p,"VXREF") != 0) {
 			printf("Error, invalid letter in RKEY(%s)\n",kt->rkey);
 		}
 		break;
@@ -541,6 +548,8 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 {
 	INT n;
 	INT32 size=0;
+	INT32 live=0, dead=0;
+	BOOLEAN inorder=TRUE;
 	INT NRcount = 0;
 
 	printf("\n");
@@ -560,9 +569,10 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 	*offset += sizeof(ixtype(block));
 
 #if __WORDSIZE != 16
-	printf(FMT_INT32_HEX ":ix_pad1:   " FMT_INT16_HEX "\n",
-		*offset, block->ix_pad1);
-	*offset += sizeof(block->ix_pad1);
+	printf(FMT_INT32_HEX ":ix_format: " FMT_INT16_HEX "%s\n",
+		*offset, blockformat(block),
+		blockzipped(btree, block) ? " (compressed)" : "");
+	*offset += sizeof(blockformat(block));
 #endif
 	printf(FMT_INT32_HEX ":ix_parent: " FMT_INT32_HEX " (%s)\n",
 		*offset, ixparent(block), fkey2path(ixparent(block)));
@@ -666,10 +676,23 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 	/* Step 3: Dump BLOCK data */
 	/* Note that this mechanism is horribly inefficient from an I/O perspective. */
 	printf("BLOCK - DATA\n");
+	// records added or updated in place are appended (see bt_addrecord)
+	// so may be out of key order, and may leave dead space behind
+	for (n=0; n<NRcount; n++) {
+		if (offs(block,n) != live)
+			inorder = FALSE;
+		live += lens(block,n);
+	}
+	dead = size - BUFLEN - live;
+	if (!inorder) {
+		printf("Note, block records not in key order, with " FMT_INT32_HEX
+			" bytes of dead space (not compacted)\n", dead);
+	}
 	for (n=0; n<NRcount; n++) {
 		INT len;
 		INT32 roff = offs(block, n);
 		INT32 rlen = lens(block,n);
+		INT32 stored = -1;
 		if (roff == 0 && rlen == 0 && *(INT64*)&rkeys(block,n) == 0) {
 			printf("[" FMT_INT "], found unexpected unitialized key\n",
 				n );
@@ -678,7 +701,12 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 		RAWRECORD rec = readrec(btree, block, n, &len);
 		INT32 roffnxt = (n < NORECS - 1 && offs(block,n+1)!=0) ?
 			offs(block,n+1)+BUFLEN : size ;
-		if (*offset + rlen > roffnxt) {
+		if (!inorder) {
+			*offset = BUFLEN + roff;
+			if (*offset + rlen > size) {
+				printf("Error, record " FMT_INT " extends past end of block\n",n);
+			}
+		} else if (*offset + rlen > roffnxt) {
 			printf("Error, record " FMT_INT " longer than available data\n",n);
 			printf("offset=" FMT_INT32_HEX
 				", +rlen(" FMT_INT32_HEX ")n=" 
@@ -705,7 +733,35 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 			" lens: " FMT_INT32_HEX "\n",
 			n,akey.rname, akey.rkeyfirst,
 			(INT32)offs(block,n), (INT32)lens(block,n));
-		if (*akey.rkeyfirst ==  'N' || *akey.rkeyfirst == 'R') {
+		if (blockzipped(btree, block)) {
+			// offsets below are within record as expanded
+			printf("   compressed, expands to " FMT_INT32_HEX " bytes\n",
+				(INT32)len);
+			stored = *offset;
+			*offset = 0;
+		}
+		if (strcmp(akey.rname,"Name") == 0
+			&& *(INT32 *) &rec[0] < 0) {
+			// directory of Name record split in parts
+			// INT32 -1 : marks directory
+			// INT32 nparts : number of parts
+			// RKEY[nparts] : keys of the parts
+			// RKEY[nparts] : lowest INDI key in each part
+			INT32 nparts = *(INT32 *) &rec[sizeof(INT32)];
+			INT32 col1 = 2*sizeof(INT32);
+			INT32 col2 = col1 + nparts * sizeof(RKEY);
+			INT m;
+			printf("   " FMT_INT32_HEX ": Split, nparts " FMT_INT32 "\n",
+				*offset,nparts);
+			for(m = 0; m < nparts; m++) {
+				printf("    " FMT_INT_3 ". " FMT_INT32_HEX ":RKEY %8.8s "
+				    FMT_INT32_HEX ":low %8.8s\n",
+					m+1, *offset + col1, &rec[col1],
+					*offset + col2, &rec[col2]);
+				col1 += sizeof(RKEY);
+				col2 += sizeof(RKEY);
+			}
+		} else if (strcmp(akey.rname,"Name") == 0 || *akey.rkeyfirst == 'R') {
 			// name / REFN data consists of
 			// INT16 nnames : number of names
 			// RKEY[nnames] : INDI keys of the name/REFN
@@ -715,7 +771,7 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 			// so *offset is kept frozen till end
 			// we reuse akey buffer to check rkeys in sublists
 			//    so save first letter of this record's key
-			char first = *akey.rkeyfirst;
+			char first = akey.rname[0];
 			INT32 Ncount = *(INT32 *) &rec[0]; 
 			INT32 col1 = sizeof(INT32);
 			INT32 col2 = col1 + Ncount * sizeof(RKEY);
@@ -810,22 +866,27 @@ void print_block(BTREE btree, BLOCK block, INT32 *offset)
 			else
 				printf(">> ??not text?? <<\n");
 		} 
+		if (stored >= 0)
+			*offset = stored;
 		*offset += lens(block,n);
 		stdfree(rec);
 	}
+	if (!inorder && *offset <= size)
+		*offset = size; /* last record need not be last in file */
 	printf("\n");
 
 	printf(FMT_INT32_HEX ": EOF (" FMT_INT32_HEX ") %s\n",
 		*offset, size, (*offset == size) ? "GOOD" : "BAD");
 }
 /*===============================
- * dump_keyfile -- open and print KEYFILE1 and KEYFILE2 to stdout
+ * dump_keyfile -- open and print KEYFILE1, KEYFILE2 and KEYFILE3 to stdout
  *=============================*/
 void dump_keyfile(STRING dir)
 {
 	char scratch[MAXPATHLEN];
 	KEYFILE1 kfile1;
 	KEYFILE2 kfile2;
+	KEYFILE3 kfile3;
 	FILE *fk;
 	size_t size;
 
@@ -840,10 +901,12 @@ void dump_keyfile(STRING dir)
 
 	printf("KEYFILE key\n");
 	if (size != sizeof(kfile1) &&
-		size != (sizeof(kfile1) + sizeof(kfile2))) {
+		size != (sizeof(kfile1) + sizeof(kfile2)) &&
+		size != (sizeof(kfile1) + sizeof(kfile2) + sizeof(kfile3))) {
 		printf("Error: keyfile size invalid (" FMT_SIZET 
-			"), valid sizes are " FMT_SIZET " and " FMT_SIZET "\n",
-			size, sizeof(kfile1), sizeof(kfile1)+sizeof(kfile2));
+			"), valid sizes are " FMT_SIZET ", " FMT_SIZET " and " FMT_SIZET "\n",
+			size, sizeof(kfile1), sizeof(kfile1)+sizeof(kfile2),
+			sizeof(kfile1)+sizeof(kfile2)+sizeof(kfile3));
 		goto error1;
 	}
 
@@ -860,11 +923,23 @@ void dump_keyfile(STRING dir)
 			goto error1;
 		}
 
-		print_keyfile(&kfile1, &kfile2, size);
+		/* likewise kfile3 */
+		if (size != sizeof(kfile1) + sizeof(kfile2))
+		{
+			if (fread(&kfile3, sizeof(kfile3), 1, fk) != 1) {
+				printf("Error reading keyfile (%d: %s)\n", errno, scratch);
+				goto error1;
+			}
+			print_keyfile(&kfile1, &kfile2, &kfile3, size);
+		}
+		else
+		{
+			print_keyfile(&kfile1, &kfile2, NULL, size);
+		}
 	}
 	else
 	{
-		print_keyfile(&kfile1, NULL, size);
+		print_keyfile(&kfile1, NULL, NULL, size);
 	}
 
 error1:
@@ -873,9 +948,9 @@ error2:
 	return;
 }
 /*===============================
- * print_keyfile -- print KEYFILE1 and KEYFILE2 to stdout
+ * print_keyfile -- print KEYFILE1, KEYFILE2 and KEYFILE3 to stdout
  *=============================*/
-void print_keyfile(KEYFILE1* kfile1, KEYFILE2* kfile2, INT32 size)
+void print_keyfile(KEYFILE1* kfile1, KEYFILE2* kfile2, KEYFILE3* kfile3, INT32 size)
 {
 	INT32 offset = 0;
 
@@ -917,6 +992,16 @@ void print_keyfile(KEYFILE1* kfile1, KEYFILE2* kfile2, INT32 size)
 		offset += sizeof(kfile2->version);
 	}
 
+	if (kfile3)
+	{
+		printf("\nKEYFILE3\n");
+		printf("========\n");
+
+		printf(FMT_INT16_HEX ":version:  " FMT_INT32_HEX " (%d)\n", 
+			offset, kfile3->k_version, kfile3->k_version);
+		offset += sizeof(kfile3->k_version);
+	}
+
 	printf(FMT_INT32_HEX ": EOF (" FMT_INT32_HEX ") %s\n", offset,
 		size, (offset == size) ? "GOOD" : "BAD");
 	printf("\n");
@@ -0,0 +1,574 @@
+/*
+   Copyright (c) 1991-2005 Thomas T. Wetmore IV
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without
+   restriction, including without limitation the rights to use, copy,
+   modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+*/
+/*=================================================================
+ * ttbench.c -- Command that times custom translation tables
+ *  Translates a GEDCOM file (or generated GEDCOM text) line by
+ *  line with each .tt file given, through the compiled table of
+ *  gedlib/charmaps.c and through the character tree walk it
+ *  replaced, which is kept here only for comparison.
+ *===============================================================*/
+
+#include <stdarg.h>
+#include <time.h>
+#include "llstdlib.h"
+/* llstdlib.h pulls in standard.h, config.h, sys_inc.h */
+#include "translat.h"
+#include "gedcom.h"
+#include "zstr.h"
+#include "../gedlib/gedcomi.h"
+#include "version.h"
+
+extern STRING qSgen_bugreport;
+
+/*********************************************
+ * required global variables
+ *********************************************/
+/* defined in liflines/main.c */
+STRING readpath_file = NULL;
+STRING readpath = NULL;
+BOOLEAN readonly = FALSE;
+BOOLEAN writeable = FALSE;
+BOOLEAN immutable = FALSE;
+int opt_finnish = 0;
+int opt_mychar = 0;
+
+/*********************************************
+ * local types
+ *********************************************/
+
+/* node of former character tree */
+typedef struct tag_treenode *TREENODE;
+struct tag_treenode {
+	TREENODE parent;
+	TREENODE sibling;
+	TREENODE child;
+	INT achar;
+	STRING replace;
+};
+
+/* former table, a tree for each first character */
+typedef struct tag_treetab {
+	TREENODE start[256];
+} *TREETAB;
+
+/*********************************************
+ * local function prototypes
+ *********************************************/
+
+/* alphabetical */
+static double elapsed(clock_t start);
+static STRING load_file(CNSTRING path, INT * plen);
+static STRING make_gedcom(INT megs, INT * plen);
+static INT next_random(void);
+static CNSTRING parse_tt_char(CNSTRING p, STRING * pout);
+static void print_usage(void);
+static void report(CNSTRING what, INT bytes, double secs);
+static void time_table(CNSTRING path, STRING text, INT len);
+static void vcrashlog(int newline, const char * fmt, va_list args);
+static void tree_add(TREETAB tab, CNSTRING left, CNSTRING right);
+static void tree_free(TREENODE node);
+static TREETAB tree_load(CNSTRING path);
+static INT tree_match(TREETAB tab, CNSTRING in, CNSTRING * out);
+static ZSTR tree_translate(CNSTRING str, TREETAB tab);
+
+/*********************************************
+ * local variables
+ *********************************************/
+
+static unsigned long rand_state = 1;
+
+/* name pieces for generated GEDCOM, some with non-ASCII UTF-8 */
+static CNSTRING f_names[] = {
+	"John", "Mary", "Smith", "Jones", "William", "Elizabeth"
+	, "Brown", "Taylor", "M\xC3\xBCller", "Dvo\xC5\x99\xC3\xA1k"
+	, "\xC5\x81ukasz", "\xC3\x85ngstr\xC3\xB6m", "Nguy\xE1\xBB\x85n"
+	, "\xD0\x98\xD0\xB2\xD0\xB0\xD0\xBD", "Jos\xC3\xA9", "O'Brien"
+};
+static CNSTRING f_places[] = {
+	"London, England", "Boston, Suffolk, Massachusetts"
+	, "Z\xC3\xBCrich, Switzerland", "Krak\xC3\xB3w, Poland"
+	, "Troms\xC3\xB8, Norway", "Smith &amp; Sons Farm, Ohio"
+};
+
+/*********************************************
+ * local function definitions
+ * body of module
+ *********************************************/
+
+/*=========================================
+ * main -- Main procedure of ttbench command
+ *=======================================*/
+int
+main (int argc,
+      char **argv)
+{
+	INT megs = 10;
+	CNSTRING input = NULL;
+	STRING text;
+	INT i, len, ntables=0;
+
+#ifdef WIN32
+	_fmode = O_BINARY;	/* default to binary rather than TEXT mode */
+#endif
+
+	for (i=1; i<argc; ++i) {
+		if (!strcmp(argv[i], "--version")
+			|| !strcmp(argv[i], "-v")) {
+			print_version("ttbench");
+			return 0;
+		}
+		if (!strcmp(argv[i], "--help")
+			|| !strcmp(argv[i], "-h")
+			|| !strcmp(argv[i], "-?")) {
+			print_usage();
+			return 0;
+		}
+		if (!strcmp(argv[i], "-m") && i+1<argc) {
+			megs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-i") && i+1<argc) {
+			input = argv[++i];
+		} else if (argv[i][0] == '-') {
+			print_usage();
+			return 10;
+		} else {
+			++ntables;
+		}
+	}
+	if (!ntables || megs < 1) {
+		print_usage();
+		return 10;
+	}
+
+	if (input) {
+		if (!(text = load_file(input, &len))) {
+			printf(_("Cannot read `%s'"), input);
+			printf("\n");
+			return 1;
+		}
+	} else {
+		text = make_gedcom(megs, &len);
+	}
+	printf(FMT_INT " bytes of GEDCOM (%s)\n", len, input ? input : "generated");
+
+	for (i=1; i<argc; ++i) {
+		if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "-i"))
+			++i;
+		else
+			time_table(argv[i], text, len);
+	}
+	stdfree(text);
+	return 0;
+}
+/*=========================================
+ * time_table -- Time one .tt file both ways
+ *  & check that both give the same output
+ *=======================================*/
+static void
+time_table (CNSTRING path, STRING text, INT len)
+{
+	TRANTABLE tt=0;
+	TREETAB tab=0;
+	ZSTR zerr=zs_new(), zout;
+	STRING line, end;
+	INT outlen1=0, outlen2=0, diffs=0, i;
+	clock_t start;
+
+	if (!init_map_from_file(path, path, &tt, zerr) || !tt
+		|| !(tab = tree_load(path))) {
+		printf(_("Cannot load translation table `%s' %s"), path, zs_str(zerr));
+		printf("\n");
+		zs_free(&zerr);
+		remove_trantable(tt);
+		return;
+	}
+	printf("%s:\n", path);
+
+	/* text holds lines separated by zeros (see load_file) */
+	start = clock();
+	for (line = text; line < text+len; line = end+1) {
+		end = line + strlen(line);
+		zout = tree_translate(line, tab);
+		outlen1 += zs_len(zout);
+		zs_free(&zout);
+	}
+	report("tree walk", len, elapsed(start));
+
+	start = clock();
+	for (line = text; line < text+len; line = end+1) {
+		end = line + strlen(line);
+		zout = custom_translate(line, tt);
+		outlen2 += zs_len(zout);
+		zs_free(&zout);
+	}
+	report("compiled", len, elapsed(start));
+
+	/* compare outputs (untimed) */
+	for (line = text; line < text+len; line = end+1) {
+		ZSTR zout2;
+		end = line + strlen(line);
+		zout = tree_translate(line, tab);
+		zout2 = custom_translate(line, tt);
+		if (!eqstr(zs_str(zout), zs_str(zout2)))
+			++diffs;
+		zs_free(&zout);
+		zs_free(&zout2);
+	}
+	printf("  output " FMT_INT " & " FMT_INT " bytes, " FMT_INT " lines differ\n"
+		, outlen1, outlen2, diffs);
+
+	remove_trantable(tt);
+	for (i = 0; i < 256; ++i)
+		tree_free(tab->start[i]);
+	stdfree(tab);
+	zs_free(&zerr);
+}
+/*=========================================
+ * report -- Print time & throughput of one pass
+ *=======================================*/
+static void
+report (CNSTRING what, INT bytes, double secs)
+{
+	printf("  %-10s %.3f sec, %.1f MB/sec\n"
+		, what, secs, secs > 0 ? bytes/secs/(1024*1024) : 0.0);
+}
+/*=========================================
+ * load_file -- Read whole file, with its lines
+ *  zero-terminated in place of newlines
+ *=======================================*/
+static STRING
+load_file (CNSTRING path, INT * plen)
+{
+	FILE * fp = fopen(path, LLREADBINARY);
+	STRING text, p;
+	INT len;
+	if (!fp)
+		return NULL;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	text = (STRING)stdalloc(len+1);
+	len = fread(text, 1, len, fp);
+	fclose(fp);
+	text[len] = 0;
+	for (p = text; p < text+len; ++p) {
+		if (*p == '\n' || *p == '\r')
+			*p = 0;
+	}
+	*plen = len;
+	return text;
+}
+/*=========================================
+ * make_gedcom -- Generate megs megabytes of GEDCOM lines
+ *  (zero-terminated, as from load_file)
+ *=======================================*/
+static STRING
+make_gedcom (INT megs, INT * plen)
+{
+	INT size = megs*1024*1024, len=0, key=0;
+	STRING text = (STRING)stdalloc(size+512);
+	INT nnames = ARRSIZE(f_names), nplaces = ARRSIZE(f_places);
+	while (len < size) {
+		++key;
+		len += 1+sprintf(text+len, "0 @I" FMT_INT "@ INDI", key);
+		len += 1+sprintf(text+len, "1 NAME %s %s /%s/"
+			, f_names[next_random() % nnames]
+			, f_names[next_random() % nnames]
+			, f_names[next_random() % nnames]);
+		len += 1+sprintf(text+len, "1 SEX %s", key % 2 ? "M" : "F");
+		len += 1+sprintf(text+len, "1 BIRT");
+		len += 1+sprintf(text+len, "2 DATE " FMT_INT " MAR " FMT_INT
+			, 1+next_random() % 28, 1700+next_random() % 300);
+		len += 1+sprintf(text+len, "2 PLAC %s", f_places[next_random() % nplaces]);
+		len += 1+sprintf(text+len, "1 FAMS @F" FMT_INT "@", 1+next_random() % key);
+		len += 1+sprintf(text+len, "1 NOTE Son of %s %s, moved to %s in "
+			FMT_INT " with his family."
+			, f_names[next_random() % nnames]
+			, f_names[next_random() % nnames]
+			, f_places[next_random() % nplaces]
+			, 1720+next_random() % 300);
+	}
+	*plen = len;
+	return text;
+}
+/*=========================================
+ * tree_load -- Read .tt file into former tree table
+ *  (same syntax as init_map_from_str in gedlib/charmaps.c)
+ *=======================================*/
+static TREETAB
+tree_load (CNSTRING path)
+{
+	TREETAB tab;
+	INT len;
+	STRING text = load_file(path, &len), line, end;
+	char left[50], right[50];
+	char sep = '\t';
+	if (!text)
+		return NULL;
+	tab = (TREETAB)stdalloc(sizeof(*tab));
+	memset(tab, 0, sizeof(*tab));
+	for (line = text; line < text+len; line = end+1) {
+		CNSTRING p = line;
+		STRING q;
+		end = line + strlen(line);
+		if (!line[0])
+			continue;
+		if (line[0] == '#' && line[1] == '#') {
+			if (!strncmp(line, "##!sep=", 7))
+				sep = '=';
+			continue;
+		}
+		for (q = left; *p && *p != sep && q < left+sizeof(left)-1; )
+			p = parse_tt_char(p, &q);
+		*q = 0;
+		if (*p++ != sep || !left[0])
+			continue;
+		for (q = right; *p && *p != sep && *p != '\t' && q < right+sizeof(right)-1; )
+			p = parse_tt_char(p, &q);
+		*q = 0;
+		tree_add(tab, left, right);
+	}
+	stdfree(text);
+	return tab;
+}
+/*=========================================
+ * parse_tt_char -- Parse one (maybe escaped) .tt character
+ *  p:    [IN]  where to parse
+ *  pout: [I/O] where to put character (advanced)
+ * returns position after what was parsed
+ *=======================================*/
+static CNSTRING
+parse_tt_char (CNSTRING p, STRING * pout)
+{
+	INT c;
+	if (*p == '#' && (c = get_decimal((STRING)p+1)) >= 0) {
+		*(*pout)++ = c;
+		return p+4;
+	}
+	if (*p == '$' && (c = get_hexidecimal((STRING)p+1)) >= 0) {
+		*(*pout)++ = c;
+		return p+3;
+	}
+	if (*p == '\\' && p[1]) {
+		*(*pout)++ = (p[1] == 't' ? '\t' : p[1]);
+		return p+2;
+	}
+	*(*pout)++ = *p;
+	return p+1;
+}
+/*=========================================
+ * tree_add -- Add pattern to former tree table
+ *=======================================*/
+static void
+tree_add (TREETAB tab, CNSTRING left, CNSTRING right)
+{
+	TREENODE parent=0, *pnode = &tab->start[(uchar)*left];
+	while (TRUE) {
+		while (*pnode && (*pnode)->achar != (uchar)*left)
+			pnode = &(*pnode)->sibling;
+		if (!*pnode) {
+			*pnode = (TREENODE)stdalloc(sizeof(**pnode));
+			memset(*pnode, 0, sizeof(**pnode));
+			(*pnode)->parent = parent;
+			(*pnode)->achar = (uchar)*left;
+		}
+		if (!*++left)
+			break;
+		parent = *pnode;
+		pnode = &parent->child;
+	}
+	/* later patterns win, as in create_trantable */
+	strupdate(&(*pnode)->replace, right);
+}
+/*=========================================
+ * tree_free -- Free tree nodes
+ *=======================================*/
+static void
+tree_free (TREENODE node)
+{
+	if (!node) return;
+	tree_free(node->child);
+	tree_free(node->sibling);
+	strfree(&node->replace);
+	stdfree(node);
+}
+/*=========================================
+ * tree_match -- Find match in former tree table
+ *  (former translate_match)
+ *=======================================*/
+static INT
+tree_match (TREETAB tab, CNSTRING in, CNSTRING * out)
+{
+	TREENODE node, chnode;
+	INT nxtch;
+	CNSTRING q = in;
+	node = tab->start[(uchar)*in];
+	if (!node) {
+		*out = "";
+		return 0;
+	}
+	q = in+1;
+	while (*q && node->child) {
+		nxtch = (uchar)*q;
+		chnode = node->child;
+		while (chnode && chnode->achar != nxtch)
+			chnode = chnode->sibling;
+		if (!chnode) break;
+		node = chnode;
+		q++;
+	}
+	while (TRUE) {
+		if (node->replace) {
+			*out = node->replace;
+			return q - in;
+		}
+		if (node->parent) {
+			node = node->parent;
+			--q;
+			continue;
+		}
+		*out = "";
+		return 0;
+	}
+}
+/*=========================================
+ * tree_translate -- Translate via former tree table
+ *  (former custom_translate)
+ *=======================================*/
+static ZSTR
+tree_translate (CNSTRING str, TREETAB tab)
+{
+	ZSTR zout = zs_newn((unsigned int)(strlen(str)*1.3+2));
+	CNSTRING p = str;
+	while (*p) {
+		CNSTRING tmp;
+		INT len = tree_match(tab, p, &tmp);
+		if (len) {
+			p += len;
+			zs_apps(zout, tmp);
+		} else {
+			zs_appc(zout, *p++);
+		}
+	}
+	return zout;
+}
+/*=========================================
+ * next_random -- Simple repeatable pseudo random number
+ *  (so that runs are comparable)
+ *=======================================*/
+static INT
+next_random (void)
+{
+	rand_state = rand_state * 1103515245UL + 12345UL;
+	return (INT)((rand_state >> 8) & 0x7fffff);
+}
+/*=========================================
+ * elapsed -- Processor seconds since start
+ *=======================================*/
+static double
+elapsed (clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+/*=============================
+ * __fatal -- Fatal error routine
+ *  handles null or empty details input
+ *===========================*/
+void
+__fatal (STRING file, int line, CNSTRING details)
+{
+	printf("FATAL ERROR: ");
+	if (details && details[0]) {
+		printf("%s", details);
+		printf("\nAT: ");
+	}
+	printf("%s: line %d\n", file, line);
+	exit(1);
+}
+/*===============================
+ * vcrashlog -- Send crash info to screen
+ *  internal implementation
+ *=============================*/
+static void
+vcrashlog (int newline, const char * fmt, va_list args)
+{
+	vprintf(fmt, args);
+	if (newline) {
+		printf("\n");
+	}
+}
+/*===============================
+ * crashlog -- Send string to crash log and screen
+ *=============================*/
+void
+crashlog (STRING fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vcrashlog(0, fmt, args);
+	va_end(args);
+}
+/*===============================
+ * crashlogn -- Send string to crash log and screen
+ *  add carriage return to end line
+ *=============================*/
+void
+crashlogn (STRING fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vcrashlog(1, fmt, args);
+	va_end(args);
+}
+/*===============================================
+ * print_usage -- display program help/usage
+ *  displays to stdout
+ *=============================================*/
+static void
+print_usage (void)
+{
+	printf(_("lifelines `ttbench' times custom translation tables.\n"));
+	printf("\n\n");
+	printf(_("Usage ttbench <options> <ttfile>..."));
+	printf("\n\n");
+	printf(_("Options:"));
+	printf("\n");
+	printf(_("\t-i FILE\tGEDCOM file to translate"));
+	printf("\n");
+	printf(_("\t-m N\tmegabytes of GEDCOM to generate if no -i (default 10)"));
+	printf("\n");
+	printf(_("\t--help\tdisplay this help and exit"));
+	printf("\n");
+	printf(_("\t--version\toutput version information and exit"));
+	printf("\n\n");
+	printf(_("Examples:"));
+	printf("\n");
+	printf(_("\tttbench tt/UTF-8_ANSEL.tt tt/UTF-8__html.tt"));
+	printf("\n");
+	printf(_("\tttbench -m 100 tt/*.tt"));
+	printf("\n");
+	printf(_("\tttbench -i family.ged tt/UTF-8_ISO-8859-1.tt"));
+	printf("\n\t\t");
+	printf("%s", _(qSgen_bugreport));
+	printf("\n");
+}
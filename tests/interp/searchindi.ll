@@ -0,0 +1,40 @@
+/*
+@progname searchindi.ll
+@description Test searchindiset() with prefix, *inside & near~ words
+*/
+
+proc main ()
+{
+  "Starting Test" nl()
+  call search("s")
+  call search("sm")
+  call search("smith")
+  call search("j smith")
+  call search("*h")
+  call search("*th")
+  call search("*mi")
+  call search("*ri")
+  call search("*ic")
+  call search("*ith")
+  call search("*ri keith")
+  call search("a~")
+  call search("bo~")
+  call search("smyth~")
+  call search("richard~")
+  call search("zz")
+  call search("*zz")
+  "Ending Test" nl()
+}
+
+proc search (words)
+{
+  searchindiset(words, set)
+  "'" words "':"
+  if (set) {
+    keysort(set)
+    forindiset(set, indi, val, num) {
+      " " key(indi) "=" name(indi)
+    }
+  }
+  nl()
+}
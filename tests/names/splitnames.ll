@@ -0,0 +1,25 @@
+/*
+@progname splitnames.ll
+@description Find persons through split name records
+*/
+
+proc main ()
+{
+  "Starting Test" nl()
+  call count("John/Smith")
+  call count("J/Smit")
+  call count("Judith/Smyth")
+  call count("Ann/Jones")
+  set(n, 0)
+  forindi(indi, num) { incr(n) }
+  "forindi: " d(n) nl()
+  "Ending Test" nl()
+}
+
+proc count (name)
+{
+  genindiset(name, set)
+  name ": "
+  if (set) { d(length(set)) } else { "0" }
+  nl()
+}